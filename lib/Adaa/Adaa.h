@@ -0,0 +1,170 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+
+// **************************
+// Adaa
+// *****************
+// Antiderivative anti-aliasing for static waveshapers. Instead of f(x)
+// at the sample, ADAA1 outputs the mean of f over the segment between
+// the last two inputs, (F1(x) - F1(x1)) / (x - x1), ADAA2 the same one
+// order up with the second antiderivative F2. The images a waveshaper
+// folds back get a sinc / sinc^2 rolloff at the sample rate, roughly
+// what a 2x loop buys at 1x cost, for half (ADAA1) or one (ADAA2)
+// sample of delay.
+//
+// Near x == x1 the divided difference is 0/0, so under TOL it falls
+// back to f at the midpoint (exact to O(dx^2)). ADAA2's differences of
+// F2 lose too much in float, it works in double (hardware on the M7).
+//
+// Shapes (u is the already-driven input):
+//   Alg   u / (1 + |u|)
+//   Atan  atan(u)
+//   Tanh  tanh(u)        first order only: its F2 is a dilogarithm,
+//                        ADAA2 runs as ADAA1
+namespace Adaa {
+
+enum Mode : uint8_t { OFF = 0, ADAA1 = 1, ADAA2 = 2 };
+
+static constexpr float  TOL1 = 1.0e-3f;
+static constexpr double TOL2 = 1.0e-4;
+
+// **************************
+// Shapes
+// *****************
+struct Alg {
+  static constexpr bool HAS_F2 = true;
+
+  static float f(float u) { return u / (1.0f + fabsf(u)); }
+
+  static float F1(float u) {
+    float a = fabsf(u);
+    return a - log1pf(a);
+  }
+
+  static double F1d(double u) {
+    double a = fabs(u);
+    return a - log1p(a);
+  }
+
+  static double F2(double u) {
+    double a = fabs(u);
+    double v = 0.5 * a * a - (1.0 + a) * log1p(a) + a;
+    return (u < 0.0) ? -v : v;
+  }
+};
+
+struct Atan {
+  static constexpr bool HAS_F2 = true;
+
+  static float f(float u) { return atanf(u); }
+
+  static float F1(float u) { return u * atanf(u) - 0.5f * log1pf(u * u); }
+
+  static double F1d(double u) { return u * atan(u) - 0.5 * log1p(u * u); }
+
+  static double F2(double u) {
+    return 0.5 * (u * u - 1.0) * atan(u) + 0.5 * u - 0.5 * u * log1p(u * u);
+  }
+};
+
+struct Tanh {
+  static constexpr bool HAS_F2 = false;
+
+  static float f(float u) { return tanhf(u); }
+
+  // log cosh, written so large |u| doesn't overflow
+  static float F1(float u) {
+    float a = fabsf(u);
+    return a + log1pf(expf(-2.0f * a)) - 0.69314718f;
+  }
+
+  static double F1d(double u) {
+    double a = fabs(u);
+    return a + log1p(exp(-2.0 * a)) - 0.69314718055994531;
+  }
+
+  static double F2(double) { return 0.0; }
+};
+
+// **************************
+// Shaper
+// *****************
+// One waveshaper with its own history. Parked at a constant input u,
+// every mode outputs exactly f(u), so effects that idle at a bias
+// point can park the history there (reset(u)) and stay bit-silent.
+template <class S>
+class Shaper {
+public:
+  void setMode(Mode m) {
+    if (m == ADAA2 && !S::HAS_F2) m = ADAA1;
+    if (m == _mode) return;
+    _mode = m;
+    reset(_x1);
+  }
+  Mode mode() const { return _mode; }
+
+  void reset(float u = 0.0f) {
+    _x1 = u;
+    _x2 = u;
+    _F1x1 = S::F1(u);
+    _F2x1 = S::F2((double)u);
+    _d1   = S::F1d((double)u);
+  }
+
+  // history within t of u
+  bool settled(float u, float t) const {
+    return fabsf(_x1 - u) < t && fabsf(_x2 - u) < t;
+  }
+
+  float process(float u) {
+    if (_mode == ADAA1) return adaa1(u);
+    if (_mode == ADAA2) return adaa2(u);
+    return S::f(u);
+  }
+
+private:
+  Mode   _mode = OFF;
+  float  _x1 = 0.0f, _x2 = 0.0f;
+  float  _F1x1 = 0.0f;
+  double _F2x1 = 0.0;
+  double _d1 = 0.0; // (F2(x1) - F2(x2)) / (x1 - x2)
+
+  float adaa1(float x) {
+    float F  = S::F1(x);
+    float dx = x - _x1;
+    float y  = (fabsf(dx) < TOL1) ? S::f(0.5f * (x + _x1)) : (F - _F1x1) / dx;
+    _x2   = _x1;
+    _x1   = x;
+    _F1x1 = F;
+    return y;
+  }
+
+  float adaa2(float xf) {
+    const double x = xf, x1 = _x1, x2 = _x2;
+    const double F = S::F2(x);
+
+    const double dx = x - x1;
+    const double d1 = (fabs(dx) < TOL2) ? S::F1d(0.5 * (x + x1)) : (F - _F2x1) / dx;
+
+    double y;
+    const double dx2 = x - x2;
+    if (fabs(dx2) < TOL2) {
+      // x back where it was two samples ago: expand around the mean
+      const double xb = 0.5 * (x + x2);
+      const double dl = xb - x1;
+      if (fabs(dl) < TOL2) y = (double)S::f((float)(0.5 * (xb + x1)));
+      else                 y = (2.0 / dl) * (S::F1d(xb) + (_F2x1 - S::F2(xb)) / dl);
+    } else {
+      y = 2.0 * (d1 - _d1) / dx2;
+    }
+
+    _x2   = _x1;
+    _x1   = xf;
+    _F2x1 = F;
+    _d1   = d1;
+    return (float)y;
+  }
+};
+
+} // namespace Adaa
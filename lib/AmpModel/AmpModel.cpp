@@ -0,0 +1,370 @@
+#include "AmpModel.h"
+#include "ParamMap.h" // constexpr exp for the activation table
+#include "Trace.h"
+#include <math.h>
+#include <string.h>
+
+// **************************
+// Activations
+// *****************
+// tanh on [-6, 6] in 1/32 steps, linear in between (error < 1e-4),
+// saturated outside. sigmoid(x) = 0.5 + 0.5 tanh(x/2) from the same table.
+static constexpr int   ACT_N     = 385;
+static constexpr float ACT_RANGE = 6.0f;
+static constexpr float ACT_SCALE = (float)(ACT_N - 1) / (2.0f * ACT_RANGE);
+
+struct ActTable {
+  float v[ACT_N];
+};
+
+static constexpr ActTable makeTanh() {
+  ActTable t{};
+  for (int i = 0; i < ACT_N; i++) {
+    double x = -(double)ACT_RANGE + (double)i / (double)ACT_SCALE;
+    double e = ParamMap::cx::exp(2.0 * x);
+    t.v[i] = (float)((e - 1.0) / (e + 1.0));
+  }
+  return t;
+}
+
+static constexpr ActTable TANH_T PROGMEM = makeTanh();
+
+static inline float tanhLut(float x) {
+  float p = (x + ACT_RANGE) * ACT_SCALE;
+  if (!(p > 0.0f)) return -1.0f; // NaN too
+  if (p >= (float)(ACT_N - 1)) return 1.0f;
+  int i = (int)p;
+  float f = p - (float)i;
+  return TANH_T.v[i] + f * (TANH_T.v[i + 1] - TANH_T.v[i]);
+}
+
+static inline float sigmoidLut(float x) {
+  return 0.5f + 0.5f * tanhLut(0.5f * x);
+}
+
+AmpModel::AmpModel() { reset(); }
+
+void AmpModel::reset() {
+  for (int j = 0; j < MAX_HIDDEN; j++) {
+    _h[j] = 0.0f;
+    _c[j] = 0.0f;
+  }
+  _dcX1 = _dcY1 = 0.0f;
+  _tone = 0.0f;
+
+  // zero state isn't the model's resting point, let it settle first
+  _silent = !loaded();
+}
+
+void AmpModel::prepare(float fs, int maxBlock) {
+  (void)maxBlock;
+  _fs = fs;
+  _dcR = 1.0f - 2.0f * 3.14159265f * 10.0f / fs; // ~10 Hz
+}
+
+bool AmpModel::load(const uint8_t* blob, size_t bytes) {
+  _hidden = 0;
+  _wh8 = nullptr;
+  reset();
+
+  if (!blob || bytes < sizeof(Header) || ((uintptr_t)blob & 3u)) return false;
+
+  Header h;
+  memcpy(&h, blob, sizeof(h));
+  if (memcmp(h.magic, "AMPM", 4) || h.version != VERSION) return false;
+  if (h.cell > LSTM || h.weights > INT8) return false;
+  if (h.hidden < 1 || h.hidden > MAX_HIDDEN) return false;
+
+  const Cell    cell = (Cell)h.cell;
+  const Weights w    = (Weights)h.weights;
+  const int     H    = h.hidden;
+  const int     G    = gates(cell);
+  if (h.bytes != blobBytes(cell, H, w) || h.bytes > bytes) return false;
+
+  const float* f = (const float*)(blob + sizeof(Header));
+  _wx  = f; f += G * H;
+  _bx  = f; f += G * H;
+  _bhn = (cell == GRU) ? f : nullptr;
+  if (cell == GRU) f += H;
+  _wo  = f; f += H;
+  _bo  = *f++;
+
+  if (w == F32) {
+    _wh = f;
+  } else {
+    _scale = f;
+    _wh8 = (const int8_t*)(f + G * H);
+  }
+
+  _cell   = cell;
+  _skip   = h.skip != 0;
+  _hidden = H;
+  reset();
+  return true;
+}
+
+// **************************
+// Kernels
+// *****************
+// One row of the recurrent matrix against h. Four partial sums keep
+// the M7's FPU pipeline busy instead of waiting on each add.
+template <>
+float AmpModel::rowDot<false>(int row) const {
+  const int H = _hidden;
+  const float* w = _wh + row * H;
+  float a0 = 0.0f, a1 = 0.0f, a2 = 0.0f, a3 = 0.0f;
+  int j = 0;
+  for (; j + 4 <= H; j += 4) {
+    a0 += w[j]     * _h[j];
+    a1 += w[j + 1] * _h[j + 1];
+    a2 += w[j + 2] * _h[j + 2];
+    a3 += w[j + 3] * _h[j + 3];
+  }
+  for (; j < H; j++) a0 += w[j] * _h[j];
+  return (a0 + a1) + (a2 + a3);
+}
+
+// int8 rows: a quarter of the flash traffic, one scale per row
+template <>
+float AmpModel::rowDot<true>(int row) const {
+  const int H = _hidden;
+  const int8_t* w = _wh8 + row * H;
+  float a0 = 0.0f, a1 = 0.0f, a2 = 0.0f, a3 = 0.0f;
+  int j = 0;
+  for (; j + 4 <= H; j += 4) {
+    a0 += (float)w[j]     * _h[j];
+    a1 += (float)w[j + 1] * _h[j + 1];
+    a2 += (float)w[j + 2] * _h[j + 2];
+    a3 += (float)w[j + 3] * _h[j + 3];
+  }
+  for (; j < H; j++) a0 += (float)w[j] * _h[j];
+  return ((a0 + a1) + (a2 + a3)) * _scale[row];
+}
+
+// PyTorch GRU: r, z, n rows; n = tanh(Wx + b + r * (Wh h + bh))
+template <bool Q>
+float AmpModel::stepGRU(float x) {
+  const int H = _hidden;
+
+  // every dot against the old h before any of it changes
+  for (int r = 0; r < 3 * H; r++) _g[r] = rowDot<Q>(r);
+
+  float y = _bo;
+  for (int j = 0; j < H; j++) {
+    float r = sigmoidLut(_wx[j] * x + _bx[j] + _g[j]);
+    float z = sigmoidLut(_wx[H + j] * x + _bx[H + j] + _g[H + j]);
+    float n = tanhLut(_wx[2 * H + j] * x + _bx[2 * H + j] + r * (_g[2 * H + j] + _bhn[j]));
+    _h[j] = n + z * (_h[j] - n);
+    y += _wo[j] * _h[j];
+  }
+  return _skip ? y + x : y;
+}
+
+// PyTorch LSTM: i, f, g, o rows
+template <bool Q>
+float AmpModel::stepLSTM(float x) {
+  const int H = _hidden;
+
+  for (int r = 0; r < 4 * H; r++) _g[r] = _wx[r] * x + _bx[r] + rowDot<Q>(r);
+
+  float y = _bo;
+  for (int j = 0; j < H; j++) {
+    float i = sigmoidLut(_g[j]);
+    float f = sigmoidLut(_g[H + j]);
+    float g = tanhLut(_g[2 * H + j]);
+    float o = sigmoidLut(_g[3 * H + j]);
+    _c[j] = f * _c[j] + i * g;
+    _h[j] = o * tanhLut(_c[j]);
+    y += _wo[j] * _h[j];
+  }
+  return _skip ? y + x : y;
+}
+
+// **************************
+// Process
+// *****************
+float AmpModel::clamp01(float x) {
+  if (!(x > 0.0f)) return 0.0f; // NaN -> 0
+  if (x > 1.0f) return 1.0f;
+  return x;
+}
+
+template <bool Q>
+void AmpModel::runBlock(int16_t* data, int n, const Params& p) {
+  const float mix   = clamp01(p.mix);
+  const float drive = (p.drive > 0.0f) ? p.drive : 0.0f;
+  const float level = (p.level > 0.0f) ? p.level : 0.0f;
+  const float a     = clamp01(p.toneA);
+  const int   H     = _hidden;
+
+  float h0[MAX_HIDDEN], c0[MAX_HIDDEN];
+  for (int j = 0; j < H; j++) {
+    h0[j] = _h[j];
+    c0[j] = _c[j];
+  }
+
+  bool  quietIn = true;
+  float peak = 0.0f;
+
+  FX_TRACE("AmpModel");
+
+  for (int i = 0; i < n; i++) {
+    if (data[i] != 0) quietIn = false;
+
+    float dry = (float)data[i] / 32768.0f;
+    float y = (_cell == GRU) ? stepGRU<Q>(dry * drive) : stepLSTM<Q>(dry * drive);
+
+    // trained models carry some DC, and the bias moves with drive
+    float d = y - _dcX1 + _dcR * _dcY1;
+    _dcX1 = y;
+    _dcY1 = d;
+
+    _tone = (1.0f - a) * d + a * _tone;
+    float ay = fabsf(_tone);
+    if (ay > peak) peak = ay;
+
+    float out = dry + mix * (_tone * level - dry);
+    if (out > 1.0f) out = 1.0f;
+    if (!(out > -1.0f)) out = -1.0f; // NaN too
+    data[i] = (int16_t)(out * 32767.0f);
+  }
+
+  // park only on an exact fixed point of zeros in: the cells stopped
+  // moving, and the DC blocker / tone tail (under threshold) snap to 0,
+  // so skipping a block gives what running it would have
+  bool moved = false;
+  for (int j = 0; j < H; j++) moved |= (_h[j] != h0[j]) | (_c[j] != c0[j]);
+
+  _silent = quietIn && !moved && peak < SILENT_THRESH && fabsf(_dcY1) < SILENT_THRESH;
+  if (_silent) _dcY1 = _tone = 0.0f;
+}
+
+void AmpModel::processMono(int16_t* data, int n, const Params& p) {
+  if (!loaded()) return;
+  if (_wh8) runBlock<true>(data, n, p);
+  else      runBlock<false>(data, n, p);
+}
+
+// **************************
+// Test blobs + benchmark
+// *****************
+size_t AmpModel::makeTestBlob(uint8_t* out, size_t cap, Cell cell, int hidden, Weights w, uint32_t seed) {
+  if (hidden < 1 || hidden > MAX_HIDDEN) return 0;
+  const size_t bytes = blobBytes(cell, hidden, w);
+  if (!out || cap < bytes || ((uintptr_t)out & 3u)) return 0;
+  memset(out, 0, bytes);
+
+  Header h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, "AMPM", 4);
+  h.version = VERSION;
+  h.cell    = cell;
+  h.hidden  = (uint8_t)hidden;
+  h.weights = w;
+  h.skip    = 1;
+  h.bytes   = (uint32_t)bytes;
+  memcpy(out, &h, sizeof(h));
+
+  // xorshift, weights ~ +-1/sqrt(H) like a trained layer
+  uint32_t s = seed ? seed : 1u;
+  auto rnd = [&s]() {
+    s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+    return (float)(s >> 8) / 8388608.0f - 1.0f; // -1..1
+  };
+  const float k = 1.0f / sqrtf((float)hidden);
+  const int G = gates(cell), H = hidden;
+
+  float* f = (float*)(out + sizeof(Header));
+  const int head = G * H + G * H + (cell == GRU ? H : 0) + H + 1;
+  for (int i = 0; i < head; i++) f[i] = k * rnd();
+  f += head;
+
+  if (w == F32) {
+    for (int i = 0; i < G * H * H; i++) f[i] = k * rnd();
+  } else {
+    int8_t* q = (int8_t*)(f + G * H);
+    for (int r = 0; r < G * H; r++) {
+      f[r] = k / 127.0f;
+      for (int j = 0; j < H; j++) q[r * H + j] = (int8_t)(127.0f * rnd());
+    }
+  }
+  return bytes;
+}
+
+void AmpModel::benchmark(Print& out, uint32_t (*ticks)(), uint32_t budget,
+                         uint8_t* scratch, size_t scratchBytes,
+                         const uint8_t* flashBlob, size_t flashBytes) {
+  static const int SIZES[] = { 4, 8, 12, 16, 20, 24, 32 };
+  static constexpr int BLOCK = 128;
+  static constexpr int RUNS  = 8;
+
+  int16_t in[BLOCK], buf[BLOCK];
+  for (int i = 0; i < BLOCK; i++) in[i] = (int16_t)(12000.0f * sinf(0.0623f * (float)i));
+
+  AmpModel m;
+  Params p;
+
+  // worst of a few blocks, starting with the first one after load: that
+  // block takes the cache misses on the weights and it has the same deadline
+  auto worstBlock = [&](const uint8_t* blob, size_t n) -> uint32_t {
+    if (!m.load(blob, n)) return 0;
+    m.prepare(44100.0f, BLOCK);
+    uint32_t worst = 0;
+    for (int r = 0; r < RUNS; r++) {
+      memcpy(buf, in, sizeof(buf));
+      uint32_t t0 = ticks();
+      m.processMono(buf, BLOCK, p);
+      uint32_t dt = ticks() - t0;
+      if (dt > worst) worst = dt;
+    }
+    return worst;
+  };
+
+  // the sizes below run from scratch RAM; a model in flash (the way
+  // AMP_MODEL_DEFAULT ships) pays for the flash cache on top, so time the
+  // given blob in place and from a RAM copy and scale the table by that
+  float flashPenalty = 1.0f;
+  if (flashBlob && flashBytes <= scratchBytes) {
+    uint32_t inFlash = worstBlock(flashBlob, flashBytes);
+    memcpy(scratch, flashBlob, flashBytes);
+    uint32_t inRam = worstBlock(scratch, flashBytes);
+    if (inFlash && inRam) {
+      flashPenalty = (float)inFlash / (float)inRam;
+      if (flashPenalty < 1.0f) flashPenalty = 1.0f;
+      out.print("default model in flash: ");
+      out.print((unsigned long)inFlash);
+      out.print(" ticks/block, from RAM: ");
+      out.print((unsigned long)inRam);
+      out.print(", sizes scaled by ");
+      out.println(flashPenalty, 2);
+    }
+  }
+
+  for (int c = 0; c < 2; c++) {
+    for (int w = 0; w < 2; w++) {
+      int fits = 0;
+      for (int H : SIZES) {
+        size_t n = makeTestBlob(scratch, scratchBytes, (Cell)c, H, (Weights)w, 12345u);
+        uint32_t worst = n ? worstBlock(scratch, n) : 0;
+        if (!worst) break;
+        uint32_t cost = (uint32_t)((float)worst * flashPenalty + 0.5f);
+
+        out.print(c == LSTM ? "LSTM " : "GRU  ");
+        out.print(w == INT8 ? "int8 " : "f32  ");
+        out.print("H=");
+        out.print(H);
+        out.print(": ");
+        out.print((unsigned long)cost);
+        out.print(" ticks/block, ");
+        out.print(100.0 * (double)cost / (double)budget, 1);
+        out.println("% of budget");
+        if (cost <= budget) fits = H;
+      }
+
+      out.print(c == LSTM ? "LSTM " : "GRU  ");
+      out.print(w == INT8 ? "int8 " : "f32  ");
+      out.print("largest within budget: H=");
+      out.println(fits);
+    }
+  }
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "FxBase.h"
+
+// **************************
+// AmpModel
+// *****************
+// Recurrent amp / drive capture run per sample: one GRU or LSTM layer
+// (hidden size up to MAX_HIDDEN), a linear readout and an optional skip
+// from the input. The weights stay where the blob is (a PROGMEM array
+// on the Teensy), as floats or as int8 with one scale per row, so only
+// the hidden state lives in RAM. tanh / sigmoid come from one
+// interpolated table.
+//
+// Blobs are made from a GuitarML / Automated-GuitarAmpModelling style
+// JSON capture by tools/host/amp_convert.
+class AmpModel : public FxBase<AmpModel> {
+public:
+  static constexpr int MAX_HIDDEN = 32;
+
+  enum Cell : uint8_t { GRU = 0, LSTM = 1 };
+  enum Weights : uint8_t { F32 = 0, INT8 = 1 };
+
+  // **************************
+  // Blob
+  // *****************
+  // Little endian, 4 byte aligned, G gates (GRU r,z,n / LSTM i,f,g,o),
+  // H hidden:
+  //   Header
+  //   float wx[G*H]        input weights
+  //   float bx[G*H]        input + recurrent bias (GRU n: input side only)
+  //   float bhn[H]         GRU only: recurrent bias of n, inside r * (...)
+  //   float wo[H], bo      readout
+  //   F32:  float  wh[G*H][H]
+  //   INT8: float  scale[G*H], int8 wh[G*H][H], padded to 4
+  struct Header {
+    char     magic[4]; // "AMPM"
+    uint8_t  version;
+    uint8_t  cell;
+    uint8_t  hidden;
+    uint8_t  weights;
+    uint8_t  skip;     // readout adds the input
+    uint8_t  reserved[3];
+    uint32_t bytes;    // whole blob, header included
+  };
+  static constexpr uint8_t VERSION = 1;
+
+  static constexpr int gates(Cell c) { return (c == LSTM) ? 4 : 3; }
+  static constexpr size_t blobBytes(Cell cell, int hidden, Weights w) {
+    return sizeof(Header) +
+           4 * (2 * (size_t)gates(cell) * hidden + (cell == GRU ? hidden : 0) + hidden + 1) +
+           ((w == F32) ? 4 * (size_t)gates(cell) * hidden * hidden
+                       : 4 * (size_t)gates(cell) * hidden + (((size_t)gates(cell) * hidden * hidden + 3u) & ~(size_t)3u));
+  }
+
+  // blob with small random weights, for timing only; 0 if cap is short
+  static size_t makeTestBlob(uint8_t* out, size_t cap, Cell cell, int hidden, Weights w, uint32_t seed);
+
+  // **************************
+  // Params
+  // *****************
+  struct Params {
+    float mix   = 1.0f; // dry / model
+    float drive = 1.0f; // gain into the model
+    float level = 1.0f; // gain out of the model
+    float toneA = 0.0f; // one-pole LP coefficient after the model, 0 = open
+  };
+
+  AmpModel();
+  void reset();
+
+  // Points at the blob, which has to outlive the model (flash array).
+  // False, and pass-through, if it doesn't check out.
+  bool load(const uint8_t* blob, size_t bytes);
+  bool loaded() const { return _hidden > 0; }
+  int  hidden() const { return _hidden; }
+  Cell cell() const { return _cell; }
+  bool quantized() const { return _wh8 != nullptr; }
+
+  void processMono(int16_t* data, int n, const Params& p);
+
+  // **************************
+  // Idle
+  // *****************
+  // A trained model rarely maps silence to exactly zero: with zeros in,
+  // the state settles on a fixed point and the DC blocker takes the
+  // remaining offset away. Once the state stopped moving and the output
+  // is under the threshold, blocks of zeros can be skipped.
+  bool isSilent() const { return _silent; }
+
+  // Time the worst block (the first after load included) at every size
+  // and print which fit. ticks() is a free running counter, budget is
+  // ticks per audio block, scratch holds the largest test blob
+  // (blobBytes(LSTM, MAX_HIDDEN, F32)). flashBlob, if given, is a model
+  // stored in PROGMEM; its flash / RAM cost ratio is applied to every size.
+  static void benchmark(Print& out, uint32_t (*ticks)(), uint32_t budget,
+                        uint8_t* scratch, size_t scratchBytes,
+                        const uint8_t* flashBlob = nullptr, size_t flashBytes = 0);
+
+  // **************************
+  // FxBase interface
+  // *****************
+  void prepare(float fs, int maxBlock);
+  void setParams(const Params& p) { _p = p; }
+  void process(int16_t* data, int n, const BlockAnalysis&) { processMono(data, n, _p); }
+
+private:
+  float  _fs = 44100.0f;
+  Params _p;
+
+  // **************************
+  // Model (points into the blob)
+  // *****************
+  Cell   _cell = GRU;
+  int    _hidden = 0;
+  bool   _skip = false;
+  const float*  _wx  = nullptr;
+  const float*  _bx  = nullptr;
+  const float*  _bhn = nullptr;
+  const float*  _wo  = nullptr;
+  float         _bo  = 0.0f;
+  const float*  _wh  = nullptr;
+  const float*  _scale = nullptr;
+  const int8_t* _wh8 = nullptr;
+
+  // **************************
+  // State
+  // *****************
+  float _h[MAX_HIDDEN];
+  float _c[MAX_HIDDEN];         // LSTM cell
+  float _g[4 * MAX_HIDDEN];     // gate pre-activations, per sample
+
+  // DC blocker + tone
+  float _dcR  = 0.9986f;
+  float _dcX1 = 0.0f;
+  float _dcY1 = 0.0f;
+  float _tone = 0.0f;
+
+  static constexpr float SILENT_THRESH = 1.0e-5f; // ~-100 dBFS
+  bool _silent = false;
+
+  // **************************
+  // Kernels
+  // *****************
+  template <bool Q> float rowDot(int row) const;
+  template <bool Q> float stepGRU(float x);
+  template <bool Q> float stepLSTM(float x);
+  template <bool Q> void  runBlock(int16_t* data, int n, const Params& p);
+
+  static float clamp01(float x);
+};
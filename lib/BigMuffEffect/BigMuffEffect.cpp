@@ -1,7 +1,87 @@
 #include "BigMuffEffect.h"
+#include "Trace.h"
 #include <math.h>
+#include <string.h>
+
+// **************************
+// Circuit values
+// *****************
+// Two clipping stages as inverting amps (the transistor's gain taken
+// as high enough for a virtual ground at the base), each with 100k,
+// 470p and a 1N914 pair from collector to base. Tone stack is the
+// usual 39k/10n low pass and 4n/22k high pass into a 100k pot, loaded
+// by the 100k volume pot.
+static constexpr double DIODE_IS = 2.52e-9;  // A
+static constexpr double DIODE_NVT = 1.752 * 0.02585; // V
+static constexpr double CLIP_RF = 100.0e3;
+static constexpr double CLIP_C  = 470.0e-12;
+
+static constexpr float CLIP_RIN1 = 10.0e3f;  // stage 1 input
+static constexpr float CLIP_RIN2_LO = 15.0e3f; // stage 2 input, shape 0..1
+static constexpr float CLIP_RIN2_HI = 3.3e3f;
+static constexpr float COUPLE_C = 100.0e-9f; // stage 2 input cap, with RIN2
+
+static constexpr float TS_R1 = 39.0e3f;
+static constexpr float TS_C1 = 10.0e-9f;
+static constexpr float TS_C2 = 4.0e-9f;
+static constexpr float TS_R2 = 22.0e3f;
+static constexpr float TS_POT = 100.0e3f;
+static constexpr float TS_POT_MIN = 100.0f; // pot end resistance
+static constexpr float TS_LOAD = 100.0e3f;
+
+static constexpr float SUSTAIN_LO = 1.5f;    // gain into stage 1, drive 0..1
+static constexpr float SUSTAIN_HI = 80.0f;
+static constexpr float IN_VOLTS = 1.0f;      // full scale at the input jack
+static constexpr float PI_F = 3.14159265f;
+static constexpr float ATAN_NORM = 2.0f / 3.14159265f;
+
+BigMuffEffect::BigMuffEffect() {
+  for (int j = 0; j <= CLIP_N; j++) _clipS[j] = 0.0f;
+  for (int j = 0; j < 6; j++) _tsK[j] = 0.0f;
+  reset();
+}
+
+void BigMuffEffect::setModel(Model m) {
+  if (m == _model) return;
+  _model = m;
+  reset();
+}
 
-BigMuffEffect::BigMuffEffect() { reset(); }
+void BigMuffEffect::setAntiAlias(Adaa::Mode m) {
+  if (m == _aa) return;
+  _aa = m;
+  _sat1.setMode(m);
+  _sat2.setMode(m);
+  _sat3.setMode(m);
+  reset();
+}
+
+void BigMuffEffect::prepare(float fs, int maxBlock) {
+  (void)maxBlock;
+  _fs = fs;
+
+  // circuit runs at the 2x rate like the classic path
+  const double T  = 1.0 / (2.0 * (double)fs);
+  const double gc = 2.0 * CLIP_C / T;
+  const double a  = 1.0 / CLIP_RF + gc;
+  const double k  = 2.0 * DIODE_IS / (a * DIODE_NVT);
+
+  _clipQ  = (float)(1.0 / (a * DIODE_NVT));
+  _clipV  = (float)DIODE_NVT;
+  _clipG2 = (float)(2.0 * gc);
+
+  // u = N*q/(q + Q1) -> q = Q1*u/(N - u); the last point stands in for
+  // q -> inf, half a step further out
+  for (int j = 0; j <= CLIP_N; j++) {
+    double u = (j < CLIP_N) ? (double)j : (double)CLIP_N - 0.5;
+    double q = (double)CLIP_Q1 * u / ((double)CLIP_N - u);
+    _clipS[j] = (float)solveClip(q, k);
+  }
+
+  _tsGc1  = 2.0f * TS_C1 * 2.0f * fs;
+  _tsGc2  = 2.0f * TS_C2 * 2.0f * fs;
+  _tsTone = -1.0f;
+}
 
 void BigMuffEffect::reset() {
   _dc_x1 = _dc_y1 = 0.0f;
@@ -17,10 +97,32 @@ void BigMuffEffect::reset() {
   _osLP   = 0.0f;
 
   _xPrev  = 0.0f;
+
+  _fb1 = _fb2 = 0.0f;
+  _ts1 = _ts2 = 0.0f;
+
+  _biasU = 0.0f;
+  _sat1.reset();
+  _sat2.reset();
+  _sat3.reset();
+
+  _silent = true;
+}
+
+// true if every filter state has decayed under the silence threshold
+bool BigMuffEffect::tailDecayed() const {
+  const float t = SILENT_THRESH;
+  return fabsf(_dc_x1)  < t && fabsf(_dc_y1)  < t &&
+         fabsf(_hp1_lp) < t && fabsf(_hp2_lp) < t && fabsf(_hp3_lp) < t &&
+         fabsf(_preLP)  < t && fabsf(_postLP) < t && fabsf(_toneLP) < t &&
+         fabsf(_osLP)   < t && fabsf(_xPrev)  < t &&
+         fabsf(_fb1 * _clipQ) < t && fabsf(_fb2 * _clipQ) < t &&
+         fabsf(_ts1 * TS_R1)  < t && fabsf(_ts2 * TS_R2)  < t &&
+         _sat1.settled(_biasU, t) && _sat2.settled(0.0f, t) && _sat3.settled(0.0f, t);
 }
 
 float BigMuffEffect::clamp01(float x) {
-  if (x < 0.0f) return 0.0f;
+  if (!(x > 0.0f)) return 0.0f; // NaN -> 0
   if (x > 1.0f) return 1.0f;
   return x;
 }
@@ -55,7 +157,7 @@ float BigMuffEffect::onePoleHP_viaLP(float x, float& lpState, float a) {
 
 // atan sat (k = hardness)
 float BigMuffEffect::satAtan(float x, float k) {
-  return (2.0f / 3.14159265f) * atanf(k * x);
+  return ATAN_NORM * atanf(k * x);
 }
 
 // tiny safety clamp
@@ -72,9 +174,10 @@ void BigMuffEffect::processMonoWet(int16_t* mono, int n, float fs, const Params&
   float pres  = clamp01(pIn.pres);
 
   // **************************
-  // oversample (2x)
+  // oversample (2x), or 1x with ADAA stages
   // *****************
-  float fs2 = fs * 2.0f;
+  const int osN = (_aa == Adaa::OFF) ? 2 : 1;
+  float fs2 = fs * (float)osN;
 
   // **************************
   // gain staging
@@ -96,12 +199,28 @@ void BigMuffEffect::processMonoWet(int16_t* mono, int n, float fs, const Params&
   // tiny bias (keep it subtle)
   float bias = lerp(0.00f, 0.04f, shape);
 
+  // Static DC the bias puts on stage 1, taken out up front. The coupling
+  // HP right after removes it anyway, so in steady state this only
+  // moves rounding (1 LSB). What it changes is the start: from reset()
+  // the HP no longer has to charge up to the offset, which came out as
+  // a thump of up to ~1800 LSB over the first 20-30 ms after a mode
+  // change. It also makes all-zero state the fixed point of silence in,
+  // which the idle skip needs to park here at all.
+  float biasDC = satAtan(bias, k1);
+
+  // ADAA history parks where silence puts stage 1
+  _biasU = k1 * bias;
+  if (_silent) _sat1.reset(_biasU);
+
   // **************************
   // "coupling caps" (HP)
   // *****************
-  float hpA1 = lerp(0.0045f, 0.012f, drive);
-  float hpA2 = lerp(0.0040f, 0.010f, drive);
-  float hpA3 = lerp(0.0035f, 0.009f, drive);
+  // (per-sample coefficients, doubled at 1x for the same corners)
+  const float hpScale = 2.0f / (float)osN;
+  float hpA1 = lerp(0.0045f, 0.012f, drive) * hpScale;
+  float hpA2 = lerp(0.0040f, 0.010f, drive) * hpScale;
+  float hpA3 = lerp(0.0035f, 0.009f, drive) * hpScale;
+  const float dcR = (osN == 2) ? 0.995f : 0.990f;
 
   // **************************
   // bandlimits (alias control)
@@ -131,7 +250,13 @@ void BigMuffEffect::processMonoWet(int16_t* mono, int n, float fs, const Params&
   // leave headroom (main handles volume)
   float outScale = 0.55f;
 
+  bool quietIn = true;
+
+  FX_TRACE("BigMuff");
+
   for (int i = 0; i < n; i++) {
+    if (mono[i] != 0) quietIn = false;
+
     float x1 = (float)mono[i] / 32768.0f;
     float x0 = _xPrev;
     float xHalf = 0.5f * (x0 + x1); // cheap 2x interp
@@ -139,52 +264,61 @@ void BigMuffEffect::processMonoWet(int16_t* mono, int n, float fs, const Params&
     float yOut = 0.0f;
 
     // **************************
-    // 2x loop + decimate
+    // 2x loop + decimate (one pass at 1x)
     // *****************
-    for (int os = 0; os < 2; os++) {
-      float x = (os == 0) ? xHalf : x1;
+    for (int os = 0; os < osN; os++) {
+      FX_TRACE_LAPS(t);
+      FX_TRACE_LAP(t, "input");
+
+      float x = (os + 1 < osN) ? xHalf : x1;
 
       x *= inPad;
 
       // DC cleanup (slow, but fine)
-      x = dcBlock(x, _dc_x1, _dc_y1, 0.995f);
+      x = dcBlock(x, _dc_x1, _dc_y1, dcR);
 
       // pre LP before clipping (big alias win)
       x = onePoleLP(x, _preLP, preA);
 
       // ******** stage 1 ********
+      FX_TRACE_LAP(t, "clip1");
       float s1 = x * g1 + bias;
-      float y1 = satAtan(s1, k1);
+      float y1 = ATAN_NORM * _sat1.process(k1 * s1) - biasDC;
       y1 = onePoleHP_viaLP(y1, _hp1_lp, hpA1);
 
       // ******** stage 2 ********
+      FX_TRACE_LAP(t, "clip2");
       float s2 = y1 * g2;
-      float y2 = satAtan(s2, k2);
+      float y2 = ATAN_NORM * _sat2.process(k2 * s2);
       y2 = onePoleHP_viaLP(y2, _hp2_lp, hpA2);
 
       // ******** stage 3 ********
+      FX_TRACE_LAP(t, "clip3");
       float s3 = y2 * g3;
-      float y3 = satAtan(s3, k3);
+      float y3 = ATAN_NORM * _sat3.process(k3 * s3);
       y3 = onePoleHP_viaLP(y3, _hp3_lp, hpA3);
 
       // **************************
       // tone (LP/HP blend)
       // *****************
+      FX_TRACE_LAP(t, "tone");
       float lp = onePoleLP(y3, _toneLP, toneA);
       float hp = y3 - lp;
       float yt = (1.0f - tone) * lp + tone * hp;
 
       // fizz killer
+      FX_TRACE_LAP(t, "post");
       yt = onePoleLP(yt, _postLP, postA);
 
       // keep it from going insane
       yt = softLimit(yt);
 
       // AA LP before decimate
-      float ytAA = onePoleLP(yt, _osLP, osA);
-
-      if (os == 1) {
-        yOut = ytAA * outScale;
+      if (osN == 2) {
+        float ytAA = onePoleLP(yt, _osLP, osA);
+        if (os == 1) yOut = ytAA * outScale;
+      } else {
+        yOut = yt * outScale;
       }
     }
 
@@ -193,4 +327,239 @@ void BigMuffEffect::processMonoWet(int16_t* mono, int n, float fs, const Params&
     int32_t out = (int32_t)(yOut * 32767.0f);
     mono[i] = clamp16(out);
   }
+
+  // **************************
+  // tail flush
+  // *****************
+  // Silent input + every state under threshold: park at exact zero,
+  // which is a fixed point, so main can skip us until input returns.
+  if (!quietIn) {
+    _silent = false;
+  } else if (!_silent && tailDecayed()) {
+    reset();
+  }
+}
+
+// **************************
+// Circuit model
+// *****************
+// s + k*sinh(s) = q for s >= 0. The left side is convex, so Newton from
+// an upper bound walks down without overshooting.
+double BigMuffEffect::solveClip(double q, double k) {
+  if (!(q > 0.0)) return 0.0;
+  double s = asinh(q / k);
+  if (q < s) s = q;
+  for (int i = 0; i < 100; i++) {
+    double f  = s + k * sinh(s) - q;
+    double df = 1.0 + k * cosh(s);
+    double ds = f / df;
+    s -= ds;
+    if (fabs(ds) < 1.0e-12 * (1.0 + s)) break;
+  }
+  return s;
+}
+
+float BigMuffEffect::clipLookup(float q) const {
+  float aq = fabsf(q);
+  float u = (float)CLIP_N * aq / (aq + CLIP_Q1);
+  int i = (int)u;
+  if (i > CLIP_N - 1) i = CLIP_N - 1;
+  float f = u - (float)i;
+  float s = _clipS[i] + f * (_clipS[i + 1] - _clipS[i]);
+  return (q < 0.0f) ? -s : s;
+}
+
+// inverting stage: input current in, collector voltage out; hist is
+// the feedback cap's trapezoid history current
+float BigMuffEffect::clipStage(float iIn, float& hist) const {
+  float v = _clipV * clipLookup((hist - iIn) * _clipQ);
+  hist = _clipG2 * v - hist;
+  return v;
+}
+
+// Nodes A (LP cap), B (HP side) and the wiper W, caps as trapezoid
+// companions, pot split Ra = tone*POT, Rb = (1 - tone)*POT. The system
+// is symmetric, only the two right hand columns that are ever non-zero
+// are kept.
+void BigMuffEffect::solveToneStack(float tone) {
+  _tsTone = tone;
+
+  float ra = tone * TS_POT;
+  float rb = (1.0f - tone) * TS_POT;
+  if (ra < TS_POT_MIN) ra = TS_POT_MIN;
+  if (rb < TS_POT_MIN) rb = TS_POT_MIN;
+  const float ga = 1.0f / ra, gb = 1.0f / rb;
+
+  const float a00 = 1.0f / TS_R1 + _tsGc1 + ga;
+  const float a11 = _tsGc2 + 1.0f / TS_R2 + gb;
+  const float a22 = ga + gb + 1.0f / TS_LOAD;
+
+  const float m00 = a11 * a22 - gb * gb;
+  const float det = a00 * m00 - ga * ga * a11;
+  const float inv = 1.0f / det;
+
+  _tsK[0] = m00 * inv;                  // A <- r0
+  _tsK[1] = ga * gb * inv;              // A <- r1, B <- r0
+  _tsK[2] = (a00 * a22 - ga * ga) * inv; // B <- r1
+  _tsK[3] = a11 * ga * inv;             // W <- r0
+  _tsK[4] = a00 * gb * inv;             // W <- r1
+  _tsK[5] = 0.0f;
+}
+
+void BigMuffEffect::processMonoCircuit(int16_t* mono, int n, const Params& pIn) {
+  float drive = clamp01(pIn.drive);
+  float tone  = clamp01(pIn.tone);
+  float shape = clamp01(pIn.shape);
+  float pres  = clamp01(pIn.pres);
+
+  const float fs2 = _fs * 2.0f;
+
+  if (tone != _tsTone) solveToneStack(tone);
+
+  // sustain: gain ahead of stage 1, log sweep
+  const float g0 = SUSTAIN_LO * powf(SUSTAIN_HI / SUSTAIN_LO, drive) * IN_VOLTS / CLIP_RIN1;
+
+  // shape: stage 2 input resistor, harder clip and less bass as it drops
+  const float rin2 = lerp(CLIP_RIN2_LO, CLIP_RIN2_HI, shape);
+  const float g2 = 1.0f / rin2;
+
+  // coupling caps: input ~20 Hz, stage 2 input RC with rin2
+  const float hpIn = 1.0f - expf(-2.0f * PI_F * 20.0f / fs2);
+  const float hp2  = 1.0f - expf(-1.0f / (rin2 * COUPLE_C * fs2));
+  const float hpTs = 1.0f - expf(-2.0f * PI_F * 30.0f / fs2);
+
+  // recovery stage treble cut, pres opens it
+  const float postA = 1.0f - expf(-2.0f * PI_F * lerp(2500.0f, 8000.0f, pres) / fs2);
+  const float osA   = 1.0f - expf(-2.0f * PI_F * 12000.0f / fs2);
+
+  // volts at the wiper -> output level near the classic model's
+  const float outScale = 1.8f;
+
+  const float k0 = _tsK[0], k1 = _tsK[1], k2 = _tsK[2], k3 = _tsK[3], k4 = _tsK[4];
+  const float gc1x2 = 2.0f * _tsGc1, gc2 = _tsGc2, gc2x2 = 2.0f * _tsGc2;
+  const float r1i = 1.0f / TS_R1;
+
+  bool quietIn = true;
+
+  FX_TRACE("BigMuffCircuit");
+
+  for (int i = 0; i < n; i++) {
+    if (mono[i] != 0) quietIn = false;
+
+    float x1 = (float)mono[i] / 32768.0f;
+    float x0 = _xPrev;
+    float xHalf = 0.5f * (x0 + x1); // cheap 2x interp
+
+    float yOut = 0.0f;
+
+    for (int os = 0; os < 2; os++) {
+      FX_TRACE_LAPS(t);
+      FX_TRACE_LAP(t, "input");
+
+      float x = (os == 0) ? xHalf : x1;
+      x = onePoleHP_viaLP(x, _hp1_lp, hpIn);
+
+      // ******** clipping stages ********
+      FX_TRACE_LAP(t, "clip1");
+      float v1 = clipStage(x * g0, _fb1);
+
+      FX_TRACE_LAP(t, "clip2");
+      float x2 = onePoleHP_viaLP(v1, _hp2_lp, hp2);
+      float v2 = clipStage(x2 * g2, _fb2);
+      v2 = onePoleHP_viaLP(v2, _hp3_lp, hpTs);
+
+      // ******** tone stack ********
+      FX_TRACE_LAP(t, "tone");
+      float r0 = v2 * r1i + _ts1;
+      float r1 = gc2 * v2 - _ts2;
+      float vA = k0 * r0 + k1 * r1;
+      float vB = k1 * r0 + k2 * r1;
+      float vW = k3 * r0 + k4 * r1;
+      _ts1 = gc1x2 * vA - _ts1;
+      _ts2 = gc2x2 * (v2 - vB) - _ts2;
+
+      // ******** recovery ********
+      FX_TRACE_LAP(t, "post");
+      float yt = onePoleLP(vW * outScale, _postLP, postA);
+      yt = softLimit(yt);
+
+      float ytAA = onePoleLP(yt, _osLP, osA);
+      if (os == 1) yOut = ytAA;
+    }
+
+    _xPrev = x1;
+
+    int32_t out = (int32_t)(yOut * 32767.0f);
+    mono[i] = clamp16(out);
+  }
+
+  if (!quietIn) {
+    _silent = false;
+  } else if (!_silent && tailDecayed()) {
+    reset();
+  }
+}
+
+// **************************
+// Benchmark
+// *****************
+void BigMuffEffect::benchmark(Print& out, uint32_t (*ticks)(), uint32_t budget) {
+  static constexpr int BLOCK = 128;
+  static constexpr int RUNS  = 8;
+  static constexpr float FS  = 44100.0f;
+
+  int16_t in[BLOCK], buf[BLOCK];
+  for (int i = 0; i < BLOCK; i++) in[i] = (int16_t)(12000.0f * sinf(0.0623f * (float)i));
+
+  Params p;
+  p.drive = 0.7f;
+  p.tone  = 0.5f;
+  p.shape = 0.5f;
+  p.pres  = 0.5f;
+
+  // classic at 2x / ADAA1 / ADAA2, then the circuit model
+  static const char* NAMES[4] = { "classic 2x", "classic ADAA1", "classic ADAA2", "circuit" };
+  uint32_t best[4];
+  for (int c = 0; c < 4; c++) {
+    BigMuffEffect fx;
+    fx.prepare(FS, BLOCK);
+    fx.setModel(c == 3 ? CIRCUIT : CLASSIC);
+    fx.setAntiAlias(c == 3 ? Adaa::OFF : (Adaa::Mode)c);
+    fx.setParams(p);
+    BlockAnalysis an{};
+    best[c] = 0xffffffffu;
+    for (int r = 0; r < RUNS; r++) {
+      memcpy(buf, in, sizeof(buf));
+      uint32_t t0 = ticks();
+      fx.process(buf, BLOCK, an);
+      uint32_t dt = ticks() - t0;
+      if (dt < best[c]) best[c] = dt;
+    }
+
+    out.print("muff ");
+    out.print(NAMES[c]);
+    out.print(": ");
+    out.print((unsigned long)best[c]);
+    out.print(" ticks/block, ");
+    out.print(100.0 * (double)best[c] / (double)budget, 1);
+    out.print("% of budget, x");
+    out.print((double)best[c] / (double)best[0], 2);
+    out.println(" classic 2x");
+  }
+
+  // table vs the exact solution, between the table points too
+  BigMuffEffect fx;
+  fx.prepare(FS, BLOCK);
+  const double T  = 1.0 / (2.0 * (double)FS);
+  const double a  = 1.0 / CLIP_RF + 2.0 * CLIP_C / T;
+  const double k  = 2.0 * DIODE_IS / (a * DIODE_NVT);
+  double worst = 0.0;
+  for (int i = 0; i < 4096; i++) {
+    double q = 0.01 * pow(1.0e6, (double)i / 4095.0); // 0.01 .. 1e4
+    double err = fabs((double)fx.clipLookup((float)q) - solveClip(q, k)) * DIODE_NVT;
+    if (err > worst) worst = err;
+  }
+  out.print("clip table max error: ");
+  out.print(worst * 1000.0, 3);
+  out.println(" mV");
 }
@@ -1,9 +1,21 @@
 #pragma once
 #include <Arduino.h>
 #include <stdint.h>
+#include "FxBase.h"
+#include "Adaa.h"
 
-class BigMuffEffect {
+class BigMuffEffect : public FxBase<BigMuffEffect> {
 public:
+  // **************************
+  // Model
+  // *****************
+  // CLASSIC: three atan stages with one-pole coupling HPs (cheap).
+  // CIRCUIT: the pedal's two diode-feedback clipping stages and passive
+  // tone stack. The diode equation is solved into a table in prepare(),
+  // the tone stack is a small nodal solve redone only when Tone moves,
+  // so the audio loop is lookups and multiply-adds.
+  enum Model : uint8_t { CLASSIC = 0, CIRCUIT = 1 };
+
   // **************************
   // Params
   // *****************
@@ -17,10 +29,50 @@ public:
   BigMuffEffect();
   void reset();
 
+  // switching resets the state
+  void  setModel(Model m);
+  Model model() const { return _model; }
+
+  // CLASSIC clip stages: OFF runs the 2x loop, ADAA1 / ADAA2 run once
+  // per sample with antiderivative anti-aliased atan stages
+  void       setAntiAlias(Adaa::Mode m);
+  Adaa::Mode antiAlias() const { return _aa; }
+
   // in-place mono (wet only)
   void processMonoWet(int16_t* mono, int n, float fs, const Params& p);
 
+  // in-place mono, CIRCUIT model at the prepare() rate
+  void processMonoCircuit(int16_t* mono, int n, const Params& p);
+
+  // Time a block of each model and print both; ticks() is a free
+  // running counter, budget is ticks per audio block. Also prints how
+  // far the clipper table strays from the exact diode solution.
+  static void benchmark(Print& out, uint32_t (*ticks)(), uint32_t budget);
+
+  // **************************
+  // Idle
+  // *****************
+  // true once the tail has decayed and the state is parked at zero.
+  // While silent, a block of zeros would come out as zeros with no
+  // state change, so it can be skipped entirely.
+  bool isSilent() const { return _silent; }
+
+  // **************************
+  // FxBase interface
+  // *****************
+  void prepare(float fs, int maxBlock);
+  void setParams(const Params& p) { _p = p; }
+  void process(int16_t* data, int n, const BlockAnalysis&) {
+    if (_model == CIRCUIT) processMonoCircuit(data, n, _p);
+    else                   processMonoWet(data, n, _fs, _p);
+  }
+
 private:
+  float  _fs = 44100.0f;
+  Params _p;
+  Model  _model = CLASSIC;
+  Adaa::Mode _aa = Adaa::OFF;
+
   // **************************
   // State
   // *****************
@@ -45,6 +97,40 @@ private:
   // 2x interp helper
   float _xPrev  = 0.0f;
 
+  // CLASSIC at 1x: atan stage histories, stage 1 parks at the bias
+  Adaa::Shaper<Adaa::Atan> _sat1, _sat2, _sat3;
+  float _biasU = 0.0f;
+
+  // CIRCUIT: trapezoid cap histories (the coupling caps use _hpN_lp)
+  float _fb1 = 0.0f; // stage 1 feedback cap
+  float _fb2 = 0.0f; // stage 2 feedback cap
+  float _ts1 = 0.0f; // tone stack LP cap
+  float _ts2 = 0.0f; // tone stack HP cap
+
+  // **************************
+  // Circuit tables
+  // *****************
+  // Clipping stage: v + Rf*2Is*sinh(v/nVt) = p, with the feedback cap
+  // folded into Rf by the trapezoid rule. v = nVt * S(p / (a*nVt)),
+  // S odd, stored for |q| on a warped axis u = N*|q|/(|q| + CLIP_Q1)
+  // so the flat top of the curve needs no more points than the knee.
+  static constexpr int   CLIP_N  = 256;
+  static constexpr float CLIP_Q1 = 160.0f;
+  float _clipS[CLIP_N + 1];
+  float _clipQ  = 0.0f; // 1 / (a * nVt)
+  float _clipV  = 0.0f; // nVt
+  float _clipG2 = 0.0f; // 2 * C / T, history update
+
+  // tone stack: node voltages as rows of [vs/R1 + ts1, Gc2*vs - ts2]
+  float _tsTone = -1.0f; // tone the rows were solved for
+  float _tsGc1  = 0.0f;
+  float _tsGc2  = 0.0f;
+  float _tsK[6];         // A, B, wiper
+
+  // idle detection
+  static constexpr float SILENT_THRESH = 1.0e-5f; // ~-100 dBFS
+  bool _silent = true;
+
   // **************************
   // Helpers
   // *****************
@@ -58,4 +144,11 @@ private:
 
   static float satAtan(float x, float k); // smooth sat
   static float softLimit(float x);        // safety
+
+  static double solveClip(double q, double k); // Newton, prepare only
+  float clipLookup(float q) const;
+  float clipStage(float iIn, float& hist) const;
+  void  solveToneStack(float tone);
+
+  bool tailDecayed() const;
 };
@@ -0,0 +1,100 @@
+#include "BlockAnalysis.h"
+#include <math.h>
+
+void InputAnalyzer::setSampleRate(float fs, int blockSize) {
+  if (fs <= 0.0f) fs = 44100.0f;
+  if (blockSize < 1) blockSize = 1;
+
+  // one-pole per block: 1 - e^(-T/tau)
+  float blockMs = 1000.0f * (float)blockSize / fs;
+  _atk  = 1.0f - expf(-blockMs / ENV_ATTACK_MS);
+  _rel  = 1.0f - expf(-blockMs / ENV_RELEASE_MS);
+  _slow = 1.0f - expf(-blockMs / SLOW_RMS_MS);
+}
+
+void InputAnalyzer::reset() {
+  _env = 0.0f;
+  _slowRms = 0.0f;
+  _armed = true;
+  _a = BlockAnalysis();
+}
+
+// Peak + sum of squares in one pass. On the M7 this runs two samples per
+// step with the DSP extension: SMLALD for the power, SSUB16/SEL for a
+// packed running max/min.
+void InputAnalyzer::peakAndPower(const int16_t* data, int n, int32_t& peak, uint64_t& sumSq) {
+  int i = 0;
+  uint64_t acc = 0;
+  int32_t hi = 0, lo = 0;
+
+#if defined(__ARM_FEATURE_DSP)
+  // audio blocks are word aligned
+  const uint32_t* p = (const uint32_t*)data;
+  uint32_t mx = 0, mn = 0; // packed lanes
+  for (; i + 1 < n; i += 2) {
+    uint32_t v = *p++;
+    uint32_t t;
+    __asm__("smlald %Q0, %R0, %1, %1" : "+r"(acc) : "r"(v));
+    // GE flags from ssub16 pick the lanes for sel, keep each pair together
+    __asm__("ssub16 %0, %2, %1\n\tsel %1, %2, %1" : "=&r"(t), "+r"(mx) : "r"(v));
+    __asm__("ssub16 %0, %1, %2\n\tsel %1, %2, %1" : "=&r"(t), "+r"(mn) : "r"(v));
+  }
+  int32_t mx0 = (int16_t)(mx & 0xFFFF), mx1 = (int16_t)(mx >> 16);
+  int32_t mn0 = (int16_t)(mn & 0xFFFF), mn1 = (int16_t)(mn >> 16);
+  hi = (mx0 > mx1) ? mx0 : mx1;
+  lo = (mn0 < mn1) ? mn0 : mn1;
+#endif
+
+  for (; i < n; i++) {
+    int32_t v = data[i];
+    acc += (uint64_t)(v * v);
+    if (v > hi) hi = v;
+    if (v < lo) lo = v;
+  }
+
+  peak  = (hi > -lo) ? hi : -lo;
+  sumSq = acc;
+}
+
+const BlockAnalysis& InputAnalyzer::process(const int16_t* data, int n) {
+  if (!data || n <= 0) return _a;
+
+  int32_t  pk = 0;
+  uint64_t sumSq = 0;
+  peakAndPower(data, n, pk, sumSq);
+
+  // **************************
+  // idle gate
+  // *****************
+  // only a hint that the DSP may be skipped: the audio is left alone,
+  // zeros are substituted by FxBase::run once the effect's tail is parked
+  _a.silent = (pk <= IDLE_GATE_LSB);
+
+  _a.peak = (float)pk / 32768.0f;
+  _a.rms  = sqrtf((float)sumSq / (float)n) / 32768.0f;
+
+  // **************************
+  // envelope (peak follower)
+  // *****************
+  _a.envStart = _env;
+  _env += ((_a.peak > _env) ? _atk : _rel) * (_a.peak - _env);
+  _a.envEnd = _env;
+
+  // **************************
+  // onset: rms jumps well over its slow average
+  // *****************
+  bool jump = (_a.rms > ONSET_MIN) && (_a.rms > ONSET_RATIO * _slowRms);
+  _a.onset = jump && _armed;
+  if (_a.onset) _armed = false;
+  else if (_a.rms < 1.2f * _slowRms) _armed = true;
+
+  _slowRms += _slow * (_a.rms - _slowRms);
+
+  // **************************
+  // gate (hysteresis)
+  // *****************
+  if (!_a.gate && _env > GATE_ON)  _a.gate = true;
+  if ( _a.gate && _env < GATE_OFF) _a.gate = false;
+
+  return _a;
+}
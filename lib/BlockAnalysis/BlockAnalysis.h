@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+
+// **************************
+// BlockAnalysis
+// *****************
+// Input dynamics measured once per audio block in FxStream and handed
+// read-only to any effect that wants them, so every effect sees the same
+// envelope / onset / gate instead of running its own follower.
+struct BlockAnalysis {
+  float peak     = 0.0f;  // block peak |x| (0..1)
+  float rms      = 0.0f;  // block RMS (0..1)
+
+  // peak envelope at the start and end of the block,
+  // effects ramp between them for a per-sample value
+  float envStart = 0.0f;
+  float envEnd   = 0.0f;
+
+  bool  onset    = false; // transient starts in this block
+  bool  gate     = false; // playing (hysteresis on the envelope)
+  bool  silent   = false; // under the idle gate, the DSP may be skipped
+
+  // linear per-sample step from envStart to envEnd over n samples
+  float envStep(int n) const { return (envEnd - envStart) / (float)n; }
+};
+
+// **************************
+// InputAnalyzer
+// *****************
+class InputAnalyzer {
+public:
+  void setSampleRate(float fs, int blockSize);
+  void reset();
+
+  // Measure one block. The block is not touched: a peak under the idle
+  // gate only marks it silent, see FxBase::run.
+  const BlockAnalysis& process(const int16_t* data, int n);
+
+  const BlockAnalysis& last() const { return _a; }
+
+private:
+  // **************************
+  // Tuning
+  // *****************
+  static constexpr int16_t IDLE_GATE_LSB  = 8;       // ~-72 dBFS, above codec hiss
+  static constexpr float   ENV_ATTACK_MS  = 1.0f;
+  static constexpr float   ENV_RELEASE_MS = 20.0f;
+  static constexpr float   SLOW_RMS_MS    = 120.0f;  // onset reference
+  static constexpr float   ONSET_RATIO    = 2.0f;    // rms jump over slow rms
+  static constexpr float   ONSET_MIN      = 0.010f;  // ignore onsets in the noise
+  static constexpr float   GATE_ON        = 0.012f;
+  static constexpr float   GATE_OFF       = 0.006f;
+
+  // per-block smoothing coefs (set from fs + block size)
+  float _atk  = 0.9f;
+  float _rel  = 0.14f;
+  float _slow = 0.02f;
+
+  float _env     = 0.0f;
+  float _slowRms = 0.0f;
+  bool  _armed   = true; // onset re-arms once rms falls back
+
+  BlockAnalysis _a;
+
+  static void peakAndPower(const int16_t* data, int n, int32_t& peak, uint64_t& sumSq);
+};
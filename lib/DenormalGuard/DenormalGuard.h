@@ -0,0 +1,58 @@
+#pragma once
+#include <stdint.h>
+
+#if defined(__SSE__) || defined(__x86_64__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+
+// **************************
+// ScopedFlushToZero
+// *****************
+// Reverb / filter feedback decays toward zero and ends up in subnormal
+// floats, which are very slow on x86 and depend on FPSCR on the M7.
+// Hold one of these around DSP work to flush them to zero:
+//   - Cortex-M7: FPSCR.FZ (bit 24). Handlers start from FPDSCR, not the
+//     FPSCR loop() sees, so set it inside the audio interrupt.
+//   - x86 (host): MXCSR FTZ (bit 15) + DAZ (bit 6)
+// Previous mode is restored on scope exit. on = false clears the bits
+// instead, for host A/B runs.
+class ScopedFlushToZero {
+public:
+  explicit ScopedFlushToZero(bool on = true) {
+    _saved = readMode();
+    writeMode(on ? (_saved | FTZ_BITS) : (_saved & ~FTZ_BITS));
+  }
+
+  ~ScopedFlushToZero() { writeMode(_saved); }
+
+  ScopedFlushToZero(const ScopedFlushToZero&) = delete;
+  ScopedFlushToZero& operator=(const ScopedFlushToZero&) = delete;
+
+private:
+#if defined(__ARM_FP)
+  static constexpr uint32_t FTZ_BITS = (1u << 24);
+
+  static uint32_t readMode() {
+    uint32_t r;
+    __asm__ volatile("vmrs %0, fpscr" : "=r"(r));
+    return r;
+  }
+
+  static void writeMode(uint32_t r) {
+    __asm__ volatile("vmsr fpscr, %0" : : "r"(r));
+  }
+#elif defined(__SSE__) || defined(__x86_64__) || defined(_M_X64)
+  static constexpr uint32_t FTZ_BITS = 0x8040u;
+
+  static uint32_t readMode() { return _mm_getcsr(); }
+  static void writeMode(uint32_t r) { _mm_setcsr(r); }
+#else
+  // no FPU mode bits to touch
+  static constexpr uint32_t FTZ_BITS = 0u;
+
+  static uint32_t readMode() { return 0u; }
+  static void writeMode(uint32_t) {}
+#endif
+
+  uint32_t _saved = 0;
+};
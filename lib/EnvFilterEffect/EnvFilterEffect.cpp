@@ -0,0 +1,210 @@
+#include "EnvFilterEffect.h"
+#include "Trace.h"
+#include <math.h>
+#include <string.h>
+
+static constexpr float PI_F = 3.14159265f;
+static constexpr float NYQ_GUARD = 0.45f; // table tops out under fs/2
+
+EnvFilterEffect::EnvFilterEffect() {
+  prepare(44100.0f, 128);
+  reset();
+}
+
+void EnvFilterEffect::prepare(float fs, int maxBlock) {
+  (void)maxBlock;
+  _fs = (fs > 0.0f) ? fs : 44100.0f;
+
+  for (int i = 0; i <= G_STEPS; i++) {
+    float fc = cutoffHz((float)i / (float)G_STEPS);
+    if (fc > NYQ_GUARD * _fs) fc = NYQ_GUARD * _fs;
+    _g[i] = tanf(PI_F * fc / _fs);
+  }
+
+  _atk = 1.0f - expf(-1000.0f / (ATTACK_MS * _fs));
+  _relMs = -1.0f; // redo the release at the new rate
+}
+
+void EnvFilterEffect::reset() {
+  _svf.reset();
+  _ctrl = 0.0f;
+  _silent = true;
+}
+
+float EnvFilterEffect::clamp01(float x) {
+  if (!(x > 0.0f)) return 0.0f; // NaN -> 0
+  if (x > 1.0f) return 1.0f;
+  return x;
+}
+
+float EnvFilterEffect::cutoffHz(float pos) {
+  return MIN_HZ * powf(MAX_HZ / MIN_HZ, clamp01(pos));
+}
+
+float EnvFilterEffect::gAt(float pos) const {
+  const float f = clamp01(pos) * (float)G_STEPS;
+  int i = (int)f;
+  if (i >= G_STEPS) i = G_STEPS - 1;
+  const float t = f - (float)i;
+  return _g[i] + t * (_g[i + 1] - _g[i]);
+}
+
+void EnvFilterEffect::process(int16_t* data, int n, const BlockAnalysis& an) {
+  FX_TRACE("EnvFilter");
+  if (n <= 0) return;
+
+  // **************************
+  // per block
+  // *****************
+  float q = _p.q;
+  if (!(q >= MIN_Q)) q = MIN_Q; // NaN too
+  if (q > MAX_Q) q = MAX_Q;
+  const float k = 1.0f / q;
+
+  // the resonant peak is Q times the input, trim it back to sqrt(Q)
+  const float trim = (q > 1.0f) ? 1.0f / sqrtf(q) : 1.0f;
+  const float cLp = (_p.type == LOWPASS)  ? trim : 0.0f;
+  const float cBp = (_p.type == BANDPASS) ? trim : 0.0f;
+  const float cHp = (_p.type == HIGHPASS) ? trim : 0.0f;
+
+  float sens = _p.sens;
+  if (!(sens > 0.0f)) sens = 0.0f;
+  if (sens > 1000.0f) sens = 1000.0f;
+  const float start = clamp01(_p.start);
+  float depth = (_p.depth == _p.depth) ? _p.depth : 0.0f; // NaN -> 0
+  if (depth < -1.0f) depth = -1.0f;
+  if (depth > 1.0f) depth = 1.0f;
+
+  float decayMs = _p.decayMs;
+  if (!(decayMs >= 5.0f)) decayMs = 5.0f;
+  if (decayMs > 5000.0f) decayMs = 5000.0f;
+  if (decayMs != _relMs) {
+    _relMs = decayMs;
+    _rel = 1.0f - expf(-1000.0f / (decayMs * _fs));
+  }
+
+  // **************************
+  // per sample
+  // *****************
+  const float atk = _atk, rel = _rel;
+  float env = an.envStart;
+  const float envStep = an.envStep(n);
+  float ctrl = _ctrl;
+  Svf svf = _svf;
+  bool quietIn = true;
+
+  for (int i = 0; i < n; i++) {
+    float target = sens * env;
+    env += envStep;
+    if (target > 1.0f) target = 1.0f;
+    if (!(target > 0.0f)) target = 0.0f;
+    ctrl += ((target > ctrl) ? atk : rel) * (target - ctrl);
+
+    const float g = gAt(start + depth * ctrl);
+
+    const int16_t s = data[i];
+    if (s != 0) quietIn = false;
+
+    float lp, bp, hp;
+    svf.tick((float)s * (1.0f / 32768.0f), g, k, lp, bp, hp);
+    const float y = cLp * lp + cBp * bp + cHp * hp;
+
+    int32_t out = (int32_t)(y * 32767.0f);
+    if (out > 32767) out = 32767;
+    else if (out < -32768) out = -32768;
+    data[i] = (int16_t)out;
+  }
+
+  _svf = svf;
+  _ctrl = ctrl;
+
+  // **************************
+  // tail flush
+  // *****************
+  // rung out and the sweep back at rest: park at exact zero
+  if (!quietIn) {
+    _silent = false;
+  } else if (!_silent && fabsf(_svf.ic1) < SILENT_THRESH && fabsf(_svf.ic2) < SILENT_THRESH &&
+             _ctrl < SILENT_THRESH) {
+    reset();
+  }
+}
+
+// **************************
+// Benchmark
+// *****************
+void EnvFilterEffect::benchmark(Print& out, uint32_t (*ticks)(), uint32_t budget) {
+  static constexpr int BLOCK = 128;
+  static constexpr int RUNS  = 8;
+  static constexpr int CASES = 5;
+
+  int16_t in[BLOCK], buf[BLOCK];
+  float pos[BLOCK];
+  for (int i = 0; i < BLOCK; i++) {
+    in[i]  = (int16_t)(12000.0f * sinf(0.0623f * (float)i));
+    pos[i] = 0.5f + 0.45f * sinf(2.0f * PI_F * (float)i / 32.0f); // sweep every 32 samples
+  }
+
+  static const char* NAMES[CASES] = {
+    "one-pole, expf per sample", "svf, tanf per sample", "svf, table per sample",
+    "svf, fixed cutoff", "effect block",
+  };
+
+  EnvFilterEffect fx;
+  Params p;
+  p.q = 8.0f;
+  fx.setParams(p);
+  BlockAnalysis an;
+  an.envStart = 0.0f;
+  an.envEnd   = 1.0f;
+
+  const float fs = fx._fs;
+  const float lnRange = logf(MAX_HZ / MIN_HZ);
+  const float k = 1.0f / p.q;
+
+  for (int c = 0; c < CASES; c++) {
+    uint32_t best = 0xffffffffu;
+    for (int r = 0; r < RUNS; r++) {
+      memcpy(buf, in, sizeof(buf));
+      Svf svf;
+      float y1 = 0.0f;
+      const float gFixed = fx.gAt(0.5f);
+
+      uint32_t t0 = ticks();
+      if (c == 4) {
+        fx.process(buf, BLOCK, an);
+      } else {
+        for (int i = 0; i < BLOCK; i++) {
+          const float x = (float)buf[i] * (1.0f / 32768.0f);
+          float y, lp, bp, hp;
+          if (c == 0) {
+            const float fc = MIN_HZ * expf(pos[i] * lnRange);
+            const float a = expf(-2.0f * PI_F * fc / fs);
+            y1 = (1.0f - a) * x + a * y1;
+            y = y1;
+          } else {
+            float g;
+            if (c == 1)      g = tanf(PI_F * MIN_HZ * expf(pos[i] * lnRange) / fs);
+            else if (c == 2) g = fx.gAt(pos[i]);
+            else             g = gFixed;
+            svf.tick(x, g, k, lp, bp, hp);
+            y = k * bp; // unity at the peak
+          }
+          buf[i] = (int16_t)(y * 32767.0f);
+        }
+      }
+      uint32_t dt = ticks() - t0;
+      if (dt < best) best = dt;
+    }
+
+    out.print("envf ");
+    out.print(NAMES[c]);
+    out.print(": ");
+    out.print((unsigned long)best);
+    out.print(" ticks/block, ");
+    out.print((double)best / (double)BLOCK, 2);
+    out.print(" ticks/sample, ");
+    out.print(100.0 * (double)best / (double)budget, 2);
+    out.println("% of budget");
+  }
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include "FxBase.h"
+
+// **************************
+// EnvFilterEffect
+// *****************
+// Envelope filter (auto-wah): a resonant state variable filter whose
+// cutoff follows the playing level.
+//
+// The filter is the trapezoidal (TPT, zero-delay feedback) SVF: two
+// integrators that keep their state as 2x the capacitor current, LP / BP
+// / HP out of one update. It stays stable and click free with the cutoff
+// moving every sample, which the one-poles elsewhere don't (their
+// coefficient alone is an expf), so the sweep here runs at audio rate.
+//
+// Cutoff -> g = tan(pi fc / fs) is a table over the log sweep range,
+// built in prepare(). Per sample that's a lerp and one divide.
+//
+// The level is the shared BlockAnalysis envelope, ramped per sample, with
+// a release of its own on top so the filter falls back like a wah pedal.
+class EnvFilterEffect : public FxBase<EnvFilterEffect> {
+public:
+  enum Type : uint8_t { LOWPASS = 0, BANDPASS, HIGHPASS };
+
+  // sweep range, position 0..1 is log between these
+  static constexpr float MIN_HZ = 40.0f;
+  static constexpr float MAX_HZ = 4000.0f;
+
+  static constexpr float MIN_Q = 0.5f;
+  static constexpr float MAX_Q = 25.0f;
+
+  // **************************
+  // Params
+  // *****************
+  struct Params {
+    float sens    = 3.0f;   // envelope gain, 1 = full scale opens it fully
+    float start   = 0.2f;   // sweep position with no signal, 0..1
+    float depth   = 0.75f;  // sweep at full envelope, -1..1 (down / up)
+    float q       = 4.0f;   // resonance
+    float decayMs = 150.0f; // fall back time
+    Type  type    = BANDPASS;
+  };
+
+  // **************************
+  // Svf
+  // *****************
+  // One TPT SVF, g = tan(pi fc / fs) and k = 1 / Q given every sample.
+  struct Svf {
+    float ic1 = 0.0f, ic2 = 0.0f;
+
+    void reset() { ic1 = ic2 = 0.0f; }
+
+    void tick(float x, float g, float k, float& lp, float& bp, float& hp) {
+      const float a1 = 1.0f / (1.0f + g * (g + k));
+      const float a2 = g * a1;
+      const float a3 = g * a2;
+      const float v3 = x - ic2;
+      const float v1 = a1 * ic1 + a2 * v3;
+      const float v2 = ic2 + a2 * ic1 + a3 * v3;
+      ic1 = 2.0f * v1 - ic1;
+      ic2 = 2.0f * v2 - ic2;
+      lp = v2;
+      bp = v1;
+      hp = x - k * v1 - v2;
+    }
+  };
+
+  EnvFilterEffect();
+  void reset();
+
+  // sweep position 0..1 -> g (table) and -> Hz (exact)
+  float gAt(float pos) const;
+  static float cutoffHz(float pos);
+
+  // Time a block with the cutoff moving every sample: one-pole with an
+  // expf per sample, the SVF with tanf per sample, the SVF on the table,
+  // the SVF at a fixed cutoff, and the whole effect. ticks() is a free
+  // running counter, budget is ticks per audio block.
+  static void benchmark(Print& out, uint32_t (*ticks)(), uint32_t budget);
+
+  // true once the filter has rung out and is parked at zero
+  bool isSilent() const { return _silent; }
+
+  // **************************
+  // FxBase interface
+  // *****************
+  void prepare(float fs, int maxBlock);
+  void setParams(const Params& p) { _p = p; }
+  void process(int16_t* data, int n, const BlockAnalysis& an);
+
+private:
+  static constexpr int   G_STEPS       = 128;    // table intervals
+  static constexpr float ATTACK_MS     = 2.0f;   // on top of the analyzer's
+  static constexpr float SILENT_THRESH = 1.0e-5f;
+
+  float  _fs = 44100.0f;
+  Params _p;
+
+  float _g[G_STEPS + 1];
+  float _atk = 0.01f;
+
+  // release coefficient, redone when decayMs moves
+  float _rel = 0.0004f;
+  float _relMs = -1.0f;
+
+  // **************************
+  // State
+  // *****************
+  Svf   _svf;
+  float _ctrl = 0.0f; // smoothed envelope, 0..1
+  bool  _silent = true;
+
+  static float clamp01(float x);
+};
@@ -0,0 +1,103 @@
+#include "FlightRecorder.h"
+#include <string.h>
+
+static_assert(sizeof(FlightRecorder::Header) == 32, "dump header layout");
+static_assert(sizeof(FlightRecorder::Frame) == 20 + 2 * FlightRecorder::BLOCK, "dump frame layout");
+
+// one recorder, ring lives in OCRAM (~17 KB)
+static DMAMEM FlightRecorder::Frame ring[FlightRecorder::FRAMES];
+
+uint16_t FlightRecorder::knob16(float k) {
+  if (k <= 0.0f) return 0;
+  if (k >= 1.0f) return 65535;
+  return (uint16_t)(k * 65535.0f + 0.5f);
+}
+
+void FlightRecorder::capture(const int16_t* in, uint8_t mode, float vol, float k2, float k3, float k4, float k5) {
+  if (_frozen) return;
+
+  Frame& f = ring[_head];
+  f.seq      = _seq;
+  f.cycles   = 0;
+  f.mode     = mode;
+  f.flags    = 0;
+  f.knobs[0] = knob16(vol);
+  f.knobs[1] = knob16(k2);
+  f.knobs[2] = knob16(k3);
+  f.knobs[3] = knob16(k4);
+  f.knobs[4] = knob16(k5);
+  memcpy(f.input, in, sizeof(f.input));
+}
+
+void FlightRecorder::commit(uint32_t cycles, bool clipped) {
+  if (_frozen) return;
+
+  Frame& f = ring[_head];
+  f.cycles = cycles;
+  if (cycles > _deadline) f.flags |= DEADLINE;
+  if (clipped)            f.flags |= CLIPPED;
+
+  if (++_head >= FRAMES) _head = 0;
+  if (_count < FRAMES) _count++;
+  _seq++;
+
+  // a latched reason re-arms after HOLDOFF_FRAMES blocks without it
+  if (_latched) {
+    if (f.flags & _latched) _clear = 0;
+    else if (++_clear >= HOLDOFF_FRAMES) _latched = 0;
+  }
+
+  // first new event arms, then keep a few blocks of aftermath
+  const uint8_t fresh = f.flags & ~_latched;
+  if (!_triggered && fresh) {
+    _triggered  = true;
+    _post       = POST_FRAMES;
+    _triggerSeq = f.seq;
+    _reason     = fresh;
+    _latched   |= fresh;
+    _clear      = 0;
+    return;
+  }
+
+  if (_triggered && --_post <= 0) {
+    __atomic_store_n(&_frozen, (uint8_t)1, __ATOMIC_RELEASE);
+  }
+}
+
+bool FlightRecorder::drain(Print& out, int maxFrames) {
+  if (!frozen()) return true;
+
+  if (_drained < 0) {
+    writeHeader(out);
+    _drained = 0;
+  }
+
+  // oldest first
+  const int start = (_head - _count + FRAMES) % FRAMES;
+  for (int n = 0; n < maxFrames && _drained < _count; n++, _drained++) {
+    out.write((const uint8_t*)&ring[(start + _drained) % FRAMES], sizeof(Frame));
+  }
+  if (_drained < _count) return false;
+
+  // re-arm with an empty history
+  _drained = -1;
+  _count = 0;
+  _triggered = false;
+  __atomic_store_n(&_frozen, (uint8_t)0, __ATOMIC_RELEASE);
+  return true;
+}
+
+void FlightRecorder::writeHeader(Print& out) const {
+  Header h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, "FXFR", 4);
+  h.version        = 1;
+  h.headerBytes    = sizeof(Header);
+  h.frames         = (uint16_t)_count;
+  h.blockSamples   = BLOCK;
+  h.sampleRate     = _fs;
+  h.deadlineCycles = _deadline;
+  h.triggerSeq     = _triggerSeq;
+  h.reason         = _reason;
+  out.write((const uint8_t*)&h, sizeof(h));
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+
+// **************************
+// FlightRecorder
+// *****************
+// Keeps the last FRAMES audio blocks (raw input, knobs, mode, cycles)
+// in a ring. A deadline miss or clipped output arms a trigger, POST_FRAMES
+// more blocks are kept, then the ring freezes until loop() drains it.
+// A reason that triggered stays latched until HOLDOFF_FRAMES blocks in a
+// row go by without it, so a take that keeps clipping leaves one dump,
+// not one every few hundred ms. Frames still carry every flag.
+//
+// Single producer (audio interrupt) / single consumer (loop()):
+//   - capture() / commit() only run while the ring is live
+//   - drain() only runs while it is frozen
+// so the frozen flag is the only thing the two sides share.
+// Per block the interrupt pays one 256 byte memcpy and a few stores.
+//
+// Dump format (little endian, packed):
+//   Header  'FXFR' u16 version u16 headerBytes u16 frames u16 blockSamples
+//           f32 sampleRate u32 deadlineCycles u32 triggerSeq u8 reason u8[7] pad
+//   Frame   u32 seq u32 cycles u8 mode u8 flags u16 knobs[5] (vol,k2..k5, 0..65535)
+//           i16 input[blockSamples]  (before the idle gate)
+// Frames are written oldest first. tools/fr_decode.py turns a dump
+// into a WAV + CSV for replay.
+class FlightRecorder {
+public:
+  static constexpr int BLOCK       = 128; // = AUDIO_BLOCK_SAMPLES
+  static constexpr int FRAMES      = 64;  // ~186 ms of history
+  static constexpr int POST_FRAMES = 8;   // kept after the trigger
+  static constexpr int HOLDOFF_FRAMES = 3445; // ~10 s clear before a reason re-arms
+
+  enum Flags : uint8_t {
+    DEADLINE = 0x01, // update() ran past the deadline
+    CLIPPED  = 0x02, // output hit full scale
+  };
+
+  struct Header {
+    char     magic[4];
+    uint16_t version;
+    uint16_t headerBytes;
+    uint16_t frames;
+    uint16_t blockSamples;
+    float    sampleRate;
+    uint32_t deadlineCycles;
+    uint32_t triggerSeq;
+    uint8_t  reason;
+    uint8_t  pad[7];
+  };
+
+  struct Frame {
+    uint32_t seq;
+    uint32_t cycles;
+    uint8_t  mode;
+    uint8_t  flags;
+    uint16_t knobs[5];
+    int16_t  input[BLOCK];
+  };
+
+  void setSampleRate(float fs) { _fs = fs; }
+  void setDeadline(uint32_t cycles) { _deadline = cycles; }
+
+  // cycle counter (DWT on the M7, 0 on host)
+  static inline uint32_t cycles() {
+#if defined(__IMXRT1062__)
+    return ARM_DWT_CYCCNT;
+#else
+    return 0;
+#endif
+  }
+
+  // **************************
+  // Interrupt side
+  // *****************
+  // start of update(): raw input + controls
+  void capture(const int16_t* in, uint8_t mode, float vol, float k2, float k3, float k4, float k5);
+
+  // end of update(): cost of the block and whether it clipped
+  void commit(uint32_t cycles, bool clipped);
+
+  // **************************
+  // loop() side
+  // *****************
+  bool frozen() const { return __atomic_load_n(&_frozen, __ATOMIC_ACQUIRE) != 0; }
+
+  // Write up to maxFrames more frames of the dump (the header goes out
+  // with the first call). True once it's all out and the ring re-armed,
+  // so loop() can spread a dump over several passes.
+  bool drain(Print& out, int maxFrames = FRAMES);
+
+private:
+  uint32_t _seq = 0;
+  int      _head = 0;  // slot capture() fills next
+  int      _count = 0; // valid frames in the ring
+
+  uint8_t  _frozen = 0;
+  bool     _triggered = false;
+  int      _post = 0;
+  uint32_t _triggerSeq = 0;
+  uint8_t  _reason = 0;
+
+  uint8_t  _latched = 0; // reasons that can't trigger yet
+  int      _clear = 0;   // blocks in a row without a latched reason
+
+  int      _drained = -1; // frames written by drain(), -1 before the header
+
+  float    _fs = 44100.0f;
+  uint32_t _deadline = 0xFFFFFFFFu;
+
+  static uint16_t knob16(float k);
+  void writeHeader(Print& out) const;
+};
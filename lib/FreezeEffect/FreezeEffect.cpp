@@ -0,0 +1,170 @@
+#include "FreezeEffect.h"
+#include "Trace.h"
+#include <math.h>
+#include <string.h>
+
+// frames of silence that flush everything still in the overlap-add
+static constexpr int DRAIN_FRAMES = FreezeEffect::FFT_N / FreezeEffect::HOP + 2;
+
+// **************************
+// Phase table
+// *****************
+static constexpr int PHASES = 256;
+
+struct UnitCircle {
+  float c[PHASES];
+  float s[PHASES];
+};
+
+static constexpr UnitCircle makeCircle() {
+  UnitCircle u{};
+  for (int i = 0; i < PHASES; i++) {
+    u.c[i] = (float)Stft::cx::cos(2.0 * Stft::cx::PI * i / PHASES);
+    u.s[i] = (float)Stft::cx::sin(2.0 * Stft::cx::PI * i / PHASES);
+  }
+  return u;
+}
+
+static constexpr UnitCircle CIRCLE = makeCircle();
+
+FreezeEffect::FreezeEffect() {
+  prepare(44100.0f, BLOCK);
+  reset();
+}
+
+void FreezeEffect::prepare(float fs, int maxBlock) {
+  (void)maxBlock;
+  _fs = (fs > 0.0f) ? fs : 44100.0f;
+  _glide = -1.0f; // redo the coefficients at the new rate
+}
+
+void FreezeEffect::reset() {
+  _stft.reset();
+  memset(_target, 0, sizeof(_target));
+  memset(_held, 0, sizeof(_held));
+  _wasHold = false;
+  _capture = false;
+  _onsetIn = 0;
+  _frameCapture = false;
+  _frameHold = false;
+  _frameMax = 0.0f;
+  _zeroFrames = DRAIN_FRAMES;
+  _rng = RNG_SEED;
+  _silent = true;
+}
+
+// **************************
+// Stft client
+// *****************
+void FreezeEffect::beginFrame() {
+  // the last frame held nothing: one more frame of zeros through the OLA
+  if (!_frameHold && _frameMax == 0.0f) {
+    if (_zeroFrames < DRAIN_FRAMES) _zeroFrames++;
+  } else {
+    _zeroFrames = 0;
+  }
+
+  _frameCapture = _capture;
+  _capture = false;
+  if (_onsetIn > 0 && --_onsetIn == 0) _frameCapture = true;
+
+  _frameHold = _p.hold;
+  _frameA = _frameHold ? _aCapture : _aRelease;
+  _frameMax = 0.0f;
+}
+
+void FreezeEffect::spectrum(float* X, int k0, int k1) {
+  const float a = _frameA;
+  const bool capture = _frameCapture, hold = _frameHold;
+  uint32_t rng = _rng;
+  float peak = _frameMax;
+
+  for (int k = k0; k < k1; k++) {
+    // DC and Nyquist carry nothing a guitar needs
+    if (k == 0 || k == FFT_N / 2) {
+      X[(k == 0) ? 0 : 1] = 0.0f;
+      continue;
+    }
+
+    float* b = X + 2 * k;
+    if (capture) _target[k] = sqrtf(b[0] * b[0] + b[1] * b[1]);
+
+    float h = _held[k];
+    h += a * ((hold ? _target[k] : 0.0f) - h);
+    if (!hold && h < MAG_FLOOR) h = 0.0f;
+    _held[k] = h;
+    if (h > peak) peak = h;
+
+    // nothing held: no phase drawn, so a parked layer's state stays put
+    if (h == 0.0f) {
+      b[0] = b[1] = 0.0f;
+      continue;
+    }
+
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    const int ph = (int)(rng >> 24);
+    b[0] = h * CIRCLE.c[ph];
+    b[1] = h * CIRCLE.s[ph];
+  }
+
+  _rng = rng;
+  _frameMax = peak;
+}
+
+// **************************
+// Process
+// *****************
+void FreezeEffect::process(int16_t* data, int n, const BlockAnalysis& an) {
+  FX_TRACE("Freeze");
+  if (n != BLOCK) return; // whole blocks only
+
+  // **************************
+  // per block
+  // *****************
+  float glide = _p.glide;
+  if (!(glide > 0.0f)) glide = 0.0f; // NaN too
+  if (glide > 1.0f) glide = 1.0f;
+  if (glide != _glide) {
+    _glide = glide;
+    const float hopS = (float)HOP / _fs;
+    _aCapture = 1.0f - expf(-1000.0f * hopS / (CAPTURE_MS + CAPTURE_GLIDE_MS * glide));
+    _aRelease = 1.0f - expf(-1000.0f * hopS / (RELEASE_MS + RELEASE_GLIDE_MS * glide));
+  }
+
+  float level = _p.level;
+  if (!(level > 0.0f)) level = 0.0f;
+  if (level > 1.0f) level = 1.0f;
+  const float gain = level * 32767.0f;
+
+  if (_p.hold && !_wasHold) _capture = true;
+  _wasHold = _p.hold;
+  if (_p.hold && _p.retrigger && an.onset) _onsetIn = ONSET_FRAMES;
+
+  // **************************
+  // per sample
+  // *****************
+  _stft.process(data, _wet, *this);
+
+  bool quietIn = true;
+  for (int i = 0; i < BLOCK; i++) {
+    const int16_t s = data[i];
+    if (s != 0) quietIn = false;
+
+    int32_t out = (int32_t)s + (int32_t)(_wet[i] * gain);
+    if (out > 32767) out = 32767;
+    else if (out < -32768) out = -32768;
+    data[i] = (int16_t)out;
+  }
+
+  // **************************
+  // tail flush
+  // *****************
+  // layer faded and drained: park with the rings cleared
+  if (!quietIn) {
+    _silent = false;
+  } else if (!_silent && !_p.hold && _zeroFrames >= DRAIN_FRAMES) {
+    reset();
+  }
+}
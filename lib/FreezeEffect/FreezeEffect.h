@@ -0,0 +1,99 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include "FxBase.h"
+#include "Stft.h"
+
+// **************************
+// FreezeEffect
+// *****************
+// Spectral freeze, the first Stft client. Hold captures the magnitude
+// spectrum of the newest frame; every frame after that resynthesises
+// those magnitudes with fresh random phases, so the note sustains as a
+// steady wash instead of looping. The dry signal passes on top as is.
+//
+// A new capture (hold again, or each onset with retrigger on) glides in
+// over the glide time; letting go of hold fades the layer out.
+//
+// Phases come from a constexpr unit circle table indexed by a xorshift,
+// so a bin costs a sqrtf (capture frames only) and two multiplies.
+class FreezeEffect : public FxBase<FreezeEffect> {
+public:
+  static constexpr int FFT_N = 1024; // 23 ms frames, 43 Hz bins
+  static constexpr int HOP   = 256;  // 4x overlap, a frame every 2 blocks
+  using Engine = Stft::Engine<FFT_N, HOP>;
+  static constexpr int BLOCK = Engine::BLOCK;
+
+  // **************************
+  // Params
+  // *****************
+  struct Params {
+    float level     = 0.8f;  // frozen layer, 0..1
+    float glide     = 0.2f;  // capture crossfade / release time, 0..1
+    bool  hold      = false; // capture on the rising edge, fade when released
+    bool  retrigger = false; // while holding, recapture after each onset
+  };
+
+  FreezeEffect();
+  void reset();
+
+  // true once the layer has faded and the overlap-add is drained; not
+  // while hold is down, its rising edge has to be seen where it happens
+  bool isSilent() const { return _silent && !_p.hold; }
+  void idle(int n) { (void)n; _stft.idle(); }
+
+  // **************************
+  // FxBase interface
+  // *****************
+  void prepare(float fs, int maxBlock);
+  void setParams(const Params& p) { _p = p; }
+  void process(int16_t* data, int n, const BlockAnalysis& an);
+
+private:
+  friend Engine;
+
+  static constexpr int   BINS         = Engine::BINS;
+  static constexpr int   ONSET_FRAMES = 2;       // capture past the attack
+  static constexpr float MAG_FLOOR    = 1.0e-3f; // fading bins snap to zero, < 1 LSB summed
+  static constexpr uint32_t RNG_SEED = 0x9e3779b9u;
+
+  // time constants at glide 0, and what glide 1 adds
+  static constexpr float CAPTURE_MS       = 10.0f;
+  static constexpr float RELEASE_MS       = 200.0f;
+  static constexpr float CAPTURE_GLIDE_MS = 3000.0f;
+  static constexpr float RELEASE_GLIDE_MS = 1000.0f;
+
+  // Stft client
+  void beginFrame();
+  void spectrum(float* X, int k0, int k1);
+
+  float  _fs = 44100.0f;
+  Params _p;
+
+  // per frame coefficients, redone when glide moves
+  float _aCapture = 1.0f;
+  float _aRelease = 0.1f;
+  float _glide = -1.0f;
+
+  // **************************
+  // State
+  // *****************
+  Engine _stft;
+  float  _target[BINS]; // captured magnitudes
+  float  _held[BINS];   // what is playing, gliding to _target (or 0)
+  float  _wet[BLOCK];
+
+  bool     _wasHold = false;
+  bool     _capture = false; // next frame captures
+  int      _onsetIn = 0;     // frames until an onset capture
+  uint32_t _rng = RNG_SEED;
+
+  // the frame in flight
+  bool  _frameCapture = false;
+  bool  _frameHold = false;
+  float _frameA = 0.0f;
+  float _frameMax = 0.0f;
+
+  int  _zeroFrames = 0; // frames in a row with nothing held
+  bool _silent = true;
+};
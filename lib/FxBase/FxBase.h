@@ -0,0 +1,61 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "BlockAnalysis.h"
+
+// **************************
+// FxBase
+// *****************
+// Common effect interface, resolved at compile time (CRTP). Every
+// effect derives as `class Foo : public FxBase<Foo>` and provides:
+//
+//   struct Params                          knob-level parameters
+//   void prepare(float fs, int maxBlock)   before the first block
+//   void setParams(const Params& p)        once per block, before process
+//   void process(int16_t* data, int n, const BlockAnalysis& an)   in place
+//   bool isSilent() const                  tail parked at zero (pass-through
+//                                          effects: false, see run())
+//   void reset()
+//
+// and may override the defaults below (idle, latency, memoryBytes).
+// run() wraps process() in the idle-skip rule used by FxStream, so a
+// dispatch table, chain or benchmark can drive any effect the same way
+// without a virtual call.
+template <class Derived>
+class FxBase {
+public:
+  // input under the idle gate with the tail parked => keep time moving,
+  // skip the DSP and put out the silence it would have settled to. The
+  // zeros only replace the block here, never ahead of the effect, so a
+  // tail still ringing (or a pass-through that never parks) keeps the
+  // quiet input as it is.
+  void run(int16_t* data, int n, const BlockAnalysis& an, bool& silent) {
+    Derived& d = self();
+    if (silent && d.isSilent()) {
+      d.idle(n);
+      memset(data, 0, (size_t)n * sizeof(int16_t));
+      return;
+    }
+    d.process(data, n, an);
+    silent = false;
+  }
+
+  // **************************
+  // Defaults
+  // *****************
+  // nothing moves while silent
+  void idle(int n) { (void)n; }
+
+  // samples the output lags the input
+  int latency() const { return 0; }
+
+  // state + buffers; effects with file-scope buffers add them
+  size_t memoryBytes() const { return sizeof(Derived); }
+
+protected:
+  FxBase() = default;
+
+private:
+  Derived& self() { return *static_cast<Derived*>(this); }
+};
@@ -0,0 +1,96 @@
+#pragma once
+#include <stdint.h>
+
+// **************************
+// LazyLine
+// *****************
+// Delay line storage that is cleared by forgetting, not by memset.
+//
+// A mark remembers where the write head was at the last clear (origin)
+// and how many slots have been written since, in ring order. Slots past
+// that are unwritten and read as zero, so clear() is O(1) and a fresh
+// line costs nothing at boot. Once the head has gone all the way round
+// the count saturates and reads go straight to the buffer.
+//
+// Writes are expected at the head (origin + written); one further ahead
+// zeroes the skipped slots first, so any order stays correct. Effects
+// that move the head without writing while idle re-anchor with
+// clear(head) instead, the line being all zero there anyway.
+namespace Lazy {
+
+class Mark {
+public:
+  // slots in the ring, 1..capacity
+  void setLength(int len) { _len = (len < 1) ? 1 : len; clear(0); }
+  int  length() const { return _len; }
+
+  void clear(int head = 0) {
+    _origin  = (head >= 0 && head < _len) ? head : 0;
+    _written = 0;
+  }
+
+  bool full() const { return _written >= _len; }
+  int  written() const { return _written; }
+
+  // slot i was written since the last clear
+  bool valid(int i) const {
+    if (_written >= _len) return true;
+    int off = i - _origin;
+    if (off < 0) off += _len;
+    return off < _written;
+  }
+
+  // slot i is about to be written; returns how many slots before it
+  // were skipped, the caller zeroes slot(from + k) for k < that
+  int advance(int i, int& from) {
+    int off = i - _origin;
+    if (off < 0) off += _len;
+    from = _written;
+    if (off < _written) return 0;
+    _written = off + 1;
+    return off - from;
+  }
+
+  // ring index of the k-th slot after the origin
+  int slot(int k) const {
+    int j = _origin + k;
+    return (j >= _len) ? j - _len : j;
+  }
+
+private:
+  int _len     = 1;
+  int _origin  = 0;
+  int _written = 0;
+};
+
+// N slots of T, the ring wraps at length() (N unless set shorter)
+template <class T, int N>
+class Line {
+public:
+  static constexpr int CAPACITY = N;
+
+  Line() { _m.setLength(N); }
+
+  void setLength(int len) { _m.setLength(len > N ? N : len); }
+  int  length() const { return _m.length(); }
+
+  void clear(int head = 0) { _m.clear(head); }
+  bool full() const { return _m.full(); }
+
+  T read(int i) const { return _m.valid(i) ? _buf[i] : T(0); }
+
+  void write(int i, T v) {
+    if (!_m.full()) {
+      int from;
+      int skipped = _m.advance(i, from);
+      for (int k = 0; k < skipped; k++) _buf[_m.slot(from + k)] = T(0);
+    }
+    _buf[i] = v;
+  }
+
+private:
+  T    _buf[N];
+  Mark _m;
+};
+
+} // namespace Lazy
@@ -1,13 +1,17 @@
 #include "LeslieEffect.h"
+#include "Trace.h"
 #include <math.h>
 
+// base doppler delays (samples)
+static constexpr float BASE_HORN = 140.0f;
+static constexpr float BASE_DRUM = 200.0f;
+
 LeslieEffect::LeslieEffect() {
   reset();
 }
 
 void LeslieEffect::reset() {
-  _lowL = 0.0f;
-  _lowR = 0.0f;
+  _low = 0.0f;
 
   _phHorn = 0.0f;
   _phDrum = 0.0f;
@@ -18,17 +22,57 @@ void LeslieEffect::reset() {
   _idxHorn = 0;
   _idxDrum = 0;
 
-  // wipe delay buffers
-  for (int i = 0; i < BUF_LEN; i++) {
-    _hornBufL[i] = 0;
-    _hornBufR[i] = 0;
-    _drumBufL[i] = 0;
-    _drumBufR[i] = 0;
+  // park the mod ramps at rest (base delay, full gain)
+  for (int k = 0; k < MIC_COUNT; k++) {
+    _delay[k].jump((k < DRUM_L) ? BASE_HORN : BASE_DRUM);
+    _gain[k].jump(1.0f);
+  }
+
+  // forget the delay buffers (read as zero until rewritten)
+  _hornBuf.clear();
+  _drumBuf.clear();
+
+  _quietSamples = 0;
+  _silent = false;
+}
+
+void LeslieEffect::setControlInterval(int k) {
+  _ctrlK = ModEngine::clampInterval(k);
+}
+
+// While silent: rotors keep spinning up/down and turning and the mod
+// ramps keep moving. Buffers stay all zero, but write positions still
+// advance since fractional reads round differently at different offsets
+// (the lazy lines are re-anchored there, all zero either way).
+void LeslieEffect::idle(int n, float fs, const Params& pIn) {
+  float speed = clamp01(pIn.speed);
+  float depth = clamp01(pIn.depth);
+  float ramp  = clamp01(pIn.ramp);
+
+  updateRotors(n, fs, speed, ramp);
+
+  Mod md = modFor(depth);
+  float dPhHorn = _hornHz / fs;
+  float dPhDrum = _drumHz / fs;
+
+  for (int i = 0; i < n; ) {
+    int m = ModEngine::segment(n - i, _ctrlK);
+    controlTick(m, dPhHorn, dPhDrum, md);
+    for (int k = 0; k < MIC_COUNT; k++) {
+      _delay[k].skip(m);
+      _gain[k].skip(m);
+    }
+    i += m;
   }
+
+  _idxHorn = (_idxHorn + n) % BUF_LEN;
+  _idxDrum = (_idxDrum + n) % BUF_LEN;
+  _hornBuf.clear(_idxHorn);
+  _drumBuf.clear(_idxDrum);
 }
 
 float LeslieEffect::clamp01(float x) {
-  if (x < 0.0f) return 0.0f;
+  if (!(x > 0.0f)) return 0.0f; // NaN -> 0
   if (x > 1.0f) return 1.0f;
   return x;
 }
@@ -49,33 +93,26 @@ float LeslieEffect::wrap01(float x) {
   return x;
 }
 
-float LeslieEffect::cosine01(float phase01) {
-  float c = cosf(2.0f * 3.14159265f * phase01);
-  return 0.5f + 0.5f * c;
-}
-
 // fractional delay read (linear interp)
-float LeslieEffect::fracDelayRead(const int16_t* buf, int bufLen, int writeIdx, float delaySamps) {
+// delay held to [0, bufLen-1] (NaN -> 0), so one wrap each way is enough
+float LeslieEffect::fracDelayRead(const Line& buf, int bufLen, int writeIdx, float delaySamps) {
+  if (!(delaySamps > 0.0f)) delaySamps = 0.0f;
+  if (delaySamps > (float)(bufLen - 1)) delaySamps = (float)(bufLen - 1);
+
   float rp = (float)writeIdx - delaySamps;
-  while (rp < 0.0f) rp += (float)bufLen;
-  while (rp >= (float)bufLen) rp -= (float)bufLen;
+  if (rp < 0.0f) rp += (float)bufLen;
+  if (rp >= (float)bufLen) rp -= (float)bufLen;
 
   int i0 = (int)rp;
   int i1 = i0 + 1;
   if (i1 >= bufLen) i1 = 0;
 
   float t = rp - (float)i0;
-  return (1.0f - t) * (float)buf[i0] + t * (float)buf[i1];
+  return (1.0f - t) * (float)buf.read(i0) + t * (float)buf.read(i1);
 }
 
-void LeslieEffect::processWet(int16_t* left, int16_t* right, int n, float fs, const Params& pIn) {
-  // **************************
-  // params
-  // *****************
-  float speed = clamp01(pIn.speed);
-  float depth = clamp01(pIn.depth);
-  float ramp  = clamp01(pIn.ramp);   // keep edges valid (no remap)
-
+// rotor inertia (update once per block)
+void LeslieEffect::updateRotors(int n, float fs, float speed, float ramp) {
   // **************************
   // speed ranges
   // *****************
@@ -85,7 +122,6 @@ void LeslieEffect::processWet(int16_t* left, int16_t* right, int n, float fs, co
   float hornTarget = lerp(hornSlow, hornFast, speed);
   float drumTarget = lerp(drumSlow, drumFast, speed);
 
-  // inertia (update once per block)
   float dt = (float)n / fs;
 
   // tau grows with ramp
@@ -98,98 +134,156 @@ void LeslieEffect::processWet(int16_t* left, int16_t* right, int n, float fs, co
 
   _hornHz += (hornTarget - _hornHz) * hornA;
   _drumHz += (drumTarget - _drumHz) * drumA;
+}
 
+// doppler + directionality depths
+LeslieEffect::Mod LeslieEffect::modFor(float depth) {
+  Mod md;
+  md.dopHorn = lerp(3.0f, 26.0f, depth);
+  md.dopDrum = lerp(2.0f, 18.0f, depth);
+  md.amHorn  = lerp(0.15f, 0.98f, depth);
+  md.amDrum  = lerp(0.05f, 0.75f, depth);
+  return md;
+}
+
+// Control-rate step: move the rotors m samples ahead and aim the
+// delay / AM ramps at where the mics will be by then.
+void LeslieEffect::controlTick(int m, float dPhHorn, float dPhDrum, const Mod& md) {
+  // phases still step per sample so they land exactly where the
+  // per-sample version did, whatever K is (adds are cheap, cosf isn't)
+  for (int j = 0; j < m; j++) {
+    _phHorn = wrap01(_phHorn + dPhHorn);
+    _phDrum = wrap01(_phDrum + dPhDrum);
+  }
+
+  // stereo offsets
+  const float micL = 0.00f;
+  const float micR = 0.25f;
+
+  const float ph[MIC_COUNT] = { _phHorn + micL, _phHorn + micR,
+                                _phDrum + micL, _phDrum + micR };
+
+  for (int k = 0; k < MIC_COUNT; k++) {
+    bool  horn = (k < DRUM_L);
+    float base = horn ? BASE_HORN : BASE_DRUM;
+    float dop  = horn ? md.dopHorn : md.dopDrum;
+    float am   = horn ? md.amHorn : md.amDrum;
+
+    // one cos drives both doppler and AM
+    float c = cosf(2.0f * 3.14159265f * ph[k]);
+
+    float d = base + dop * c;
+    if (d < 1.0f) d = 1.0f;
+    _delay[k].rampTo(d, m);
+
+    _gain[k].rampTo((1.0f - am) + am * (0.5f + 0.5f * c), m);
+  }
+}
+
+// Mono guitar in, so L/R crossover + buffers would hold the same samples.
+// One crossover + one pair of buffers, both mics read from them.
+void LeslieEffect::processMono(const int16_t* monoIn, int16_t* monoOut, int n, float fs, const Params& pIn) {
   // **************************
-  // crossover
+  // params
   // *****************
-  float x = 850.0f / fs; // ~850 Hz
-  if (x < 0.001f) x = 0.001f;
-  if (x > 0.45f)  x = 0.45f;
-  float a = x;
+  float blend = clamp01(pIn.blend);
+  float speed = clamp01(pIn.speed);
+  float depth = clamp01(pIn.depth);
+  float ramp  = clamp01(pIn.ramp);
+
+  updateRotors(n, fs, speed, ramp);
 
   // **************************
-  // doppler setup
+  // crossover
   // *****************
-  const float baseHorn = 140.0f;
-  const float baseDrum = 200.0f;
+  float a = 850.0f / fs; // ~850 Hz
+  if (a < 0.001f) a = 0.001f;
+  if (a > 0.45f)  a = 0.45f;
 
-  float dopHorn = lerp(3.0f, 26.0f, depth);
-  float dopDrum = lerp(2.0f, 18.0f, depth);
+  Mod md = modFor(depth);
+  float dPhHorn = _hornHz / fs;
+  float dPhDrum = _drumHz / fs;
 
-  // directionality AM depth
-  float amHorn = lerp(0.15f, 0.98f, depth);
-  float amDrum = lerp(0.05f, 0.75f, depth);
+  // anything non-zero in or written to the buffers ends the quiet run
+  int32_t activity = 0;
 
-  // stereo offsets
-  const float micL = 0.00f;
-  const float micR = 0.25f;
+  FX_TRACE("Leslie");
 
-  float dPhHorn = _hornHz / fs;
-  float dPhDrum = _drumHz / fs;
+  for (int i = 0; i < n; ) {
+    FX_TRACE_LAPS(seg);
+    FX_TRACE_LAP(seg, "control");
 
-  for (int i = 0; i < n; i++) {
-    float inL = (float)left[i];
-    float inR = (float)right[i];
+    // mod targets at control rate
+    int m = ModEngine::segment(n - i, _ctrlK);
+    controlTick(m, dPhHorn, dPhDrum, md);
 
-    // split low/high
-    _lowL = _lowL + a * (inL - _lowL);
-    _lowR = _lowR + a * (inR - _lowR);
+    FX_TRACE_LAP(seg, "samples");
+    for (int j = 0; j < m; j++, i++) {
+      FX_TRACE_LAPS(t);
+      FX_TRACE_LAP(t, "crossover");
 
-    float lowL  = _lowL;
-    float lowR  = _lowR;
-    float highL = inL - lowL;
-    float highR = inR - lowR;
+      activity |= monoIn[i];
 
-    // write bands into buffers
-    _hornBufL[_idxHorn] = clamp16((int32_t)highL);
-    _hornBufR[_idxHorn] = clamp16((int32_t)highR);
+      float in = (float)monoIn[i];
 
-    _drumBufL[_idxDrum] = clamp16((int32_t)lowL);
-    _drumBufR[_idxDrum] = clamp16((int32_t)lowR);
+      // split low/high
+      _low = _low + a * (in - _low);
 
-    // update phases
-    _phHorn = wrap01(_phHorn + dPhHorn);
-    _phDrum = wrap01(_phDrum + dPhDrum);
+      float low  = _low;
+      float high = in - low;
+
+      // write bands into buffers
+      int16_t hw = clamp16((int32_t)high);
+      int16_t dw = clamp16((int32_t)low);
+      _hornBuf.write(_idxHorn, hw);
+      _drumBuf.write(_idxDrum, dw);
+      activity |= hw | dw;
+
+      // read both mics from the shared buffers
+      FX_TRACE_LAP(t, "delayReads");
+      float hornWetL = fracDelayRead(_hornBuf, BUF_LEN, _idxHorn, _delay[HORN_L].tick());
+      float hornWetR = fracDelayRead(_hornBuf, BUF_LEN, _idxHorn, _delay[HORN_R].tick());
+      float drumWetL = fracDelayRead(_drumBuf, BUF_LEN, _idxDrum, _delay[DRUM_L].tick());
+      float drumWetR = fracDelayRead(_drumBuf, BUF_LEN, _idxDrum, _delay[DRUM_R].tick());
+
+      // AM gains
+      FX_TRACE_LAP(t, "am");
+      float gHornL = _gain[HORN_L].tick();
+      float gHornR = _gain[HORN_R].tick();
+      float gDrumL = _gain[DRUM_L].tick();
+      float gDrumR = _gain[DRUM_R].tick();
 
-    // doppler delay mod (cos)
-    float hornModL = cosf(2.0f * 3.14159265f * (_phHorn + micL));
-    float hornModR = cosf(2.0f * 3.14159265f * (_phHorn + micR));
-    float drumModL = cosf(2.0f * 3.14159265f * (_phDrum + micL));
-    float drumModR = cosf(2.0f * 3.14159265f * (_phDrum + micR));
-
-    float dHornL = baseHorn + dopHorn * hornModL;
-    float dHornR = baseHorn + dopHorn * hornModR;
-    float dDrumL = baseDrum + dopDrum * drumModL;
-    float dDrumR = baseDrum + dopDrum * drumModR;
-
-    if (dHornL < 1.0f) dHornL = 1.0f;
-    if (dHornR < 1.0f) dHornR = 1.0f;
-    if (dDrumL < 1.0f) dDrumL = 1.0f;
-    if (dDrumR < 1.0f) dDrumR = 1.0f;
-
-    // read wet (frac delay)
-    float hornWetL = fracDelayRead(_hornBufL, BUF_LEN, _idxHorn, dHornL);
-    float hornWetR = fracDelayRead(_hornBufR, BUF_LEN, _idxHorn, dHornR);
-    float drumWetL = fracDelayRead(_drumBufL, BUF_LEN, _idxDrum, dDrumL);
-    float drumWetR = fracDelayRead(_drumBufR, BUF_LEN, _idxDrum, dDrumR);
-
-    // AM gains
-    float gHornL = (1.0f - amHorn) + amHorn * cosine01(_phHorn + micL);
-    float gHornR = (1.0f - amHorn) + amHorn * cosine01(_phHorn + micR);
-    float gDrumL = (1.0f - amDrum) + amDrum * cosine01(_phDrum + micL);
-    float gDrumR = (1.0f - amDrum) + amDrum * cosine01(_phDrum + micR);
-
-    // combine bands (keep headroom)
-    float outL = (1.10f * hornWetL * gHornL + 0.90f * drumWetL * gDrumL) * 0.80f;
-    float outR = (1.10f * hornWetR * gHornR + 0.90f * drumWetR * gDrumR) * 0.80f;
-
-    left[i]  = clamp16((int32_t)outL);
-    right[i] = clamp16((int32_t)outR);
-
-    _idxHorn++;
-    if (_idxHorn >= BUF_LEN) _idxHorn = 0;
-
-    _idxDrum++;
-    if (_idxDrum >= BUF_LEN) _idxDrum = 0;
+      // combine bands (keep headroom), clamp per mic
+      float outL = (1.10f * hornWetL * gHornL + 0.90f * drumWetL * gDrumL) * 0.80f;
+      float outR = (1.10f * hornWetR * gHornR + 0.90f * drumWetR * gDrumR) * 0.80f;
+
+      float wetMono = 0.5f * ((float)clamp16((int32_t)outL) + (float)clamp16((int32_t)outR));
+
+      // dry/wet
+      float mix = (1.0f - blend) * in + blend * wetMono;
+      monoOut[i] = clamp16((int32_t)mix);
+
+      _idxHorn++;
+      if (_idxHorn >= BUF_LEN) _idxHorn = 0;
+
+      _idxDrum++;
+      if (_idxDrum >= BUF_LEN) _idxDrum = 0;
+    }
+  }
+
+  // **************************
+  // tail flush
+  // *****************
+  // BUF_LEN quiet samples => every slot has been overwritten with 0,
+  // only the crossover state (< 1 LSB by now) is left to clear.
+  if (activity != 0) {
+    _quietSamples = 0;
+    _silent = false;
+  } else if (!_silent) {
+    _quietSamples += n;
+    if (_quietSamples >= BUF_LEN) {
+      _low = 0.0f;
+      _silent = true;
+    }
   }
 }
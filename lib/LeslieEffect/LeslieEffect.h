@@ -1,15 +1,18 @@
 #pragma once
 #include <Arduino.h>
 #include <stdint.h>
+#include "ModEngine.h"
+#include "FxBase.h"
+#include "LazyLine.h"
 
-class LeslieEffect {
+class LeslieEffect : public FxBase<LeslieEffect> {
 public:
   // **************************
   // Params
   // *****************
   struct Params {
     float volume = 0.0f; // main handles this
-    float blend  = 0.0f; // main handles this
+    float blend  = 0.0f; // dry/wet
     float speed  = 0.0f; // slow -> fast
     float depth  = 0.0f; // how wide the wobble gets
     float ramp   = 0.0f; // snappy -> sluggish
@@ -18,15 +21,38 @@ public:
   LeslieEffect();
   void reset();
 
-  // wet only (blend/volume happen in main)
-  void processWet(int16_t* left, int16_t* right, int n, float fs, const Params& p);
+  // doppler / AM targets are evaluated every k samples (1..32) and ramped
+  void setControlInterval(int k);
+
+  // mono in -> both mics -> mono out, blend applied here
+  // in and out may point at the same buffer
+  void processMono(const int16_t* monoIn, int16_t* monoOut, int n, float fs, const Params& p);
+
+  // **************************
+  // Idle
+  // *****************
+  // true once the mono tail has decayed and the state is parked at zero.
+  // While silent, call idle() instead of processMono() for blocks of
+  // zeros: output is zeros and only the rotors advance.
+  bool isSilent() const { return _silent; }
+  void idle(int n, float fs, const Params& p);
+
+  // **************************
+  // FxBase interface
+  // *****************
+  void prepare(float fs, int maxBlock) { _fs = fs; (void)maxBlock; }
+  void setParams(const Params& p) { _p = p; }
+  void process(int16_t* data, int n, const BlockAnalysis&) { processMono(data, data, n, _fs, _p); }
+  void idle(int n) { idle(n, _fs, _p); }
 
 private:
+  float  _fs = 44100.0f;
+  Params _p;
+
   // **************************
   // Crossover state
   // *****************
-  float _lowL = 0.0f;
-  float _lowR = 0.0f;
+  float _low = 0.0f;
 
   // **************************
   // Phases (0..1)
@@ -43,15 +69,36 @@ private:
   // **************************
   // Delay buffers
   // *****************
+  // one per band, both mics read them; cleared lazily, reset() doesn't
+  // touch the 16 KB
   static constexpr int BUF_LEN = 4096;
-  int16_t _hornBufL[BUF_LEN];
-  int16_t _hornBufR[BUF_LEN];
-  int16_t _drumBufL[BUF_LEN];
-  int16_t _drumBufR[BUF_LEN];
+  using Line = Lazy::Line<int16_t, BUF_LEN>;
+  Line _hornBuf;
+  Line _drumBuf;
 
   int _idxHorn = 0;
   int _idxDrum = 0;
 
+  // **************************
+  // Control-rate mod (per mic)
+  // *****************
+  enum Mic { HORN_L = 0, HORN_R, DRUM_L, DRUM_R, MIC_COUNT };
+
+  struct Mod {
+    float dopHorn, dopDrum; // doppler swing (samples)
+    float amHorn,  amDrum;  // directionality AM depth
+  };
+
+  ModEngine::Ramp _delay[MIC_COUNT]; // doppler delay (samples)
+  ModEngine::Ramp _gain[MIC_COUNT];  // AM gain
+  int _ctrlK = ModEngine::K_DEFAULT;
+
+  // **************************
+  // Idle detection
+  // *****************
+  int  _quietSamples = 0;
+  bool _silent = false;
+
   // **************************
   // Helpers
   // *****************
@@ -59,6 +106,10 @@ private:
   static int16_t clamp16(int32_t x);
   static float lerp(float a, float b, float t);
   static float wrap01(float x);
-  static float cosine01(float phase01);
-  static float fracDelayRead(const int16_t* buf, int bufLen, int writeIdx, float delaySamps);
+  static float fracDelayRead(const Line& buf, int bufLen, int writeIdx, float delaySamps);
+
+  static Mod modFor(float depth);
+
+  void updateRotors(int n, float fs, float speed, float ramp);
+  void controlTick(int m, float dPhHorn, float dPhDrum, const Mod& md);
 };
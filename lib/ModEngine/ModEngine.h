@@ -0,0 +1,58 @@
+#pragma once
+#include <stdint.h>
+
+// **************************
+// Control-rate modulation
+// *****************
+// LFO-driven targets (delay times, AM gains) are bandlimited, so they
+// get evaluated every K samples and linearly ramped in between. The
+// audio loop is left with one add per ramp per sample.
+//
+// Typical loop:
+//   for (int i = 0; i < n; ) {
+//     int m = ModEngine::segment(n - i, k);
+//     ...advance LFO by m, ramp.rampTo(target, m)...
+//     for (int j = 0; j < m; j++, i++) { float d = ramp.tick(); ... }
+//   }
+namespace ModEngine {
+
+static constexpr int K_MIN     = 1; // every sample, what mod_bench compares against
+static constexpr int K_MAX     = 32;
+static constexpr int K_DEFAULT = 16;
+
+static inline int clampInterval(int k) {
+  return (k < K_MIN) ? K_MIN : (k > K_MAX) ? K_MAX : k;
+}
+
+// samples in the next control segment
+static inline int segment(int remaining, int k) {
+  return (remaining < k) ? remaining : k;
+}
+
+// **************************
+// Ramp
+// *****************
+struct Ramp {
+  float value = 0.0f;
+  float step  = 0.0f;
+
+  // hard set, no ramp
+  void jump(float v) { value = v; step = 0.0f; }
+
+  // reach target after m ticks
+  void rampTo(float target, int m) { step = (target - value) / (float)m; }
+
+  // current value, then move one sample along
+  float tick() {
+    float v = value;
+    value += step;
+    return v;
+  }
+
+  // m ticks without reading (same float ops as tick)
+  void skip(int m) {
+    for (int i = 0; i < m; i++) value += step;
+  }
+};
+
+} // namespace ModEngine
@@ -4,7 +4,6 @@
 OctaveEffect::OctaveEffect() { reset(); }
 
 void OctaveEffect::reset() {
-  _env = 0.0f;
   _samplesSinceCross = 0;
   _freqSmoothed = 200.0f;
   _phase = 0.0f;
@@ -18,10 +17,57 @@ void OctaveEffect::reset() {
   _upDC   = 0.0f;
   _oscLP  = 0.0f;
   _postLP = 0.0f;
+  _upSat.reset();
+
+  _silent = false;
+}
+
+// Park the signal path at zero once the tail is gone. The sub
+// oscillator keeps free-running (idle() advances it), so only the
+// parts that silence drives to zero get flushed.
+void OctaveEffect::flushTail() {
+  _hangSamples = 0;
+
+  _preLP  = 0.0f;
+  _upLP   = 0.0f;
+  _upDC   = 0.0f;
+  _postLP = 0.0f;
+  _upSat.reset();
+
+  _silent = true;
+}
+
+// same tracker / sub osc steps processMono runs on silent input
+void OctaveEffect::idle(int n, float fs, const Params& pIn) {
+  float character = clamp01(pIn.character);
+  float sqMix = character;
+
+  float oscLPA = 5000.0f / fs;
+  if (oscLPA < 0.001f) oscLPA = 0.001f;
+  if (oscLPA > 0.45f)  oscLPA = 0.45f;
+
+  for (int i = 0; i < n; i++) {
+    _samplesSinceCross++;
+
+    // no lock => drift to something safe
+    _freqSmoothed = _freqSmoothed + 0.01f * (120.0f - _freqSmoothed);
+
+    float fDown = 0.5f * _freqSmoothed;
+    if (fDown < 20.0f) fDown = 20.0f;
+
+    _phase += fDown / fs;
+    if (_phase >= 1.0f) _phase -= 1.0f;
+
+    float s = sinf(2.0f * 3.14159265f * _phase);
+    float q = (s >= 0.0f) ? 1.0f : -1.0f;
+    float osc = (1.0f - sqMix) * s + sqMix * q;
+
+    onePoleLP(osc, _oscLP, oscLPA);
+  }
 }
 
 float OctaveEffect::clamp01(float x) {
-  if (x < 0.0f) return 0.0f;
+  if (!(x > 0.0f)) return 0.0f; // NaN -> 0
   if (x > 1.0f) return 1.0f;
   return x;
 }
@@ -40,12 +86,8 @@ float OctaveEffect::onePoleLP(float x, float& y, float a) {
   return y;
 }
 
-// atan sat (cheap + smooth)
-float OctaveEffect::satAtan(float x, float k) {
-  return (2.0f / 3.14159265f) * atanf(k * x);
-}
-
-void OctaveEffect::processMono(const int16_t* monoIn, int16_t* monoOut, int n, float fs, const Params& pIn) {
+void OctaveEffect::processMono(const int16_t* monoIn, int16_t* monoOut, int n, float fs,
+                               const Params& pIn, const BlockAnalysis& an) {
   float blend     = clamp01(pIn.blend);
   float mix       = clamp01(pIn.mix);
   float tracking  = clamp01(pIn.tracking);
@@ -116,23 +158,28 @@ void OctaveEffect::processMono(const int16_t* monoIn, int16_t* monoOut, int n, f
   const float fMin = 55.0f;
   const float fMax = 800.0f;
 
+  bool  quietIn = true;
+  float wetPeak = 0.0f;
+
+  // shared input envelope, ramped across the block
+  float env  = an.envStart;
+  float dEnv = an.envStep(n);
+
   for (int i = 0; i < n; i++) {
+    if (monoIn[i] != 0) quietIn = false;
+
     float x = (float)monoIn[i] / 32768.0f;
 
-    // env follower
-    float ax = fabsf(x);
-    float envA = 0.015f;
-    float envR = 0.0030f;
-    _env = _env + ((ax > _env) ? envA : envR) * (ax - _env);
+    env += dEnv;
 
     // gate + hang (keep lock during decay)
     if (!_trackingActive) {
-      if (_env > gateOn) {
+      if (env > gateOn) {
         _trackingActive = true;
         _hangSamples = hangMax;
       }
     } else {
-      if (_env < gateOff) {
+      if (env < gateOff) {
         if (_hangSamples > 0) _hangSamples--;
         else _trackingActive = false;
       } else {
@@ -145,7 +192,7 @@ void OctaveEffect::processMono(const int16_t* monoIn, int16_t* monoOut, int n, f
     // *****************
     float up = fabsf(x);                 // rectifier
     up = onePoleLP(up, _upLP, upA);      // smooth it
-    up = satAtan(up * upDrive, 2.5f);    // add some bite
+    up = (2.0f / 3.14159265f) * _upSat.process(2.5f * (up * upDrive)); // add some bite
 
     float dc = onePoleLP(up, _upDC, upDCA);
     up = (up - dc) * upGain;             // LOUDER
@@ -209,7 +256,7 @@ void OctaveEffect::processMono(const int16_t* monoIn, int16_t* monoOut, int n, f
     osc = onePoleLP(osc, _oscLP, oscLPA);
 
     // fade down osc with env so it stops hanging
-    float envGate = (_env - gateOff) * 30.0f;
+    float envGate = (env - gateOff) * 30.0f;
     if (envGate < 0.0f) envGate = 0.0f;
     if (envGate > 1.0f) envGate = 1.0f;
 
@@ -222,9 +269,24 @@ void OctaveEffect::processMono(const int16_t* monoIn, int16_t* monoOut, int n, f
     float wet = (wDown * down + wUp * up) / wScale;
     wet = onePoleLP(wet, _postLP, postA);
 
+    float aw = fabsf(wet);
+    if (aw > wetPeak) wetPeak = aw;
+
     float y = (1.0f - blend) * x + blend * wet;
 
     int32_t out = (int32_t)(y * 32767.0f);
     monoOut[i] = clamp16(out);
   }
+
+  // **************************
+  // tail flush
+  // *****************
+  if (!quietIn) {
+    _silent = false;
+  } else if (!_silent && !_trackingActive && wetPeak < SILENT_THRESH &&
+             an.envEnd < SILENT_THRESH && fabsf(_upLP) < SILENT_THRESH &&
+             fabsf(_upDC) < SILENT_THRESH && fabsf(_preLP) < SILENT_THRESH &&
+             _upSat.settled(0.0f, SILENT_THRESH)) {
+    flushTail();
+  }
 }
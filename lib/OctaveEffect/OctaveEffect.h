@@ -1,8 +1,11 @@
 #pragma once
 #include <Arduino.h>
 #include <stdint.h>
+#include "BlockAnalysis.h"
+#include "FxBase.h"
+#include "Adaa.h"
 
-class OctaveEffect {
+class OctaveEffect : public FxBase<OctaveEffect> {
 public:
   // **************************
   // Params
@@ -17,13 +20,38 @@ public:
   OctaveEffect();
   void reset();
 
-  void processMono(const int16_t* monoIn, int16_t* monoOut, int n, float fs, const Params& p);
+  // monoIn and monoOut may point at the same buffer
+  // envelope comes from the shared per-block input analysis
+  void processMono(const int16_t* monoIn, int16_t* monoOut, int n, float fs,
+                   const Params& p, const BlockAnalysis& a);
+
+  // **************************
+  // Idle
+  // *****************
+  // true once the tail has decayed and the signal path is parked at zero.
+  // While silent, call idle() instead of processMono() for blocks of
+  // zeros: output is zeros and only the free-running sub osc advances.
+  bool isSilent() const { return _silent; }
+  void idle(int n, float fs, const Params& p);
+
+  // octave-up shaper: OFF = plain atan, ADAA1 / ADAA2 anti-aliased
+  void setAntiAlias(Adaa::Mode m) { _upSat.setMode(m); }
+
+  // **************************
+  // FxBase interface
+  // *****************
+  void prepare(float fs, int maxBlock) { _fs = fs; (void)maxBlock; }
+  void setParams(const Params& p) { _p = p; }
+  void process(int16_t* data, int n, const BlockAnalysis& a) { processMono(data, data, n, _fs, _p, a); }
+  void idle(int n) { idle(n, _fs, _p); }
 
 private:
+  float  _fs = 44100.0f;
+  Params _p;
+
   // **************************
-  // Env + tracking state
+  // Tracking state
   // *****************
-  float _env = 0.0f;
   int   _samplesSinceCross = 0;
   float _freqSmoothed = 200.0f; // Hz
   float _phase = 0.0f;          // 0..1
@@ -42,6 +70,12 @@ private:
   float _oscLP   = 0.0f; // smooth osc edges
   float _postLP  = 0.0f; // final smoothing
 
+  Adaa::Shaper<Adaa::Atan> _upSat; // octave-up bite
+
+  // idle detection
+  static constexpr float SILENT_THRESH = 1.0e-5f; // ~-100 dBFS
+  bool _silent = false;
+
   // **************************
   // Helpers
   // *****************
@@ -50,5 +84,6 @@ private:
   static float lerp(float a, float b, float t);
 
   static float onePoleLP(float x, float& y, float a);
-  static float satAtan(float x, float k);
+
+  void flushTail();
 };
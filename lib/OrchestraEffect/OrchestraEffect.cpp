@@ -1,103 +1,199 @@
 #include "OrchestraEffect.h"
+#include "Trace.h"
 #include <math.h>
 
 // **************************
 // Helpers
 // *****************
-float OrchestraEffect::clamp01(float x){
-  if(x<0) return 0;
+template <int D>
+float OrchestraEffectT<D>::clamp01(float x){
+  if(!(x>0)) return 0; // NaN -> 0
   if(x>1) return 1;
   return x;
 }
 
-float OrchestraEffect::lerp(float a,float b,float t){
+template <int D>
+float OrchestraEffectT<D>::lerp(float a,float b,float t){
   return a + (b-a)*t;
 }
 
 // Clamp to int16 range
-int16_t OrchestraEffect::clamp16(int32_t x){
+template <int D>
+int16_t OrchestraEffectT<D>::clamp16(int32_t x){
   if (x > 32767) return 32767;
   if (x < -32768) return -32768;
   return (int16_t)x;
 }
 
 // One-pole LP (cheap smoothing)
-float OrchestraEffect::onePoleLP(float x, float& y, float a){
+template <int D>
+float OrchestraEffectT<D>::onePoleLP(float x, float& y, float a){
   y = y + a * (x - y);
   return y;
 }
 
 // HP via LP subtraction (DC removal)
-float OrchestraEffect::onePoleHP_viaLP(float x, float& lpState, float a){
+template <int D>
+float OrchestraEffectT<D>::onePoleHP_viaLP(float x, float& lpState, float a){
   lpState = lpState + a * (x - lpState);
   return x - lpState;
 }
 
 // Soft saturation (keep level up without hard clipping)
-float OrchestraEffect::softSat(float x, float drive){
+template <int D>
+float OrchestraEffectT<D>::softSat(float x, float drive){
   float z = x * drive;
-  float y = tanhf(z);
+  float y = _outSat.process(z);
   float n = tanhf(drive);
   return y / (n > 1e-6f ? n : 1.0f);
 }
 
+// **************************
+// Halfband
+// *****************
+// h[11 +- (2k-1)], k = 1..6 (center is 0.5)
+static constexpr float HB[6] = {
+  0.309885528f, -0.083031313f, 0.031473970f,
+  -0.010518765f, 0.002422103f, -0.000171639f
+};
+
+template <int D>
+void OrchestraEffectT<D>::HbLine::reset(){
+  for(int i=0;i<2*LEN;i++) buf[i]=0.0f;
+  p=0;
+}
+
+template <int D>
+void OrchestraEffectT<D>::HbLine::push(float x){
+  p++; if(p>=LEN) p=0;
+  buf[p]=x;
+  buf[p+LEN]=x;
+}
+
+// symmetric pairs around the middle of a 12 sample window
+template <int D>
+float OrchestraEffectT<D>::hbTaps(const float* w){
+  float y = 0.0f;
+  for(int k=1;k<=6;k++) y += HB[k-1] * (w[5+k] + w[6-k]);
+  return y;
+}
+
+template <int D>
+void OrchestraEffectT<D>::Decimator::reset(){
+  even.reset();
+  odd.reset();
+}
+
+// two full-rate samples in, one wet-rate sample out
+template <int D>
+float OrchestraEffectT<D>::Decimator::process(float x0, float x1){
+  even.push(x0);
+  odd.push(x1);
+  return 0.5f*even.win()[6] + hbTaps(odd.win());
+}
+
+template <int D>
+void OrchestraEffectT<D>::Interpolator::reset(){
+  u.reset();
+}
+
+// one wet-rate sample in, two full-rate samples out
+template <int D>
+void OrchestraEffectT<D>::Interpolator::process(float x, float& y0, float& y1){
+  u.push(x);
+  y0 = 2.0f*hbTaps(u.win());
+  y1 = u.win()[6];
+}
+
 // **************************
 // DelayLine
 // *****************
-void OrchestraEffect::DelayLine::reset(){
-  for(int i=0;i<MAX;i++) buf[i]=0.0f;
+template <int D>
+void OrchestraEffectT<D>::DelayLine::reset(){
+  buf.clear();
   w=0;
 }
 
-void OrchestraEffect::DelayLine::push(float x){
-  buf[w]=x;
+template <int D>
+void OrchestraEffectT<D>::DelayLine::push(float x){
+  buf.write(w,x);
   w++; if(w>=MAX) w=0;
 }
 
-float OrchestraEffect::DelayLine::readFrac(float dSamp) const{
+// delay held to [0, MAX-1] (NaN -> 0), so one wrap each way is enough
+template <int D>
+float OrchestraEffectT<D>::DelayLine::readFrac(float dSamp) const{
+  if(!(dSamp > 0.0f)) dSamp = 0.0f;
+  if(dSamp > (float)(MAX-1)) dSamp = (float)(MAX-1);
+
   float r = (float)w - dSamp;
-  while(r<0.0f) r += (float)MAX;
-  while(r>=(float)MAX) r -= (float)MAX;
+  if(r<0.0f) r += (float)MAX;
+  if(r>=(float)MAX) r -= (float)MAX;
 
   int i0 = (int)r;
   int i1 = i0+1; if(i1>=MAX) i1=0;
 
   float f = r - (float)i0;
-  return buf[i0] + f*(buf[i1]-buf[i0]);
+  float b0 = buf.read(i0);
+  return b0 + f*(buf.read(i1)-b0);
 }
 
 // **************************
 // PitchShift (4-grain overlap)
 // *****************
-void OrchestraEffect::PitchShift::reset(){
-  for(int i=0;i<BUF;i++) buf[i]=0.0f;
+template <int D>
+void OrchestraEffectT<D>::PitchShift::reset(){
+  buf.clear();
   w=0;
   ph[0]=0.00f; ph[1]=0.25f; ph[2]=0.50f; ph[3]=0.75f;
 }
 
 // Hann window for grain overlap
-float OrchestraEffect::PitchShift::hann(float p01){
+template <int D>
+float OrchestraEffectT<D>::PitchShift::hann(float p01){
   return 0.5f - 0.5f*cosf(2.0f * 3.14159265f * p01);
 }
 
-float OrchestraEffect::PitchShift::readFrac(float delaySamp) const{
+template <int D>
+float OrchestraEffectT<D>::PitchShift::readFrac(float delaySamp) const{
+  if(!(delaySamp > 0.0f)) delaySamp = 0.0f;
+  if(delaySamp > (float)(BUF-1)) delaySamp = (float)(BUF-1);
+
   float r = (float)w - delaySamp;
-  while(r<0.0f) r += (float)BUF;
-  while(r>=(float)BUF) r -= (float)BUF;
+  if(r<0.0f) r += (float)BUF;
+  if(r>=(float)BUF) r -= (float)BUF;
 
   int i0 = (int)r;
   int i1 = i0+1; if(i1>=BUF) i1=0;
 
   float f = r - (float)i0;
-  return buf[i0] + f*(buf[i1]-buf[i0]);
+  float b0 = buf.read(i0);
+  return b0 + f*(buf.read(i1)-b0);
+}
+
+// grain phases run even on silence, so idle() steps them alone
+template <int D>
+void OrchestraEffectT<D>::PitchShift::advance(float ratio, float fs, float grainMs){
+  float grain = (grainMs/1000.0f) * fs;
+  if(!(grain >= 256.0f)) grain = 256.0f; // NaN too
+  if(grain > (float)(BUF-16)) grain = (float)(BUF-16);
+
+  float step = (1.0f - ratio) / grain;
+
+  for(int k=0;k<4;k++){
+    ph[k] += step; // |step| < 1, one wrap each way
+    if(ph[k] < 0.0f) ph[k] += 1.0f;
+    if(ph[k] >= 1.0f) ph[k] -= 1.0f;
+  }
 }
 
-float OrchestraEffect::PitchShift::process(float x, float ratio, float fs, float grainMs){
-  buf[w] = x;
+template <int D>
+float OrchestraEffectT<D>::PitchShift::process(float x, float ratio, float fs, float grainMs){
+  buf.write(w, x);
   w++; if(w>=BUF) w=0;
 
   float grain = (grainMs/1000.0f) * fs;
-  if(grain < 256.0f) grain = 256.0f;
+  if(!(grain >= 256.0f)) grain = 256.0f; // NaN too
   if(grain > (float)(BUF-16)) grain = (float)(BUF-16);
 
   // Time-warp step (ratio controls shift amount)
@@ -107,9 +203,9 @@ float OrchestraEffect::PitchShift::process(float x, float ratio, float fs, float
   float wsum = 0.0f;
 
   for(int k=0;k<4;k++){
-    ph[k] += step;
-    while(ph[k] < 0.0f) ph[k] += 1.0f;
-    while(ph[k] >= 1.0f) ph[k] -= 1.0f;
+    ph[k] += step; // |step| < 1, one wrap each way
+    if(ph[k] < 0.0f) ph[k] += 1.0f;
+    if(ph[k] >= 1.0f) ph[k] -= 1.0f;
 
     float d = ph[k] * grain;
     float s = readFrac(d);
@@ -126,43 +222,52 @@ float OrchestraEffect::PitchShift::process(float x, float ratio, float fs, float
 // **************************
 // Comb / Allpass
 // *****************
-void OrchestraEffect::Comb::init(int delay){
+template <int D>
+void OrchestraEffectT<D>::Comb::init(int delay){
   if(delay<1) delay=1;
   if(delay>MAX) delay=MAX;
   len=delay;
+  buf.setLength(len);
   reset();
 }
 
-void OrchestraEffect::Comb::reset(){
-  for(int i=0;i<len;i++) buf[i]=0.0f;
+template <int D>
+void OrchestraEffectT<D>::Comb::reset(){
+  buf.clear();
   idx=0;
   lp=0.0f;
 }
 
-float OrchestraEffect::Comb::process(float x, float fb, float damp){
-  float y = buf[idx];
+// damp is already scaled to the wet rate
+template <int D>
+float OrchestraEffectT<D>::Comb::process(float x, float fb, float damp){
+  float y = buf.read(idx);
   lp = lp + damp*(y - lp);
-  buf[idx] = x + fb*lp;
+  buf.write(idx, x + fb*lp);
   idx++; if(idx>=len) idx=0;
   return y;
 }
 
-void OrchestraEffect::Allpass::init(int delay){
+template <int D>
+void OrchestraEffectT<D>::Allpass::init(int delay){
   if(delay<1) delay=1;
   if(delay>MAX) delay=MAX;
   len=delay;
+  buf.setLength(len);
   reset();
 }
 
-void OrchestraEffect::Allpass::reset(){
-  for(int i=0;i<len;i++) buf[i]=0.0f;
+template <int D>
+void OrchestraEffectT<D>::Allpass::reset(){
+  buf.clear();
   idx=0;
 }
 
-float OrchestraEffect::Allpass::process(float x, float g){
-  float b = buf[idx];
+template <int D>
+float OrchestraEffectT<D>::Allpass::process(float x, float g){
+  float b = buf.read(idx);
   float y = -g*x + b;
-  buf[idx] = x + g*y;
+  buf.write(idx, x + g*y);
   idx++; if(idx>=len) idx=0;
   return y;
 }
@@ -170,20 +275,22 @@ float OrchestraEffect::Allpass::process(float x, float g){
 // **************************
 // ShimmerStage
 // *****************
-void OrchestraEffect::ShimmerStage::init(){
-  // Comb delays chosen to avoid obvious ringing
-  c[0].init(1557);
-  c[1].init(1617);
-  c[2].init(1491);
-  c[3].init(1422);
+template <int D>
+void OrchestraEffectT<D>::ShimmerStage::init(){
+  // Comb delays chosen to avoid obvious ringing (full-rate samples)
+  c[0].init(1557 / DECIM);
+  c[1].init(1617 / DECIM);
+  c[2].init(1491 / DECIM);
+  c[3].init(1422 / DECIM);
 
-  ap[0].init(225);
-  ap[1].init(556);
+  ap[0].init(225 / DECIM);
+  ap[1].init(556 / DECIM);
 
   reset();
 }
 
-void OrchestraEffect::ShimmerStage::reset(){
+template <int D>
+void OrchestraEffectT<D>::ShimmerStage::reset(){
   for(int i=0;i<4;i++) c[i].reset();
   for(int i=0;i<2;i++) ap[i].reset();
 
@@ -193,31 +300,50 @@ void OrchestraEffect::ShimmerStage::reset(){
   dcLP = 0.0f;
 }
 
-float OrchestraEffect::ShimmerStage::process(float x, float fs,
+// zero the audio state but keep the grain phases running
+template <int D>
+void OrchestraEffectT<D>::ShimmerStage::flush(){
+  for(int i=0;i<4;i++) c[i].reset();
+  for(int i=0;i<2;i++) ap[i].reset();
+
+  ps.buf.clear();
+  ps.w = 0;
+
+  fbLP = 0.0f;
+  wetLP = 0.0f;
+  dcLP = 0.0f;
+}
+
+template <int D>
+float OrchestraEffectT<D>::ShimmerStage::process(float x, float fs,
                                             float size, float tone,
                                             float shimmerAmt, float ratio,
                                             float grainMs)
 {
   // MORE SUSTAIN: allow higher feedback
-  float fb   = OrchestraEffect::lerp(0.82f, 0.965f, size);
-  float damp = OrchestraEffect::lerp(0.08f, 0.42f, size);
-  float apg  = OrchestraEffect::lerp(0.68f, 0.78f, size);
+  float fb   = OrchestraEffectT::lerp(0.82f, 0.965f, size);
+  float damp = OrchestraEffectT::wetA(OrchestraEffectT::lerp(0.08f, 0.42f, size));
+  float apg  = OrchestraEffectT::lerp(0.68f, 0.78f, size);
 
   // darker feedback hides pitch artifacts + longer tails
-  float fbLPHz = OrchestraEffect::lerp(5200.0f, 1500.0f, tone);
+  float fbLPHz = OrchestraEffectT::lerp(5200.0f, 1500.0f, tone);
   float fbA = fbLPHz / fs;
   if(fbA < 0.002f) fbA = 0.002f;
   if(fbA > 0.45f)  fbA = 0.45f;
 
-  float sh = OrchestraEffect::clamp01(shimmerAmt);
+  float sh = OrchestraEffectT::clamp01(shimmerAmt);
   if(sh > 0.95f) sh = 0.95f;
 
+  FX_TRACE_LAPS(t);
+  FX_TRACE_LAP(t, "pitchShift");
+
   float fbShift = ps.process(x, ratio, fs, grainMs);
-  fbShift = OrchestraEffect::onePoleLP(fbShift, fbLP, fbA);
+  fbShift = OrchestraEffectT::onePoleLP(fbShift, fbLP, fbA);
 
   // shimmer injection
   float in = x + sh * 0.78f * fbShift;
 
+  FX_TRACE_LAP(t, "combs");
   float csum = 0.0f;
   csum += c[0].process(in, fb, damp);
   csum += c[1].process(in, fb*0.997f, damp);
@@ -225,11 +351,12 @@ float OrchestraEffect::ShimmerStage::process(float x, float fs,
   csum += c[3].process(in, fb*0.991f, damp);
   csum *= 0.25f;
 
+  FX_TRACE_LAP(t, "allpasses");
   float r = ap[1].process(ap[0].process(csum, apg), apg);
 
   // DC cleanup + light smoothing
-  r = OrchestraEffect::onePoleHP_viaLP(r, dcLP, 0.0008f);
-  r = OrchestraEffect::onePoleLP(r, wetLP, 0.10f);
+  r = OrchestraEffectT::onePoleHP_viaLP(r, dcLP, OrchestraEffectT::wetA(0.0008f));
+  r = OrchestraEffectT::onePoleLP(r, wetLP, OrchestraEffectT::wetA(0.10f));
 
   return r;
 }
@@ -237,16 +364,18 @@ float OrchestraEffect::ShimmerStage::process(float x, float fs,
 // **************************
 // OrchestraEffect
 // *****************
-OrchestraEffect::OrchestraEffect(){
-  _pre.reset();
+template <int D>
+OrchestraEffectT<D>::OrchestraEffectT(){
   _up.init();
   _down.init();
   reset();
 }
 
-void OrchestraEffect::reset(){
+template <int D>
+void OrchestraEffectT<D>::reset(){
+  _dec.reset();
+  _int.reset();
   _pre.reset();
-  _env = 0.0f;
   _duck = 1.0f;
   _swellLP = 0.0f;
 
@@ -255,9 +384,58 @@ void OrchestraEffect::reset(){
 
   _outLP = 0.0f;
   _outDC = 0.0f;
+  _outSat.reset();
+
+  _quietSamples = 0;
+  _silent = false;
+}
+
+// Tail is below threshold: zero the signal path so silence is an exact
+// fixed point and idle() can stand in for processMono() until input
+// returns. Duck/swell are left alone, they're already settled (the
+// flush only happens once they stop changing).
+template <int D>
+void OrchestraEffectT<D>::flushTail(){
+  _dec.reset();
+  _int.reset();
+  _pre.reset();
+
+  _up.flush();
+  _down.flush();
+
+  _outLP = 0.0f;
+  _outDC = 0.0f;
+  _outSat.reset();
+
+  _silent = true;
 }
 
-void OrchestraEffect::processMono(const int16_t* inMono, int16_t* outMono, int n, float fs, const Params& pIn){
+template <int D>
+void OrchestraEffectT<D>::idle(int n, float fs, const Params& pIn){
+  float size = clamp01(pIn.size);
+
+  float grainMsUp = lerp(50.0f, 86.0f, size);
+  float grainMsDn = lerp(56.0f, 96.0f, size);
+
+  // wet path samples
+  const float fsW = fs / (float)DECIM;
+  const int   nW  = n / DECIM;
+
+  for(int i=0;i<nW;i++){
+    _up.ps.advance(2.0f, fsW, grainMsUp);
+    _down.ps.advance(0.5f, fsW, grainMsDn);
+  }
+
+  // buffers are all zero, but frac reads round differently at other
+  // write offsets, so keep those in step
+  _pre.w     = (_pre.w + nW) % DelayLine::MAX;
+  _up.ps.w   = (_up.ps.w + nW) % PitchShift::BUF;
+  _down.ps.w = (_down.ps.w + nW) % PitchShift::BUF;
+}
+
+template <int D>
+void OrchestraEffectT<D>::processMono(const int16_t* inMono, int16_t* outMono, int n, float fs,
+                                  const Params& pIn, const BlockAnalysis& an){
   float mix   = clamp01(pIn.mix);
   float size  = clamp01(pIn.size);
   float swell = clamp01(pIn.swell);
@@ -265,19 +443,20 @@ void OrchestraEffect::processMono(const int16_t* inMono, int16_t* outMono, int n
   float dnAmt = clamp01(pIn.down);
   float tone  = clamp01(pIn.tone);
 
+  // wet path rate
+  const float fsW = fs / (float)DECIM;
+
   // Predelay scales with size
   float preMs = lerp(10.0f, 32.0f, size);
-  float preS  = (preMs/1000.0f) * fs;
-
-  // Envelope follower
-  float envA = 0.03f;
-  float envR = 0.0010f;
+  float preS  = (preMs/1000.0f) * fsW;
 
   float duckAtk = lerp(0.05f, 0.12f, swell);
   float duckRel = lerp(0.0012f, 0.00018f, swell); // MORE SUSTAIN
 
   float openTh  = 0.030f;
 
+  float wetFloor = lerp(1.0f, 0.22f, swell);
+
   // Bigger grains = smoother shimmer
   float grainMsUp = lerp(50.0f, 86.0f, size);
   float grainMsDn = lerp(56.0f, 96.0f, size);
@@ -285,41 +464,97 @@ void OrchestraEffect::processMono(const int16_t* inMono, int16_t* outMono, int n
   // LOUDER: bigger wet gain
   float wetGain = lerp(2.4f, 4.2f, upAmt);
 
-  for(int i=0;i<n;i++){
-    float x = (float)inMono[i] / 32768.0f;
-    float dry = x;
+  bool  quietIn = true;
+  float wetPeak = 0.0f;
+
+  float duck0    = _duck;
+  float swellLP0 = _swellLP;
+
+  // shared input envelope, ramped across the block
+  float env  = an.envStart;
+  float dEnv = an.envStep(n);
 
-    float ax = fabsf(x);
-    _env = _env + ((ax > _env) ? envA : envR) * (ax - _env);
+  FX_TRACE("Orchestra");
 
-    float playing = (_env > openTh) ? 1.0f : 0.0f;
+  for(int i=0;i<n;i+=DECIM){
+    FX_TRACE_LAPS(t);
+    FX_TRACE_LAP(t, "swell");
 
-    float wetFloor = lerp(1.0f, 0.22f, swell);
+    // full rate: dry + swell / duck
+    float xs[2] = {0.0f, 0.0f};
+    float swellGain = 0.0f;
 
-    float targetDuck = playing ? wetFloor : 1.0f;
-    float a = (targetDuck > _duck) ? duckRel : duckAtk;
-    _duck = _duck + a * (targetDuck - _duck);
+    for(int j=0;j<DECIM;j++){
+      if(inMono[i+j] != 0) quietIn = false;
+      xs[j] = (float)inMono[i+j] / 32768.0f;
 
-    float swellGain = _duck;
-    swellGain *= swellGain;
-    swellGain = onePoleLP(swellGain, _swellLP, 0.02f);
+      env += dEnv;
+      float playing = (env > openTh) ? 1.0f : 0.0f;
 
-    _pre.push(x);
+      float targetDuck = playing ? wetFloor : 1.0f;
+      float a = (targetDuck > _duck) ? duckRel : duckAtk;
+      _duck = _duck + a * (targetDuck - _duck);
+
+      swellGain = _duck;
+      swellGain *= swellGain;
+      swellGain = onePoleLP(swellGain, _swellLP, 0.02f);
+    }
+
+    // wet rate: predelay + both shimmer stages
+    FX_TRACE_LAP(t, "halfband");
+    float xw = (DECIM == 2) ? _dec.process(xs[0], xs[1]) : xs[0];
+
+    FX_TRACE_LAP(t, "predelay");
+    _pre.push(xw);
     float pre = _pre.readFrac(preS);
 
     float inWet = pre * swellGain;
 
-    float yUp = _up.process(inWet, fs, size, tone, upAmt, 2.0f, grainMsUp);
-    float yDn = _down.process(yUp,  fs, size, tone, dnAmt, 0.5f, grainMsDn);
+    FX_TRACE_LAP(t, "shimmerUp");
+    float yUp = _up.process(inWet, fsW, size, tone, upAmt, 2.0f, grainMsUp);
+    FX_TRACE_LAP(t, "shimmerDown");
+    float yDn = _down.process(yUp,  fsW, size, tone, dnAmt, 0.5f, grainMsDn);
+
+    FX_TRACE_LAP(t, "halfband");
+    float ys[2] = {yDn, 0.0f};
+    if(DECIM == 2) _int.process(yDn, ys[0], ys[1]);
 
-    float wet = yDn * wetGain;
+    // full rate: output stage
+    FX_TRACE_LAP(t, "output");
+    for(int j=0;j<DECIM;j++){
+      float wet = ys[j] * wetGain;
 
-    // keep hot but not fuzzy
-    wet = softSat(wet, 0.78f);
-    wet = onePoleHP_viaLP(wet, _outDC, 0.0008f);
-    wet = onePoleLP(wet, _outLP, 0.08f);
+      // keep hot but not fuzzy
+      wet = softSat(wet, 0.78f);
+      wet = onePoleHP_viaLP(wet, _outDC, 0.0008f);
+      wet = onePoleLP(wet, _outLP, 0.08f);
 
-    float out = (1.0f - mix) * dry + mix * wet;
-    outMono[i] = clamp16((int32_t)(out * 32767.0f));
+      float aw = fabsf(wet);
+      if(aw > wetPeak) wetPeak = aw;
+
+      float out = (1.0f - mix) * xs[j] + mix * wet;
+      outMono[i+j] = clamp16((int32_t)(out * 32767.0f));
+    }
+  }
+
+  // **************************
+  // Tail flush
+  // *****************
+  // Quiet output for longer than every delay in the chain means no
+  // energy is left hiding in a buffer either.
+  if(!quietIn || wetPeak >= SILENT_THRESH){
+    _quietSamples = 0;
+    _silent = false;
+  } else if(!_silent){
+    _quietSamples += n;
+    if(_quietSamples >= TAIL_SAMPLES &&
+       an.envEnd < SILENT_THRESH &&
+       _duck == duck0 && _swellLP == swellLP0){
+      flushTail();
+    }
   }
 }
+
+// full rate for the A/B reference, half rate for the pedal
+template class OrchestraEffectT<1>;
+template class OrchestraEffectT<2>;
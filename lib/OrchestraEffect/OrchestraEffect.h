@@ -1,7 +1,25 @@
 #pragma once
 #include <stdint.h>
-
-class OrchestraEffect {
+#include "BlockAnalysis.h"
+#include "FxBase.h"
+#include "Adaa.h"
+#include "LazyLine.h"
+
+// -DORCH_HALF_RATE=1 runs the wet path (predelay, pitch shift, combs,
+// allpasses) at fs/2 between a halfband decimator and interpolator.
+// Everything in there is low-passed well under fs/4, so this halves its
+// cost and buffer memory. Off by default: the comb lengths only halve to
+// the nearest sample, which moves the tail's 200-400 Hz band by ~1.4 dB
+// (tools/host/orch_bench).
+#ifndef ORCH_HALF_RATE
+#define ORCH_HALF_RATE 0
+#endif
+
+// WET_DECIM is the wet path's rate divider (1 or 2). Both are built so
+// tools/host/orch_bench can render one against the other; the pedal
+// uses OrchestraEffect below.
+template <int WET_DECIM>
+class OrchestraEffectT : public FxBase<OrchestraEffectT<WET_DECIM>> {
 public:
   // **************************
   // Params
@@ -15,11 +33,47 @@ public:
     float tone  = 0.55f; // brighter -> darker (fb LPF)
   };
 
-  OrchestraEffect();
+  // wet path runs at fs / DECIM
+  static constexpr int DECIM = WET_DECIM;
+  static_assert(DECIM == 1 || DECIM == 2, "full or half rate");
+
+  OrchestraEffectT();
   void reset();
-  void processMono(const int16_t* inMono, int16_t* outMono, int n, float fs, const Params& p);
+
+  // inMono and outMono may point at the same buffer
+  // swell envelope comes from the shared per-block input analysis
+  // n must be a multiple of DECIM
+  void processMono(const int16_t* inMono, int16_t* outMono, int n, float fs,
+                   const Params& p, const BlockAnalysis& a);
+
+  // **************************
+  // Idle
+  // *****************
+  // true once the tail has decayed and the state is parked at silence.
+  // While silent, call idle() instead of processMono() for blocks of
+  // zeros: output is zeros and only the grain phases advance.
+  bool isSilent() const { return _silent; }
+  void idle(int n, float fs, const Params& p);
+
+  // output saturation: OFF = plain tanh, ADAA1 anti-aliased (tanh has
+  // no ADAA2, see Adaa.h)
+  void setAntiAlias(Adaa::Mode m) { _outSat.setMode(m); }
+
+  // **************************
+  // FxBase interface
+  // *****************
+  void prepare(float fs, int maxBlock) { _fs = fs; (void)maxBlock; }
+  void setParams(const Params& p) { _p = p; }
+  void process(int16_t* data, int n, const BlockAnalysis& a) { processMono(data, data, n, _fs, _p, a); }
+  void idle(int n) { idle(n, _fs, _p); }
 
 private:
+  float  _fs = 44100.0f;
+  Params _p;
+
+  // one-pole coefficient tuned per full-rate sample -> same cutoff at fs/DECIM
+  static constexpr float wetA(float a) { return (DECIM == 2) ? a * (2.0f - a) : a; }
+
   // **************************
   // Helpers
   // *****************
@@ -29,14 +83,16 @@ private:
 
   static float onePoleLP(float x, float& y, float a);
   static float onePoleHP_viaLP(float x, float& lpState, float a);
-  static float softSat(float x, float drive);
+  float softSat(float x, float drive);
 
   // **************************
   // Predelay (frac delay)
   // *****************
+  // Lines below are Lazy::Line, so reset() and flushTail() only drop the
+  // written count instead of clearing ~100 KB.
   struct DelayLine {
-    static const int MAX = 8192;
-    float buf[MAX];
+    static const int MAX = 8192 / DECIM;
+    Lazy::Line<float, MAX> buf;
     int w = 0;
 
     void reset();
@@ -48,13 +104,14 @@ private:
   // PitchShift (4 grain + Hann)
   // *****************
   struct PitchShift {
-    static const int BUF = 8192;
-    float buf[BUF];
+    static const int BUF = 8192 / DECIM;
+    Lazy::Line<float, BUF> buf;
     int w = 0;
 
     float ph[4];
 
     void reset();
+    void advance(float ratio, float fs, float grainMs);
     float process(float x, float ratio, float fs, float grainMs);
     float readFrac(float delaySamp) const;
     static float hann(float p01);
@@ -64,8 +121,8 @@ private:
   // Comb / Allpass
   // *****************
   struct Comb {
-    static const int MAX = 4096;
-    float buf[MAX];
+    static const int MAX = 4096 / DECIM;
+    Lazy::Line<float, MAX> buf;
     int len = 1, idx = 0;
     float lp = 0.0f;
 
@@ -75,8 +132,8 @@ private:
   };
 
   struct Allpass {
-    static const int MAX = 2048;
-    float buf[MAX];
+    static const int MAX = 2048 / DECIM;
+    Lazy::Line<float, MAX> buf;
     int len = 1, idx = 0;
 
     void init(int delay);
@@ -84,6 +141,38 @@ private:
     float process(float x, float g);
   };
 
+  // **************************
+  // Halfband (2x down / up)
+  // *****************
+  // 23 tap Kaiser halfband, -71 dB above 16 kHz, flat to 6 kHz.
+  // Only the 6 odd tap pairs and the center are nonzero, so each
+  // side costs 6 MACs per wet sample. 11 samples of delay each way.
+  struct HbLine {
+    static const int LEN = 12;
+    float buf[2 * LEN]; // written twice, window is always contiguous
+    int p = 0;
+
+    void reset();
+    void push(float x);
+    const float* win() const { return &buf[p + 1]; } // oldest .. newest
+  };
+
+  static float hbTaps(const float* w);
+
+  struct Decimator {
+    HbLine even, odd;
+
+    void reset();
+    float process(float x0, float x1);
+  };
+
+  struct Interpolator {
+    HbLine u;
+
+    void reset();
+    void process(float x, float& y0, float& y1);
+  };
+
   // **************************
   // Shimmer Stage
   // *****************
@@ -98,6 +187,7 @@ private:
 
     void init();
     void reset();
+    void flush();
     float process(float x, float fs,
                   float size, float tone,
                   float shimmerAmt, float ratio,
@@ -107,10 +197,12 @@ private:
   // **************************
   // State
   // *****************
+  Decimator    _dec;
+  Interpolator _int;
+
   DelayLine _pre;
 
   // swell / ducking
-  float _env     = 0.0f;
   float _duck    = 1.0f;
   float _swellLP = 0.0f;
 
@@ -120,4 +212,19 @@ private:
   // output cleanup
   float _outLP = 0.0f;
   float _outDC = 0.0f;
+  Adaa::Shaper<Adaa::Tanh> _outSat;
+
+  // **************************
+  // Idle detection
+  // *****************
+  static constexpr float SILENT_THRESH = 1.0e-5f; // ~-100 dBFS
+  static constexpr int   TAIL_SAMPLES  =
+      DECIM * (DelayLine::MAX + 2 * (PitchShift::BUF + Comb::MAX + 2 * Allpass::MAX) + HbLine::LEN);
+
+  int  _quietSamples = 0;
+  bool _silent = false;
+
+  void flushTail();
 };
+
+using OrchestraEffect = OrchestraEffectT<ORCH_HALF_RATE ? 2 : 1>;
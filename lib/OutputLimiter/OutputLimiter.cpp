@@ -0,0 +1,146 @@
+#include "OutputLimiter.h"
+#include <math.h>
+#include <string.h>
+
+OutputLimiter::OutputLimiter() {
+  setSampleRate(44100.0f);
+  reset();
+}
+
+void OutputLimiter::setSampleRate(float fs) {
+  if (fs <= 0.0f) fs = 44100.0f;
+  _ceiling = 32767.0f * powf(10.0f, CEILING_DB / 20.0f);
+  _rel     = 1.0f - expf(-1000.0f / (RELEASE_MS * fs));
+}
+
+void OutputLimiter::reset() {
+  _n = 0;
+  memset(_h, 0, sizeof(_h));
+  memset(_delay, 0, sizeof(_delay));
+  _dqHead = _dqTail = 0;
+  _release = 1.0f;
+  for (int i = 0; i < BOX; i++) _box[i] = 1.0f;
+  _boxPos = 0;
+  _boxSum = (float)BOX;
+  _minGain = 1.0f;
+  _quiet = LATENCY + 3;
+  _parked = true;
+}
+
+bool OutputLimiter::process(int16_t* data, int n, float gain) {
+  _parked = false;
+
+  // exact sum once a block, the running one only drifts within it.
+  // Oldest first, so the rounding doesn't depend on where the ring
+  // starts (a reset puts it back at 0)
+  float boxSum = 0.0f;
+  for (int i = 0, j = _boxPos; i < BOX; i++) {
+    boxSum += _box[j];
+    if (++j == BOX) j = 0;
+  }
+
+  const float ceiling = _ceiling, rel = _rel;
+  float h0 = _h[0], h1 = _h[1], h2 = _h[2], h3 = _h[3];
+  float r = _release;
+  float minG = 1.0f;
+  uint32_t head = _dqHead, tail = _dqTail, t = _n;
+  int pos = _boxPos, quiet = _quiet;
+  bool clamped = false;
+  const uint32_t MASK = RING - 1;
+
+  for (int i = 0; i < n; i++) {
+    const float x = (float)data[i] * gain;
+
+    h0 = h1; h1 = h2; h2 = h3; h3 = x;
+
+    // sample t = h2, plus the point half way back to h1
+    const float mid = (9.0f * (h1 + h2) - (h0 + h3)) * (1.0f / 16.0f);
+    const float v = fmaxf(fabsf(h2), fabsf(mid));
+
+    // sliding max: drop what fell out of the window, then what v
+    // outlives, then push; at most HOLD - 1 entries before the push
+    while (head != tail && t - _dqIdx[head & MASK] >= (uint32_t)HOLD) head++;
+    while (tail != head && _dqVal[(tail - 1) & MASK] <= v) tail--;
+    _dqVal[tail & MASK] = v;
+    _dqIdx[tail & MASK] = t;
+    tail++;
+    const float peak = _dqVal[head & MASK];
+
+    const float target = (peak > ceiling) ? ceiling / peak : 1.0f;
+    r = (target < r) ? target : r + rel * (target - r);
+    if (target - r < RELEASE_SNAP) r = target;
+
+    // zeros in at unity gain; LATENCY + 3 of them also fill the box
+    quiet = (x == 0.0f && r == 1.0f) ? ((quiet < LATENCY + 3) ? quiet + 1 : quiet) : 0;
+
+    boxSum += r - _box[pos];
+    _box[pos] = r;
+    if (++pos == BOX) pos = 0;
+    const float g = boxSum * (1.0f / (float)BOX);
+    if (g < minG) minG = g;
+
+    _delay[t & MASK] = h2;
+    int32_t y = (int32_t)(_delay[(t - BOX) & MASK] * g);
+    t++;
+
+    if (y >= 32767) { y = 32767; clamped = true; }
+    else if (y <= -32768) { y = -32768; clamped = true; }
+    data[i] = (int16_t)y;
+  }
+
+  _h[0] = h0; _h[1] = h1; _h[2] = h2; _h[3] = h3;
+  _release = r;
+  _dqHead = head;
+  _dqTail = tail;
+  _n = t;
+  _boxPos = pos;
+  _quiet = quiet;
+  _minGain = minG;
+  return clamped;
+}
+
+// **************************
+// Benchmark
+// *****************
+void OutputLimiter::benchmark(Print& out, uint32_t (*ticks)(), uint32_t budget) {
+  static constexpr int BLOCK = 128;
+  static constexpr int RUNS  = 8;
+
+  // 2x over full scale, so the limiter works the whole block
+  int16_t in[BLOCK], buf[BLOCK];
+  for (int i = 0; i < BLOCK; i++) in[i] = (int16_t)(16000.0f * sinf(0.0623f * (float)i));
+
+  static const char* NAMES[3] = { "clamp", "limiter idle", "limiter hot" };
+  uint32_t best[3];
+  OutputLimiter lim;
+  for (int c = 0; c < 3; c++) {
+    const float gain = (c == 1) ? 0.5f : 2.0f;
+    best[c] = 0xffffffffu;
+    for (int r = 0; r < RUNS; r++) {
+      memcpy(buf, in, sizeof(buf));
+      uint32_t t0 = ticks();
+      if (c == 0) {
+        for (int i = 0; i < BLOCK; i++) {
+          int32_t y = (int32_t)((float)buf[i] * gain);
+          if (y >= 32767) y = 32767;
+          else if (y <= -32768) y = -32768;
+          buf[i] = (int16_t)y;
+        }
+      } else {
+        lim.process(buf, BLOCK, gain);
+      }
+      uint32_t dt = ticks() - t0;
+      if (dt < best[c]) best[c] = dt;
+    }
+
+    out.print("output ");
+    out.print(NAMES[c]);
+    out.print(": ");
+    out.print((unsigned long)best[c]);
+    out.print(" ticks/block, ");
+    out.print((double)best[c] / (double)BLOCK, 2);
+    out.print(" ticks/sample, ");
+    out.print(100.0 * (double)best[c] / (double)budget, 2);
+    out.println("% of budget");
+  }
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+
+// **************************
+// OutputLimiter
+// *****************
+// Last stage in FxStream: volume, then a look-ahead peak limiter instead
+// of a hard clamp at full scale.
+//
+//   detect   max(|x|, |half-sample cubic between x[n-1] and x[n]|), a
+//            cheap stand-in for the inter-sample (true) peak
+//   hold     sliding max over HOLD samples, monotonic deque, O(1)
+//            amortised per sample
+//   gain     ceiling / held peak, instant attack, one-pole release
+//   smooth   moving average over BOX = HOLD - 1 samples, so the gain
+//            ramps down over the look-ahead and reaches the needed
+//            value as the peak leaves the delay line
+//
+// Signal under the ceiling passes unchanged, only LATENCY samples later.
+class OutputLimiter {
+public:
+  static constexpr int HOLD    = 64;       // look-ahead window, ~1.5 ms
+  static constexpr int BOX     = HOLD - 1; // gain smoothing length
+  static constexpr int LATENCY = BOX + 1;  // samples, the detector lags one
+
+  static constexpr float CEILING_DB = -0.5f;  // dBFS
+  static constexpr float RELEASE_MS = 60.0f;
+
+  // the release one-pole stops moving this close to its target (the
+  // step rounds away), so it snaps the rest: unity gain really is 1
+  static constexpr float RELEASE_SNAP = 1.0e-4f;
+
+  OutputLimiter();
+  void setSampleRate(float fs);
+  void reset();
+
+  // In place, y = limit(x * gain). True if the safety clamp still had to
+  // act (it shouldn't); minGain() is the deepest reduction of the block.
+  bool process(int16_t* data, int n, float gain);
+  float minGain() const { return _minGain; }
+
+  // nothing left in the delay line or the detector history, gain at rest
+  bool isSilent() const { return _quiet >= LATENCY + 3; }
+
+  // a skipped (all zero) block: start over at unity gain, once
+  void idle() { if (!_parked) reset(); }
+
+  // Per-sample cost against the plain clamp; ticks() is a free running
+  // counter, budget is ticks per audio block.
+  static void benchmark(Print& out, uint32_t (*ticks)(), uint32_t budget);
+
+private:
+  static constexpr int RING = 64; // delay line, power of two >= LATENCY
+  static_assert((RING & (RING - 1)) == 0 && RING >= LATENCY, "delay ring");
+  static_assert(HOLD <= RING, "deque holds at most HOLD entries (evicted before the push)");
+
+  float _ceiling = 30934.0f; // int16 units
+  float _rel     = 0.0004f;
+
+  // **************************
+  // State
+  // *****************
+  uint32_t _n = 0;      // detector sample count
+  float    _h[4];       // input history, _h[3] newest
+
+  float    _delay[RING];
+
+  // sliding max: values decreasing from head to tail
+  float    _dqVal[RING];
+  uint32_t _dqIdx[RING];
+  uint32_t _dqHead = 0, _dqTail = 0;
+
+  float    _release = 1.0f; // held gain after the release one-pole
+  float    _box[BOX];
+  int      _boxPos = 0;
+  float    _boxSum = (float)BOX;
+
+  float    _minGain = 1.0f;
+  int      _quiet = LATENCY + 3; // zero samples in a row at unity gain
+  bool     _parked = false;       // reset since the last process()
+};
@@ -0,0 +1,151 @@
+#pragma once
+#include <stdint.h>
+
+// **************************
+// Knob maps
+// *****************
+// Knob -> parameter curves built at compile time, one entry per 10 bit
+// ADC step. A lookup replaces the per-block powf/expf/divide, and the
+// curve for each knob is a line of data instead of a formula in the
+// mode code.
+//
+//   linear(lo, hi)          straight line
+//   logTaper(lo, hi)        equal ratio per step (rates, cutoffs)
+//   audioTaper(dB)          -dB..0 dB, last few steps fade to zero (volume)
+//   lpfCoef / hpfCoef       log cutoff sweep stored as the OnePole
+//                           coefficient the filter actually uses
+//
+// lo > hi gives a reversed knob. Each table is 4 KB, keep them in
+// flash (PROGMEM) on the Teensy.
+//
+// Typical use:
+//   static constexpr ParamMap::Table RATE PROGMEM = ParamMap::logTaper(0.2f, 12.0f);
+//   float hz = RATE(k3);
+namespace ParamMap {
+
+static constexpr int STEPS = 1024; // 10 bit ADC
+
+// smoothed 0..1 knob -> nearest ADC step (NaN lands on step 0)
+static inline int index(float k01) {
+  if (!(k01 > 0.0f)) return 0;
+  if (k01 >= 1.0f) return STEPS - 1;
+  return (int)(k01 * (float)(STEPS - 1) + 0.5f);
+}
+
+struct Table {
+  float v[STEPS];
+
+  constexpr float operator[](int i) const { return v[i]; }
+  float operator()(float k01) const { return v[index(k01)]; }
+};
+
+// **************************
+// constexpr math
+// *****************
+// <cmath> isn't constexpr, so just enough of exp/log to fill tables.
+// Doubles inside, well under float precision.
+namespace cx {
+
+static constexpr double PI  = 3.14159265358979323846;
+static constexpr double LN2 = 0.69314718055994530942;
+
+constexpr double exp(double x) {
+  // x = n*ln2 + r, |r| <= ln2/2
+  int n = (int)(x / LN2 + (x < 0.0 ? -0.5 : 0.5));
+  double r = x - n * LN2;
+
+  double term = 1.0, sum = 1.0;
+  for (int k = 1; k < 16; k++) {
+    term *= r / k;
+    sum += term;
+  }
+
+  for (; n > 0; n--) sum *= 2.0;
+  for (; n < 0; n++) sum *= 0.5;
+  return sum;
+}
+
+constexpr double log(double x) {
+  // x = m * 2^e, m in [0.75, 1.5)
+  int e = 0;
+  while (x >= 1.5)  { x *= 0.5; e++; }
+  while (x < 0.75)  { x *= 2.0; e--; }
+
+  // ln m = 2 atanh((m-1)/(m+1))
+  double z = (x - 1.0) / (x + 1.0);
+  double z2 = z * z;
+  double term = z, sum = 0.0;
+  for (int k = 1; k < 40; k += 2) {
+    sum += term / k;
+    term *= z2;
+  }
+  return 2.0 * sum + e * LN2;
+}
+
+} // namespace cx
+
+// **************************
+// Curves
+// *****************
+// knob position of step i
+constexpr double pos(int i) { return (double)i / (double)(STEPS - 1); }
+
+constexpr double logAt(double lo, double hi, int i) {
+  return lo * cx::exp(pos(i) * cx::log(hi / lo));
+}
+
+constexpr Table linear(float lo, float hi) {
+  Table t{};
+  for (int i = 0; i < STEPS; i++) t.v[i] = (float)(lo + (hi - lo) * pos(i));
+  return t;
+}
+
+constexpr Table logTaper(float lo, float hi) {
+  Table t{};
+  for (int i = 0; i < STEPS; i++) t.v[i] = (float)logAt(lo, hi, i);
+  return t;
+}
+
+// gain, 0 dB at the top, -rangeDb at 5% travel, then a straight fade to 0
+constexpr Table audioTaper(float rangeDb) {
+  constexpr double FADE = 0.05;
+  Table t{};
+  for (int i = 0; i < STEPS; i++) {
+    double p = pos(i);
+    double q = (p < FADE) ? FADE : p;
+    double db = -rangeDb * (1.0 - q) / (1.0 - FADE);
+    double g = cx::exp(db * cx::log(10.0) / 20.0);
+    if (p < FADE) g *= p / FADE;
+    t.v[i] = (float)g;
+  }
+  return t;
+}
+
+// **************************
+// OnePole coefficients
+// *****************
+// same formulas as SimpleFX::OnePoleLPF / OnePoleHPF::setCutoffHz
+
+// y = (1-a)x + a*y1, a = exp(-2*pi*fc/fs)
+constexpr float lpfA(double fc, double fs) {
+  return (float)cx::exp(-2.0 * cx::PI * fc / fs);
+}
+
+// y = a(y1 + x - x1), a = rc / (rc + dt)
+constexpr float hpfA(double fc, double fs) {
+  return (float)(1.0 / (1.0 + 2.0 * cx::PI * fc / fs));
+}
+
+constexpr Table lpfCoef(float loHz, float hiHz, float fs) {
+  Table t{};
+  for (int i = 0; i < STEPS; i++) t.v[i] = lpfA(logAt(loHz, hiHz, i), fs);
+  return t;
+}
+
+constexpr Table hpfCoef(float loHz, float hiHz, float fs) {
+  Table t{};
+  for (int i = 0; i < STEPS; i++) t.v[i] = hpfA(logAt(loHz, hiHz, i), fs);
+  return t;
+}
+
+} // namespace ParamMap
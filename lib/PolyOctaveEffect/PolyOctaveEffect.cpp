@@ -0,0 +1,186 @@
+#include "PolyOctaveEffect.h"
+#include <math.h>
+
+// **************************
+// Tuning
+// *****************
+// band centers cover guitar fundamentals + low harmonics
+static constexpr float BAND_LO_HZ = 70.0f;
+static constexpr float BAND_HI_HZ = 1400.0f;
+
+// focus knob is quantized so coefs only rebuild on real moves
+static constexpr int FOCUS_STEPS = 16;
+
+// sum of halved bands -> sub about as loud as the played fundamental
+// (each band only carries the positive-frequency half of a partial)
+static constexpr float OUT_GAIN = 3.6f;
+
+// samples processed per pass over the bank
+static constexpr int CHUNK = 128;
+
+PolyOctaveEffect::PolyOctaveEffect() { reset(); }
+
+void PolyOctaveEffect::reset() {
+  clearBands();
+
+  _gateGain = 0.0f;
+  _postLP   = 0.0f;
+
+  _silent = false;
+}
+
+void PolyOctaveEffect::clearBands() {
+  for (int b = 0; b < MAX_BANDS; b++) {
+    _z1Re[b] = _z1Im[b] = 0.0f;
+    _z2Re[b] = _z2Im[b] = 0.0f;
+    _hRe[b]  = _hIm[b]  = 0.0f;
+  }
+}
+
+void PolyOctaveEffect::setBands(int bands) {
+  bands = (bands < MIN_BANDS) ? MIN_BANDS : (bands > MAX_BANDS ? MAX_BANDS : bands);
+  if (bands == _bands) return;
+
+  _bands = bands;
+  _coefFocus = -1; // force rebuild
+  clearBands();
+}
+
+float PolyOctaveEffect::clamp01(float x) {
+  if (!(x > 0.0f)) return 0.0f; // NaN -> 0
+  if (x > 1.0f) return 1.0f;
+  return x;
+}
+
+int16_t PolyOctaveEffect::clamp16(int32_t x) {
+  if (x > 32767) return 32767;
+  if (x < -32768) return -32768;
+  return (int16_t)x;
+}
+
+float PolyOctaveEffect::lerp(float a, float b, float t) { return a + (b - a) * t; }
+
+// log-spaced centers, bandwidth a multiple of the band spacing
+void PolyOctaveEffect::updateCoefs(float fs, int focusStep) {
+  _coefFs    = fs;
+  _coefFocus = focusStep;
+
+  float focus = (float)focusStep / (float)(FOCUS_STEPS - 1);
+  float bwScale = lerp(1.6f, 0.6f, focus); // narrow => less band overlap
+
+  float spacing = powf(BAND_HI_HZ / BAND_LO_HZ, 1.0f / (float)(_bands - 1));
+
+  float fc = BAND_LO_HZ;
+  for (int b = 0; b < _bands; b++) {
+    float bw = fc * (spacing - 1.0f) * bwScale;
+    float r  = expf(-3.14159265f * bw / fs);
+    float w  = 2.0f * 3.14159265f * fc / fs;
+
+    _pRe[b] = r * cosf(w);
+    _pIm[b] = r * sinf(w);
+    _g[b]   = 1.0f - r; // per stage, unity at center
+
+    fc *= spacing;
+  }
+}
+
+float PolyOctaveEffect::bandPeak() const {
+  float pk = 0.0f;
+  for (int b = 0; b < _bands; b++) {
+    float a = fabsf(_z1Re[b]) + fabsf(_z1Im[b]) + fabsf(_z2Re[b]) + fabsf(_z2Im[b]);
+    if (a > pk) pk = a;
+  }
+  return pk;
+}
+
+void PolyOctaveEffect::processMono(const int16_t* monoIn, int16_t* monoOut, int n, float fs,
+                                   const Params& pIn, const BlockAnalysis& an) {
+  float blend = clamp01(pIn.blend);
+  float focus = clamp01(pIn.focus);
+  float tone  = clamp01(pIn.tone);
+
+  int focusStep = (int)(focus * (float)(FOCUS_STEPS - 1) + 0.5f);
+  if (fs != _coefFs || focusStep != _coefFocus) updateCoefs(fs, focusStep);
+
+  float postHz = lerp(300.0f, 3000.0f, tone);
+  float postA = postHz / fs;
+  if (postA < 0.001f) postA = 0.001f;
+  if (postA > 0.45f)  postA = 0.45f;
+
+  // sub follows the shared gate, ramped over the block
+  float gateTarget = an.gate ? 1.0f : 0.0f;
+  float gateStep = (gateTarget - _gateGain) / (float)n;
+
+  bool  quietIn = true;
+  float wetPeak = 0.0f;
+
+  float x[CHUNK];
+  float sub[CHUNK];
+
+  for (int i0 = 0; i0 < n; i0 += CHUNK) {
+    int m = (n - i0 < CHUNK) ? (n - i0) : CHUNK;
+
+    for (int j = 0; j < m; j++) {
+      if (monoIn[i0 + j] != 0) quietIn = false;
+      x[j] = (float)monoIn[i0 + j] / 32768.0f;
+      sub[j] = 0.0f;
+    }
+
+    // **************************
+    // bank: one band at a time, state stays in registers
+    // *****************
+    for (int b = 0; b < _bands; b++) {
+      const float pr = _pRe[b], pi = _pIm[b], g = _g[b];
+      float z1r = _z1Re[b], z1i = _z1Im[b];
+      float z2r = _z2Re[b], z2i = _z2Im[b];
+      float hr  = _hRe[b],  hi  = _hIm[b];
+
+      for (int j = 0; j < m; j++) {
+        // two complex one-poles in series
+        float t1r = pr * z1r - pi * z1i + g * x[j];
+        float t1i = pr * z1i + pi * z1r;
+        z1r = t1r; z1i = t1i;
+
+        float t2r = pr * z2r - pi * z2i + g * z1r;
+        float t2i = pr * z2i + pi * z2r;
+        z2r = t2r; z2i = t2i;
+
+        sub[j] += halfAngle(z2r, z2i, hr, hi);
+      }
+
+      _z1Re[b] = z1r; _z1Im[b] = z1i;
+      _z2Re[b] = z2r; _z2Im[b] = z2i;
+      _hRe[b]  = hr;  _hIm[b]  = hi;
+    }
+
+    // **************************
+    // tone + gate + blend
+    // *****************
+    for (int j = 0; j < m; j++) {
+      _gateGain += gateStep;
+
+      _postLP += postA * (sub[j] * OUT_GAIN - _postLP);
+      float wet = _postLP * _gateGain;
+
+      float aw = fabsf(wet);
+      if (aw > wetPeak) wetPeak = aw;
+
+      float y = (1.0f - blend) * x[j] + blend * wet;
+      monoOut[i0 + j] = clamp16((int32_t)(y * 32767.0f));
+    }
+  }
+
+  _gateGain = gateTarget; // no drift from the ramp adds
+
+  // **************************
+  // tail flush
+  // *****************
+  if (!quietIn) {
+    _silent = false;
+  } else if (!_silent && wetPeak < SILENT_THRESH &&
+             fabsf(_postLP) < SILENT_THRESH && bandPeak() < SILENT_THRESH) {
+    clearBands();
+    _postLP = 0.0f;
+    _silent = true;
+  }
+}
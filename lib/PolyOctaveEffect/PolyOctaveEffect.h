@@ -0,0 +1,125 @@
+#pragma once
+#include <Arduino.h>
+#include <math.h>
+#include <stdint.h>
+#include "BlockAnalysis.h"
+#include "FxBase.h"
+
+// **************************
+// PolyOctaveEffect
+// *****************
+// Polyphonic octave down. The input is split by a bank of complex
+// resonators (2x complex one-pole per band, log spaced). Each band's
+// output is an analytic signal, so halving its phase angle (complex
+// sqrt, sign kept continuous) drops that band an octave. The halved
+// bands are summed back, so every note in a chord gets its own sub.
+class PolyOctaveEffect : public FxBase<PolyOctaveEffect> {
+public:
+  // **************************
+  // Params
+  // *****************
+  struct Params {
+    float blend = 0.0f; // dry/wet
+    float focus = 0.0f; // band width: wide/fast -> narrow/clean chords
+    float tone  = 0.0f; // sub lowpass: dark -> bright
+  };
+
+  static constexpr int MIN_BANDS = 16;
+  static constexpr int MAX_BANDS = 64;
+
+  PolyOctaveEffect();
+  void reset();
+
+  // 16..64 bands spread over the guitar range, default 32
+  void setBands(int bands);
+  int  bands() const { return _bands; }
+
+  // monoIn and monoOut may point at the same buffer
+  // gate comes from the shared per-block input analysis
+  void processMono(const int16_t* monoIn, int16_t* monoOut, int n, float fs,
+                   const Params& p, const BlockAnalysis& a);
+
+  // **************************
+  // Half angle
+  // *****************
+  // One band's octave down from its analytic sample z: z + |z| bisects 0
+  // and arg(z). Of the two roots it keeps the one closest to the last
+  // bisector h (updated), then rescales to |z| and returns the real part.
+  static float halfAngle(float zr, float zi, float& hr, float& hi) {
+    float mag = sqrtf(zr * zr + zi * zi);
+    float cr = zr + mag;
+    float ci = zi;
+
+    // on the negative real axis z + |z| is 0 (or only rounding): there
+    // the roots are +-i|z|, and h must not lose its side
+    if (cr * cr + ci * ci <= AXIS_EPS * mag * mag) { cr = 0.0f; ci = mag; }
+
+    if (cr * hr + ci * hi < 0.0f) { cr = -cr; ci = -ci; }
+    hr = cr; hi = ci;
+
+    float h2 = cr * cr + ci * ci;
+    return (h2 > 1.0e-24f) ? cr * mag / sqrtf(h2) : 0.0f;
+  }
+
+  // **************************
+  // Idle
+  // *****************
+  // true once every band has rung out and the state is parked at zero.
+  // Nothing free-runs, so silent blocks can simply be skipped.
+  bool isSilent() const { return _silent; }
+
+  // **************************
+  // FxBase interface
+  // *****************
+  void prepare(float fs, int maxBlock) { _fs = fs; (void)maxBlock; }
+  void setParams(const Params& p) { _p = p; }
+  void process(int16_t* data, int n, const BlockAnalysis& a) { processMono(data, data, n, _fs, _p, a); }
+
+private:
+  float  _fs = 44100.0f;
+  Params _p;
+
+  // **************************
+  // Band bank (SoA)
+  // *****************
+  // one array per field so the per-band loop walks memory linearly
+  float _pRe[MAX_BANDS];  // pole
+  float _pIm[MAX_BANDS];
+  float _g[MAX_BANDS];    // input gain (unity at center)
+
+  float _z1Re[MAX_BANDS]; // stage 1 state
+  float _z1Im[MAX_BANDS];
+  float _z2Re[MAX_BANDS]; // stage 2 state (analytic band signal)
+  float _z2Im[MAX_BANDS];
+  float _hRe[MAX_BANDS];  // last half-angle vector (sign tracking)
+  float _hIm[MAX_BANDS];
+
+  int   _bands = 32;
+
+  // coefs are rebuilt only when these change
+  float _coefFs    = 0.0f;
+  int   _coefFocus = -1;
+
+  // **************************
+  // Output state
+  // *****************
+  float _gateGain = 0.0f; // follows the analysis gate
+  float _postLP   = 0.0f; // tone
+
+  static constexpr float AXIS_EPS = 1.0e-12f; // relative, |z + |z||^2 / |z|^2
+
+  // idle detection
+  static constexpr float SILENT_THRESH = 1.0e-5f; // ~-100 dBFS
+  bool _silent = false;
+
+  // **************************
+  // Helpers
+  // *****************
+  static float clamp01(float x);
+  static int16_t clamp16(int32_t x);
+  static float lerp(float a, float b, float t);
+
+  void updateCoefs(float fs, int focusStep);
+  void clearBands();
+  float bandPeak() const;
+};
@@ -0,0 +1,378 @@
+#include "SdLooper.h"
+#include <string.h>
+
+#if !defined(ARDUINO)
+#include <chrono>
+#include <thread>
+#endif
+
+// **************************
+// Rings
+// *****************
+// Big rings go in OCRAM (DMAMEM) on the Teensy, DTCM stays free for
+// effect state. The card staging buffer is loop()-only.
+#if defined(ARDUINO)
+#define LOOPER_RAM DMAMEM
+#else
+#define LOOPER_RAM
+#endif
+
+static constexpr int BLOCK = SdLooper::BLOCK;
+static constexpr int RING  = SdLooper::RING_BLOCKS;
+static constexpr int CHUNK = SdLooper::CHUNK_BLOCKS;
+
+static constexpr uint32_t NO_TAG = 0xFFFFFFFFu;
+
+static LOOPER_RAM int16_t readRing[RING * BLOCK] __attribute__((aligned(32)));
+static LOOPER_RAM int16_t writeRing[RING * BLOCK] __attribute__((aligned(32)));
+static uint32_t readTag[RING];  // play block held by each slot
+static uint32_t writeTag[RING]; // write key held by each slot
+
+static int16_t ioBuf[CHUNK * BLOCK] __attribute__((aligned(32)));
+
+static const char* loopPath = nullptr;
+
+// **************************
+// LoopFile
+// *****************
+#if defined(ARDUINO)
+
+bool LoopFile::open(const char* path) {
+  close();
+  SD.remove(path);
+  _f = SD.open(path, FILE_WRITE_BEGIN);
+  return (bool)_f;
+}
+
+void LoopFile::close() {
+  if (_f) _f.close();
+}
+
+bool LoopFile::read(uint32_t at, int16_t* dst, int blocks) {
+  size_t bytes = (size_t)blocks * BLOCK * sizeof(int16_t);
+  if (!_f.seek((uint64_t)at * BLOCK * sizeof(int16_t))) return false;
+
+  int got = _f.read(dst, bytes);
+  if (got < 0) got = 0;
+  if ((size_t)got < bytes) memset((uint8_t*)dst + got, 0, bytes - got);
+  return true;
+}
+
+bool LoopFile::write(uint32_t at, const int16_t* src, int blocks) {
+  size_t bytes = (size_t)blocks * BLOCK * sizeof(int16_t);
+  if (!_f.seek((uint64_t)at * BLOCK * sizeof(int16_t))) return false;
+  return _f.write((const uint8_t*)src, bytes) == bytes;
+}
+
+#else
+
+bool LoopFile::open(const char* path) {
+  close();
+  _f = fopen(path, "w+b");
+  return _f != nullptr;
+}
+
+void LoopFile::close() {
+  if (_f) fclose(_f);
+  _f = nullptr;
+}
+
+// stand-in for a card that sometimes goes away for a while
+void LoopFile::stall() {
+  if (_everyN <= 0 || _spikeMs <= 0) return;
+  if (++_count % _everyN) return;
+  std::this_thread::sleep_for(std::chrono::milliseconds(_spikeMs));
+}
+
+bool LoopFile::read(uint32_t at, int16_t* dst, int blocks) {
+  stall();
+  size_t count = (size_t)blocks * BLOCK;
+  if (fseek(_f, (long)at * BLOCK * (long)sizeof(int16_t), SEEK_SET) != 0) return false;
+
+  size_t got = fread(dst, sizeof(int16_t), count, _f);
+  if (got < count) memset(dst + got, 0, (count - got) * sizeof(int16_t));
+  return true;
+}
+
+bool LoopFile::write(uint32_t at, const int16_t* src, int blocks) {
+  stall();
+  size_t count = (size_t)blocks * BLOCK;
+  if (fseek(_f, (long)at * BLOCK * (long)sizeof(int16_t), SEEK_SET) != 0) return false;
+  return fwrite(src, sizeof(int16_t), count, _f) == count;
+}
+
+#endif
+
+// **************************
+// Sync
+// *****************
+// ISR and loop() each own their counters, the other side only reads
+uint32_t SdLooper::ld(const uint32_t& v) { return __atomic_load_n(&v, __ATOMIC_ACQUIRE); }
+void SdLooper::st(uint32_t& v, uint32_t x) { __atomic_store_n(&v, x, __ATOMIC_RELEASE); }
+
+SdLooper::State SdLooper::state() const {
+  return (State)__atomic_load_n(&_state, __ATOMIC_ACQUIRE);
+}
+
+SdLooper::Stats SdLooper::stats() const {
+  Stats s;
+  s.underruns = ld(_underruns);
+  s.overruns  = ld(_overruns);
+  return s;
+}
+
+uint32_t SdLooper::loopBlocks() const { return ld(_loopLen); }
+
+size_t SdLooper::memoryBytes() const {
+  return sizeof(*this) + sizeof(readRing) + sizeof(writeRing) +
+         sizeof(readTag) + sizeof(writeTag) + sizeof(ioBuf);
+}
+
+static inline int16_t sat16(float x) {
+  if (x > 32767.0f) return 32767;
+  if (x < -32768.0f) return -32768;
+  return (int16_t)x;
+}
+
+// **************************
+// Setup
+// *****************
+bool SdLooper::begin(const char* path) {
+  loopPath = path;
+  _fileOk = _file.open(path);
+  reset();
+  return _fileOk;
+}
+
+void SdLooper::clearRings() {
+  for (int s = 0; s < RING; s++) {
+    readTag[s]  = NO_TAG;
+    writeTag[s] = NO_TAG;
+  }
+}
+
+void SdLooper::reset() {
+  __atomic_store_n(&_state, (uint8_t)EMPTY, __ATOMIC_RELEASE);
+  __atomic_store_n(&_tapReq, (uint8_t)0, __ATOMIC_RELEASE);
+
+  clearRings();
+
+  st(_loopLen, 0);
+  st(_playPos, 0);
+  st(_wKey, 0);
+  st(_wFlushed, 0);
+  st(_rFetched, 0);
+  st(_underruns, 0);
+  st(_overruns, 0);
+
+  _readsArmed = false;
+}
+
+void SdLooper::tap() {
+  if (!_fileOk) return;
+
+  if (state() == EMPTY) {
+    // fresh take: new file, rings and counters start at zero
+    _fileOk = _file.open(loopPath);
+    if (!_fileOk) return;
+
+    reset();
+    __atomic_store_n(&_state, (uint8_t)RECORD, __ATOMIC_RELEASE);
+    return;
+  }
+
+  // the rest switch on a block boundary inside the interrupt
+  __atomic_store_n(&_tapReq, (uint8_t)1, __ATOMIC_RELEASE);
+}
+
+// **************************
+// Interrupt side
+// *****************
+// Write keys:
+//   RECORD      key = file block (0..L-1)
+//   PLAY / DUB  key = L + play block, so key % L is still the file block
+// One counter covers both, and the key a block was written under is
+// the play block that reads it back next pass.
+void SdLooper::applyTap() {
+  uint8_t s = _state;
+
+  if (s == RECORD) {
+    uint32_t len = _wKey; // blocks recorded
+    if (len == 0) return;
+
+    st(_loopLen, len);
+    st(_playPos, 0);
+    __atomic_store_n(&_state, (uint8_t)PLAY, __ATOMIC_RELEASE);
+  } else if (s == PLAY) {
+    __atomic_store_n(&_state, (uint8_t)OVERDUB, __ATOMIC_RELEASE);
+  } else if (s == OVERDUB) {
+    __atomic_store_n(&_state, (uint8_t)PLAY, __ATOMIC_RELEASE);
+  }
+}
+
+void SdLooper::processBlock(int16_t* data, const Params& p) {
+  if (__atomic_exchange_n(&_tapReq, (uint8_t)0, __ATOMIC_ACQ_REL)) applyTap();
+
+  const uint8_t s = _state;
+  if (s == EMPTY) return;
+
+  const uint32_t key = _wKey;
+
+  // **************************
+  // first take
+  // *****************
+  if (s == RECORD) {
+    int slot = key % RING;
+
+    if (key < ld(_wFlushed) + RING) {
+      memcpy(&writeRing[slot * BLOCK], data, BLOCK * sizeof(int16_t));
+      st(writeTag[slot], key);
+    } else {
+      st(_overruns, _overruns + 1);
+    }
+
+    // the start of the take is also the start of playback,
+    // keep it so PLAY doesn't wait on the card
+    if (key < (uint32_t)RING) {
+      memcpy(&readRing[slot * BLOCK], data, BLOCK * sizeof(int16_t));
+      st(readTag[slot], key);
+    }
+
+    st(_wKey, key + 1);
+    return;
+  }
+
+  // **************************
+  // play / overdub
+  // *****************
+  const uint32_t pos = _playPos;
+  const int slot = pos % RING;
+
+  // prefetched from the card, else still in the write ring from last pass
+  const int16_t* loop = nullptr;
+  if (ld(readTag[slot]) == pos)       loop = &readRing[slot * BLOCK];
+  else if (ld(writeTag[slot]) == pos) loop = &writeRing[slot * BLOCK];
+  else st(_underruns, _underruns + 1);
+
+  // the new layer, when overdubbing. With L a multiple of RING it is the
+  // same write ring slot loop may point at, so each sample is read once
+  // and played before the layer replaces it
+  const int ws = key % RING;
+  int16_t* w = nullptr;
+  if (s == OVERDUB) {
+    if (key < ld(_wFlushed) + RING) w = &writeRing[ws * BLOCK];
+    else st(_overruns, _overruns + 1);
+  }
+
+  if (loop || w) {
+    for (int i = 0; i < BLOCK; i++) {
+      const float l = loop ? (float)loop[i] : 0.0f;
+      const float x = (float)data[i];
+      data[i] = sat16(x + p.level * l);
+      if (w) w[i] = sat16(l * p.feedback + x);
+    }
+  }
+  if (w) st(writeTag[ws], key);
+
+  st(_playPos, pos + 1);
+  st(_wKey, key + 1);
+}
+
+// **************************
+// loop() side
+// *****************
+void SdLooper::service() {
+  if (!_fileOk || state() == EMPTY) return;
+
+  flushWrites();
+  prefetchReads();
+}
+
+// oldest pending write keys -> card, one contiguous file run at a time
+void SdLooper::flushWrites() {
+  for (;;) {
+    const uint32_t end = ld(_wKey);
+    const uint32_t len = ld(_loopLen); // 0 while recording the first take
+    const bool recording = (state() == RECORD);
+
+    uint32_t k = _wFlushed;
+    if (k >= end) return;
+
+    // clean blocks (played, not overdubbed) need no I/O
+    if (len && k >= len && ld(writeTag[k % RING]) != k) {
+      st(_wFlushed, k + 1);
+      continue;
+    }
+
+    // one run: contiguous in the file, no clean blocks inside
+    uint32_t fileAt = len ? (k % len) : k;
+    uint32_t maxRun = CHUNK;
+    if (len && len - fileAt < maxRun) maxRun = len - fileAt;
+
+    uint32_t run = 0;
+    while (run < maxRun && k + run < end) {
+      uint32_t kk = k + run;
+      if (len && kk >= len && ld(writeTag[kk % RING]) != kk) break;
+      run++;
+    }
+
+    // wait for a full chunk while more is on its way
+    bool more = recording || state() == OVERDUB;
+    if (more && run < maxRun && k + run == end) return;
+
+    for (uint32_t j = 0; j < run; j++) {
+      uint32_t kk = k + j;
+      int16_t* dst = &ioBuf[j * BLOCK];
+
+      // first take keeps the file contiguous, a dropped block becomes silence
+      if (ld(writeTag[kk % RING]) == kk) memcpy(dst, &writeRing[(kk % RING) * BLOCK], BLOCK * sizeof(int16_t));
+      else memset(dst, 0, BLOCK * sizeof(int16_t));
+    }
+
+    _file.write(fileAt, ioBuf, (int)run);
+    st(_wFlushed, k + run);
+  }
+}
+
+// card -> read ring, as far ahead as the ring and the write-back allow
+void SdLooper::prefetchReads() {
+  const uint32_t len = ld(_loopLen);
+  if (len == 0 || state() == RECORD) return;
+
+  // the first take already sits in the read ring
+  if (!_readsArmed) {
+    st(_rFetched, (len < (uint32_t)RING) ? len : (uint32_t)RING);
+    _readsArmed = true;
+  }
+
+  for (;;) {
+    uint32_t p   = _rFetched;
+    uint32_t pos = ld(_playPos);
+
+    // fell behind the play head, those blocks were already missed
+    if (p < pos) p = pos;
+
+    // ring space, and last pass's write for the same file block is out
+    uint32_t limit = pos + RING;
+    uint32_t flushed = ld(_wFlushed);
+    if (flushed < limit) limit = flushed;
+    if (p >= limit) { st(_rFetched, p); return; }
+
+    uint32_t fileAt = p % len;
+    uint32_t want = CHUNK;
+    if (len - fileAt < want) want = len - fileAt;
+
+    // wait until a whole chunk fits
+    if (limit - p < want) { st(_rFetched, p); return; }
+
+    _file.read(fileAt, ioBuf, (int)want);
+
+    for (uint32_t j = 0; j < want; j++) {
+      int slot = (p + j) % RING;
+      memcpy(&readRing[slot * BLOCK], &ioBuf[j * BLOCK], BLOCK * sizeof(int16_t));
+      st(readTag[slot], p + j);
+    }
+
+    st(_rFetched, p + want);
+  }
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include <stdint.h>
+#include "FxBase.h"
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#include <SD.h>
+#else
+#include <stdio.h>
+#endif
+
+// **************************
+// LoopFile
+// *****************
+// Raw int16 loop storage addressed in whole audio blocks.
+//   - Teensy: a file on the SD card (audio shield slot)
+//   - host:   a stdio file, with optional injected latency spikes so
+//             the ring sizing can be checked against a slow card
+class LoopFile {
+public:
+  bool open(const char* path); // create / truncate
+  void close();
+
+  // blocks of SdLooper::BLOCK samples at block index 'at'
+  bool read(uint32_t at, int16_t* dst, int blocks);
+  bool write(uint32_t at, const int16_t* src, int blocks);
+
+#if !defined(ARDUINO)
+  // every Nth access sleeps spikeMs (0 = off)
+  void setLatency(int everyN, int spikeMs) { _everyN = everyN; _spikeMs = spikeMs; }
+#endif
+
+private:
+#if defined(ARDUINO)
+  File _f;
+#else
+  FILE* _f = nullptr;
+  int   _everyN  = 0;
+  int   _spikeMs = 0;
+  int   _count   = 0;
+  void stall();
+#endif
+};
+
+// **************************
+// SdLooper
+// *****************
+// Record / overdub / play a loop far longer than RAM by streaming it
+// through the SD card.
+//
+// The audio interrupt only memcpys whole blocks into or out of two RAM
+// rings and never touches the card:
+//   - read ring:  blocks prefetched from the file for playback
+//   - write ring: recorded / overdubbed blocks waiting for the file
+// loop() calls service(), which does the card I/O in CHUNK_BLOCKS
+// sized, block aligned chunks. A stall in service() only eats into
+// the ring headroom (~1.5 s each way), the audio side never waits.
+//
+// Ring slots are tagged with the block they hold, so a late or lost
+// block is detected (and counted) instead of playing stale audio.
+class SdLooper : public FxBase<SdLooper> {
+public:
+  static constexpr int BLOCK        = 128; // samples, = AUDIO_BLOCK_SAMPLES
+  static constexpr int CHUNK_BLOCKS = 32;  // 8 KB per card access
+  static constexpr int RING_BLOCKS  = 512; // 128 KB per ring, ~1.49 s
+
+  enum State : uint8_t { EMPTY = 0, RECORD, PLAY, OVERDUB };
+
+  struct Params {
+    float level    = 1.0f; // loop playback level
+    float feedback = 1.0f; // old layers kept per overdub pass
+  };
+
+  struct Stats {
+    uint32_t underruns = 0; // play blocks that weren't prefetched in time
+    uint32_t overruns  = 0; // record blocks dropped, write ring full
+  };
+
+  // open the loop file (after SD.begin on the device)
+  bool begin(const char* path);
+
+  // back to EMPTY, safe to call from loop()
+  void reset();
+
+  // footswitch: EMPTY -> RECORD -> PLAY <-> OVERDUB (from loop())
+  void tap();
+
+  // audio interrupt: mixes the loop into data in place
+  void processBlock(int16_t* data, const Params& p);
+
+  // loop(): card reads / writes, never called from the interrupt
+  void service();
+
+  State state() const;
+  Stats stats() const;
+  uint32_t loopBlocks() const;
+
+  // **************************
+  // FxBase interface
+  // *****************
+  // whole blocks only (n == BLOCK), fs doesn't matter
+  void prepare(float fs, int maxBlock) { (void)fs; (void)maxBlock; }
+  void setParams(const Params& p) { _p = p; }
+  void process(int16_t* data, int n, const BlockAnalysis&) { (void)n; processBlock(data, _p); }
+
+  // EMPTY passes the dry signal and still has to see the first tap,
+  // so the looper never parks
+  bool isSilent() const { return false; }
+
+  // plus the static rings and card staging buffer
+  size_t memoryBytes() const;
+
+#if !defined(ARDUINO)
+  LoopFile& file() { return _file; }
+#endif
+
+private:
+  Params   _p;
+  LoopFile _file;
+  bool     _fileOk = false;
+
+  // **************************
+  // Shared with the interrupt
+  // *****************
+  // written by one side only, read with acquire / release
+  uint8_t  _state    = EMPTY;
+  uint8_t  _tapReq   = 0;  // loop() -> ISR
+  uint32_t _loopLen  = 0;  // blocks, set at RECORD -> PLAY
+  uint32_t _playPos  = 0;  // ISR: next play block (counts up across passes)
+  uint32_t _wKey     = 0;  // ISR: next write key (see .cpp)
+  uint32_t _wFlushed = 0;  // loop(): write keys below this are on the card
+  uint32_t _rFetched = 0;  // loop(): play blocks below this were prefetched
+
+  uint32_t _underruns = 0;
+  uint32_t _overruns  = 0;
+
+  // loop() side bookkeeping
+  bool _readsArmed = false;
+
+  static uint32_t ld(const uint32_t& v);
+  static void st(uint32_t& v, uint32_t x);
+
+  void clearRings();
+  void applyTap();
+  void flushWrites();
+  void prefetchReads();
+};
@@ -40,28 +40,43 @@ void BitCrusher::processBlock(int16_t* data, int n) {
 // ***********************
 // Tremolo
 // ***************
+void Tremolo::setControlInterval(int k) {
+  _ctrlK = ModEngine::clampInterval(k);
+}
+
+// LFO jumps m samples ahead, gain ramps to its value there
+void Tremolo::controlTick(int m, float phaseInc) {
+  // per-sample adds keep the phase identical for any K
+  for (int j = 0; j < m; j++) {
+    _phase += phaseInc;
+    if (_phase > 2.0f * (float)M_PI) _phase -= 2.0f * (float)M_PI;
+  }
+
+  // lfo 0..1
+  float lfo = 0.5f * (sinf(_phase) + 1.0f);
+
+  // gain (1-depth) .. 1
+  _gain.rampTo((1.0f - _depth) + _depth * lfo, m);
+}
+
 void Tremolo::processBlock(int16_t* data, int n) {
   if (!data || n <= 0) return;
 
   // phase step per sample
   const float phaseInc = (2.0f * (float)M_PI) * (_rate / _sr);
 
-  for (int i = 0; i < n; i++) {
-    float x = int16ToFloat(data[i]);
-
-    // lfo 0..1
-    float lfo = 0.5f * (sinf(_phase) + 1.0f);
+  for (int i = 0; i < n; ) {
+    int m = ModEngine::segment(n - i, _ctrlK);
+    controlTick(m, phaseInc);
 
-    // gain (1-depth) .. 1
-    float g = (1.0f - _depth) + _depth * lfo;
+    for (int j = 0; j < m; j++, i++) {
+      float x = int16ToFloat(data[i]);
 
-    float wet = x * g;
-    float y = (1.0f - _mix) * x + _mix * wet;
+      float wet = x * _gain.tick();
+      float y = (1.0f - _mix) * x + _mix * wet;
 
-    data[i] = floatToInt16(y);
-
-    _phase += phaseInc;
-    if (_phase > 2.0f * (float)M_PI) _phase -= 2.0f * (float)M_PI;
+      data[i] = floatToInt16(y);
+    }
   }
 }
 
@@ -74,11 +89,55 @@ void Flanger::setSampleRate(float sr) {
   _sr = (sr <= 8000.0f) ? 44100.0f : sr;
 }
 
-// wipe delay buffer + state
+// drop delay buffer (lazy, reads zero) + state
 void Flanger::reset() {
-  for (int i = 0; i < MAX_DELAY_SAMPLES; i++) _buf[i] = 0.0f;
+  _buf.clear();
   _w = 0;
   _phase = 0.0f;
+  _delay.jump(_baseMs * (_sr / 1000.0f));
+
+  _quietSamples = 0;
+  _silent = false;
+}
+
+// buffer is all zero while silent, so only the LFO + write index move
+// (index still matters, frac reads round differently at other offsets)
+void Flanger::idle(int n) {
+  const float phaseInc = (2.0f * (float)M_PI) * (_rate / _sr);
+  const float msToSamples = _sr / 1000.0f;
+
+  for (int i = 0; i < n; ) {
+    int m = ModEngine::segment(n - i, _ctrlK);
+    controlTick(m, phaseInc, msToSamples);
+    _delay.skip(m);
+    i += m;
+  }
+
+  _w = (_w + n) % MAX_DELAY_SAMPLES;
+  _buf.clear(_w); // all zero, follow the head
+}
+
+void Flanger::setControlInterval(int k) {
+  _ctrlK = ModEngine::clampInterval(k);
+}
+
+// LFO jumps m samples ahead, delay ramps to its value there
+void Flanger::controlTick(int m, float phaseInc, float msToSamples) {
+  // per-sample adds keep the phase identical for any K
+  for (int j = 0; j < m; j++) {
+    _phase += phaseInc;
+    if (_phase > 2.0f * (float)M_PI) _phase -= 2.0f * (float)M_PI;
+  }
+
+  // delay mod from LFO
+  float lfo = 0.5f * (sinf(_phase) + 1.0f);
+  float delaySamp = (_baseMs + _depthMs * lfo) * msToSamples;
+
+  // clamp so read stays in buffer (NaN -> 0)
+  if (!(delaySamp > 0.0f)) delaySamp = 0.0f;
+  if (delaySamp > (MAX_DELAY_SAMPLES - 2)) delaySamp = (float)(MAX_DELAY_SAMPLES - 2);
+
+  _delay.rampTo(delaySamp, m);
 }
 
 void Flanger::processBlock(int16_t* data, int n) {
@@ -89,45 +148,207 @@ void Flanger::processBlock(int16_t* data, int n) {
   // ms -> samples
   const float msToSamples = _sr / 1000.0f;
 
-  for (int i = 0; i < n; i++) {
-    float x = int16ToFloat(data[i]);
+  bool quiet = true;
+
+  for (int i = 0; i < n; ) {
+    int m = ModEngine::segment(n - i, _ctrlK);
+    controlTick(m, phaseInc, msToSamples);
 
-    // delay mod from LFO
-    float lfo = 0.5f * (sinf(_phase) + 1.0f);
-    float delaySamp = (_baseMs + _depthMs * lfo) * msToSamples;
+    for (int j = 0; j < m; j++, i++) {
+      if (data[i] != 0) quiet = false;
 
-    // clamp so read stays in buffer
-    if (delaySamp < 0.0f) delaySamp = 0.0f;
-    if (delaySamp > (MAX_DELAY_SAMPLES - 2)) delaySamp = (float)(MAX_DELAY_SAMPLES - 2);
+      float x = int16ToFloat(data[i]);
 
-    // fractional read index
-    float readIndex = (float)_w - delaySamp;
-    while (readIndex < 0.0f) readIndex += (float)MAX_DELAY_SAMPLES;
+      // fractional read index (delay is clamped in controlTick, one wrap
+      // each way: _w - tiny + MAX can round up to MAX itself)
+      float readIndex = (float)_w - _delay.tick();
+      if (readIndex < 0.0f) readIndex += (float)MAX_DELAY_SAMPLES;
+      if (readIndex >= (float)MAX_DELAY_SAMPLES) readIndex -= (float)MAX_DELAY_SAMPLES;
 
-    int idx0 = (int)readIndex;
-    int idx1 = idx0 + 1;
-    if (idx1 >= MAX_DELAY_SAMPLES) idx1 -= MAX_DELAY_SAMPLES;
+      int idx0 = (int)readIndex;
+      int idx1 = idx0 + 1;
+      if (idx1 >= MAX_DELAY_SAMPLES) idx1 -= MAX_DELAY_SAMPLES;
 
-    // linear interp
-    float frac = readIndex - (float)idx0;
-    float d0 = _buf[idx0];
-    float d1 = _buf[idx1];
-    float delayed = d0 + frac * (d1 - d0);
+      // linear interp
+      float frac = readIndex - (float)idx0;
+      float d0 = _buf.read(idx0);
+      float d1 = _buf.read(idx1);
+      float delayed = d0 + frac * (d1 - d0);
 
-    // feedback write
-    float writeVal = x + delayed * _fb;
-    _buf[_w] = clampf(writeVal, -1.0f, 1.0f);
+      // feedback write
+      float writeVal = x + delayed * _fb;
+      _buf.write(_w, clampf(writeVal, -1.0f, 1.0f));
 
-    _w++;
-    if (_w >= MAX_DELAY_SAMPLES) _w = 0;
+      if (fabsf(writeVal) >= SILENT_THRESH) quiet = false;
+
+      _w++;
+      if (_w >= MAX_DELAY_SAMPLES) _w = 0;
+
+      // dry/wet
+      float y = (1.0f - _mix) * x + _mix * delayed;
+      data[i] = floatToInt16(y);
+    }
+  }
+
+  // a full buffer of quiet writes => whole line is under threshold,
+  // zero it so silence is an exact fixed point
+  if (!quiet) {
+    _quietSamples = 0;
+    _silent = false;
+  } else if (!_silent) {
+    _quietSamples += n;
+    if (_quietSamples >= MAX_DELAY_SAMPLES) {
+      _buf.clear(_w);
+      _silent = true;
+    }
+  }
+}
+
+// ***********************
+// Chorus
+// ***************
+
+// keep sr sane
+void Chorus::setSampleRate(float sr) {
+  _sr = (sr <= 8000.0f) ? 44100.0f : sr;
+}
+
+void Chorus::setVoices(int voices) {
+  voices = (voices < 2) ? 2 : (voices > MAX_VOICES ? MAX_VOICES : voices);
+  if (voices == _voices) return;
+
+  _voices = voices;
+  spreadVoices();
+}
+
+void Chorus::setControlInterval(int k) {
+  _ctrlK = ModEngine::clampInterval(k);
+}
+
+// even phase spread, rates fanned +-8% so the voices drift apart
+void Chorus::spreadVoices() {
+  _wetGain = 1.0f / sqrtf((float)_voices);
+
+  const float msToSamples = _sr / 1000.0f;
+  for (int v = 0; v < MAX_VOICES; v++) {
+    float t = (_voices > 1) ? (float)v / (float)(_voices - 1) : 0.0f;
+    _phase[v]   = (2.0f * (float)M_PI) * (float)v / (float)_voices;
+    _rateMul[v] = 1.0f + 0.16f * (t - 0.5f);
+    _dly[v]     = _baseMs * msToSamples;
+    _dlyStep[v] = 0.0f;
+  }
+}
+
+// drop delay buffer (lazy, reads zero) + state
+void Chorus::reset() {
+  _buf.clear();
+  _w = 0;
+  spreadVoices();
+
+  _quietSamples = 0;
+  _silent = false;
+}
+
+// LFOs jump m samples ahead, delays ramp to their values there
+void Chorus::controlTick(int m, float phaseInc, float msToSamples) {
+  // segment writes land before the reads, keep the oldest tap clear of them
+  const float maxDelay = (float)(BUF_LEN - ModEngine::K_MAX - 2);
+
+  for (int v = 0; v < _voices; v++) {
+    float ph = _phase[v] + phaseInc * _rateMul[v] * (float)m;
+    if (ph > 2.0f * (float)M_PI) ph -= 2.0f * (float)M_PI;
+    _phase[v] = ph;
+
+    float lfo = 0.5f * (sinf(ph) + 1.0f);
+    float d = (_baseMs + _depthMs * lfo) * msToSamples;
+    d = clampf(d, 1.0f, maxDelay);
+
+    _dlyStep[v] = (d - _dly[v]) / (float)m;
+  }
+}
+
+void Chorus::processBlock(int16_t* data, int n) {
+  if (!data || n <= 0) return;
+
+  const float phaseInc = (2.0f * (float)M_PI) * (_rate / _sr);
+  const float msToSamples = _sr / 1000.0f;
+
+  float dry[ModEngine::K_MAX];
+  float wet[ModEngine::K_MAX];
+
+  bool quiet = true;
+
+  for (int i = 0; i < n; ) {
+    int m = ModEngine::segment(n - i, _ctrlK);
+    controlTick(m, phaseInc, msToSamples);
+
+    // write the whole segment first (no feedback, delays are >= 1)
+    const int w0 = _w;
+    for (int j = 0; j < m; j++) {
+      if (data[i + j] != 0) quiet = false;
+      dry[j] = int16ToFloat(data[i + j]);
+      wet[j] = 0.0f;
+      _buf.write((w0 + j) & BUF_MASK, dry[j]);
+    }
+    _w = (w0 + m) & BUF_MASK;
+
+    // taps: one pass per voice over the segment
+    for (int v = 0; v < _voices; v++) {
+      float d = _dly[v];
+      const float step = _dlyStep[v];
+
+      for (int j = 0; j < m; j++) {
+        // + BUF_LEN keeps the index positive, mask does the wrap
+        float r = (float)(w0 + j + BUF_LEN) - d;
+        d += step;
+
+        int i0 = (int)r;
+        float frac = r - (float)i0;
+        float d0 = _buf.read(i0 & BUF_MASK);
+        float d1 = _buf.read((i0 + 1) & BUF_MASK);
+        wet[j] += d0 + frac * (d1 - d0);
+      }
+
+      _dly[v] = d;
+    }
 
     // dry/wet
-    float y = (1.0f - _mix) * x + _mix * delayed;
-    data[i] = floatToInt16(y);
+    for (int j = 0; j < m; j++, i++) {
+      float y = (1.0f - _mix) * dry[j] + _mix * _wetGain * wet[j];
+      data[i] = floatToInt16(y);
+    }
+  }
 
-    _phase += phaseInc;
-    if (_phase > 2.0f * (float)M_PI) _phase -= 2.0f * (float)M_PI;
+  // once a full buffer of zeros went in, every tap reads zero
+  if (!quiet) {
+    _quietSamples = 0;
+    _silent = false;
+  } else if (!_silent) {
+    _quietSamples += n;
+    if (_quietSamples >= BUF_LEN) _silent = true;
+  }
+}
+
+// buffer is all zero while silent, so only the LFOs, ramps and write
+// index move (same float ops as processBlock)
+void Chorus::idle(int n) {
+  const float phaseInc = (2.0f * (float)M_PI) * (_rate / _sr);
+  const float msToSamples = _sr / 1000.0f;
+
+  for (int i = 0; i < n; ) {
+    int m = ModEngine::segment(n - i, _ctrlK);
+    controlTick(m, phaseInc, msToSamples);
+
+    for (int v = 0; v < _voices; v++) {
+      float d = _dly[v];
+      for (int j = 0; j < m; j++) d += _dlyStep[v];
+      _dly[v] = d;
+    }
+
+    _w = (_w + m) & BUF_MASK;
+    i += m;
   }
+  _buf.clear(_w); // all zero, follow the head
 }
 
 // ***********************
@@ -143,9 +364,16 @@ void SoftClip::processBlock(int16_t* data, int n) {
     float xd = x * _drive;
 
     // soft clip
-    float wet = xd / (1.0f + fabsf(xd));
+    float wet = _sat.process(xd);
+
+    // ADAA of the identity: the dry lines up with the wet's delay
+    float dry = x;
+    if (_sat.mode() == Adaa::ADAA1)      dry = 0.5f * (x + _x1);
+    else if (_sat.mode() == Adaa::ADAA2) dry = (x + _x1 + _x2) * (1.0f / 3.0f);
+    _x2 = _x1;
+    _x1 = x;
 
-    float y = (1.0f - _mix) * x + _mix * wet;
+    float y = (1.0f - _mix) * dry + _mix * wet;
     data[i] = floatToInt16(y);
   }
 }
@@ -2,6 +2,10 @@
 #include <Arduino.h>
 #include <stdint.h>
 #include <math.h>
+#include "ModEngine.h"
+#include "FxBase.h"
+#include "Adaa.h"
+#include "LazyLine.h"
 
 namespace SimpleFX {
 
@@ -9,8 +13,9 @@ namespace SimpleFX {
 // Helpers
 // *****************
 
+// NaN -> lo
 static inline float clampf(float x, float lo, float hi) {
-  return (x < lo) ? lo : (x > hi) ? hi : x;
+  return (x > lo) ? ((x < hi) ? x : hi) : lo;
 }
 
 static inline float int16ToFloat(int16_t s) {
@@ -18,6 +23,9 @@ static inline float int16ToFloat(int16_t s) {
   return (s >= 0) ? (s / 32767.0f) : (s / 32768.0f);
 }
 
+// below this a tail counts as gone (~-100 dBFS, under 1 LSB)
+static constexpr float SILENT_THRESH = 1.0e-5f;
+
 static inline int16_t floatToInt16(float x) {
   // clamp so it doesnt wrap
   x = clampf(x, -1.0f, 1.0f);
@@ -30,8 +38,14 @@ static inline int16_t floatToInt16(float x) {
 // BitCrusher
 // *****************
 // bit depth + sample/hold downsample
-class BitCrusher {
+class BitCrusher : public FxBase<BitCrusher> {
 public:
+  struct Params {
+    int   bits = 12;
+    int   down = 1;
+    float mix  = 1.0f;
+  };
+
   void setSampleRate(float sr) { _sr = sr; }
 
   // bits: 1..16
@@ -41,6 +55,7 @@ public:
     _down = (downsampleFactor < 1) ? 1 : (downsampleFactor > 128 ? 128 : downsampleFactor);
     _mix  = clampf(mix, 0.0f, 1.0f);
   }
+  void setParams(const Params& p) { setParams(p.bits, p.down, p.mix); }
 
   void reset() {
     _holdCount = 0;
@@ -49,6 +64,14 @@ public:
 
   void processBlock(int16_t* data, int n);
 
+  // no tail, and quiet input can come out loud (1 bit turns hiss into
+  // a square): never parks, so it's never gated
+  bool isSilent() const { return false; }
+
+  // FxBase interface
+  void prepare(float fs, int maxBlock) { setSampleRate(fs); (void)maxBlock; }
+  void process(int16_t* data, int n, const BlockAnalysis&) { processBlock(data, n); }
+
 private:
   float _sr = 44100.0f;
 
@@ -64,8 +87,14 @@ private:
 // Tremolo
 // *****************
 // sine LFO amp mod
-class Tremolo {
+class Tremolo : public FxBase<Tremolo> {
 public:
+  struct Params {
+    float rateHz = 4.0f;
+    float depth  = 0.6f;
+    float mix    = 1.0f;
+  };
+
   void setSampleRate(float sr) { _sr = sr; }
 
   // rateHz: speed
@@ -76,11 +105,23 @@ public:
     _depth = clampf(depth, 0.0f, 1.0f);
     _mix   = clampf(mix, 0.0f, 1.0f);
   }
+  void setParams(const Params& p) { setParams(p.rateHz, p.depth, p.mix); }
+
+  // gain target evaluated every k samples (1..32) and ramped
+  void setControlInterval(int k);
 
-  void reset() { _phase = 0.0f; }
+  void reset() { _phase = 0.0f; _gain.jump(1.0f); }
 
   void processBlock(int16_t* data, int n);
 
+  // no tail, but the output is the input: never parks, so quiet input
+  // is modulated rather than gated
+  bool isSilent() const { return false; }
+
+  // FxBase interface
+  void prepare(float fs, int maxBlock) { setSampleRate(fs); (void)maxBlock; }
+  void process(int16_t* data, int n, const BlockAnalysis&) { processBlock(data, n); }
+
 private:
   float _sr = 44100.0f;
 
@@ -89,14 +130,28 @@ private:
   float _mix   = 1.0f;
 
   float _phase = 0.0f; // radians
+
+  // control-rate gain
+  ModEngine::Ramp _gain;
+  int _ctrlK = ModEngine::K_DEFAULT;
+
+  void controlTick(int m, float phaseInc);
 };
 
 // **************************
 // Flanger
 // *****************
 // short mod delay + feedback
-class Flanger {
+class Flanger : public FxBase<Flanger> {
 public:
+  struct Params {
+    float baseMs   = 2.0f;
+    float depthMs  = 1.5f;
+    float rateHz   = 0.25f;
+    float feedback = 0.2f;
+    float mix      = 0.6f;
+  };
+
   void setSampleRate(float sr);
 
   // baseDelayMs: base delay
@@ -112,14 +167,27 @@ public:
     _fb      = clampf(feedback,  -0.95f, 0.95f);
     _mix     = clampf(mix,        0.0f, 1.0f);
   }
+  void setParams(const Params& p) { setParams(p.baseMs, p.depthMs, p.rateHz, p.feedback, p.mix); }
+
+  // delay target evaluated every k samples (1..32) and ramped
+  void setControlInterval(int k);
 
   void reset();
   void processBlock(int16_t* data, int n);
 
+  // idle: true once the feedback tail has decayed and the buffer is
+  // parked at zero. idle() keeps the LFO turning for blocks of zeros.
+  bool isSilent() const { return _silent; }
+  void idle(int n);
+
+  // FxBase interface
+  void prepare(float fs, int maxBlock) { setSampleRate(fs); (void)maxBlock; }
+  void process(int16_t* data, int n, const BlockAnalysis&) { processBlock(data, n); }
+
 private:
   // keep this small, flanger only needs a few ms
   static constexpr int MAX_DELAY_SAMPLES = 2048; // ~46ms at 44.1k
-  float _buf[MAX_DELAY_SAMPLES] = {0};
+  Lazy::Line<float, MAX_DELAY_SAMPLES> _buf;
 
   float _sr = 44100.0f;
   int   _w  = 0;
@@ -131,6 +199,98 @@ private:
   float _mix     = 0.6f;
 
   float _phase = 0.0f; // radians
+
+  // control-rate delay (samples)
+  ModEngine::Ramp _delay;
+  int _ctrlK = ModEngine::K_DEFAULT;
+
+  // idle detection
+  int  _quietSamples = 0;
+  bool _silent = false;
+
+  void controlTick(int m, float phaseInc, float msToSamples);
+};
+
+// **************************
+// Chorus
+// *****************
+// N voices reading one shared delay line, no feedback.
+// Voice state is kept as parallel arrays so each control segment
+// runs one tight loop per voice over the same buffer.
+class Chorus : public FxBase<Chorus> {
+public:
+  static constexpr int MAX_VOICES = 8;
+
+  struct Params {
+    float baseMs  = 12.0f;
+    float depthMs = 4.0f;
+    float rateHz  = 0.5f;
+    float mix     = 0.5f;
+  };
+
+  void setSampleRate(float sr);
+
+  // baseDelayMs: center delay
+  // depthMs: LFO swing
+  // rateHz: LFO speed (voices are detuned around it)
+  // mix: 0..1
+  void setParams(float baseDelayMs, float depthMs, float rateHz, float mix = 0.5f) {
+    _baseMs  = clampf(baseDelayMs, 1.0f, 25.0f);
+    _depthMs = clampf(depthMs,     0.0f, 15.0f);
+    _rate    = clampf(rateHz,      0.01f, 10.0f);
+    _mix     = clampf(mix,         0.0f, 1.0f);
+  }
+  void setParams(const Params& p) { setParams(p.baseMs, p.depthMs, p.rateHz, p.mix); }
+
+  // voices: 2..MAX_VOICES, re-spreads the LFO phases
+  void setVoices(int voices);
+
+  // delay targets evaluated every k samples (1..32) and ramped
+  void setControlInterval(int k);
+
+  void reset();
+  void processBlock(int16_t* data, int n);
+
+  // idle: true once the whole line holds zeros (no feedback, so one
+  // buffer length of zero input). idle() keeps the LFOs turning.
+  bool isSilent() const { return _silent; }
+  void idle(int n);
+
+  // FxBase interface
+  void prepare(float fs, int maxBlock) { setSampleRate(fs); (void)maxBlock; }
+  void process(int16_t* data, int n, const BlockAnalysis&) { processBlock(data, n); }
+
+private:
+  // power of 2 so tap reads wrap with a mask
+  static constexpr int BUF_LEN  = 2048; // ~46ms at 44.1k
+  static constexpr int BUF_MASK = BUF_LEN - 1;
+  Lazy::Line<float, BUF_LEN> _buf;
+
+  float _sr = 44100.0f;
+  int   _w  = 0;
+
+  float _baseMs  = 12.0f;
+  float _depthMs = 4.0f;
+  float _rate    = 0.5f;
+  float _mix     = 0.5f;
+
+  int   _voices  = 4;
+  float _wetGain = 0.5f; // 1/sqrt(voices)
+
+  // per-voice state (SoA)
+  float _phase[MAX_VOICES]   = {0}; // radians
+  float _rateMul[MAX_VOICES] = {0}; // detune around _rate
+  float _dly[MAX_VOICES]     = {0}; // current delay (samples)
+  float _dlyStep[MAX_VOICES] = {0}; // ramp step per sample
+
+  int _ctrlK = ModEngine::K_DEFAULT;
+
+  // idle detection
+  int  _quietSamples = 0;
+  bool _silent = false;
+
+  void spreadVoices();
+  void controlTick(int m, float phaseInc, float msToSamples);
 };
 
 // **************************
@@ -144,11 +304,20 @@ public:
     _mix   = clampf(mix,   0.0f, 1.0f);
   }
 
+  // OFF = plain, ADAA1 / ADAA2 anti-aliased (dry delayed to match)
+  void setAntiAlias(Adaa::Mode m) {
+    _sat.setMode(m);
+    _x1 = _x2 = 0.0f;
+  }
+
   void processBlock(int16_t* data, int n);
 
 private:
   float _drive = 1.5f;
   float _mix   = 1.0f;
+
+  Adaa::Shaper<Adaa::Alg> _sat;
+  float _x1 = 0.0f, _x2 = 0.0f; // dry history
 };
 
 // **************************
@@ -160,10 +329,16 @@ public:
   void setSampleRate(float sr) { _sr = sr; }
   void setCutoffHz(float fc);
 
+  // precomputed a = exp(-2*pi*fc/sr), e.g. from a ParamMap table
+  void setCoef(float a) { _a = a; }
+
   void reset(float y = 0.0f) { _y = y; }
 
   void processBlock(int16_t* data, int n);
 
+  // zero state + zero input => zero output, safe to skip
+  bool isSilent() const { return _y == 0.0f; }
+
 private:
   float _sr = 44100.0f;
   float _a  = 0.0f;
@@ -175,10 +350,16 @@ public:
   void setSampleRate(float sr) { _sr = sr; }
   void setCutoffHz(float fc);
 
+  // precomputed a = rc / (rc + dt), e.g. from a ParamMap table
+  void setCoef(float a) { _a = a; }
+
   void reset(float x = 0.0f, float y = 0.0f) { _x1 = x; _y1 = y; }
 
   void processBlock(int16_t* data, int n);
 
+  // zero state + zero input => zero output, safe to skip
+  bool isSilent() const { return _x1 == 0.0f && _y1 == 0.0f; }
+
 private:
   float _sr = 44100.0f;
   float _a  = 0.0f;
@@ -0,0 +1,122 @@
+#include "Stft.h"
+#include <math.h>
+#include <string.h>
+
+namespace Stft {
+
+static constexpr int BLOCK = 128;
+static constexpr int RUNS  = 8;
+
+namespace {
+
+// leaves the spectrum alone: the cost of the engine by itself
+struct Passthrough {
+  void beginFrame() {}
+  void spectrum(float*, int, int) {}
+};
+
+void printTicks(Print& out, uint32_t t, uint32_t budget) {
+  out.print((unsigned long)t);
+  out.print(" ticks (");
+  out.print(100.0 * (double)t / (double)budget, 2);
+  out.print("%)");
+}
+
+template <int N>
+void fftCase(Print& out, uint32_t (*ticks)(), uint32_t budget) {
+  static float x[N];
+  uint32_t best = 0xffffffffu;
+  for (int r = 0; r < RUNS; r++) {
+    for (int i = 0; i < N; i++) x[i] = sinf(0.05f * (float)i) * (float)((i * 7) % 11);
+    const uint32_t t0 = ticks();
+    RealFft<N>::forward(x);
+    RealFft<N>::inverse(x);
+    const uint32_t dt = ticks() - t0;
+    if (dt < best) best = dt;
+  }
+  out.print("stft fft N=");
+  out.print(N);
+  out.print(" forward + inverse: ");
+  printTicks(out, best, budget);
+  out.println(" of budget");
+}
+
+// worst block of a frame cycle: per slot the best of many frames (host
+// jitter out), then the worst slot
+template <int N, int HOP>
+uint32_t engineWorst(Engine<N, HOP>& e, bool spread, uint32_t (*ticks)(), uint32_t& mean) {
+  using E = Engine<N, HOP>;
+  static constexpr int FRAMES = 12;
+
+  int16_t in[BLOCK];
+  float wet[BLOCK];
+  for (int i = 0; i < BLOCK; i++) in[i] = (int16_t)(12000.0f * sinf(0.0623f * (float)i));
+
+  uint32_t best[E::SLOTS];
+  for (int s = 0; s < E::SLOTS; s++) best[s] = 0xffffffffu;
+
+  Passthrough c;
+  e.reset();
+  e.setSpread(spread);
+  const int warm = 2 * (N / HOP) * E::SLOTS;
+  for (int b = 0; b < warm + FRAMES * E::SLOTS; b++) {
+    const uint32_t t0 = ticks();
+    e.process(in, wet, c);
+    const uint32_t dt = ticks() - t0;
+    const int s = b % E::SLOTS; // place in the frame cycle
+    if (b >= warm && dt < best[s]) best[s] = dt;
+  }
+  e.setSpread(true);
+
+  uint32_t worst = 0;
+  uint64_t sum = 0;
+  for (int s = 0; s < E::SLOTS; s++) {
+    if (best[s] > worst) worst = best[s];
+    sum += best[s];
+  }
+  mean = (uint32_t)(sum / E::SLOTS);
+  return worst;
+}
+
+template <int N, int HOP>
+void engineCase(Print& out, uint32_t (*ticks)(), uint32_t budget) {
+  static Engine<N, HOP> e;
+  uint32_t mean = 0, meanWhole = 0;
+  const uint32_t spread = engineWorst(e, true, ticks, mean);
+  const uint32_t whole = engineWorst(e, false, ticks, meanWhole);
+
+  out.print("stft engine N=");
+  out.print(N);
+  out.print(" hop=");
+  out.print(HOP);
+  out.print(" (");
+  out.print(Engine<N, HOP>::SLOTS);
+  out.print(" blocks/frame): spread worst ");
+  printTicks(out, spread, budget);
+  out.print(", mean ");
+  out.print((unsigned long)mean);
+  out.print("; one block worst ");
+  printTicks(out, whole, budget);
+  out.println("");
+}
+
+} // namespace
+
+// **************************
+// Benchmark
+// *****************
+void benchmark(Print& out, uint32_t (*ticks)(), uint32_t budget) {
+  fftCase<256>(out, ticks, budget);
+  fftCase<512>(out, ticks, budget);
+  fftCase<1024>(out, ticks, budget);
+  fftCase<2048>(out, ticks, budget);
+
+  engineCase<256, 128>(out, ticks, budget);
+  engineCase<512, 128>(out, ticks, budget);
+  engineCase<512, 256>(out, ticks, budget);
+  engineCase<1024, 256>(out, ticks, budget);
+  engineCase<1024, 512>(out, ticks, budget);
+  engineCase<2048, 512>(out, ticks, budget);
+}
+
+} // namespace Stft
@@ -0,0 +1,371 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <string.h>
+
+// **************************
+// Stft
+// *****************
+// Streaming short-time Fourier transform for spectral effects.
+//
+//   RealFft<N>      N real points as an N/2 point complex radix-2 FFT
+//                   plus a split pass. Twiddles, bit reversal and the
+//                   window are constexpr tables: no trig at boot or at
+//                   run time, and on the Teensy 4 .rodata is copied to
+//                   DTCM, so table loads are zero wait state.
+//   Engine<N, HOP>  sqrt-Hann analysis and synthesis, overlap-add. One
+//                   frame is a list of passes of roughly equal cost
+//                   (window, each FFT stage, split, client, ... overlap-
+//                   add). They are run a share per audio block across the
+//                   HOP / BLOCK blocks until the next frame starts, so no
+//                   block carries a whole frame.
+//
+// A client provides
+//   void beginFrame()                          once per frame, before its bins
+//   void spectrum(float* X, int k0, int k1)    bins k0 <= k < k1 of the frame
+// X is packed: X[0] = DC and X[1] = Nyquist (both real), X[2k], X[2k+1]
+// = re, im of bin k. Whatever the client leaves in X is resynthesised.
+namespace Stft {
+
+// **************************
+// constexpr math
+// *****************
+namespace cx {
+
+static constexpr double PI = 3.14159265358979323846;
+
+// Taylor on [-pi/2, pi/2], everything else folded in
+constexpr double sin(double x) {
+  int n = (int)(x / (2.0 * PI));
+  x -= n * 2.0 * PI;
+  if (x > PI) x -= 2.0 * PI;
+  if (x < -PI) x += 2.0 * PI;
+  if (x > PI / 2.0) x = PI - x;
+  else if (x < -PI / 2.0) x = -PI - x;
+
+  double x2 = x * x, term = x, sum = x;
+  for (int k = 1; k < 14; k++) {
+    term *= -x2 / (double)((2 * k) * (2 * k + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double cos(double x) { return sin(x + PI / 2.0); }
+
+constexpr int log2i(int n) {
+  int l = 0;
+  while ((1 << l) < n) l++;
+  return l;
+}
+
+constexpr int pow2AtLeast(int n) { return 1 << log2i(n); }
+
+} // namespace cx
+
+// **************************
+// Tables
+// *****************
+template <int N>
+struct Tables {
+  float    cosT[N / 2]; // cos(2 pi k / N)
+  float    sinT[N / 2]; // sin(2 pi k / N)
+  uint16_t rev[N / 2];  // bit reversal over log2(N / 2) bits
+  float    win[N];      // sin(pi n / N), periodic sqrt-Hann
+};
+
+template <int N>
+constexpr Tables<N> makeTables() {
+  Tables<N> t{};
+  const int M = N / 2, L = cx::log2i(N / 2);
+  for (int k = 0; k < M; k++) {
+    t.cosT[k] = (float)cx::cos(2.0 * cx::PI * k / N);
+    t.sinT[k] = (float)cx::sin(2.0 * cx::PI * k / N);
+    int r = 0;
+    for (int b = 0; b < L; b++) {
+      if ((k >> b) & 1) r |= 1 << (L - 1 - b);
+    }
+    t.rev[k] = (uint16_t)r;
+  }
+  for (int n = 0; n < N; n++) t.win[n] = (float)cx::sin(cx::PI * n / N);
+  return t;
+}
+
+// **************************
+// RealFft
+// *****************
+// In place on N floats. forward() takes N reals to the packed spectrum,
+// inverse() takes it back scaled by N. The stages are public so the
+// engine can spread them over blocks.
+template <int N>
+class RealFft {
+public:
+  static constexpr int M      = N / 2;         // complex points
+  static constexpr int STAGES = cx::log2i(M);  // radix-2 stages
+  static_assert(N >= 16 && (N & (N - 1)) == 0, "power of two, 16 or more");
+
+  static constexpr Tables<N> T = makeTables<N>();
+
+  static void forward(float* x) {
+    permute(x);
+    stage01<false>(x);
+    for (int s = 2; s < STAGES; s++) stage<false>(x, s);
+    split(x);
+  }
+
+  static void inverse(float* x) {
+    unsplit(x);
+    permute(x);
+    stage01<true>(x);
+    for (int s = 2; s < STAGES; s++) stage<true>(x, s);
+  }
+
+  // bit reversed order of the M complex points
+  static void permute(float* x) {
+    for (int i = 0; i < M; i++) {
+      const int j = T.rev[i];
+      if (j <= i) continue;
+      float* a = x + 2 * i;
+      float* b = x + 2 * j;
+      const float r = a[0], im = a[1];
+      a[0] = b[0]; a[1] = b[1];
+      b[0] = r;    b[1] = im;
+    }
+  }
+
+  // stages 0 and 1 as one radix-4 pass, twiddles 1 and -i (+i inverse)
+  template <bool INV>
+  static void stage01(float* x) {
+    for (int i = 0; i < M; i += 4) {
+      float* p = x + 2 * i;
+      const float t0r = p[0] + p[2], t0i = p[1] + p[3];
+      const float t1r = p[0] - p[2], t1i = p[1] - p[3];
+      const float t2r = p[4] + p[6], t2i = p[5] + p[7];
+      const float t3r = p[4] - p[6], t3i = p[5] - p[7];
+      const float ur = INV ? -t3i : t3i;
+      const float ui = INV ? t3r : -t3r;
+      p[0] = t0r + t2r; p[1] = t0i + t2i;
+      p[4] = t0r - t2r; p[5] = t0i - t2i;
+      p[2] = t1r + ur;  p[3] = t1i + ui;
+      p[6] = t1r - ur;  p[7] = t1i - ui;
+    }
+  }
+
+  // radix-2 stage s >= 2, butterflies 2^s apart
+  template <bool INV>
+  static void stage(float* x, int s) {
+    const int half = 1 << s;
+    const int stride = N / (2 * half); // W_len^j = W_N^(j * N / len)
+    for (int i = 0; i < M; i += 2 * half) {
+      float* a = x + 2 * i;
+      float* b = a + 2 * half;
+      for (int j = 0; j < half; j++, a += 2, b += 2) {
+        const float wr = T.cosT[j * stride];
+        const float wi = INV ? T.sinT[j * stride] : -T.sinT[j * stride];
+        const float br = b[0] * wr - b[1] * wi;
+        const float bi = b[0] * wi + b[1] * wr;
+        b[0] = a[0] - br; b[1] = a[1] - bi;
+        a[0] += br;       a[1] += bi;
+      }
+    }
+  }
+
+  // M point spectrum of the even / odd samples -> N point real spectrum
+  static void split(float* x) {
+    const float r0 = x[0], i0 = x[1];
+    x[0] = r0 + i0;
+    x[1] = r0 - i0;
+    for (int k = 1; k <= M / 2; k++) {
+      float* a = x + 2 * k;
+      float* b = x + 2 * (M - k);
+      const float er = 0.5f * (a[0] + b[0]), ei = 0.5f * (a[1] - b[1]);
+      const float orr = 0.5f * (a[1] + b[1]), oi = -0.5f * (a[0] - b[0]);
+      const float wr = T.cosT[k], wi = -T.sinT[k];
+      const float tr = orr * wr - oi * wi, ti = orr * wi + oi * wr;
+      a[0] = er + tr; a[1] = ei + ti;
+      b[0] = er - tr; b[1] = ti - ei;
+    }
+  }
+
+  // back to twice the even / odd spectrum, ready for the inverse stages
+  static void unsplit(float* x) {
+    const float x0 = x[0], xm = x[1];
+    x[0] = x0 + xm;
+    x[1] = x0 - xm;
+    for (int k = 1; k <= M / 2; k++) {
+      float* a = x + 2 * k;
+      float* b = x + 2 * (M - k);
+      const float er = a[0] + b[0], ei = a[1] - b[1];
+      const float ur = a[0] - b[0], ui = a[1] + b[1];
+      const float wr = T.cosT[k], wi = T.sinT[k];
+      const float orr = ur * wr - ui * wi, oi = ur * wi + ui * wr;
+      a[0] = er - oi; a[1] = ei + orr;
+      b[0] = er + oi; b[1] = orr - ei;
+    }
+  }
+};
+
+// **************************
+// Engine
+// *****************
+// Whole audio blocks of BLOCK samples in, the same count of wet samples
+// out, LATENCY samples behind. A frame ends every HOP samples; its
+// passes run from that block through the next SLOTS - 1.
+template <int N, int HOP>
+class Engine {
+public:
+  using Fft = RealFft<N>;
+
+  static constexpr int BLOCK   = 128;               // = AUDIO_BLOCK_SAMPLES
+  static constexpr int BINS    = N / 2 + 1;
+  static constexpr int SLOTS   = HOP / BLOCK;       // blocks per frame
+  static constexpr int LATENCY = N + HOP - BLOCK;   // wet output lag, samples
+  static_assert(HOP % BLOCK == 0 && N % HOP == 0 && 2 * HOP <= N, "HOP: whole blocks, N / HOP >= 2");
+
+  Engine() { reset(); }
+
+  void reset() {
+    memset(_in, 0, sizeof(_in));
+    memset(_buf, 0, sizeof(_buf));
+    memset(_out, 0, sizeof(_out));
+    _count = 0;
+    _end = 0;
+    _pass = PASSES;
+    _slot = 0;
+  }
+
+  // A block of zeros with nothing left in the rings (after reset() and
+  // zeros since): only the frame clock moves. The frames it skips would
+  // have transformed zeros.
+  void idle() {
+    _count += BLOCK;
+    if ((_count & (HOP - 1)) == 0) _end = _count;
+    _pass = PASSES;
+  }
+
+  // off: each frame runs whole in the block it ends in (benchmark)
+  void setSpread(bool on) { _spread = on; }
+
+  template <class Client>
+  void process(const int16_t* in, float* wet, Client& c) {
+    for (int i = 0; i < BLOCK; i++) _in[(_count + (uint32_t)i) & (N - 1)] = in[i];
+    _count += BLOCK;
+
+    // a frame ends here; the previous one is done by now unless
+    // spreading is off
+    if ((_count & (HOP - 1)) == 0) {
+      if (_pass < PASSES) runPasses(c, PASSES);
+      _end = _count;
+      _pass = 0;
+      _slot = 0;
+    }
+
+    if (_pass < PASSES) {
+      int todo = PASSES - _pass;
+      if (_spread && _slot < SLOTS - 1) {
+        const int left = SLOTS - _slot;
+        todo = (todo + left - 1) / left;
+      }
+      runPasses(c, _pass + todo);
+      _slot++;
+    }
+
+    // emit, and clear the slot for the frames still to come
+    const uint32_t r = _count - BLOCK - LATENCY;
+    for (int i = 0; i < BLOCK; i++) {
+      const uint32_t idx = (r + (uint32_t)i) & (RING - 1);
+      wet[i] = _out[idx];
+      _out[idx] = 0.0f;
+    }
+  }
+
+private:
+  // **************************
+  // Passes
+  // *****************
+  static constexpr int CLIENT_PASSES = 2;
+  static constexpr int STAGE_PASSES  = Fft::STAGES - 2; // after stage01
+
+  static constexpr int P_LOAD    = 0;
+  static constexpr int P_PERM    = P_LOAD + 1;
+  static constexpr int P_S01     = P_PERM + 1;
+  static constexpr int P_STAGE   = P_S01 + 1;
+  static constexpr int P_SPLIT   = P_STAGE + STAGE_PASSES;
+  static constexpr int P_CLIENT  = P_SPLIT + 1;
+  static constexpr int P_UNSPLIT = P_CLIENT + CLIENT_PASSES;
+  static constexpr int P_IPERM   = P_UNSPLIT + 1;
+  static constexpr int P_IS01    = P_IPERM + 1;
+  static constexpr int P_ISTAGE  = P_IS01 + 1;
+  static constexpr int P_OLA     = P_ISTAGE + STAGE_PASSES;
+  static constexpr int PASSES    = P_OLA + 1;
+
+  // overlap-add of sqrt-Hann pairs sums to N / (2 HOP); the inverse
+  // FFT leaves a factor N
+  static constexpr float OUT_SCALE = (2.0f * (float)HOP / (float)N) / (float)N;
+  static constexpr float IN_SCALE  = 1.0f / 32768.0f;
+
+  static constexpr int RING = cx::pow2AtLeast(N + HOP);
+
+  template <class Client>
+  void runPasses(Client& c, int until) {
+    while (_pass < until) runPass(c, _pass++);
+  }
+
+  template <class Client>
+  void runPass(Client& c, int p) {
+    const Tables<N>& T = Fft::T;
+    if (p == P_LOAD) {
+      const uint32_t from = _end - (uint32_t)N;
+      for (int n = 0; n < N; n++) {
+        _buf[n] = (float)_in[(from + (uint32_t)n) & (N - 1)] * (T.win[n] * IN_SCALE);
+      }
+      c.beginFrame();
+    } else if (p == P_PERM || p == P_IPERM) {
+      Fft::permute(_buf);
+    } else if (p == P_S01) {
+      Fft::template stage01<false>(_buf);
+    } else if (p < P_SPLIT) {
+      Fft::template stage<false>(_buf, 2 + (p - P_STAGE));
+    } else if (p == P_SPLIT) {
+      Fft::split(_buf);
+    } else if (p < P_UNSPLIT) {
+      const int i = p - P_CLIENT;
+      c.spectrum(_buf, BINS * i / CLIENT_PASSES, BINS * (i + 1) / CLIENT_PASSES);
+    } else if (p == P_UNSPLIT) {
+      Fft::unsplit(_buf);
+    } else if (p == P_IS01) {
+      Fft::template stage01<true>(_buf);
+    } else if (p < P_OLA) {
+      Fft::template stage<true>(_buf, 2 + (p - P_ISTAGE));
+    } else {
+      const uint32_t from = _end - (uint32_t)N;
+      for (int n = 0; n < N; n++) {
+        _out[(from + (uint32_t)n) & (RING - 1)] += _buf[n] * (T.win[n] * OUT_SCALE);
+      }
+    }
+  }
+
+  // **************************
+  // State
+  // *****************
+  int16_t  _in[N];    // newest N input samples
+  float    _buf[N];   // frame being transformed
+  float    _out[RING]; // overlap-add, read LATENCY behind the input
+
+  uint32_t _count = 0; // input samples so far
+  uint32_t _end = 0;   // input count at the end of the current frame
+  int      _pass = PASSES;
+  int      _slot = 0;
+  bool     _spread = true;
+};
+
+// **************************
+// Benchmark
+// *****************
+// RealFft forward + inverse for N = 256..2048, then the engine's worst
+// and mean block for several N / HOP, with the frame spread over its
+// blocks and run whole in one. ticks() is a free running counter,
+// budget is ticks per audio block.
+void benchmark(Print& out, uint32_t (*ticks)(), uint32_t budget);
+
+} // namespace Stft
@@ -0,0 +1,284 @@
+#include "TapeEchoEffect.h"
+#include <math.h>
+
+// **************************
+// Line buffer
+// *****************
+// one echo, so the line is a file-scope buffer in OCRAM (DMAMEM)
+static DMAMEM uint8_t line[TapeEchoEffect::LINE_BYTES] __attribute__((aligned(32)));
+
+// **************************
+// Tuning
+// *****************
+static constexpr float MIN_TIME_MS = 40.0f;
+
+static constexpr float WOW_HZ    = 0.55f;
+static constexpr float WOW_MS    = 1.2f;  // peak swing
+static constexpr float FLUT_HZ   = 6.3f;
+static constexpr float FLUT_MS   = 0.08f;
+
+static constexpr float TIME_GLIDE = 0.02f; // per control tick, tape speed inertia
+
+static constexpr float FB_HP_HZ = 90.0f;
+
+// Codecs reconstruct mid-bin, so a repeat a few LSB above zero can come
+// back louder than it went in and hang as a tiny limit cycle. Stores
+// under this count as quiet and the line gets blanked after a full pass.
+static constexpr int QUIET_LSB = 16; // ~-66 dBFS
+
+// **************************
+// μ-law (G.711, 16 bit in/out)
+// *****************
+static constexpr int MULAW_BIAS = 0x84;
+static constexpr int MULAW_CLIP = 32635;
+
+static int16_t mulawTable[256];
+
+static uint8_t mulawEncode(int16_t s) {
+  int sign = (s < 0) ? 0x80 : 0;
+  int mag = sign ? -(int)s : (int)s;
+  if (mag > MULAW_CLIP) mag = MULAW_CLIP;
+  mag += MULAW_BIAS;
+
+  int exp = 7;
+  for (int mask = 0x4000; (mag & mask) == 0 && exp > 0; mask >>= 1) exp--;
+
+  int mant = (mag >> (exp + 3)) & 0x0F;
+  return (uint8_t)~(sign | (exp << 4) | mant);
+}
+
+static int16_t mulawDecode(uint8_t u) {
+  u = (uint8_t)~u;
+  int exp  = (u >> 4) & 0x07;
+  int mant = u & 0x0F;
+  int mag  = (((mant << 3) + MULAW_BIAS) << exp) - MULAW_BIAS;
+  return (int16_t)((u & 0x80) ? -mag : mag);
+}
+
+// **************************
+// 12 bit packed: 2 samples in 3 bytes
+// *****************
+//   b0 = s0[7:0]   b1 = s1[3:0] s0[11:8]   b2 = s1[11:4]
+static inline int16_t pcm12Encode(int16_t s) {
+  int c = ((int)s + 8) >> 4; // round to 12 bits
+  if (c > 2047) c = 2047;
+  return (int16_t)c;
+}
+
+TapeEchoEffect::TapeEchoEffect() {
+  for (int u = 0; u < 256; u++) mulawTable[u] = mulawDecode((uint8_t)u);
+  setFormat(MULAW);
+}
+
+void TapeEchoEffect::setFormat(Format f) {
+  _format = f;
+  _len = (f == MULAW) ? LINE_BYTES : (LINE_BYTES / 3) * 2;
+  _mark.setLength(_len);
+  reset();
+}
+
+void TapeEchoEffect::setControlInterval(int k) {
+  _ctrlK = ModEngine::clampInterval(k);
+}
+
+// forget the tape from the write head on
+void TapeEchoEffect::blankLine() {
+  _mark.clear(_w);
+}
+
+void TapeEchoEffect::reset() {
+  _w = 0;
+  blankLine();
+
+  _timeSm = 0.0f; // first block snaps to the knob
+  _phWow  = 0.0f;
+  _phFlut = 0.0f;
+  _delay.jump(0.0f);
+
+  _fbLP = 0.0f;
+  _fbHP = 0.0f;
+
+  _quietSamples = 0;
+  _silent = false;
+}
+
+float TapeEchoEffect::clamp01(float x) {
+  if (!(x > 0.0f)) return 0.0f; // NaN -> 0
+  if (x > 1.0f) return 1.0f;
+  return x;
+}
+
+int16_t TapeEchoEffect::clamp16(int32_t x) {
+  if (x > 32767) return 32767;
+  if (x < -32768) return -32768;
+  return (int16_t)x;
+}
+
+float TapeEchoEffect::lerp(float a, float b, float t) { return a + (b - a) * t; }
+
+// atan sat, unity gain for small signals so feedback < 1 still decays
+float TapeEchoEffect::satAtan(float x, float k) {
+  return atanf(k * x) / k;
+}
+
+// **************************
+// Line codec
+// *****************
+void TapeEchoEffect::store(int idx, int16_t s) {
+  if (!_mark.full()) {
+    int from;
+    int skipped = _mark.advance(idx, from);
+    for (int k = 0; k < skipped; k++) put(_mark.slot(from + k), 0);
+  }
+  put(idx, s);
+}
+
+void TapeEchoEffect::put(int idx, int16_t s) {
+  if (_format == MULAW) {
+    line[idx] = mulawEncode(s);
+    return;
+  }
+
+  int c = pcm12Encode(s) & 0x0FFF;
+  uint8_t* p = &line[(idx >> 1) * 3];
+  if ((idx & 1) == 0) {
+    p[0] = (uint8_t)c;
+    p[1] = (uint8_t)((p[1] & 0xF0) | (c >> 8));
+  } else {
+    p[1] = (uint8_t)((p[1] & 0x0F) | ((c & 0x0F) << 4));
+    p[2] = (uint8_t)(c >> 4);
+  }
+}
+
+float TapeEchoEffect::load(int idx) const {
+  if (!_mark.valid(idx)) return 0.0f;
+  if (_format == MULAW) return (float)mulawTable[line[idx]];
+
+  const uint8_t* p = &line[(idx >> 1) * 3];
+  int c = ((idx & 1) == 0) ? (p[0] | ((p[1] & 0x0F) << 8))
+                           : ((p[1] >> 4) | (p[2] << 4));
+  c = (c ^ 0x800) - 0x800; // sign extend 12 -> 32
+  return (float)(c << 4);
+}
+
+// Fractional read behind the write head. Integer and fraction are
+// split before indexing so the interpolation keeps full precision on
+// a line this long.
+float TapeEchoEffect::tap(float delaySamps) const {
+  int   di = (int)delaySamps;
+  float t  = delaySamps - (float)di;
+
+  int i0 = _w - di;
+  if (i0 < 0) i0 += _len;
+  int i1 = i0 - 1;
+  if (i1 < 0) i1 += _len;
+
+  return (1.0f - t) * load(i0) + t * load(i1);
+}
+
+// **************************
+// Tape motion
+// *****************
+float TapeEchoEffect::targetDelay(float fs, float time) const {
+  // keep the modulated tap inside the line
+  float maxD = (float)_len - 2.0f - (WOW_MS + FLUT_MS) * fs / 1000.0f;
+  float minD = MIN_TIME_MS * fs / 1000.0f;
+
+  // squared knob, more resolution on short slapback times
+  return minD + (maxD - minD) * time * time;
+}
+
+// wow + flutter m samples ahead, delay ramps to its value there
+void TapeEchoEffect::controlTick(int m, float fs, float target) {
+  if (_timeSm <= 0.0f) _timeSm = target;
+  _timeSm += TIME_GLIDE * (target - _timeSm);
+
+  _phWow  += WOW_HZ  * (float)m / fs;
+  _phFlut += FLUT_HZ * (float)m / fs;
+  if (_phWow  >= 1.0f) _phWow  -= 1.0f;
+  if (_phFlut >= 1.0f) _phFlut -= 1.0f;
+
+  float mod = WOW_MS  * sinf(2.0f * 3.14159265f * _phWow) +
+              FLUT_MS * sinf(2.0f * 3.14159265f * _phFlut);
+
+  float d = _timeSm + mod * fs / 1000.0f;
+  if (d < 1.0f) d = 1.0f;
+
+  if (_delay.value <= 0.0f) _delay.jump(d);
+  _delay.rampTo(d, m);
+}
+
+void TapeEchoEffect::processMono(int16_t* data, int n, float fs, const Params& pIn) {
+  float mix      = clamp01(pIn.mix);
+  float time     = clamp01(pIn.time);
+  float feedback = 0.95f * clamp01(pIn.feedback);
+  float tone     = clamp01(pIn.tone);
+
+  float target = targetDelay(fs, time);
+
+  // repeats lose highs + lows like tape
+  float lpA = lerp(1500.0f, 9000.0f, tone) / fs;
+  if (lpA > 0.45f) lpA = 0.45f;
+  float hpA = FB_HP_HZ / fs;
+
+  bool quiet = true;
+
+  for (int i = 0; i < n; ) {
+    int m = ModEngine::segment(n - i, _ctrlK);
+    controlTick(m, fs, target);
+
+    for (int j = 0; j < m; j++, i++) {
+      if (data[i] != 0) quiet = false;
+
+      float x = (float)data[i];
+
+      // decode only at the tap
+      float wet = tap(_delay.tick());
+
+      // feedback: tone LP, HP, soft clip, then back on tape
+      _fbLP += lpA * (wet - _fbLP);
+      _fbHP += hpA * (_fbLP - _fbHP);
+      float fb = (_fbLP - _fbHP) * feedback;
+
+      float rec = 32767.0f * satAtan((x + fb) / 32768.0f, 0.8f);
+      int16_t s = clamp16((int32_t)rec);
+      store(_w, s);
+      if (s > QUIET_LSB || s < -QUIET_LSB) quiet = false;
+
+      if (++_w >= _len) _w = 0;
+
+      float y = (1.0f - mix) * x + mix * wet;
+      data[i] = clamp16((int32_t)y);
+    }
+  }
+
+  // a full pass of quiet stores => whatever is left is codec dust,
+  // blank the tape so silence is an exact fixed point
+  if (!quiet) {
+    _quietSamples = 0;
+    _silent = false;
+  } else if (!_silent) {
+    _quietSamples += n;
+    if (_quietSamples >= _len) {
+      blankLine();
+      _fbLP = 0.0f;
+      _fbHP = 0.0f;
+      _silent = true;
+    }
+  }
+}
+
+// tape keeps moving over a blank line
+void TapeEchoEffect::idle(int n, float fs, const Params& pIn) {
+  float target = targetDelay(fs, clamp01(pIn.time));
+
+  for (int i = 0; i < n; ) {
+    int m = ModEngine::segment(n - i, _ctrlK);
+    controlTick(m, fs, target);
+    _delay.skip(m);
+    i += m;
+  }
+
+  _w = (_w + n) % _len;
+  blankLine(); // already blank, follow the head
+}
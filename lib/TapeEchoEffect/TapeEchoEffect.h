@@ -0,0 +1,134 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include "ModEngine.h"
+#include "FxBase.h"
+#include "LazyLine.h"
+
+// **************************
+// TapeEchoEffect
+// *****************
+// Multi-second echo. The line stores samples compressed and only the
+// read taps decode them, so a few seconds fit in one 128 KB buffer.
+//
+// Storage (128 KB line, 44.1k):
+//   format    bytes/sample  max delay  noise floor
+//   MULAW     1             2.97 s     ~37 dB under the signal, -84 dBFS floor
+//   PCM12     1.5           1.98 s     -77 dBFS flat
+//   (float    4             0.74 s     reference)
+// Repeats are requantized on every pass, which on MULAW reads as a
+// slightly grainy tape, PCM12 stays clean. tools/host/echo_bench
+// measures both formats.
+//
+// The feedback path runs through HP/LP tone filters and a soft clip
+// before it is stored. Reads use a wow + flutter modulated fractional
+// tap (same linear interpolation as the Leslie / flanger lines).
+//
+// The line is one static buffer in OCRAM, so use a single instance.
+class TapeEchoEffect : public FxBase<TapeEchoEffect> {
+public:
+  enum Format : uint8_t { MULAW = 0, PCM12 };
+
+  // **************************
+  // Params
+  // *****************
+  struct Params {
+    float mix      = 0.0f; // dry/wet
+    float time     = 0.0f; // short -> full line
+    float feedback = 0.0f; // repeats
+    float tone     = 0.0f; // dark -> bright repeats
+  };
+
+  static constexpr int LINE_BYTES = 128 * 1024;
+
+  TapeEchoEffect();
+
+  // changing the format clears the line
+  void setFormat(Format f);
+  Format format() const { return _format; }
+
+  // wow / flutter delay evaluated every k samples (1..32) and ramped
+  void setControlInterval(int k);
+
+  void reset();
+
+  // samples the line holds in the current format
+  int lineSamples() const { return _len; }
+
+  // the line codec alone: stores s at slot idx and decodes it back
+  float codecRoundTrip(int idx, int16_t s) { store(idx, s); return load(idx); }
+
+  // in place, mono
+  void processMono(int16_t* data, int n, float fs, const Params& p);
+
+  // **************************
+  // Idle
+  // *****************
+  // true once a full line of zeros went in and the filters are parked.
+  // idle() advances write position, tape motion and LFOs for zero blocks.
+  bool isSilent() const { return _silent; }
+  void idle(int n, float fs, const Params& p);
+
+  // **************************
+  // FxBase interface
+  // *****************
+  void prepare(float fs, int maxBlock) { _fs = fs; (void)maxBlock; }
+  void setParams(const Params& p) { _p = p; }
+  void process(int16_t* data, int n, const BlockAnalysis&) { processMono(data, n, _fs, _p); }
+  void idle(int n) { idle(n, _fs, _p); }
+
+  // plus the static line
+  size_t memoryBytes() const { return sizeof(*this) + LINE_BYTES; }
+
+private:
+  float  _fs = 44100.0f;
+  Params _p;
+
+  Format _format = MULAW;
+  int    _len = 0; // line length (samples)
+  int    _w   = 0; // write index
+
+  // samples stored since the line was last blanked, the rest decode as
+  // zero (blanking is O(1) instead of a 128 KB memset)
+  Lazy::Mark _mark;
+
+  // **************************
+  // Tape motion
+  // *****************
+  float _timeSm = 0.0f;   // smoothed delay time (samples), glides like tape
+  float _phWow  = 0.0f;   // 0..1
+  float _phFlut = 0.0f;   // 0..1
+
+  ModEngine::Ramp _delay; // modulated read delay (samples)
+  int _ctrlK = ModEngine::K_DEFAULT;
+
+  // **************************
+  // Feedback filters
+  // *****************
+  float _fbLP = 0.0f;
+  float _fbHP = 0.0f; // LP state used for the HP
+
+  // idle detection
+  int  _quietSamples = 0;
+  bool _silent = false;
+
+  // **************************
+  // Line codec
+  // *****************
+  void  blankLine();
+  void  store(int idx, int16_t s);
+  void  put(int idx, int16_t s);
+  float load(int idx) const;
+  float tap(float delaySamps) const;
+
+  // **************************
+  // Helpers
+  // *****************
+  static float clamp01(float x);
+  static int16_t clamp16(int32_t x);
+  static float lerp(float a, float b, float t);
+  static float satAtan(float x, float k);
+
+  float targetDelay(float fs, float time) const;
+  void  controlTick(int m, float fs, float target);
+};
@@ -0,0 +1,208 @@
+#include "Trace.h"
+
+#if defined(FX_TRACE_ENABLE) && !defined(ARDUINO)
+
+#include <stdio.h>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace Trace {
+
+// **************************
+// Per-thread log
+// *****************
+static constexpr int RING      = 1 << 17; // span + lap events kept per thread
+static constexpr int MAX_SITES = 64;      // lap names open at once
+static constexpr int MAX_DEPTH = 16;      // nested spans
+
+struct Event {
+  const char* name;
+  uint64_t t0;
+  uint64_t dur;
+  uint32_t calls; // 0 = span, else laps summed into this event
+};
+
+struct Site {
+  const char* name;
+  int      parent; // site index, -1 = top of the span
+  uint64_t sum;
+  uint32_t calls;
+};
+
+struct ThreadLog {
+  int tid = 0;
+
+  std::vector<Event> ring;
+  uint32_t head  = 0;
+  uint32_t count = 0;
+
+  Site sites[MAX_SITES];
+  int  nSites = 0;
+  int  cur = -1;
+
+  int spanCur[MAX_DEPTH];
+  int depth = 0;
+};
+
+static std::mutex              regMutex;
+static std::vector<ThreadLog*> logs;
+
+static thread_local ThreadLog* tl = nullptr;
+
+static ThreadLog& threadLog() {
+  if (!tl) {
+    tl = new ThreadLog();
+    tl->ring.resize(RING);
+    std::lock_guard<std::mutex> g(regMutex);
+    tl->tid = (int)logs.size() + 1;
+    logs.push_back(tl); // kept after the thread exits so it can be dumped
+  }
+  return *tl;
+}
+
+static void push(ThreadLog& L, const char* name, uint64_t t0, uint64_t dur, uint32_t calls) {
+  Event& e = L.ring[L.head];
+  e.name  = name;
+  e.t0    = t0;
+  e.dur   = dur;
+  e.calls = calls;
+  if (++L.head >= (uint32_t)RING) L.head = 0;
+  if (L.count < (uint32_t)RING) L.count++;
+}
+
+// **************************
+// Clock
+// *****************
+// TSC where there is one (a few ns per read), converted at export
+static uint64_t steadyNs() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+uint64_t ticks() { return __rdtsc(); }
+#else
+uint64_t ticks() { return steadyNs(); }
+#endif
+
+static uint64_t calTicks = ticks();
+static uint64_t calNs    = steadyNs();
+
+static double ticksPerUs() {
+  uint64_t ns = steadyNs();
+  while (ns - calNs < 20000000ull) ns = steadyNs(); // >= 20 ms baseline
+  return (double)(ticks() - calTicks) / ((double)(ns - calNs) / 1000.0);
+}
+
+// **************************
+// Laps
+// *****************
+int site(const char* name, int parent) {
+  ThreadLog& L = threadLog();
+  for (int i = 0; i < L.nSites; i++) {
+    if (L.sites[i].name == name && L.sites[i].parent == parent) return i;
+  }
+  if (L.nSites >= MAX_SITES) return -1;
+
+  Site& s = L.sites[L.nSites];
+  s.name   = name;
+  s.parent = parent;
+  s.sum    = 0;
+  s.calls  = 0;
+  return L.nSites++;
+}
+
+void add(int s, uint64_t dt) {
+  if (s < 0) return;
+  ThreadLog& L = threadLog();
+  L.sites[s].sum += dt;
+  L.sites[s].calls++;
+}
+
+int  current()          { return threadLog().cur; }
+void setCurrent(int s)  { threadLog().cur = s; }
+
+// **************************
+// Spans
+// *****************
+int beginSpan() {
+  ThreadLog& L = threadLog();
+  if (L.depth < MAX_DEPTH) L.spanCur[L.depth] = L.cur;
+  L.depth++;
+  L.cur = -1;
+  return L.nSites;
+}
+
+// children of 'parent' back to back from t0
+static void layout(ThreadLog& L, int mark, int parent, uint64_t t0) {
+  for (int i = mark; i < L.nSites; i++) {
+    const Site& s = L.sites[i];
+    bool top = (parent < 0) ? (s.parent < mark) : (s.parent == parent);
+    if (!top) continue;
+
+    push(L, s.name, t0, s.sum, s.calls ? s.calls : 1);
+    layout(L, mark, i, t0);
+    t0 += s.sum;
+  }
+}
+
+void endSpan(const char* name, uint64_t t0, uint64_t t1, int mark) {
+  ThreadLog& L = threadLog();
+  push(L, name, t0, t1 - t0, 0);
+
+  // the span's laps, then forget them
+  layout(L, mark, -1, t0);
+  L.nSites = mark;
+
+  L.depth--;
+  if (L.depth < MAX_DEPTH) L.cur = L.spanCur[L.depth];
+}
+
+// **************************
+// Export
+// *****************
+bool writeChromeJson(const char* path) {
+  FILE* f = fopen(path, "w");
+  if (!f) return false;
+
+  const double tpu = ticksPerUs();
+
+  std::lock_guard<std::mutex> g(regMutex);
+
+  fprintf(f, "{\"traceEvents\":[\n");
+  bool first = true;
+
+  for (ThreadLog* L : logs) {
+    uint32_t start = (L->head + RING - L->count) % RING;
+    for (uint32_t i = 0; i < L->count; i++) {
+      const Event& e = L->ring[(start + i) % RING];
+      fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+              first ? "" : ",\n", e.name, L->tid,
+              (double)(e.t0 - calTicks) / tpu, (double)e.dur / tpu);
+      if (e.calls) fprintf(f, ",\"args\":{\"calls\":%u}", e.calls);
+      fprintf(f, "}");
+      first = false;
+    }
+  }
+
+  fprintf(f, "\n],\"displayTimeUnit\":\"ns\"}\n");
+  fclose(f);
+  return true;
+}
+
+void clear() {
+  std::lock_guard<std::mutex> g(regMutex);
+  for (ThreadLog* L : logs) {
+    L->head  = 0;
+    L->count = 0;
+  }
+}
+
+} // namespace Trace
+
+#endif
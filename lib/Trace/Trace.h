@@ -0,0 +1,99 @@
+#pragma once
+
+// **************************
+// Trace
+// *****************
+// Scoped timing marks for finding where the time goes inside an effect.
+// Only the host build records anything (-DFX_TRACE_ENABLE, never with
+// ARDUINO); on the Teensy every macro is an empty statement.
+//
+//   FX_TRACE("Orchestra");          span until the end of the scope,
+//                                   one trace event per call
+//   FX_TRACE_LAPS(t);               stopwatch for a per-sample loop body
+//   FX_TRACE_LAP(t, "combs");       close the previous lap, start this one
+//
+// Laps are summed per span instead of logged one by one (a block has
+// thousands of them). When the span closes, each lap name becomes one
+// event whose length is its total for the block, laid out inside the
+// span, and laps opened during a lap nest under it. So Perfetto /
+// chrome://tracing shows per-stage shares for every block.
+//
+// Each thread records into its own ring; Trace::writeChromeJson() dumps
+// all of them once the threads are done.
+#if defined(FX_TRACE_ENABLE) && !defined(ARDUINO)
+
+#include <stdint.h>
+
+namespace Trace {
+
+uint64_t ticks();
+
+// lap sums, per thread
+int  site(const char* name, int parent);
+void add(int site, uint64_t dt);
+int  current();
+void setCurrent(int site);
+
+// span events, per thread
+int  beginSpan();
+void endSpan(const char* name, uint64_t t0, uint64_t t1, int mark);
+
+// Chrome trace JSON ("traceEvents"), false if the file can't be written
+bool writeChromeJson(const char* path);
+
+// drop everything recorded so far
+void clear();
+
+class Span {
+public:
+  explicit Span(const char* name) : _name(name), _mark(beginSpan()), _t0(ticks()) {}
+  ~Span() { endSpan(_name, _t0, ticks(), _mark); }
+
+private:
+  const char* _name;
+  int         _mark;
+  uint64_t    _t0;
+};
+
+class Laps {
+public:
+  Laps() : _parent(current()) {}
+  ~Laps() {
+    close(ticks());
+    setCurrent(_parent);
+  }
+
+  void lap(const char* name) {
+    uint64_t t = ticks();
+    close(t);
+    _site = site(name, _parent);
+    _t0 = t;
+    setCurrent(_site);
+  }
+
+private:
+  int      _parent;
+  int      _site = -1;
+  uint64_t _t0 = 0;
+
+  void close(uint64_t t) {
+    if (_site >= 0) add(_site, t - _t0);
+  }
+};
+
+} // namespace Trace
+
+#define FX_TRACE_CAT2(a, b) a##b
+#define FX_TRACE_CAT(a, b)  FX_TRACE_CAT2(a, b)
+
+#define FX_TRACE(name)        Trace::Span FX_TRACE_CAT(_fxTrace, __LINE__)(name)
+#define FX_TRACE_LAPS(t)      Trace::Laps t
+#define FX_TRACE_LAP(t, name) (t).lap(name)
+
+#else
+
+#define FX_TRACE(name)        do {} while (0)
+#define FX_TRACE_LAPS(t)      do {} while (0)
+#define FX_TRACE_LAP(t, name) do {} while (0)
+
+#endif
@@ -0,0 +1,224 @@
+#include "Tuner.h"
+#include <math.h>
+#include <string.h>
+
+static_assert((Tuner::RING & (Tuner::RING - 1)) == 0, "ring indexes by mask");
+static_assert(Tuner::WINDOW <= Tuner::RING / 2, "room to copy while the ISR writes");
+static_assert((Tuner::DECIM & (Tuner::DECIM - 1)) == 0, "box sum divides by shift");
+
+// **************************
+// Analysis settings
+// *****************
+static constexpr float GATE_RMS    = 40.0f;   // int16 units, ~-58 dBFS
+static constexpr float YIN_THRESH  = 0.15f;   // first dip under this wins
+static constexpr float YIN_REJECT  = 0.35f;   // no dip under this: no pitch
+
+// **************************
+// Sync
+// *****************
+// ISR owns _written, loop() only reads it
+static inline uint32_t ld(const uint32_t& v) { return __atomic_load_n(&v, __ATOMIC_ACQUIRE); }
+static inline void st(uint32_t& v, uint32_t x) { __atomic_store_n(&v, x, __ATOMIC_RELEASE); }
+
+Tuner::Tuner() { reset(); }
+
+void Tuner::reset() {
+  memset(_ring, 0, sizeof(_ring));
+  st(_written, 0);
+  _acc = 0;
+  _prev = 0;
+  _phase = 0;
+  _lastMs = 0;
+  _reading = Reading();
+}
+
+void Tuner::prepare(float fs, int maxBlock) {
+  (void)maxBlock;
+  _fs = fs;
+}
+
+// **************************
+// Audio interrupt
+// *****************
+// Integer sums only: each group of DECIM samples is added up and a ring
+// sample is the mean of that group and the one before (a 2 * DECIM box,
+// -3 dB near 2.4 kHz, nulls on multiples of fs / 2 / DECIM). Enough
+// anti-aliasing for YIN's 60..1400 Hz, no float work per sample.
+void Tuner::processBlock(int16_t* data, int n) {
+  uint32_t w = _written; // only this side writes it
+  int32_t acc = _acc, prev = _prev;
+  int phase = _phase;
+  int i = 0;
+
+  // finish the sum an odd sized block left open
+  for (; phase != 0 && i < n; i++) {
+    acc += data[i];
+    if (++phase == DECIM) {
+      _ring[(w++) & (RING - 1)] = (int16_t)((acc + prev) / (2 * DECIM));
+      prev = acc;
+      acc = 0;
+      phase = 0;
+    }
+  }
+
+  for (; i + DECIM <= n; i += DECIM) {
+    int32_t sum = 0;
+    for (int k = 0; k < DECIM; k++) sum += data[i + k];
+    _ring[(w++) & (RING - 1)] = (int16_t)((sum + prev) / (2 * DECIM));
+    prev = sum;
+  }
+
+  for (; i < n; i++, phase++) acc += data[i];
+
+  _acc = acc;
+  _prev = prev;
+  _phase = phase;
+  st(_written, w); // samples first, then the count
+
+  if (_p.mute) memset(data, 0, (size_t)n * sizeof(int16_t));
+}
+
+void Tuner::idle(int n) {
+  uint32_t w = _written;
+  int total = _phase + n;
+  for (int k = 0; k < total / DECIM; k++) _ring[(w++) & (RING - 1)] = 0;
+  _phase = total % DECIM;
+  _acc = 0;
+  _prev = 0;
+  st(_written, w);
+}
+
+// **************************
+// loop()
+// *****************
+bool Tuner::service(uint32_t nowMs) {
+  if ((uint32_t)(nowMs - _lastMs) < INTERVAL_MS) return false;
+  _lastMs = nowMs;
+
+  const uint32_t w = ld(_written);
+  if (w < (uint32_t)WINDOW) {
+    _reading = Reading();
+    return true;
+  }
+
+  for (int j = 0; j < WINDOW; j++) _win[j] = _ring[(w - WINDOW + (uint32_t)j) & (RING - 1)];
+
+  // lapped while copying: skip, next interval tries again
+  if (ld(_written) - w > (uint32_t)(RING - WINDOW)) return false;
+
+  _reading = analyze(_win, WINDOW, _fs / (float)DECIM, _p.refHz, _scratch);
+  return true;
+}
+
+// **************************
+// YIN
+// *****************
+// vertex offset of the parabola through d[i - 1], d[i], d[i + 1]
+static float parabola(const float* d, int i) {
+  const float a = d[i - 1], b = d[i], c = d[i + 1];
+  const float den = a - 2.0f * b + c;
+  if (!(den > 0.0f)) return 0.0f;
+  float s = 0.5f * (a - c) / den;
+  if (s > 0.5f) s = 0.5f;
+  if (s < -0.5f) s = -0.5f;
+  return s;
+}
+
+Tuner::Reading Tuner::analyze(const int16_t* x, int n, float fsDecim, float refHz, float* d) {
+  Reading r;
+
+  int maxLag = (int)(fsDecim / MIN_HZ) + 1;
+  int minLag = (int)(fsDecim / MAX_HZ);
+  if (maxLag > n / 2 - 1) maxLag = n / 2 - 1;
+  if (minLag < 2) minLag = 2;
+  if (maxLag <= minLag + 2) return r;
+  const int W = n - maxLag;
+
+  // level gate (mean taken out, the difference function ignores DC)
+  float mean = 0.0f;
+  for (int j = 0; j < n; j++) mean += (float)x[j];
+  mean /= (float)n;
+  float ss = 0.0f;
+  for (int j = 0; j < n; j++) {
+    float v = (float)x[j] - mean;
+    ss += v * v;
+  }
+  if (sqrtf(ss / (float)n) < GATE_RMS) return r;
+
+  // difference function d(tau) = sum (x[j] - x[j + tau])^2
+  d[0] = 0.0f;
+  for (int tau = 1; tau <= maxLag; tau++) {
+    float s = 0.0f;
+    const int16_t* a = x;
+    const int16_t* b = x + tau;
+    for (int j = 0; j < W; j++) {
+      float e = (float)(a[j] - b[j]);
+      s += e * e;
+    }
+    d[tau] = s;
+  }
+
+  // cumulative mean normalised d'(tau) = d(tau) * tau / sum, in the
+  // scratch's upper half (the raw d is kept for the refinement)
+  float* cm = d + maxLag + 1;
+  float sum = 0.0f;
+  cm[0] = 1.0f;
+  for (int tau = 1; tau <= maxLag; tau++) {
+    sum += d[tau];
+    cm[tau] = (sum > 0.0f) ? d[tau] * (float)tau / sum : 1.0f;
+  }
+
+  // first dip under the threshold, walked down to its bottom
+  int best = -1;
+  for (int tau = minLag; tau < maxLag; tau++) {
+    if (cm[tau] < YIN_THRESH) {
+      while (tau + 1 < maxLag && cm[tau + 1] < cm[tau]) tau++;
+      best = tau;
+      break;
+    }
+  }
+  // none: the deepest dip, if it's deep enough at all
+  if (best < 0) {
+    float lo = 1.0e9f;
+    for (int tau = minLag; tau < maxLag; tau++) {
+      if (cm[tau] < lo) {
+        lo = cm[tau];
+        best = tau;
+      }
+    }
+    if (best < 0 || lo > YIN_REJECT) return r;
+  }
+  const float dip = cm[best];
+
+  // Fractional period: a parabola through the raw dip (the normalisation
+  // tilts it). Its error is a fraction of a lag, which is cents on a
+  // period of 8 lags, so short periods are measured over the furthest
+  // whole multiple that still fits and divided back.
+  float period = (float)best + parabola(d, best);
+  const int k = (int)((float)(maxLag - 1) / period);
+  if (k > 1) {
+    int at = (int)((float)k * period + 0.5f);
+    if (at >= maxLag) at = maxLag - 1;
+    if (d[at - 1] < d[at]) at--;
+    else if (at + 1 < maxLag && d[at + 1] < d[at]) at++;
+    period = ((float)at + parabola(d, at)) / (float)k;
+  }
+
+  const float hz = fsDecim / period;
+  if (!(hz >= MIN_HZ && hz <= MAX_HZ)) return r;
+
+  const float midi = 69.0f + 12.0f * log2f(hz / refHz);
+  const int note = (int)floorf(midi + 0.5f);
+
+  r.valid   = true;
+  r.hz      = hz;
+  r.note    = note;
+  r.cents   = 100.0f * (midi - (float)note);
+  r.clarity = 1.0f - dip;
+  return r;
+}
+
+const char* Tuner::noteName(int midi) {
+  static const char* NAMES[12] = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
+  return NAMES[((midi % 12) + 12) % 12];
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include "FxBase.h"
+
+// **************************
+// Tuner
+// *****************
+// Chromatic tuner split across the two contexts:
+//   - audio interrupt: integer box sum over 2 * DECIM samples, every
+//     DECIM samples into a ring of int16, audio passes or is muted
+//   - loop(): service() copies the newest WINDOW samples a few times a
+//     second and runs YIN on them (difference function, cumulative
+//     mean normalisation, absolute threshold, parabolic refinement)
+//
+// The ring is single producer / single consumer and never blocks the
+// interrupt: the reader re-checks the write count after copying and
+// drops the window if it was overwritten meanwhile.
+class Tuner : public FxBase<Tuner> {
+public:
+  static constexpr int DECIM  = 4;    // ~11 kHz analysis rate
+  static constexpr int RING   = 2048; // decimated samples, ~186 ms
+  static constexpr int WINDOW = 1024; // analysed at once, ~93 ms
+  static constexpr float MIN_HZ = 60.0f;   // below drop C
+  static constexpr float MAX_HZ = 1400.0f; // high E, 24th fret and a bit
+
+  static constexpr uint32_t INTERVAL_MS = 125; // 8 readings a second
+
+  struct Params {
+    float refHz = 440.0f; // A4
+    bool  mute  = false;  // silent tuning
+  };
+
+  struct Reading {
+    bool  valid   = false;
+    float hz      = 0.0f;
+    int   note    = 0;    // MIDI, 69 = A4
+    float cents   = 0.0f; // -50..50 from note
+    float clarity = 0.0f; // 1 - YIN dip, 1 = perfectly periodic
+  };
+
+  Tuner();
+  void reset();
+
+  // **************************
+  // Audio interrupt
+  // *****************
+  void processBlock(int16_t* data, int n);
+
+  // **************************
+  // loop()
+  // *****************
+  // New reading every INTERVAL_MS; true when one was made
+  bool service(uint32_t nowMs);
+  const Reading& reading() const { return _reading; }
+
+  // YIN on n decimated samples at fsDecim (the host test calls it
+  // directly); scratch is n floats
+  static Reading analyze(const int16_t* x, int n, float fsDecim, float refHz, float* scratch);
+
+  static const char* noteName(int midi); // "C", "C#", ...
+
+  // **************************
+  // FxBase interface
+  // *****************
+  void prepare(float fs, int maxBlock);
+  void setParams(const Params& p) { _p = p; }
+  void process(int16_t* data, int n, const BlockAnalysis&) { processBlock(data, n); }
+
+  // nothing to drain; parks only when muted, unmuted the dry signal
+  // passes. idle() moves the ring along with zeros.
+  bool isSilent() const { return _p.mute; }
+  void idle(int n);
+
+private:
+  float  _fs = 44100.0f;
+  Params _p;
+
+  // **************************
+  // Shared with the interrupt
+  // *****************
+  int16_t  _ring[RING];
+  uint32_t _written = 0; // ISR: decimated samples ever written
+
+  // ISR decimator
+  int32_t _acc   = 0; // open group
+  int32_t _prev  = 0; // sum of the last full group
+  int     _phase = 0;
+
+  // loop() side
+  uint32_t _lastMs = 0;
+  Reading  _reading;
+  int16_t  _win[WINDOW];
+  float    _scratch[WINDOW];
+};
@@ -1,5 +1,5 @@
 // main.cpp
-// Teensy 4.0 DSP Pedal (mono output on LEFT only)
+// Teensy 4.0 DSP Pedal (mono in on LEFT, mono out on LEFT only)
 // Tap button to cycle effects
 // Pots are wired backwards, so we flip them in code
 // RGB LED shows which mode we’re in
@@ -8,12 +8,27 @@
 #include <Audio.h>
 #include <Wire.h>
 #include <SPI.h>
+#include <SD.h>
 
 #include "LeslieEffect.h"
 #include "BigMuffEffect.h"
 #include "OctaveEffect.h"
 #include "OrchestraEffect.h"
+#include "PolyOctaveEffect.h"
+#include "TapeEchoEffect.h"
+#include "AmpModel.h"        // recurrent amp capture, weights in flash
+#include "AmpModelDefault.h" // built-in capture (tools/host/amp_convert)
+#include "SdLooper.h"        // record / overdub streamed through SD
+#include "Tuner.h"           // pitch analysed in loop(), not the interrupt
+#include "EnvFilterEffect.h" // auto-wah, TPT SVF swept per sample
+#include "FreezeEffect.h"    // spectral freeze on the spread-out Stft engine
 #include "SimpleEffects.h"  // bitcrush / flanger / trem + tiny filters
+#include "DenormalGuard.h"  // flush subnormals in feedback tails
+#include "BlockAnalysis.h"  // shared envelope / onset / gate per block
+#include "FlightRecorder.h" // last blocks before a dropout / clip
+#include "OutputLimiter.h"  // look-ahead limiter after the volume
+#include "ParamMap.h"       // compile-time knob curves
+#include "Trace.h"          // host-only timing marks (no-op on the Teensy)
 
 using namespace SimpleFX;
 
@@ -28,6 +43,9 @@ static constexpr int POT5_PIN = A0; // pin 14
 
 static constexpr int BTN_PIN  = 2;
 
+// SD slot on the audio shield
+static constexpr int SD_CS_PIN = 10;
+
 // RGB LED pins
 static constexpr int LED_R = 3;
 static constexpr int LED_G = 4;
@@ -37,7 +55,7 @@ static constexpr int LED_B = 5;
 // Small Helpers
 // *****************
 static inline float clamp01(float x) {
-  if (x < 0.0f) return 0.0f;
+  if (!(x > 0.0f)) return 0.0f; // NaN -> 0
   if (x > 1.0f) return 1.0f;
   return x;
 }
@@ -71,10 +89,17 @@ enum Mode : uint8_t {
   MODE_FLANGE = 6,
   MODE_TREM   = 7,
   MODE_CHORUS = 8,
+  MODE_POLYOCT = 9,
+  MODE_LOOPER  = 10,
+  MODE_ECHO    = 11,
+  MODE_AMP     = 12,
+  MODE_TUNER   = 13,
+  MODE_ENVF    = 14,
+  MODE_FREEZE  = 15,
 };
 
 static Mode mode = MODE_BYPASS;
-static constexpr uint8_t MODE_COUNT = 9;
+static constexpr uint8_t MODE_COUNT = 16;
 
 // ******************************
 // Effect Objects
@@ -83,25 +108,117 @@ static LeslieEffect    leslie;
 static BigMuffEffect   muff;
 static OctaveEffect    octave;
 static OrchestraEffect orchestra;
+static PolyOctaveEffect polyOctave;
+static TapeEchoEffect  echo;
+static SdLooper        looper;
+static AmpModel        amp;
+static Tuner           tuner;
+static EnvFilterEffect envFilter;
+static FreezeEffect    freeze;
+static_assert(SdLooper::BLOCK == AUDIO_BLOCK_SAMPLES, "looper works in whole audio blocks");
+static_assert(FreezeEffect::BLOCK == AUDIO_BLOCK_SAMPLES, "stft works in whole audio blocks");
 
 // Simple FX from SimpleEffects.h
 static BitCrusher  crush;
 static Flanger     flanger;
 static Tremolo     trem;
 
-// Chorus is basically “flanger but longer delay + no feedback”
-static Flanger     chorus;
+// Multi-voice chorus, all voices share one delay line
+static Chorus      chorus;
 
 // Tiny filters for quick cleanup
 static OnePoleHPF  hpf;
 static OnePoleLPF  lpf;
 
+// Input dynamics, measured once per block for every effect
+static InputAnalyzer analyzer;
+
+// Volume + look-ahead limiter, the last stage before the codec
+static OutputLimiter limiter;
+
+// ********************************
+// Flight Recorder
+// **************************
+// update() slower than this share of the block period counts as a miss
+static constexpr float FR_DEADLINE_FRAC = 0.8f;
+
+// the limiter pulling the output down further than this counts as a clip
+static constexpr float FR_LIMIT_GAIN = 0.5f; // -6 dB
+
+// dumps go to FR000.BIN .. FR999.BIN, a few frames per loop() pass
+static constexpr int FR_MAX_FILES = 1000;
+static constexpr int FR_FRAMES_PER_PASS = 4; // ~1 KB of card writes
+
+static FlightRecorder recorder;
+static_assert(FlightRecorder::BLOCK == AUDIO_BLOCK_SAMPLES, "recorder frames are whole audio blocks");
+static bool sdReady = false;
+static int  frNext = FR_MAX_FILES; // next free dump index, found at boot
+
 // **************************
 // Pot Smoothing
 // ****************
 static float s1=0, s2=0, s3=0, s4=0, s5=0;
 static constexpr float POT_ALPHA = 0.15f;
 
+// Control-rate interval for LFO-driven mod targets (1..32 samples)
+static constexpr int MOD_CONTROL_K = 16;
+
+// chorus voice count (2..8)
+static constexpr int CHORUS_VOICES = 4;
+
+// poly octave filterbank size (16..64)
+static constexpr int POLY_OCT_BANDS = 32;
+
+// echo line storage: MULAW = ~3 s, PCM12 = ~2 s but cleaner repeats
+static constexpr TapeEchoEffect::Format ECHO_FORMAT = TapeEchoEffect::MULAW;
+
+// muff: CIRCUIT = diode clipper + tone stack model, CLASSIC = atan stages
+#ifndef MUFF_MODEL
+#define MUFF_MODEL CIRCUIT
+#endif
+static constexpr BigMuffEffect::Model MUFF_MODEL_SEL = BigMuffEffect::MUFF_MODEL;
+
+// static waveshapers: OFF = plain (classic muff: its 2x loop),
+// ADAA1 / ADAA2 = antiderivative anti-aliased at 1x (tools/host/aa_bench)
+static constexpr Adaa::Mode MUFF_AA   = Adaa::OFF;
+static constexpr Adaa::Mode SHAPER_AA = Adaa::ADAA1; // octave up, orchestra out
+
+
+// **************************
+// Knob Maps
+// ****************
+// Curves for knobs that feed a raw Hz / gain / filter coefficient.
+// Built at compile time (see ParamMap.h), looked up by ADC step.
+// Knobs that go straight into an effect's Params are mapped inside it.
+static constexpr float KNOB_FS = AUDIO_SAMPLE_RATE_EXACT;
+
+// P1 volume, audio taper
+static constexpr ParamMap::Table VOL_GAIN PROGMEM = ParamMap::audioTaper(40.0f);
+
+// crush edge: HP 20 -> 160 Hz, LP 11.5k -> 2.5k
+static constexpr ParamMap::Table CRUSH_EDGE_HP PROGMEM = ParamMap::hpfCoef(20.0f, 160.0f, KNOB_FS);
+static constexpr ParamMap::Table CRUSH_EDGE_LP PROGMEM = ParamMap::lpfCoef(11500.0f, 2500.0f, KNOB_FS);
+
+// flanger: rate, depth darkens the LP 11.5k -> 3.5k
+static constexpr ParamMap::Table FLANGE_RATE PROGMEM = ParamMap::logTaper(0.05f, 4.05f);
+static constexpr ParamMap::Table FLANGE_LP   PROGMEM = ParamMap::lpfCoef(11500.0f, 3500.0f, KNOB_FS);
+
+// tremolo: rate, chop HP 15 -> 135 Hz
+static constexpr ParamMap::Table TREM_RATE PROGMEM = ParamMap::logTaper(0.2f, 12.2f);
+static constexpr ParamMap::Table TREM_CHOP PROGMEM = ParamMap::hpfCoef(15.0f, 135.0f, KNOB_FS);
+
+// chorus: rate (likes slower), tone LP 1.2k -> 13.2k, fixed 15 Hz HP
+static constexpr ParamMap::Table CHORUS_RATE PROGMEM = ParamMap::logTaper(0.08f, 2.58f);
+static constexpr ParamMap::Table CHORUS_TONE PROGMEM = ParamMap::lpfCoef(1200.0f, 13200.0f, KNOB_FS);
+static constexpr float CHORUS_HP_A = ParamMap::hpfA(15.0f, KNOB_FS);
+
+// amp model: drive into the capture, tone LP 1.5k -> 12k
+static constexpr ParamMap::Table AMP_DRIVE PROGMEM = ParamMap::logTaper(0.5f, 8.0f);
+static constexpr ParamMap::Table AMP_TONE  PROGMEM = ParamMap::lpfCoef(1500.0f, 12000.0f, KNOB_FS);
+
+// envelope filter: sensitivity (envelope gain), resonance Q
+static constexpr ParamMap::Table ENVF_SENS PROGMEM = ParamMap::logTaper(0.5f, 12.0f);
+static constexpr ParamMap::Table ENVF_Q    PROGMEM = ParamMap::logTaper(0.7f, 16.0f);
 
 static void readControls(float& param1, float& param2, float& param3, float& param4, float& param5) {
   float r1 = readPot01Flipped(POT5_PIN); // param1 (volume)
@@ -110,22 +227,392 @@ static void readControls(float& param1, float& param2, float& param3, float& par
   float r4 = readPot01Flipped(POT2_PIN); // param4
   float r5 = readPot01Flipped(POT1_PIN); // param5
 
-  // low-pass smoothing
-  s1 += POT_ALPHA * (r1 - s1);
-  s2 += POT_ALPHA * (r2 - s2);
-  s3 += POT_ALPHA * (r3 - s3);
-  s4 += POT_ALPHA * (r4 - s4);
-  s5 += POT_ALPHA * (r5 - s5);
+  // low-pass smoothing, clamped so a bad value can't stick in the state
+  s1 = clamp01(s1 + POT_ALPHA * (r1 - s1));
+  s2 = clamp01(s2 + POT_ALPHA * (r2 - s2));
+  s3 = clamp01(s3 + POT_ALPHA * (r3 - s3));
+  s4 = clamp01(s4 + POT_ALPHA * (r4 - s4));
+  s5 = clamp01(s5 + POT_ALPHA * (r5 - s5));
 
   param1 = s1; param2 = s2; param3 = s3; param4 = s4; param5 = s5;
 }
 
+// ********************************
+// Idle
+// **************************
+// Blocks under the analyzer's idle gate are only marked silent, the
+// audio itself is left alone. When the active effect has its tail
+// parked as well, its DSP is skipped and the block becomes the zeros a
+// parked effect settles to (FxBase::run). While a tail still rings, and
+// always in the pass-through modes, the quiet input is processed as is.
+
+// host A/B only (fx_render --no-skip, skip_check): false sends every
+// block through the DSP. Nothing on the pedal clears it.
+static bool idleSkip = true;
+
+// host A/B only (denormal_bench): false runs the effects with subnormals
+// left on. Nothing on the pedal clears it.
+static bool flushSubnormals = true;
+
+// cleanup filters: skip only after the effect skipped (block is zeros)
+// and the filter state is zero too
+template <class Filter>
+static inline void runFilter(Filter& f, int16_t* data, int n, bool& silent) {
+  if (silent && f.isSilent()) return;
+  f.processBlock(data, n);
+  silent = false;
+}
+
+// ********************************
+// Mode Table
+// **************************
+// One row per Mode, generated from the FxBase interface: the effect,
+// how the knobs map onto its Params, and any cleanup after it.
+// update() makes one indirect call into the row, no virtuals, and
+// adding a mode is a policy struct plus a row.
+struct Knobs { float k2, k3, k4, k5; };
+
+struct ModeRow {
+  void   (*process)(int16_t* data, const Knobs& k, const BlockAnalysis& an, bool& silent);
+  void   (*prepare)(float fs, int maxBlock);
+  void   (*reset)();
+  int    (*latency)();
+  size_t (*memoryBytes)();
+};
+
+// policy defaults: nothing after the effect
+struct ModeDefaults {
+  static void post(int16_t*, const Knobs&, bool&) {}
+};
+
+template <class M>
+static void modeProcess(int16_t* data, const Knobs& k, const BlockAnalysis& an, bool& silent) {
+  auto& fx = M::fx();
+  fx.setParams(M::params(k));
+  fx.run(data, AUDIO_BLOCK_SAMPLES, an, silent);
+  M::post(data, k, silent);
+}
+
+template <class M> static void   modePrepare(float fs, int maxBlock) { M::fx().prepare(fs, maxBlock); }
+template <class M> static void   modeReset()   { M::fx().reset(); }
+template <class M> static int    modeLatency() { return M::fx().latency(); }
+template <class M> static size_t modeMemory()  { return M::fx().memoryBytes(); }
+
+template <class M>
+static constexpr ModeRow modeRow() {
+  return { &modeProcess<M>, &modePrepare<M>, &modeReset<M>, &modeLatency<M>, &modeMemory<M> };
+}
+
+// BYPASS, let clean audio thru
+struct BypassFx : public FxBase<BypassFx> {
+  struct Params {};
+  void prepare(float, int) {}
+  void setParams(const Params&) {}
+  void process(int16_t*, int, const BlockAnalysis&) {}
+  bool isSilent() const { return false; } // never gate the clean signal
+  void reset() {}
+};
+static BypassFx bypass;
+
+struct BypassMode : ModeDefaults {
+  static BypassFx& fx() { return bypass; }
+  static BypassFx::Params params(const Knobs&) { return {}; }
+};
+
+// LESLIE: both mics read from one mono rotor, then collapse to mono with blend
+struct LeslieMode : ModeDefaults {
+  static LeslieEffect& fx() { return leslie; }
+
+  // K2 blend, K3 speed, K4 depth, K5 ramp
+  static LeslieEffect::Params params(const Knobs& k) {
+    LeslieEffect::Params p;
+    p.volume = 1.0f; // keep per-effect volume consistent, do final volume at the end
+    p.blend  = k.k2;
+    p.speed  = k.k3;
+    p.depth  = k.k4;
+    p.ramp   = k.k5;
+    return p;
+  }
+};
+
+// BIG MUFF
+struct MuffMode : ModeDefaults {
+  static BigMuffEffect& fx() { return muff; }
+
+  // K2 tone, K3 drive, K4 shape, K5 presence
+  static BigMuffEffect::Params params(const Knobs& k) {
+    BigMuffEffect::Params p;
+    p.tone  = k.k2;
+    p.drive = k.k3;
+    p.shape = k.k4;
+    p.pres  = k.k5;
+    return p;
+  }
+};
+
+// OCTAVE
+struct OctaveMode : ModeDefaults {
+  static OctaveEffect& fx() { return octave; }
+
+  // K2 blend, K3 octave mix, K4 tracking, K5 character
+  static OctaveEffect::Params params(const Knobs& k) {
+    OctaveEffect::Params p;
+    p.blend     = k.k2;
+    p.mix       = k.k3;
+    p.tracking  = k.k4;
+    p.character = k.k5;
+    return p;
+  }
+};
+
+// ORCHESTRA
+struct OrchMode : ModeDefaults {
+  static OrchestraEffect& fx() { return orchestra; }
+
+  // K2 blend, K3 size, K4 shimmer, K5 swell
+  static OrchestraEffect::Params params(const Knobs& k) {
+    OrchestraEffect::Params p;
+    p.mix   = k.k2;
+    p.size  = k.k3;
+    p.up    = k.k4;
+    p.down  = 0.75f * k.k4;
+    p.swell = k.k5;
+    p.tone  = 0.55f; // fixed darker so it isn’t painfully bright
+    return p;
+  }
+};
+
+// BITCRUSH: reduce bits + sample rate
+struct CrushMode {
+  static BitCrusher& fx() { return crush; }
+
+  // K2 blend, K3 bit depth, K4 SR reduce, K5 edge
+  static BitCrusher::Params params(const Knobs& k) {
+    BitCrusher::Params p;
+    p.mix  = k.k2;
+    p.bits = 1 + (int)(k.k3 * 15.0f); // 1..16
+    p.down = 1 + (int)(k.k4 * 31.0f); // 1..32
+    return p;
+  }
+
+  // Edge knob = light filtering so it’s crunchy but not pure sand
+  static void post(int16_t* data, const Knobs& k, bool& silent) {
+    if (k.k5 <= 0.02f) return;
+
+    hpf.setCoef(CRUSH_EDGE_HP(k.k5));
+    runFilter(hpf, data, AUDIO_BLOCK_SAMPLES, silent);
+
+    lpf.setCoef(CRUSH_EDGE_LP(k.k5));
+    runFilter(lpf, data, AUDIO_BLOCK_SAMPLES, silent);
+  }
+};
+
+// FLANGER
+struct FlangeMode {
+  static Flanger& fx() { return flanger; }
+
+  // K2 blend, K3 rate, K4 depth, K5 feedback
+  static Flanger::Params params(const Knobs& k) {
+    Flanger::Params p;
+    p.mix      = k.k2;
+    p.rateHz   = FLANGE_RATE(k.k3);
+    p.depthMs  = 0.2f  + 6.0f * k.k4;
+    p.feedback = -0.8f + 1.6f * k.k5;
+    p.baseMs   = 0.7f + 2.5f * (1.0f - k.k4);
+    return p;
+  }
+
+  // Quick LPF so it doesn’t get too “metallic”
+  static void post(int16_t* data, const Knobs& k, bool& silent) {
+    lpf.setCoef(FLANGE_LP(k.k4));
+    runFilter(lpf, data, AUDIO_BLOCK_SAMPLES, silent);
+  }
+};
+
+// TREMOLO
+struct TremMode {
+  static Tremolo& fx() { return trem; }
+
+  // K2 blend, K3 rate, K4 depth, K5 chop
+  static Tremolo::Params params(const Knobs& k) {
+    Tremolo::Params p;
+    p.mix    = k.k2;
+    p.rateHz = TREM_RATE(k.k3);
+    p.depth  = k.k4;
+    return p;
+  }
+
+  // Chop = a little HPF to make it feel sharper
+  static void post(int16_t* data, const Knobs& k, bool& silent) {
+    if (k.k5 <= 0.02f) return;
+    hpf.setCoef(TREM_CHOP(k.k5));
+    runFilter(hpf, data, AUDIO_BLOCK_SAMPLES, silent);
+  }
+};
+
+// CHORUS
+struct ChorusMode {
+  static Chorus& fx() { return chorus; }
+
+  // K2 blend, K3 rate, K4 depth, K5 tone
+  static Chorus::Params params(const Knobs& k) {
+    Chorus::Params p;
+    p.mix     = k.k2;
+    p.rateHz  = CHORUS_RATE(k.k3);
+    p.depthMs = 1.0f  + 10.0f * k.k4;        // longer mod delay than flanger
+    p.baseMs  = 10.0f + 6.0f * (1.0f - k.k4);
+    return p;
+  }
+
+  static void post(int16_t* data, const Knobs& k, bool& silent) {
+    // Tone knob is lpf
+    lpf.setCoef(CHORUS_TONE(k.k5));
+    runFilter(lpf, data, AUDIO_BLOCK_SAMPLES, silent);
+
+    // Small HPF so the low end doesnt get muddy
+    hpf.setCoef(CHORUS_HP_A);
+    runFilter(hpf, data, AUDIO_BLOCK_SAMPLES, silent);
+  }
+};
+
+// POLY OCTAVE: every note in a chord gets its own sub
+struct PolyOctMode : ModeDefaults {
+  static PolyOctaveEffect& fx() { return polyOctave; }
+
+  // K2 blend, K4 focus, K5 tone
+  static PolyOctaveEffect::Params params(const Knobs& k) {
+    PolyOctaveEffect::Params p;
+    p.blend = k.k2;
+    p.focus = k.k4;
+    p.tone  = k.k5;
+    return p;
+  }
+};
+
+// LOOPER: loop streams from SD, the interrupt only copies blocks
+struct LooperMode : ModeDefaults {
+  static SdLooper& fx() { return looper; }
+
+  // K2 loop level, K4 overdub feedback
+  static SdLooper::Params params(const Knobs& k) {
+    SdLooper::Params p;
+    p.level    = k.k2;
+    p.feedback = 0.6f + 0.4f * k.k4;
+    return p;
+  }
+};
+
+// ECHO: multi-second tape echo, line stored compressed
+struct EchoMode : ModeDefaults {
+  static TapeEchoEffect& fx() { return echo; }
+
+  // K2 mix, K3 time, K4 feedback, K5 tone
+  static TapeEchoEffect::Params params(const Knobs& k) {
+    TapeEchoEffect::Params p;
+    p.mix      = k.k2;
+    p.time     = k.k3;
+    p.feedback = k.k4;
+    p.tone     = k.k5;
+    return p;
+  }
+};
+
+// AMP: recurrent amp capture from flash
+struct AmpMode : ModeDefaults {
+  static AmpModel& fx() { return amp; }
+
+  // K2 blend, K3 drive, K4 level, K5 tone
+  static AmpModel::Params params(const Knobs& k) {
+    AmpModel::Params p;
+    p.mix   = k.k2;
+    p.drive = AMP_DRIVE(k.k3);
+    p.level = 0.25f + 1.75f * k.k4;
+    p.toneA = AMP_TONE(k.k5);
+    return p;
+  }
+};
+
+// TUNER: the LED shows the pitch, the reading runs in loop()
+struct TunerMode : ModeDefaults {
+  static Tuner& fx() { return tuner; }
+
+  // K2 mute (upper half), K5 reference A4 430..450 Hz
+  static Tuner::Params params(const Knobs& k) {
+    Tuner::Params p;
+    p.mute  = (k.k2 > 0.5f);
+    p.refHz = roundf(430.0f + 20.0f * k.k5);
+    return p;
+  }
+};
+
+// ENVELOPE FILTER: picking harder sweeps the filter
+struct EnvFilterMode : ModeDefaults {
+  static EnvFilterEffect& fx() { return envFilter; }
+
+  // K2 sensitivity, K3 range (centre: none, right: sweeps up, left: down
+  // from high), K4 resonance, K5 type (LP / BP / HP in thirds)
+  static EnvFilterEffect::Params params(const Knobs& k) {
+    EnvFilterEffect::Params p;
+    const float range = 2.0f * k.k3 - 1.0f;
+    p.sens  = ENVF_SENS(k.k2);
+    p.start = 0.2f + 0.6f * fmaxf(-range, 0.0f);
+    p.depth = 0.75f * range;
+    p.q     = ENVF_Q(k.k4);
+    p.type  = (k.k5 < 0.333f) ? EnvFilterEffect::LOWPASS
+            : (k.k5 < 0.667f) ? EnvFilterEffect::BANDPASS
+                              : EnvFilterEffect::HIGHPASS;
+    return p;
+  }
+};
+
+// FREEZE: hold the spectrum of the note and let it ring on
+struct FreezeMode : ModeDefaults {
+  static FreezeEffect& fx() { return freeze; }
+
+  // K2 frozen level, K3 glide, K4 hold (upper half), K5 retrigger on
+  // each new note (upper half)
+  static FreezeEffect::Params params(const Knobs& k) {
+    FreezeEffect::Params p;
+    p.level     = k.k2;
+    p.glide     = k.k3;
+    p.hold      = (k.k4 > 0.5f);
+    p.retrigger = (k.k5 > 0.5f);
+    return p;
+  }
+};
+
+// same order as Mode
+static const ModeRow MODES[] = {
+  modeRow<BypassMode>(),
+  modeRow<LeslieMode>(),
+  modeRow<MuffMode>(),
+  modeRow<OctaveMode>(),
+  modeRow<OrchMode>(),
+  modeRow<CrushMode>(),
+  modeRow<FlangeMode>(),
+  modeRow<TremMode>(),
+  modeRow<ChorusMode>(),
+  modeRow<PolyOctMode>(),
+  modeRow<LooperMode>(),
+  modeRow<EchoMode>(),
+  modeRow<AmpMode>(),
+  modeRow<TunerMode>(),
+  modeRow<EnvFilterMode>(),
+  modeRow<FreezeMode>(),
+};
+static_assert(sizeof(MODES) / sizeof(MODES[0]) == MODE_COUNT, "one row per mode");
+
 // *********************************
 // Button Debounce
 // ********************
 static bool lastBtn = true;
 static uint32_t lastEdgeMs = 0;
 
+// looper mode: tap = record/play/overdub, hold = next mode
+static constexpr uint32_t LOOPER_HOLD_MS = 600;
+static uint32_t pressStartMs = 0;
+static bool holdHandled = true;
+
 // LED color for each mode
 static void applyModeLED() {
   switch (mode) {
@@ -139,20 +626,20 @@ static void applyModeLED() {
     case MODE_FLANGE: setLED(0,   180, 255); break; // cyan
     case MODE_TREM:   setLED(0,   0,   255); break; // blue
     case MODE_CHORUS: setLED(255, 255, 255); break; // white
+    case MODE_POLYOCT: setLED(255, 0,  160); break; // magenta
+    case MODE_LOOPER: setLED(0,   60,  30);  break; // dim teal (empty)
+    case MODE_ECHO:   setLED(140, 255, 0);   break; // lime
+    case MODE_AMP:    setLED(255, 80,  120); break; // pink
+    case MODE_TUNER:  setLED(20,  20,  20);  break; // dim white (no note)
+    case MODE_ENVF:   setLED(0,   255, 160); break; // turquoise
+    case MODE_FREEZE: setLED(120, 200, 255); break; // ice blue
   }
 }
 
 // Reset effect state to prevent switching artifacts
+// (leaving the looper drops the loop)
 static void resetAllStates() {
-  leslie.reset();
-  muff.reset();
-  octave.reset();
-  orchestra.reset();
-
-  crush.reset();
-  flanger.reset();
-  trem.reset();
-  chorus.reset();
+  for (const ModeRow& m : MODES) m.reset();
 
   hpf.reset();
   lpf.reset();
@@ -172,230 +659,134 @@ static void updateButton() {
   if (pressed != lastBtn && (now - lastEdgeMs) > 40) {
     lastEdgeMs = now;
     lastBtn = pressed;
-    if (pressed) cycleMode();
+
+    if (mode != MODE_LOOPER) {
+      if (pressed) {
+        cycleMode();
+        holdHandled = true; // this press isn't a looper tap
+      }
+    } else if (pressed) {
+      pressStartMs = now;
+      holdHandled = false;
+    } else if (!holdHandled) {
+      looper.tap();
+    }
+  }
+
+  // looper: long press moves on
+  if (mode == MODE_LOOPER && lastBtn && !holdHandled && (now - pressStartMs) >= LOOPER_HOLD_MS) {
+    holdHandled = true;
+    cycleMode();
+  }
+}
+
+// looper LED follows the transport
+static void updateLooperLED() {
+  static int lastState = -1;
+  if (mode != MODE_LOOPER) { lastState = -1; return; }
+
+  int st = (int)looper.state();
+  if (st == lastState) return;
+  lastState = st;
+
+  switch (st) {
+    case SdLooper::EMPTY:   setLED(0,   60,  30);  break; // dim teal
+    case SdLooper::RECORD:  setLED(255, 0,   0);   break; // red
+    case SdLooper::PLAY:    setLED(0,   255, 120); break; // teal
+    case SdLooper::OVERDUB: setLED(255, 120, 0);   break; // amber
   }
 }
 
+// tuner LED: green in tune, red flat, blue sharp, brighter further off
+static constexpr float TUNER_IN_CENTS = 3.0f;
+
+static void updateTunerLED() {
+  if (mode != MODE_TUNER) return;
+  if (!tuner.service(millis())) return;
+
+  const Tuner::Reading& r = tuner.reading();
+  if (!r.valid) {
+    setLED(20, 20, 20); // dim white
+    return;
+  }
+
+  float off = fabsf(r.cents);
+  if (off <= TUNER_IN_CENTS) {
+    setLED(0, 255, 0);
+    return;
+  }
+  uint8_t v = (uint8_t)(40.0f + 215.0f * fminf(off / 50.0f, 1.0f));
+  if (r.cents < 0.0f) setLED(v, 0, 0);
+  else                setLED(0, 0, v);
+}
+
 // ********************************
 // Custom Audio Stream
 // **************************
+// One mono in, one mono out. Everything runs in place on the
+// input block, so there are no stack copies and only one pool block
+// is held while processing.
 class FxStream : public AudioStream {
 public:
-  FxStream() : AudioStream(2, queue) {}
+  FxStream() : AudioStream(1, queue) {}
 
   void update() override {
-    audio_block_t* L = receiveWritable(0);
-    audio_block_t* R = receiveWritable(1);
+    FX_TRACE("FxStream");
+    const uint32_t t0 = FlightRecorder::cycles();
 
-    if (!L || !R) {
-      if (L) release(L);
-      if (R) release(R);
-      return;
-    }
+    audio_block_t* block = receiveWritable(0);
+    if (!block) return;
 
     float vol, k2, k3, k4, k5;
     readControls(vol, k2, k3, k4, k5);
 
-    constexpr float FS = AUDIO_SAMPLE_RATE_EXACT;
+    // raw input + knobs, before anything touches the block
+    recorder.capture(block->data, (uint8_t)mode, vol, k2, k3, k4, k5);
 
-    // Treat input as mono
-    int16_t inMono[AUDIO_BLOCK_SAMPLES];
-    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
-      int32_t m = (int32_t)L->data[i] + (int32_t)R->data[i];
-      inMono[i] = (int16_t)(m / 2);
-    }
+    // Guitar is mono, so the block is already the dry signal
+    int16_t* mono = block->data;
+
+    // All effect feedback paths run with subnormals flushed to zero
+    ScopedFlushToZero ftz(flushSubnormals);
+
+    // envelope / onset / gate once for everyone
+    const BlockAnalysis& an = analyzer.process(mono, AUDIO_BLOCK_SAMPLES);
 
-    // Start with dry signal, then overwrite depending on mode
-    int16_t outMono[AUDIO_BLOCK_SAMPLES];
-    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) outMono[i] = inMono[i];
+    // true while the input is under the idle gate and every stage so far
+    // was idle (then the block has been zeroed)
+    bool silent = an.silent && idleSkip;
 
     // ********************************************************************
     // Mode Processing
     // ********************
 
-    // BYPASS, let clean audio thru
-    if (mode == MODE_BYPASS) {
-    
-    }
-
-    // LESLIE: effect runs stereo internally, then collapse to mono after mixing
-    else if (mode == MODE_LESILE) {
-      // K2 blend, K3 speed, K4 depth, K5 ramp
-      LeslieEffect::Params lp;
-      lp.volume = 1.0f; // keep per-effect volume consistent, do final volume at the end
-      lp.blend  = k2;
-      lp.speed  = k3;
-      lp.depth  = k4;
-      lp.ramp   = k5;
-
-      for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
-        L->data[i] = inMono[i];
-        R->data[i] = inMono[i];
-      }
-
-      leslie.processWet(L->data, R->data, AUDIO_BLOCK_SAMPLES, FS, lp);
-
-      // Mix back to mono with blend control
-      for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
-        float wetMono = 0.5f * ((float)L->data[i] + (float)R->data[i]);
-        float dryM    = (float)inMono[i];
-        float mix     = (1.0f - lp.blend) * dryM + lp.blend * wetMono;
-
-        int32_t y = (int32_t)mix;
-        if (y > 32767) y = 32767;
-        else if (y < -32768) y = -32768;
-        outMono[i] = (int16_t)y;
-      }
-    }
-
-    // BIG MUFF
-    else if (mode == MODE_MUFF) {
-      // K2 tone, K3 drive, K4 shape, K5 presence
-      BigMuffEffect::Params mp;
-      mp.tone  = k2;
-      mp.drive = k3;
-      mp.shape = k4;
-      mp.pres  = k5;
-
-      muff.processMonoWet(outMono, AUDIO_BLOCK_SAMPLES, FS, mp);
-    }
-
-    // OCTAVE
-    else if (mode == MODE_OCTAVE) {
-      // K2 blend, K3 octave mix, K4 tracking, K5 character
-      OctaveEffect::Params op;
-      op.blend     = k2;
-      op.mix       = k3;
-      op.tracking  = k4;
-      op.character = k5;
-
-      octave.processMono(inMono, outMono, AUDIO_BLOCK_SAMPLES, FS, op);
-    }
-
-    // ORCHESTRA
-    else if (mode == MODE_ORCH) {
-      // K2 blend, K3 size, K4 shimmer, K5 swell
-      OrchestraEffect::Params op;
-      op.mix   = k2;
-      op.size  = k3;
-      op.up    = k4;
-      op.down  = 0.75f * k4;
-      op.swell = k5;
-      op.tone  = 0.55f; // fixed darker so it isn’t painfully bright
-
-      orchestra.processMono(inMono, outMono, AUDIO_BLOCK_SAMPLES, FS, op);
-    }
-
-    // BITCRUSH: reduce bits + sample rate
-    else if (mode == MODE_CRUSH) {
-      // K2 blend, K3 bit depth, K4 SR reduce, K5 edge
-      float mix = k2;
-      int bits  = 1 + (int)(k3 * 15.0f);   // 1..16
-      int down  = 1 + (int)(k4 * 31.0f);   // 1..32
-
-      crush.setSampleRate(FS);
-      crush.setParams(bits, down, mix);
-      crush.processBlock(outMono, AUDIO_BLOCK_SAMPLES);
-
-      // Edge knob = light filtering so it’s crunchy but not pure sand
-      if (k5 > 0.02f) {
-        hpf.setSampleRate(FS);
-        hpf.setCutoffHz(20.0f + 140.0f * k5);
-        hpf.processBlock(outMono, AUDIO_BLOCK_SAMPLES);
-
-        lpf.setSampleRate(FS);
-        lpf.setCutoffHz(2500.0f + 9000.0f * (1.0f - k5));
-        lpf.processBlock(outMono, AUDIO_BLOCK_SAMPLES);
-      }
-    }
-
-    // FLANGER
-    else if (mode == MODE_FLANGE) {
-      // K2 blend, K3 rate, K4 depth, K5 feedback
-      float mix     = k2;
-      float rateHz  = 0.05f + 4.0f * k3;
-      float depthMs = 0.2f  + 6.0f * k4;
-      float fb      = -0.8f + 1.6f * k5;
-      float baseMs  = 0.7f + 2.5f * (1.0f - k4);
-
-      flanger.setSampleRate(FS);
-      flanger.setParams(baseMs, depthMs, rateHz, fb, mix);
-      flanger.processBlock(outMono, AUDIO_BLOCK_SAMPLES);
-
-      // Quick LPF so it doesn’t get too “metallic”
-      lpf.setSampleRate(FS);
-      lpf.setCutoffHz(3500.0f + 8000.0f * (1.0f - k4));
-      lpf.processBlock(outMono, AUDIO_BLOCK_SAMPLES);
-    }
-
-    // TREMOLO
-    else if (mode == MODE_TREM) {
-      // K2 blend, K3 rate, K4 depth, K5 chop
-      float mix    = k2;
-      float rateHz = 0.2f + 12.0f * k3;
-      float depth  = k4;
-
-      trem.setSampleRate(FS);
-      trem.setParams(rateHz, depth, mix);
-      trem.processBlock(outMono, AUDIO_BLOCK_SAMPLES);
-
-      // Chop = a little HPF to make it feel sharper
-      if (k5 > 0.02f) {
-        hpf.setSampleRate(FS);
-        hpf.setCutoffHz(15.0f + 120.0f * k5);
-        hpf.processBlock(outMono, AUDIO_BLOCK_SAMPLES);
-      }
-    }
-
-    // CHORUS (default else)
-    else {
-      // K2 blend, K3 rate, K4 depth, K5 tone
-      float mix     = k2;
-      float rateHz  = 0.08f + 2.5f * k3;       // chorus likes slower
-      float depthMs = 1.0f  + 10.0f * k4;      // longer mod delay than flanger
-      float baseMs  = 10.0f + 6.0f * (1.0f - k4);
-
-      chorus.setSampleRate(FS);
-      chorus.setParams(baseMs, depthMs, rateHz, 0.0f, mix); // no feedback for chorus
-      chorus.processBlock(outMono, AUDIO_BLOCK_SAMPLES);
-
-      // Tone knob is lpf
-      lpf.setSampleRate(FS);
-      lpf.setCutoffHz(1200.0f + 12000.0f * k5);
-      lpf.processBlock(outMono, AUDIO_BLOCK_SAMPLES);
-
-      // Small HPF so the low end doesnt get muddy
-      hpf.setSampleRate(FS);
-      hpf.setCutoffHz(15.0f);
-      hpf.processBlock(outMono, AUDIO_BLOCK_SAMPLES);
-    }
+    const Knobs k = { k2, k3, k4, k5 };
+    MODES[mode].process(mono, k, an, silent);
 
     // **************************
     // Final Output Stuff
     // **************************
 
-    // Global volume applied at the end
-    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
-      int32_t y = (int32_t)((float)outMono[i] * vol);
-      if (y > 32767) y = 32767;
-      else if (y < -32768) y = -32768;
-      outMono[i] = (int16_t)y;
+    // Global volume, then the look-ahead limiter keeps it under full
+    // scale (it runs on after the input stops until its delay is empty)
+    bool clipped = false;
+    if (!silent || !limiter.isSilent()) {
+      clipped = limiter.process(mono, AUDIO_BLOCK_SAMPLES, VOL_GAIN(vol));
+      clipped |= (limiter.minGain() < FR_LIMIT_GAIN);
+    } else {
+      limiter.idle();
     }
 
-    // Output is mono on LEFT only, right channel muted
-    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
-      L->data[i] = outMono[i];
-      R->data[i] = 0;
-    }
+    // Output is mono on LEFT only. Nothing goes to RIGHT,
+    // the I2S output plays silence for a channel with no block.
+    transmit(block, 0);
+    release(block);
 
-    transmit(L, 0);
-    transmit(R, 1);
-    release(L);
-    release(R);
+    recorder.commit(FlightRecorder::cycles() - t0, clipped);
   }
 
 private:
-  audio_block_t* queue[2];
+  audio_block_t* queue[1];
 };
 
 // **************************
@@ -405,13 +796,117 @@ AudioInputI2S        i2sIn;
 FxStream             fx;
 AudioOutputI2S       i2sOut;
 
-AudioConnection      patchL(i2sIn, 0, fx, 0);
-AudioConnection      patchR(i2sIn, 1, fx, 1);
-AudioConnection      outL(fx, 0, i2sOut, 0);
-AudioConnection      outR(fx, 1, i2sOut, 1);
+// Right input is left unconnected (mono guitar on LEFT),
+// right output is left unconnected (I2S fills it with silence)
+AudioConnection      patchIn(i2sIn, 0, fx, 0);
+AudioConnection      patchOut(fx, 0, i2sOut, 0);
 
 AudioControlSGTL5000 sgtl5000;
 
+// **************************
+// Audio Memory
+// **************************
+// Mono in-place path holds 1 block in FxStream, the rest is I2S
+// in/out double buffering. Peak use is reported over Serial so
+// this can be trimmed further after checking on the bench.
+static constexpr int AUDIO_MEM_BLOCKS = 12;
+
+static uint16_t memPeakReported = 0;
+static uint32_t lastMemReportMs = 0;
+
+static void reportAudioMemory() {
+  uint32_t now = millis();
+  if ((now - lastMemReportMs) < 5000) return;
+  lastMemReportMs = now;
+
+  uint16_t peak = AudioMemoryUsageMax();
+  if (peak == memPeakReported) return;
+  memPeakReported = peak;
+
+  Serial.print("audio mem peak: ");
+  Serial.print((unsigned)peak);
+  Serial.print(" / ");
+  Serial.println(AUDIO_MEM_BLOCKS);
+}
+
+// state + buffer size and latency of each mode, once at boot
+static void reportModes() {
+  for (int m = 0; m < MODE_COUNT; m++) {
+    Serial.print("mode ");
+    Serial.print(m);
+    Serial.print(": ");
+    Serial.print((unsigned)MODES[m].memoryBytes());
+    Serial.print(" bytes, latency ");
+    Serial.println(MODES[m].latency());
+  }
+}
+
+// first FRnnn.BIN not on the card (FR_MAX_FILES if none is free), once
+// at boot so a dump never walks the directory
+static int firstFreeDump() {
+  char name[16];
+  int i = 0;
+  for (; i < FR_MAX_FILES; i++) {
+    snprintf(name, sizeof(name), "FR%03d.BIN", i);
+    if (!SD.exists(name)) break;
+  }
+  return i;
+}
+
+// frozen flight recorder -> next free FRnnn.BIN on SD, else Serial. A
+// few frames per pass, so looper.service() gets its turn in between;
+// a full card (FR999 taken) falls back to Serial rather than overwrite
+static void dumpFlightRecorder() {
+  static File file;
+  static bool toSerial = false;
+  if (!recorder.frozen()) return;
+
+  // first pass of a dump: pick where it goes
+  if (!file && !toSerial) {
+    if (sdReady && frNext < FR_MAX_FILES) {
+      // the modulo is a no-op here, it shows the compiler the 3 digits
+      char name[16];
+      snprintf(name, sizeof(name), "FR%03u.BIN", (unsigned)frNext % FR_MAX_FILES);
+      file = SD.open(name, FILE_WRITE);
+      if (file) {
+        frNext++;
+        Serial.print("flight recorder: ");
+        Serial.println(name);
+      }
+    }
+    if (!file) {
+      toSerial = true;
+      Serial.println("flight recorder dump:");
+    }
+  }
+
+  Print& out = toSerial ? (Print&)Serial : (Print&)file;
+  if (!recorder.drain(out, FR_FRAMES_PER_PASS)) return;
+
+  if (file) file.close();
+  toSerial = false;
+}
+
+// looper ring misses, printed when they change
+static void reportLooper() {
+  static uint32_t lastMs = 0;
+  static uint32_t lastUnder = 0, lastOver = 0;
+
+  uint32_t now = millis();
+  if ((now - lastMs) < 5000) return;
+  lastMs = now;
+
+  SdLooper::Stats st = looper.stats();
+  if (st.underruns == lastUnder && st.overruns == lastOver) return;
+  lastUnder = st.underruns;
+  lastOver  = st.overruns;
+
+  Serial.print("looper underruns: ");
+  Serial.print(st.underruns);
+  Serial.print(" overruns: ");
+  Serial.println(st.overruns);
+}
+
 // **************************
 // Setup / Loop
 // **************************
@@ -428,7 +923,7 @@ void setup() {
   analogReadResolution(10);
 
   // Audio memory blocks
-  AudioMemory(90);
+  AudioMemory(AUDIO_MEM_BLOCKS);
 
   // Audio shield init
   sgtl5000.enable();
@@ -437,18 +932,89 @@ void setup() {
   sgtl5000.lineInLevel(0);
 
   // Pre-set sample rates
-  crush.setSampleRate(AUDIO_SAMPLE_RATE_EXACT);
-  flanger.setSampleRate(AUDIO_SAMPLE_RATE_EXACT);
-  trem.setSampleRate(AUDIO_SAMPLE_RATE_EXACT);
-  chorus.setSampleRate(AUDIO_SAMPLE_RATE_EXACT);
+  for (const ModeRow& m : MODES) m.prepare(AUDIO_SAMPLE_RATE_EXACT, AUDIO_BLOCK_SAMPLES);
+  chorus.setVoices(CHORUS_VOICES);
+  polyOctave.setBands(POLY_OCT_BANDS);
+  echo.setFormat(ECHO_FORMAT);
+  muff.setModel(MUFF_MODEL_SEL);
+  muff.setAntiAlias(MUFF_AA);
+  octave.setAntiAlias(SHAPER_AA);
+  orchestra.setAntiAlias(SHAPER_AA);
+  if (!amp.load(AMP_MODEL_DEFAULT, sizeof(AMP_MODEL_DEFAULT))) {
+    Serial.println("amp model: bad blob, AMP passes through");
+  }
   hpf.setSampleRate(AUDIO_SAMPLE_RATE_EXACT);
   lpf.setSampleRate(AUDIO_SAMPLE_RATE_EXACT);
 
+  // LFO targets every 16 samples, ramped in between
+  leslie.setControlInterval(MOD_CONTROL_K);
+  flanger.setControlInterval(MOD_CONTROL_K);
+  trem.setControlInterval(MOD_CONTROL_K);
+  chorus.setControlInterval(MOD_CONTROL_K);
+  echo.setControlInterval(MOD_CONTROL_K);
+
+  analyzer.setSampleRate(AUDIO_SAMPLE_RATE_EXACT, AUDIO_BLOCK_SAMPLES);
+  analyzer.reset();
+
+  limiter.setSampleRate(AUDIO_SAMPLE_RATE_EXACT);
+  limiter.reset();
+
+  recorder.setSampleRate(AUDIO_SAMPLE_RATE_EXACT);
+  recorder.setDeadline((uint32_t)((float)F_CPU_ACTUAL / AUDIO_SAMPLE_RATE_EXACT *
+                                  AUDIO_BLOCK_SAMPLES * FR_DEADLINE_FRAC));
+
+  // loop file lives on the SD card, looper stays empty without one
+  sdReady = SD.begin(SD_CS_PIN);
+  if (!sdReady || !looper.begin("LOOP.RAW")) {
+    Serial.println("looper: no SD card");
+  }
+  if (sdReady) frNext = firstFreeDump();
+
   resetAllStates();
+  reportModes();
+
+#if defined(AMP_BENCH)
+  // which model sizes fit a block on this core (build with -DAMP_BENCH)
+  static DMAMEM uint8_t ampScratch[AmpModel::blobBytes(AmpModel::LSTM, AmpModel::MAX_HIDDEN, AmpModel::F32)];
+  AmpModel::benchmark(Serial, &FlightRecorder::cycles,
+                      (uint32_t)((float)F_CPU_ACTUAL / AUDIO_SAMPLE_RATE_EXACT * AUDIO_BLOCK_SAMPLES),
+                      ampScratch, sizeof(ampScratch),
+                      AMP_MODEL_DEFAULT, sizeof(AMP_MODEL_DEFAULT));
+#endif
+
+#if defined(LIMITER_BENCH)
+  // output stage cost, clamp vs limiter (build with -DLIMITER_BENCH)
+  OutputLimiter::benchmark(Serial, &FlightRecorder::cycles,
+                           (uint32_t)((float)F_CPU_ACTUAL / AUDIO_SAMPLE_RATE_EXACT * AUDIO_BLOCK_SAMPLES));
+#endif
+
+#if defined(ENVF_BENCH)
+  // envelope filter with the cutoff moving every sample (build with -DENVF_BENCH)
+  EnvFilterEffect::benchmark(Serial, &FlightRecorder::cycles,
+                             (uint32_t)((float)F_CPU_ACTUAL / AUDIO_SAMPLE_RATE_EXACT * AUDIO_BLOCK_SAMPLES));
+#endif
+
+#if defined(STFT_BENCH)
+  // fft sizes, worst block spread vs in one block (build with -DSTFT_BENCH)
+  Stft::benchmark(Serial, &FlightRecorder::cycles,
+                  (uint32_t)((float)F_CPU_ACTUAL / AUDIO_SAMPLE_RATE_EXACT * AUDIO_BLOCK_SAMPLES));
+#endif
+
+#if defined(MUFF_BENCH)
+  // classic vs circuit muff on this core (build with -DMUFF_BENCH)
+  BigMuffEffect::benchmark(Serial, &FlightRecorder::cycles,
+                           (uint32_t)((float)F_CPU_ACTUAL / AUDIO_SAMPLE_RATE_EXACT * AUDIO_BLOCK_SAMPLES));
+#endif
 }
 
 void loop() {
   updateButton();
+  updateLooperLED();
+  updateTunerLED(); // YIN on the newest tuner window, ~8x a second
+  looper.service(); // SD reads / writes, can block, audio keeps running
+  reportAudioMemory();
+  reportLooper();
+  dumpFlightRecorder();
   delay(2); // tiny delay so loop isn’t running at max speed for no reason
 }
 
@@ -470,4 +1036,11 @@ MODE COLORS:
 - FLANGE  : cyan
 - TREM    : blue
 - CHORUS  : white
+- POLYOCT : magenta
+- LOOPER  : teal (red rec, amber overdub)
+- ECHO    : lime
+- AMP     : pink
+- TUNER   : dim white (green in tune, red flat, blue sharp)
+- ENVF    : turquoise
+- FREEZE  : ice blue
 */
@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+"""Write the pedal's built-in amp model as a GuitarML-style JSON capture.
+
+This is not a capture of a real amp. It is a small GRU with weights
+set by hand so that it behaves like a drive: each hidden unit is a
+tanh stage with its own gain and bias (asymmetric clipping), a few
+units are slowed down through the update gate (a darker, saggier
+path), and a little self-feedback through the reset path gives the
+stages some memory. It gives the AMP mode something to play until a
+trained capture is converted in its place:
+
+    amp_convert my_capture.json --header lib/AmpModel/AmpModelDefault.h
+
+usage: amp_seed_model.py [out.json]   (default tools/models/drive_gru8.json)
+"""
+import json
+import sys
+
+H = 8
+
+# per unit: input gain, bias, update-gate bias (z), self feedback, readout
+UNITS = [
+    (0.8, 0.00, -4.0, 0.00, 0.22),
+    (2.0, 0.10, -4.0, 0.10, 0.18),
+    (4.0, 0.20, -4.0, 0.15, 0.14),
+    (8.0, 0.30, -4.0, 0.20, 0.10),
+    (16.0, 0.35, -4.0, 0.20, 0.06),
+    (3.0, -0.15, 1.0, 0.30, 0.12),
+    (6.0, -0.25, 1.0, 0.30, 0.10),
+    (12.0, -0.30, 1.0, 0.30, 0.08),
+]
+
+# reset gate held open (sigmoid(6) ~ 1) so n sees the feedback
+R_BIAS = 6.0
+
+
+def build():
+    assert len(UNITS) == H
+    # PyTorch GRU layout: rows r, z, n
+    w_ih = [[0.0] for _ in range(3 * H)]
+    w_hh = [[0.0] * H for _ in range(3 * H)]
+    b_ih = [0.0] * (3 * H)
+    b_hh = [0.0] * (3 * H)
+    lin_w = []
+
+    for j, (gain, bias, zb, fb, out) in enumerate(UNITS):
+        b_ih[j] = R_BIAS
+        b_ih[H + j] = zb
+        w_ih[2 * H + j][0] = gain
+        b_ih[2 * H + j] = bias
+        w_hh[2 * H + j][j] = fb
+        lin_w.append(out)
+
+    return {
+        "model_data": {
+            "model": "SimpleRNN",
+            "input_size": 1,
+            "skip": 0,
+            "output_size": 1,
+            "unit_type": "GRU",
+            "num_layers": 1,
+            "hidden_size": H,
+            "bias_fl": True,
+        },
+        "state_dict": {
+            "rec.weight_ih_l0": w_ih,
+            "rec.weight_hh_l0": w_hh,
+            "rec.bias_ih_l0": b_ih,
+            "rec.bias_hh_l0": b_hh,
+            "lin.weight": [lin_w],
+            "lin.bias": [0.0],
+        },
+    }
+
+
+def main():
+    out = sys.argv[1] if len(sys.argv) > 1 else "tools/models/drive_gru8.json"
+    with open(out, "w") as f:
+        json.dump(build(), f, indent=1)
+        f.write("\n")
+
+
+if __name__ == "__main__":
+    main()
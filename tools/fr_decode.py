@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+"""Decode a flight recorder dump (FRnnn.BIN) from the pedal.
+
+Writes <dump>.wav with the captured input (mono, 16 bit, before the
+idle gate) and <dump>.csv with one row per block (seq, cycles, load,
+mode, flags, knobs). Feed both back through the effect code to replay
+the blocks that led up to the dropout / clip.
+
+Format: see lib/FlightRecorder/FlightRecorder.h
+
+usage: fr_decode.py FR000.BIN [more.BIN ...]
+"""
+import struct
+import sys
+import wave
+
+HEADER = struct.Struct("<4sHHHHfIIB7x")
+FRAME_HEAD = struct.Struct("<IIBB5H")
+
+MODES = ["BYPASS", "LESLIE", "MUFF", "OCTAVE", "ORCH", "CRUSH", "FLANGE",
+         "TREM", "CHORUS", "POLYOCT", "LOOPER", "ECHO", "AMP",
+         "TUNER", "ENVF", "FREEZE"]
+REASONS = {1: "deadline", 2: "clip", 3: "deadline+clip"}
+
+
+def decode(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    # Serial dumps may have the text line in front
+    start = data.find(b"FXFR")
+    if start < 0:
+        sys.exit(f"{path}: no FXFR header")
+
+    (magic, version, header_bytes, frames, block, fs, deadline,
+     trigger_seq, reason) = HEADER.unpack_from(data, start)
+    if version != 1:
+        sys.exit(f"{path}: unknown version {version}")
+
+    frame_bytes = FRAME_HEAD.size + 2 * block
+    pos = start + header_bytes
+
+    base = path.rsplit(".", 1)[0]
+    samples = bytearray()
+    worst = 0
+
+    with open(base + ".csv", "w") as csv:
+        csv.write("seq,cycles,load,mode,flags,vol,k2,k3,k4,k5\n")
+        for _ in range(frames):
+            if pos + frame_bytes > len(data):
+                print(f"{path}: truncated dump")
+                break
+            seq, cycles, mode, flags, *knobs = FRAME_HEAD.unpack_from(data, pos)
+            samples += data[pos + FRAME_HEAD.size:pos + frame_bytes]
+            pos += frame_bytes
+
+            # deadline is FR_DEADLINE_FRAC of the block period
+            load = cycles / deadline if deadline else 0.0
+            worst = max(worst, cycles)
+            name = MODES[mode] if mode < len(MODES) else str(mode)
+            ks = ",".join(f"{k / 65535:.4f}" for k in knobs)
+            csv.write(f"{seq},{cycles},{load:.3f},{name},{flags},{ks}\n")
+
+    with wave.open(base + ".wav", "wb") as w:
+        w.setnchannels(1)
+        w.setsampwidth(2)
+        w.setframerate(int(round(fs)))
+        w.writeframes(bytes(samples))
+
+    print(f"{path}: {frames} blocks @ {fs:.0f} Hz, trigger seq {trigger_seq} "
+          f"({REASONS.get(reason, reason)}), worst {worst} cycles "
+          f"(deadline {deadline}) -> {base}.wav, {base}.csv")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        sys.exit(__doc__)
+    for p in sys.argv[1:]:
+        decode(p)
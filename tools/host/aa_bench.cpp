@@ -0,0 +1,158 @@
+// **************************
+// aa_bench
+// *****************
+// Aliasing and cost of the static waveshapers (lib/Adaa) per
+// anti-aliasing option: plain 1x, the BigMuff style 2x loop (linear
+// interpolation up, one-pole AA at 12 kHz, drop every other sample),
+// ADAA1 and ADAA2 at 1x.
+//
+// A sine landing exactly on an FFT bin is driven into the shaper; every
+// bin that isn't a harmonic of it is folded-back energy. Printed as
+// alias power under the harmonics (dB), and ns per sample.
+//
+//   aa_bench [--drive G] [--hz F]
+//
+// Build from the repo root:
+//
+//   g++ -O2 -std=gnu++17 -Itools/host/shim
+//       $(for d in lib/*/; do printf -- "-I%s " "$d"; done)
+//       tools/host/aa_bench.cpp -o aa_bench
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <complex>
+#include <vector>
+#include "Adaa.h"
+
+static constexpr int    N    = 1 << 15;  // analysis length
+static constexpr int    WARM = 4096;     // settle the 2x loop's filter first
+static constexpr double FS   = 44100.0;
+
+// **************************
+// Options
+// *****************
+enum Option { PLAIN, OS2X, A1, A2, OPTIONS };
+static const char* OPTION_NAMES[OPTIONS] = { "1x", "2x loop", "ADAA1", "ADAA2" };
+
+template <class S>
+static void render(Option o, const std::vector<float>& in, std::vector<float>& out) {
+  out.resize(in.size());
+  Adaa::Shaper<S> sh;
+  sh.setMode(o == A1 ? Adaa::ADAA1 : o == A2 ? Adaa::ADAA2 : Adaa::OFF);
+
+  if (o != OS2X) {
+    for (size_t i = 0; i < in.size(); i++) out[i] = sh.process(in[i]);
+    return;
+  }
+
+  const float aa = (float)(12000.0 / (2.0 * FS));
+  float prev = 0.0f, lp = 0.0f;
+  for (size_t i = 0; i < in.size(); i++) {
+    float x1 = in[i];
+    float y = 0.0f;
+    for (int os = 0; os < 2; os++) {
+      float v = sh.process(os == 0 ? 0.5f * (prev + x1) : x1);
+      lp += aa * (v - lp);
+      if (os == 1) y = lp;
+    }
+    prev = x1;
+    out[i] = y;
+  }
+}
+
+// **************************
+// Spectrum
+// *****************
+static void fft(std::vector<std::complex<double>>& a) {
+  const size_t n = a.size();
+  for (size_t i = 1, j = 0; i < n; i++) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) std::swap(a[i], a[j]);
+  }
+  for (size_t len = 2; len <= n; len <<= 1) {
+    const double ang = -2.0 * M_PI / (double)len;
+    const std::complex<double> wl(cos(ang), sin(ang));
+    for (size_t i = 0; i < n; i += len) {
+      std::complex<double> w(1.0, 0.0);
+      for (size_t k = 0; k < len / 2; k++) {
+        std::complex<double> u = a[i + k], v = a[i + k + len / 2] * w;
+        a[i + k] = u + v;
+        a[i + k + len / 2] = u - v;
+        w *= wl;
+      }
+    }
+  }
+}
+
+// alias / harmonic power in dB, bin k0 carries the fundamental
+static double aliasDb(const std::vector<float>& y, int k0) {
+  std::vector<std::complex<double>> a(N);
+  for (int i = 0; i < N; i++) a[i] = y[WARM + i];
+  fft(a);
+
+  double harm = 0.0, alias = 0.0;
+  for (int k = 1; k < N / 2; k++) {
+    double p = std::norm(a[k]);
+    if (k % k0 == 0) harm += p;
+    else             alias += p;
+  }
+  return 10.0 * log10((alias + 1e-30) / (harm + 1e-30));
+}
+
+template <class S>
+static double nsPerSample(Option o, const std::vector<float>& in) {
+  std::vector<float> out;
+  double best = 1e30;
+  for (int r = 0; r < 5; r++) {
+    auto t0 = std::chrono::steady_clock::now();
+    render<S>(o, in, out);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    if (ns < best) best = ns;
+  }
+  return best / (double)in.size();
+}
+
+template <class S>
+static void shape(const char* name, float drive, double hz) {
+  // odd bin, so folded images never land on a harmonic bin
+  int k0 = (int)(hz * N / FS) | 1;
+  const double f0 = (double)k0 * FS / N;
+
+  std::vector<float> in(WARM + N);
+  for (size_t i = 0; i < in.size(); i++) in[i] = drive * (float)sin(2.0 * M_PI * f0 * (double)i / FS);
+
+  printf("%-5s  drive %.1f  %.0f Hz\n", name, (double)drive, f0);
+  for (int o = 0; o < OPTIONS; o++) {
+    if (o == A2 && !S::HAS_F2) continue;
+    std::vector<float> out;
+    render<S>((Option)o, in, out);
+    printf("  %-8s alias %7.1f dB   %6.1f ns/sample\n", OPTION_NAMES[o], aliasDb(out, k0),
+           nsPerSample<S>((Option)o, in));
+  }
+}
+
+int main(int argc, char** argv) {
+  float drive = 8.0f;
+  std::vector<double> hz = { 1000.0, 4000.0, 9000.0 };
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--drive") && i + 1 < argc) {
+      drive = strtof(argv[++i], nullptr);
+    } else if (!strcmp(argv[i], "--hz") && i + 1 < argc) {
+      hz = { atof(argv[++i]) };
+    } else {
+      fprintf(stderr, "usage: aa_bench [--drive G] [--hz F]\n");
+      return 2;
+    }
+  }
+
+  for (double f : hz) {
+    shape<Adaa::Alg>("alg", drive, f);
+    shape<Adaa::Atan>("atan", drive, f);
+    shape<Adaa::Tanh>("tanh", drive, f);
+  }
+  return 0;
+}
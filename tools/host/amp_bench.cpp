@@ -0,0 +1,54 @@
+// **************************
+// amp_bench
+// *****************
+// AmpModel::benchmark on the host: worst block time for GRU / LSTM,
+// float / int8, hidden 4..32, against the 128 sample deadline, plus the
+// default model timed where it is stored and from a RAM copy. The host is much
+// faster than the Teensy's M7, so --slowdown X divides the budget by X.
+// For numbers from the pedal itself build the firmware with
+// -DAMP_BENCH; it prints the same table in cycles at boot.
+//
+//   amp_bench [--slowdown X]
+//
+// Build from the repo root:
+//
+//   g++ -O2 -std=gnu++17 -Itools/host/shim
+//       $(for d in lib/*/; do printf -- "-I%s " "$d"; done)
+//       tools/host/amp_bench.cpp tools/host/shim/HostShim.cpp lib/AmpModel/AmpModel.cpp
+//       -o amp_bench
+#include <Arduino.h>
+#include <Audio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+#include "AmpModel.h"
+#include "AmpModelDefault.h"
+
+static uint32_t ticksNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec);
+}
+
+int main(int argc, char** argv) {
+  double slowdown = 1.0;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--slowdown") && i + 1 < argc) {
+      slowdown = atof(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: amp_bench [--slowdown X]\n");
+      return 2;
+    }
+  }
+  if (!(slowdown > 0.0)) slowdown = 1.0;
+
+  const double blockNs = 1e9 * AUDIO_BLOCK_SAMPLES / AUDIO_SAMPLE_RATE_EXACT;
+  const uint32_t budget = (uint32_t)(blockNs / slowdown);
+  printf("budget %u ns per block (%.0f ns / %.3g)\n", (unsigned)budget, blockNs, slowdown);
+
+  HostShim::serialOut = stdout;
+  std::vector<uint32_t> scratch(AmpModel::blobBytes(AmpModel::LSTM, AmpModel::MAX_HIDDEN, AmpModel::F32) / 4 + 1);
+  AmpModel::benchmark(Serial, ticksNs, budget, (uint8_t*)scratch.data(), scratch.size() * 4,
+                      AMP_MODEL_DEFAULT, sizeof(AMP_MODEL_DEFAULT));
+  return 0;
+}
@@ -0,0 +1,106 @@
+// **************************
+// amp_convert
+// *****************
+// GuitarML-style JSON capture -> AmpModel blob for the firmware.
+//
+//   amp_convert model.json [--int8] [--bin out.bin] [--header out.h [--name SYMBOL]]
+//
+// --header writes a PROGMEM array for the firmware to build in (the
+// pedal's default is lib/AmpModel/AmpModelDefault.h); --bin writes the
+// raw blob. --int8 stores the recurrent matrix as int8 with one scale
+// per row. Build from the repo root:
+//
+//   g++ -O2 -std=gnu++17 -Itools/host/shim
+//       $(for d in lib/*/; do printf -- "-I%s " "$d"; done)
+//       tools/host/amp_convert.cpp tools/host/shim/HostShim.cpp lib/AmpModel/AmpModel.cpp
+//       -o amp_convert
+#include "amp_json.h"
+
+static void usage() {
+  fprintf(stderr, "usage: amp_convert model.json [--int8] [--bin out.bin] [--header out.h [--name SYMBOL]]\n");
+}
+
+static bool writeHeader(const char* path, const char* name, const char* src, const std::vector<uint8_t>& blob) {
+  FILE* f = fopen(path, "w");
+  if (!f) return false;
+
+  AmpModel::Header h;
+  memcpy(&h, blob.data(), sizeof(h));
+
+  // strip directories, the header shouldn't carry a build machine's path
+  const char* base = strrchr(src, '/');
+  base = base ? base + 1 : src;
+
+  fprintf(f, "#pragma once\n#include <Arduino.h>\n#include <stdint.h>\n\n");
+  fprintf(f, "// Generated by tools/host/amp_convert from %s:\n", base);
+  fprintf(f, "// %s, hidden %d, %s weights%s, %u bytes.\n",
+          h.cell == AmpModel::LSTM ? "LSTM" : "GRU", h.hidden,
+          h.weights == AmpModel::INT8 ? "int8" : "float", h.skip ? ", skip" : "", (unsigned)h.bytes);
+  fprintf(f, "alignas(4) static const uint8_t %s[%zu] PROGMEM = {", name, blob.size());
+  for (size_t i = 0; i < blob.size(); i++) {
+    fprintf(f, "%s0x%02x,", (i % 12) ? " " : "\n  ", blob[i]);
+  }
+  fprintf(f, "\n};\n");
+
+  bool ok = !ferror(f);
+  fclose(f);
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    usage();
+    return 2;
+  }
+
+  const char* src = argv[1];
+  const char* binPath = nullptr;
+  const char* hdrPath = nullptr;
+  const char* name = "AMP_MODEL_DEFAULT";
+  bool int8 = false;
+
+  for (int i = 2; i < argc; i++) {
+    if (!strcmp(argv[i], "--int8"))                      int8 = true;
+    else if (!strcmp(argv[i], "--bin") && i + 1 < argc)    binPath = argv[++i];
+    else if (!strcmp(argv[i], "--header") && i + 1 < argc) hdrPath = argv[++i];
+    else if (!strcmp(argv[i], "--name") && i + 1 < argc)   name = argv[++i];
+    else {
+      usage();
+      return 2;
+    }
+  }
+
+  std::vector<uint8_t> blob;
+  std::string err;
+  if (!AmpJson::loadFile(src, int8, blob, err)) {
+    fprintf(stderr, "%s\n", err.c_str());
+    return 1;
+  }
+
+  // the firmware's loader is the final word on the layout
+  AmpModel check;
+  if (!check.load(blob.data(), blob.size())) {
+    fprintf(stderr, "converted blob doesn't load\n");
+    return 1;
+  }
+
+  if (binPath) {
+    FILE* f = fopen(binPath, "wb");
+    if (!f || fwrite(blob.data(), 1, blob.size(), f) != blob.size()) {
+      fprintf(stderr, "can't write %s\n", binPath);
+      if (f) fclose(f);
+      return 1;
+    }
+    fclose(f);
+  }
+
+  if (hdrPath && !writeHeader(hdrPath, name, src, blob)) {
+    fprintf(stderr, "can't write %s\n", hdrPath);
+    return 1;
+  }
+
+  fprintf(stderr, "%s: %s hidden %d, %zu bytes%s\n", src,
+          check.cell() == AmpModel::LSTM ? "LSTM" : "GRU", check.hidden(), blob.size(),
+          int8 ? " (int8)" : "");
+  return 0;
+}
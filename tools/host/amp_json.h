@@ -0,0 +1,247 @@
+#pragma once
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "AmpModel.h"
+
+// **************************
+// Amp model JSON -> blob
+// *****************
+// Reads the GuitarML / Automated-GuitarAmpModelling capture format
+// (also what NeuralPi / Proteus load):
+//
+//   { "model_data": { "unit_type": "GRU" | "LSTM", "hidden_size": H,
+//                     "input_size": 1, "output_size": 1, "num_layers": 1,
+//                     "skip": 0 | 1 },
+//     "state_dict": { "rec.weight_ih_l0": [[..]], "rec.weight_hh_l0": [[..]],
+//                     "rec.bias_ih_l0": [..], "rec.bias_hh_l0": [..],
+//                     "lin.weight": [[..]], "lin.bias": [..] } }
+//
+// and lays it out as an AmpModel blob (see AmpModel.h).
+namespace AmpJson {
+
+// **************************
+// JSON
+// *****************
+struct Value {
+  enum Type { NUL, BOOL, NUM, STR, ARR, OBJ } type = NUL;
+  double num = 0.0;
+  std::string str;
+  std::vector<Value> arr;
+  std::vector<std::pair<std::string, Value>> obj;
+
+  const Value* get(const char* key) const {
+    for (const auto& kv : obj) if (kv.first == key) return &kv.second;
+    return nullptr;
+  }
+};
+
+class Parser {
+public:
+  explicit Parser(const char* s) : _p(s) {}
+
+  bool parse(Value& v) {
+    if (!value(v)) return false;
+    ws();
+    return *_p == 0;
+  }
+
+private:
+  const char* _p;
+
+  void ws() { while (*_p == ' ' || *_p == '\t' || *_p == '\n' || *_p == '\r') _p++; }
+
+  bool lit(const char* s) {
+    size_t n = strlen(s);
+    if (strncmp(_p, s, n)) return false;
+    _p += n;
+    return true;
+  }
+
+  bool string(std::string& out) {
+    if (*_p != '"') return false;
+    _p++;
+    while (*_p && *_p != '"') {
+      if (*_p == '\\' && _p[1]) _p++; // keys and names only, escapes kept as is
+      out += *_p++;
+    }
+    if (*_p != '"') return false;
+    _p++;
+    return true;
+  }
+
+  bool value(Value& v) {
+    ws();
+    if (*_p == '{') {
+      v.type = Value::OBJ;
+      _p++;
+      ws();
+      if (*_p == '}') { _p++; return true; }
+      for (;;) {
+        ws();
+        std::string key;
+        if (!string(key)) return false;
+        ws();
+        if (*_p++ != ':') return false;
+        v.obj.emplace_back(key, Value());
+        if (!value(v.obj.back().second)) return false;
+        ws();
+        if (*_p == ',') { _p++; continue; }
+        if (*_p == '}') { _p++; return true; }
+        return false;
+      }
+    }
+    if (*_p == '[') {
+      v.type = Value::ARR;
+      _p++;
+      ws();
+      if (*_p == ']') { _p++; return true; }
+      for (;;) {
+        v.arr.emplace_back();
+        if (!value(v.arr.back())) return false;
+        ws();
+        if (*_p == ',') { _p++; continue; }
+        if (*_p == ']') { _p++; return true; }
+        return false;
+      }
+    }
+    if (*_p == '"') {
+      v.type = Value::STR;
+      return string(v.str);
+    }
+    if (lit("true"))  { v.type = Value::BOOL; v.num = 1.0; return true; }
+    if (lit("false")) { v.type = Value::BOOL; v.num = 0.0; return true; }
+    if (lit("null"))  { v.type = Value::NUL; return true; }
+
+    char* end = nullptr;
+    v.num = strtod(_p, &end);
+    if (end == _p) return false;
+    v.type = Value::NUM;
+    _p = end;
+    return true;
+  }
+};
+
+// **************************
+// Capture -> blob
+// *****************
+// flattened numbers of a (nested) array, false if anything else is in it
+static bool flat(const Value* v, std::vector<float>& out) {
+  if (!v) return false;
+  if (v->type == Value::NUM) { out.push_back((float)v->num); return true; }
+  if (v->type != Value::ARR) return false;
+  for (const Value& e : v->arr) if (!flat(&e, out)) return false;
+  return true;
+}
+
+static int intField(const Value* md, const char* key, int def) {
+  const Value* v = md ? md->get(key) : nullptr;
+  return (v && (v->type == Value::NUM || v->type == Value::BOOL)) ? (int)v->num : def;
+}
+
+static bool toBlob(const Value& root, bool int8, std::vector<uint8_t>& blob, std::string& err) {
+  const Value* md = root.get("model_data");
+  const Value* sd = root.get("state_dict");
+  if (!md || !sd) { err = "no model_data / state_dict"; return false; }
+
+  const Value* unit = md->get("unit_type");
+  std::string type = (unit && unit->type == Value::STR) ? unit->str : "LSTM";
+  AmpModel::Cell cell;
+  if (type == "GRU")       cell = AmpModel::GRU;
+  else if (type == "LSTM") cell = AmpModel::LSTM;
+  else { err = "unit_type " + type + " not supported (GRU / LSTM)"; return false; }
+
+  const int H = intField(md, "hidden_size", 0);
+  if (intField(md, "input_size", 1) != 1 || intField(md, "output_size", 1) != 1 ||
+      intField(md, "num_layers", 1) != 1) {
+    err = "only 1 input, 1 output, 1 layer";
+    return false;
+  }
+  if (H < 1 || H > AmpModel::MAX_HIDDEN) {
+    err = "hidden_size must be 1.." + std::to_string(AmpModel::MAX_HIDDEN);
+    return false;
+  }
+  const int G = AmpModel::gates(cell);
+
+  std::vector<float> wih, whh, bih, bhh, lw, lb;
+  if (!flat(sd->get("rec.weight_ih_l0"), wih) || !flat(sd->get("rec.weight_hh_l0"), whh) ||
+      !flat(sd->get("lin.weight"), lw) || !flat(sd->get("lin.bias"), lb)) {
+    err = "missing rec.weight_ih_l0 / rec.weight_hh_l0 / lin.weight / lin.bias";
+    return false;
+  }
+  // bias_fl = false captures have none
+  if (!flat(sd->get("rec.bias_ih_l0"), bih)) bih.assign(G * H, 0.0f);
+  if (!flat(sd->get("rec.bias_hh_l0"), bhh)) bhh.assign(G * H, 0.0f);
+
+  if ((int)wih.size() != G * H || (int)whh.size() != G * H * H || (int)bih.size() != G * H ||
+      (int)bhh.size() != G * H || (int)lw.size() != H || lb.size() != 1) {
+    err = "tensor sizes don't match hidden_size";
+    return false;
+  }
+
+  // header, then the float section in blob order
+  const AmpModel::Weights w = int8 ? AmpModel::INT8 : AmpModel::F32;
+  const size_t bytes = AmpModel::blobBytes(cell, H, w);
+  blob.assign(bytes, 0);
+
+  AmpModel::Header h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, "AMPM", 4);
+  h.version = AmpModel::VERSION;
+  h.cell    = cell;
+  h.hidden  = (uint8_t)H;
+  h.weights = w;
+  h.skip    = (uint8_t)(intField(md, "skip", 0) != 0);
+  h.bytes   = (uint32_t)bytes;
+  memcpy(blob.data(), &h, sizeof(h));
+
+  std::vector<float> f;
+  f.insert(f.end(), wih.begin(), wih.end());
+  for (int r = 0; r < G * H; r++) {
+    // the GRU's n gate keeps its recurrent bias inside r * (...)
+    bool nRow = (cell == AmpModel::GRU && r >= 2 * H);
+    f.push_back(nRow ? bih[r] : bih[r] + bhh[r]);
+  }
+  if (cell == AmpModel::GRU) f.insert(f.end(), bhh.begin() + 2 * H, bhh.end());
+  f.insert(f.end(), lw.begin(), lw.end());
+  f.push_back(lb[0]);
+
+  if (!int8) {
+    f.insert(f.end(), whh.begin(), whh.end());
+  } else {
+    std::vector<int8_t> q(G * H * H);
+    for (int r = 0; r < G * H; r++) {
+      float m = 0.0f;
+      for (int j = 0; j < H; j++) m = fmaxf(m, fabsf(whh[r * H + j]));
+      float scale = (m > 0.0f) ? m / 127.0f : 1.0f;
+      f.push_back(scale);
+      for (int j = 0; j < H; j++) q[r * H + j] = (int8_t)lrintf(whh[r * H + j] / scale);
+    }
+    memcpy(blob.data() + sizeof(h) + 4 * f.size(), q.data(), q.size());
+  }
+  memcpy(blob.data() + sizeof(h), f.data(), 4 * f.size());
+  return true;
+}
+
+static bool loadFile(const char* path, bool int8, std::vector<uint8_t>& blob, std::string& err) {
+  FILE* fp = fopen(path, "rb");
+  if (!fp) { err = std::string("can't read ") + path; return false; }
+  std::string text;
+  char buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) text.append(buf, n);
+  fclose(fp);
+
+  Value root;
+  if (!Parser(text.c_str()).parse(root) || root.type != Value::OBJ) {
+    err = std::string(path) + ": not valid JSON";
+    return false;
+  }
+  return toBlob(root, int8, blob, err);
+}
+
+} // namespace AmpJson
@@ -0,0 +1,136 @@
+// **************************
+// chorus_bench
+// *****************
+// Cost of the multi-voice Chorus against the way it used to be built.
+//
+//   flanger xN   N Flangers with feedback off, one per voice, each with
+//                its own delay line and its own pass over the block, wet
+//                outputs summed (one was the old chorus mode)
+//   chorus Nv    SimpleFX::Chorus with N voices: one shared line, voice
+//                state as parallel arrays, one loop per voice per
+//                control segment
+//
+// for N = 1 (flanger only), 2, 4 and 8, at the chorus mode's middle depth
+// on a plucked chord. Prints us per 128-sample block, best of
+// REPS runs, and the cost against one flanger voice.
+//
+//   chorus_bench
+//
+// Build from the repo root:
+//
+//   g++ -O2 -std=gnu++17 -Itools/host/shim
+//       $(for d in lib/*/; do printf -- "-I%s " "$d"; done)
+//       tools/host/chorus_bench.cpp tools/host/shim/HostShim.cpp lib/*/*.cpp
+//       -lpthread -o chorus_bench
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "BlockAnalysis.h"
+#include "SimpleEffects.h"
+
+using namespace SimpleFX;
+
+static constexpr int   BLOCK = 128;
+static constexpr float FS    = 44100.0f;
+static constexpr int   REPS  = 5;
+
+// chorus mode with K4 centred, a middling rate
+static constexpr float BASE_MS  = 13.0f;
+static constexpr float DEPTH_MS = 6.0f;
+static constexpr float RATE_HZ  = 0.8f;
+static constexpr float MIX      = 0.5f;
+
+static std::vector<int16_t> makeClip() {
+  std::vector<int16_t> x;
+  const double notes[3] = { 110.0, 164.8, 220.0 };
+  const int n = (int)(2.0 * FS) / BLOCK * BLOCK;
+  for (int i = 0; i < n; i++) {
+    const double t = i / (double)FS;
+    double y = 0.0;
+    for (double f : notes) {
+      for (int k = 1; k <= 6; k++) y += exp(-t * (1.5 + k)) * sin(2.0 * M_PI * k * f * t) / k;
+    }
+    x.push_back((int16_t)lrint(6000.0 * y));
+  }
+  return x;
+}
+
+// **************************
+// Old: a Flanger per voice
+// *****************
+struct FlangerVoices {
+  Flanger fl[Chorus::MAX_VOICES];
+  int voices = 1;
+
+  void setup(int n) {
+    voices = n;
+    for (int v = 0; v < n; v++) {
+      // rates fanned like the chorus does
+      const float t = (n > 1) ? (float)v / (float)(n - 1) : 0.0f;
+      fl[v].setSampleRate(FS);
+      fl[v].setParams(BASE_MS, DEPTH_MS, RATE_HZ * (1.0f + 0.16f * (t - 0.5f)), 0.0f, 1.0f);
+      fl[v].reset();
+    }
+  }
+
+  void process(int16_t* data, int n) {
+    float wet[BLOCK] = {};
+    int16_t tap[BLOCK];
+    for (int v = 0; v < voices; v++) {
+      memcpy(tap, data, n * sizeof(int16_t));
+      fl[v].processBlock(tap, n);
+      for (int i = 0; i < n; i++) wet[i] += int16ToFloat(tap[i]);
+    }
+    const float g = 1.0f / sqrtf((float)voices);
+    for (int i = 0; i < n; i++) {
+      data[i] = floatToInt16((1.0f - MIX) * int16ToFloat(data[i]) + MIX * g * wet[i]);
+    }
+  }
+};
+
+// **************************
+// Timing
+// *****************
+// best of REPS passes over the clip, us per block
+template <class Fn>
+static double usPerBlock(const std::vector<int16_t>& clip, Fn&& fn) {
+  std::vector<int16_t> y(clip.size());
+  double best = 1e30;
+  for (int r = 0; r < REPS; r++) {
+    y = clip;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (size_t at = 0; at + BLOCK <= y.size(); at += BLOCK) fn(&y[at]);
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    best = fmin(best, s);
+  }
+  return 1e6 * best / (double)(clip.size() / BLOCK);
+}
+
+int main() {
+  const std::vector<int16_t> clip = makeClip();
+  static FlangerVoices old;
+  static Chorus chorus;
+
+  old.setup(1);
+  const double one = usPerBlock(clip, [&](int16_t* b) { old.process(b, BLOCK); });
+  printf("flanger x1  %6.2f us/block\n", one);
+
+  static const int NS[] = { 2, 4, 8 };
+  for (int n : NS) {
+    old.setup(n);
+    const double f = usPerBlock(clip, [&](int16_t* b) { old.process(b, BLOCK); });
+
+    chorus.setSampleRate(FS);
+    chorus.setParams(BASE_MS, DEPTH_MS, RATE_HZ, MIX);
+    chorus.setVoices(n);
+    chorus.reset();
+    const double c = usPerBlock(clip, [&](int16_t* b) { chorus.processBlock(b, BLOCK); });
+
+    printf("flanger x%d  %6.2f us/block (%.1fx)   chorus %dv  %6.2f us/block (%.1fx)\n", n, f, f / one,
+           n, c, c / one);
+  }
+  return 0;
+}
@@ -0,0 +1,209 @@
+// **************************
+// denormal_bench
+// *****************
+// What ScopedFlushToZero buys in a decaying tail. Every mode plays 1 s of
+// plucked chords and then a long run of digital silence, all of it sent
+// through the DSP (idleSkip off, as if hiss held the gate open), once
+// with subnormals flushed as on the pedal and once with the flush off
+// (flushSubnormals = false).
+//
+//   us/block   mean host time per block over the second before each mark,
+//              the whole update() like the pedal runs it
+//   subnormal  32-bit words holding a subnormal float at the mark, in
+//              the mode's effect object plus the limiter and the cleanup
+//              filters, which run in every mode. Words that come out the
+//              same both ways (indexes, pointers, flags) aren't counted,
+//              only state the flush actually changed.
+//
+// Buffers outside the effect object (tape echo's compressed line, the
+// looper rings) are integer and not scanned.
+//
+//   denormal_bench [--tail S] [--mode M]
+//
+// --tail is the silence after the chords in seconds (90), --mode runs
+// one mode only. Exit status is non-zero if any subnormal is left in
+// state with the flush on.
+//
+// Build from the repo root:
+//
+//   g++ -O2 -std=gnu++17 -Itools/host/shim
+//       $(for d in lib/*/; do printf -- "-I%s " "$d"; done)
+//       tools/host/denormal_bench.cpp tools/host/shim/HostShim.cpp lib/*/*.cpp
+//       -lpthread -o denormal_bench
+#include "pedal.h"
+
+#include <math.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+static constexpr int BLOCK = Pedal::BLOCK;
+static constexpr int MARKS[] = { 1, 10, 30, 60, 90 }; // s into the tail
+static constexpr int MARK_COUNT = sizeof(MARKS) / sizeof(MARKS[0]);
+
+// **************************
+// State
+// *****************
+struct State {
+  const uint8_t* p;
+  size_t bytes;
+};
+
+template <class M> static State stateOf() {
+  const auto& f = M::fx();
+  return { (const uint8_t*)&f, sizeof(f) };
+}
+
+// in MODES order
+static const State STATES[] = {
+  stateOf<BypassMode>(),  stateOf<LeslieMode>(),    stateOf<MuffMode>(),      stateOf<OctaveMode>(),
+  stateOf<OrchMode>(),    stateOf<CrushMode>(),     stateOf<FlangeMode>(),    stateOf<TremMode>(),
+  stateOf<ChorusMode>(),  stateOf<PolyOctMode>(),   stateOf<LooperMode>(),    stateOf<EchoMode>(),
+  stateOf<AmpMode>(),     stateOf<TunerMode>(),     stateOf<EnvFilterMode>(), stateOf<FreezeMode>(),
+};
+static_assert(sizeof(STATES) / sizeof(STATES[0]) == MODE_COUNT, "one state per mode");
+
+template <class T> static void append(std::vector<uint8_t>& v, const T& obj) {
+  const uint8_t* p = (const uint8_t*)&obj;
+  v.insert(v.end(), p, p + sizeof(obj));
+}
+
+static void snapshot(int m, std::vector<uint8_t>& v) {
+  v.assign(STATES[m].p, STATES[m].p + STATES[m].bytes);
+  append(v, limiter);
+  append(v, hpf);
+  append(v, lpf);
+}
+
+static bool subnormal(uint32_t w) {
+  return (w & 0x7f800000u) == 0 && (w & 0x007fffffu) != 0;
+}
+
+// words subnormal in a that differ in b
+static int countSubnormals(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+  int count = 0;
+  for (size_t i = 0; i + 4 <= a.size(); i += 4) {
+    uint32_t wa, wb;
+    memcpy(&wa, &a[i], 4);
+    memcpy(&wb, &b[i], 4);
+    if (subnormal(wa) && wa != wb) count++;
+  }
+  return count;
+}
+
+// **************************
+// Run
+// *****************
+struct Run {
+  double usPerBlock[MARK_COUNT];
+  std::vector<uint8_t> snap[MARK_COUNT];
+};
+
+static void chords(std::vector<int16_t>& x) {
+  static const double notes[3] = { 110.0, 164.8, 220.0 };
+  const int n = (int)Pedal::FS;
+  for (int i = 0; i < n; i++) {
+    const double t = i / (double)Pedal::FS;
+    double y = 0.0;
+    for (double f : notes) {
+      for (int k = 1; k <= 6; k++) y += exp(-t * (1.5 + k)) * sin(2.0 * M_PI * k * f * t) / k;
+    }
+    x.push_back((int16_t)lrint(6000.0 * y));
+  }
+  x.resize(x.size() / BLOCK * BLOCK);
+}
+
+static void hardReset(int m, const Pedal::Knobs5& k) {
+  static const int16_t zeros[BLOCK] = {};
+  int16_t out[BLOCK];
+  Pedal::setKnobs(k);
+  Pedal::setMode(m);
+  Pedal::process(zeros, out);
+  Pedal::setMode(m);
+  analyzer.reset();
+  limiter.reset();
+}
+
+static Run run(int m, const Pedal::Knobs5& k, const std::vector<int16_t>& note, int tailS, bool ftz) {
+  Run r;
+  hardReset(m, k);
+  idleSkip = false;
+  flushSubnormals = ftz;
+
+  int16_t out[BLOCK];
+  for (size_t at = 0; at + BLOCK <= note.size(); at += BLOCK) Pedal::process(&note[at], out);
+
+  static const int16_t zeros[BLOCK] = {};
+  const int perSecond = (int)(Pedal::FS / BLOCK);
+  int mark = 0;
+  double secondS = 0.0;
+  for (int sec = 1; sec <= tailS && mark < MARK_COUNT; sec++) {
+    secondS = 0.0;
+    for (int b = 0; b < perSecond; b++) {
+      const auto t0 = std::chrono::steady_clock::now();
+      Pedal::process(zeros, out);
+      secondS += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+    while (mark < MARK_COUNT && (MARKS[mark] == sec || (sec == tailS && MARKS[mark] > tailS))) {
+      r.usPerBlock[mark] = 1e6 * secondS / perSecond;
+      snapshot(m, r.snap[mark]);
+      mark++;
+    }
+  }
+
+  idleSkip = true;
+  flushSubnormals = true;
+  return r;
+}
+
+int main(int argc, char** argv) {
+  int tailS = 90, only = -1;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--tail") && i + 1 < argc) {
+      tailS = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--mode") && i + 1 < argc) {
+      only = atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: denormal_bench [--tail S] [--mode M]\n");
+      return 2;
+    }
+  }
+  if (tailS < 1) tailS = 1;
+
+  // long tails: feedback, size and shimmer up
+  const Pedal::Knobs5 knobs = { { 0.8f, 0.7f, 0.8f, 0.9f, 0.5f } };
+  Pedal::begin(MODE_BYPASS, knobs);
+
+  std::vector<int16_t> note;
+  chords(note);
+
+  printf("marks (s into the tail):");
+  for (int t : MARKS) printf(" %d", std::min(t, tailS));
+  printf("\n");
+
+  bool ok = true;
+  for (int m = 0; m < Pedal::modeCount(); m++) {
+    if (only >= 0 && m != only) continue;
+    const Run on = run(m, knobs, note, tailS, true);
+    const Run off = run(m, knobs, note, tailS, false);
+
+    printf("mode %2d  us/block  ftz off", m);
+    for (double us : off.usPerBlock) printf(" %7.1f", us);
+    printf("   on");
+    for (double us : on.usPerBlock) printf(" %7.1f", us);
+    printf("\n         subnormal ftz off");
+    for (int i = 0; i < MARK_COUNT; i++) printf(" %7d", countSubnormals(off.snap[i], on.snap[i]));
+    printf("   on");
+    bool clean = true;
+    for (int i = 0; i < MARK_COUNT; i++) {
+      const int n = countSubnormals(on.snap[i], off.snap[i]);
+      clean &= (n == 0);
+      printf(" %7d", n);
+    }
+    printf("%s\n", clean ? "" : "   LEFT IN STATE");
+    ok &= clean;
+  }
+
+  printf("%s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+// **************************
+// echo_bench
+// *****************
+// The tape echo's line formats (lib/TapeEchoEffect): how long the
+// 128 KB line is and how much noise the codec adds. A 997 Hz sine at
+// -6, -20, -40 and -60 dBFS goes through the line's own store / decode
+// round trip, one pass, no tap interpolation or feedback.
+//
+//   line   seconds of delay the format holds at 44.1 kHz
+//   SNR    the int16 sine against the decoded line, dB
+//
+// The floors in FLOORS are the documented figures (TapeEchoEffect.h,
+// README) less TOLERANCE_DB.
+//
+//   echo_bench
+//
+// Exit status is non-zero if a format drops below its floor.
+//
+// Build from the repo root:
+//
+//   g++ -O2 -std=gnu++17 -Itools/host/shim
+//       $(for d in lib/*/; do printf -- "-I%s " "$d"; done)
+//       tools/host/echo_bench.cpp tools/host/shim/HostShim.cpp lib/*/*.cpp
+//       -lpthread -o echo_bench
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include "TapeEchoEffect.h"
+
+static constexpr float  FS   = 44100.0f;
+static constexpr double HZ   = 997.0;
+static constexpr int    N    = 44100; // 1 s, shorter than either line
+static constexpr double TOLERANCE_DB = 0.5;
+
+static const double LEVELS_DB[] = { -6.0, -20.0, -40.0, -60.0 };
+static constexpr int LEVEL_COUNT = sizeof(LEVELS_DB) / sizeof(LEVELS_DB[0]);
+
+struct Format {
+  const char* name;
+  TapeEchoEffect::Format f;
+  double bytesPerSample;
+  double floorDb[LEVEL_COUNT]; // per level, as documented
+};
+
+static const Format FORMATS[] = {
+  { "MULAW", TapeEchoEffect::MULAW, 1.0, { 36.7, 38.2, 35.2, 20.6 } },
+  { "PCM12", TapeEchoEffect::PCM12, 1.5, { 68.0, 53.9, 33.7, 15.0 } },
+};
+
+static double snrDb(TapeEchoEffect& fx, double levelDb) {
+  const double amp = 32767.0 * pow(10.0, levelDb / 20.0);
+  double sig = 0.0, err = 0.0;
+  for (int i = 0; i < N; i++) {
+    const int16_t x = (int16_t)lrint(amp * sin(2.0 * M_PI * HZ * i / FS));
+    const double e = (double)fx.codecRoundTrip(i, x) - x;
+    sig += (double)x * x;
+    err += e * e;
+  }
+  return 10.0 * log10(sig / fmax(err, 1e-30));
+}
+
+int main() {
+  static TapeEchoEffect fx;
+  bool ok = true;
+
+  printf("format  B/sample  line     ");
+  for (double l : LEVELS_DB) printf("  %4.0f dBFS", l);
+  printf("\n");
+
+  for (const Format& f : FORMATS) {
+    fx.setFormat(f.f);
+    printf("%-6s  %4.1f      %4.2f s  ", f.name, f.bytesPerSample, fx.lineSamples() / (double)FS);
+
+    bool pass = true;
+    for (int k = 0; k < LEVEL_COUNT; k++) {
+      fx.reset();
+      const double snr = snrDb(fx, LEVELS_DB[k]);
+      const bool under = snr < f.floorDb[k] - TOLERANCE_DB;
+      pass &= !under;
+      printf("  %5.1f dB%s", snr, under ? "!" : " ");
+    }
+    printf("  %s\n", pass ? "ok" : "UNDER FLOOR");
+    ok &= pass;
+  }
+
+  printf("(int16   2.0      %4.2f s, float 4.0: %4.2f s)\n", TapeEchoEffect::LINE_BYTES / 2.0 / FS,
+         TapeEchoEffect::LINE_BYTES / 4.0 / FS);
+  printf("%s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,202 @@
+// **************************
+// envf_bench
+// *****************
+// lib/EnvFilterEffect on the host: cost per sample with the cutoff
+// moving every sample, table accuracy, and stability at the extremes.
+//
+//   cost       EnvFilterEffect::benchmark, the same table the pedal
+//              prints with -DENVF_BENCH. --slowdown X divides the budget
+//              by X as a stand-in for the slower core.
+//   table      cutoff error of the g table against tanf, in cents
+//   svf        the bare SVF at Q up to MAX_Q, cutoff jumping bottom to
+//              top every sample / random every sample / swept over 8
+//              samples, full-scale noise and square in, then silence
+//              with the modulation still running. Fails on a non-finite
+//              or runaway state, or a tail that doesn't die out.
+//   effect     the whole mode at max sensitivity / Q / fastest decay on
+//              bursts that slam the envelope, then silence; it has to
+//              park (isSilent) again.
+//
+//   envf_bench [--slowdown X]
+//
+// Exit status is non-zero if a stability case fails.
+//
+// Build from the repo root:
+//
+//   g++ -O2 -std=gnu++17 -Itools/host/shim
+//       $(for d in lib/*/; do printf -- "-I%s " "$d"; done)
+//       tools/host/envf_bench.cpp tools/host/shim/HostShim.cpp
+//       lib/EnvFilterEffect/EnvFilterEffect.cpp lib/BlockAnalysis/BlockAnalysis.cpp
+//       -o envf_bench
+#include <Arduino.h>
+#include <Audio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <time.h>
+#include <random>
+#include <vector>
+#include "BlockAnalysis.h"
+#include "EnvFilterEffect.h"
+
+static constexpr int   BLOCK = 128;
+static constexpr float FS    = 44100.0f;
+
+static uint32_t ticksNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec);
+}
+
+// **************************
+// Table
+// *****************
+static void tableError(const EnvFilterEffect& fx) {
+  double worst = 0.0;
+  for (int i = 0; i <= 100000; i++) {
+    const float pos = (float)i / 100000.0f;
+    const double fc = atan((double)fx.gAt(pos)) * FS / M_PI;
+    const double c = fabs(1200.0 * log2(fc / (double)EnvFilterEffect::cutoffHz(pos)));
+    if (c > worst) worst = c;
+  }
+  printf("table: worst cutoff error %.4f cents over %.0f..%.0f Hz\n", worst,
+         EnvFilterEffect::MIN_HZ, EnvFilterEffect::MAX_HZ);
+}
+
+// **************************
+// Bare SVF
+// *****************
+enum Mod { JUMP, RANDOM, SWEEP8 };
+static const char* MOD_NAMES[] = { "jump", "random", "sweep8" };
+
+static bool svfCase(const EnvFilterEffect& fx, float q, Mod mod, bool square) {
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+  std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+
+  const float k = 1.0f / q;
+  EnvFilterEffect::Svf svf;
+  const int loud = (int)(5.0f * FS);
+  const int tail = (int)(5.0f * FS);
+
+  double peak = 0.0;
+  bool finite = true;
+  for (int i = 0; i < loud + tail; i++) {
+    float pos;
+    switch (mod) {
+      case JUMP:   pos = (i & 1) ? 1.0f : 0.0f; break;
+      case RANDOM: pos = uni(rng); break;
+      default:     pos = 0.5f + 0.5f * sinf(2.0f * (float)M_PI * (float)i / 8.0f); break;
+    }
+
+    float x = 0.0f;
+    if (i < loud) x = square ? (((i / 200) & 1) ? 1.0f : -1.0f) : noise(rng);
+
+    float lp, bp, hp;
+    svf.tick(x, fx.gAt(pos), k, lp, bp, hp);
+    if (!std::isfinite(svf.ic1) || !std::isfinite(svf.ic2)) {
+      finite = false;
+      break;
+    }
+    const double m = fmax(fabs(svf.ic1), fabs(svf.ic2));
+    if (m > peak) peak = m;
+  }
+
+  const double left = fmax(fabs(svf.ic1), fabs(svf.ic2));
+  const bool bounded = peak < 4.0 * (q + 1.0);
+  const bool died = left < 1.0e-6;
+  const bool ok = finite && bounded && died;
+  printf("svf q %5.1f %-6s %-6s  peak state %8.3f  after 5 s of silence %.2e  %s\n", q,
+         MOD_NAMES[mod], square ? "square" : "noise", peak, left, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+// **************************
+// Whole effect
+// *****************
+static bool effectCase(EnvFilterEffect::Type type, float depth) {
+  EnvFilterEffect fx;
+  fx.prepare(FS, BLOCK);
+  EnvFilterEffect::Params p;
+  p.sens = 1000.0f;
+  p.start = (depth < 0.0f) ? 1.0f : 0.0f;
+  p.depth = depth;
+  p.q = EnvFilterEffect::MAX_Q;
+  p.decayMs = 0.0f; // clamps to the fastest
+  p.type = type;
+  fx.setParams(p);
+  fx.reset();
+
+  InputAnalyzer an;
+  an.setSampleRate(FS, BLOCK);
+  an.reset();
+
+  std::mt19937 rng(3);
+  std::uniform_int_distribution<int> noise(-32768, 32767);
+  const int blocks = (int)(10.0f * FS) / BLOCK;
+  const int quietFrom = blocks / 2;
+
+  int16_t buf[BLOCK];
+  int parkedAt = -1;
+  for (int b = 0; b < blocks; b++) {
+    // 64-sample bursts in the loud half, full scale on / off
+    for (int i = 0; i < BLOCK; i++) {
+      const bool on = (b < quietFrom) && ((i / 64) & 1);
+      buf[i] = on ? (int16_t)noise(rng) : 0;
+    }
+    const BlockAnalysis& a = an.process(buf, BLOCK);
+    bool silent = a.silent;
+    fx.run(buf, BLOCK, a, silent);
+    if (b >= quietFrom && parkedAt < 0 && fx.isSilent()) parkedAt = b - quietFrom;
+  }
+
+  const bool ok = parkedAt >= 0;
+  static const char* TYPES[] = { "lowpass", "bandpass", "highpass" };
+  if (ok) {
+    printf("effect %-8s depth %+.0f  parked %.0f ms after the input stopped  ok\n", TYPES[type],
+           depth, 1000.0 * parkedAt * BLOCK / FS);
+  } else {
+    printf("effect %-8s depth %+.0f  never parked  FAIL\n", TYPES[type], depth);
+  }
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  double slowdown = 1.0;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--slowdown") && i + 1 < argc) {
+      slowdown = atof(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: envf_bench [--slowdown X]\n");
+      return 2;
+    }
+  }
+  if (!(slowdown > 0.0)) slowdown = 1.0;
+
+  const double blockNs = 1e9 * AUDIO_BLOCK_SAMPLES / AUDIO_SAMPLE_RATE_EXACT;
+  const uint32_t budget = (uint32_t)(blockNs / slowdown);
+  printf("budget %u ns per block (%.0f ns / %.3g)\n", (unsigned)budget, blockNs, slowdown);
+
+  HostShim::serialOut = stdout;
+  EnvFilterEffect::benchmark(Serial, ticksNs, budget);
+
+  EnvFilterEffect fx;
+  fx.prepare(FS, BLOCK);
+  tableError(fx);
+
+  bool ok = true;
+  const float qs[] = { 0.7f, 4.0f, EnvFilterEffect::MAX_Q };
+  for (float q : qs) {
+    for (int m = JUMP; m <= SWEEP8; m++) {
+      ok &= svfCase(fx, q, (Mod)m, false);
+      ok &= svfCase(fx, q, (Mod)m, true);
+    }
+  }
+
+  for (int t = EnvFilterEffect::LOWPASS; t <= EnvFilterEffect::HIGHPASS; t++) {
+    ok &= effectCase((EnvFilterEffect::Type)t, 1.0f);
+    ok &= effectCase((EnvFilterEffect::Type)t, -1.0f);
+  }
+
+  printf("%s\n", ok ? "stable" : "UNSTABLE");
+  return ok ? 0 : 1;
+}
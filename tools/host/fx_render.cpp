@@ -0,0 +1,343 @@
+// **************************
+// fx_render
+// *****************
+// Render a WAV through the pedal firmware on a PC.
+//
+// The file streams through a reader -> DSP -> writer pipeline, three
+// threads passing CHUNKS reusable buffers over bounded SPSC queues, so
+// memory stays the same however long the file is (past 4 GB too) and
+// the disk works while the effect does. At the end it prints how the
+// wall time split between reading, the effect and writing; a DSP share
+// near 100% means the effect code is the limit, not I/O.
+//
+//   fx_render in.wav out.wav [--mode N] [--knobs vol,k2,k3,k4,k5] [--trace out.json]
+//             [--amp-model capture.json [--int8]] [--no-skip]
+//
+// --no-skip runs the DSP on every block, idle or not; the output has to
+// match a normal render (tools/host/skip_check does that for every mode).
+//
+//   fx_render --replay FR000.BIN out.wav [--no-skip]
+//
+// --replay plays a flight recorder dump back: each recorded input block
+// with its own mode and knobs, starting from reset state, and prints
+// the cycles each block took on the pedal next to its host time.
+//
+// --amp-model swaps the AMP mode's built-in capture for a GuitarML style
+// JSON one (converted like tools/host/amp_convert does), --int8 runs it
+// with quantized recurrent weights.
+//
+// --trace writes every FX_TRACE span / lap as Chrome trace JSON (open in
+// Perfetto or chrome://tracing). Build from the repo root, trace marks
+// only record with -DFX_TRACE_ENABLE:
+//
+//   g++ -O2 -std=gnu++17 -DFX_TRACE_ENABLE -Itools/host/shim
+//       $(for d in lib/*/; do printf -- "-I%s " "$d"; done)
+//       tools/host/fx_render.cpp tools/host/shim/HostShim.cpp lib/*/*.cpp
+//       -lpthread -o fx_render
+#include "pedal.h"
+#include "wav.h"
+#include "amp_json.h"
+#include "spsc.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// **************************
+// Pipeline
+// *****************
+static constexpr int CHUNK_BLOCKS = 512; // 64k samples, 128 KB each way
+static constexpr int CHUNKS       = 4;   // in flight across the three stages
+
+struct Chunk {
+  int16_t in[CHUNK_BLOCKS * Pedal::BLOCK];
+  int16_t out[CHUNK_BLOCKS * Pedal::BLOCK];
+  size_t  n = 0; // samples, whole blocks
+};
+
+// nullptr down the line means the end of the file
+using ChunkQueue = Spsc<Chunk*, CHUNKS>;
+
+static double secondsSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void usage() {
+  fprintf(stderr, "usage: fx_render in.wav out.wav [--mode N] [--knobs vol,k2,k3,k4,k5] [--trace out.json]\n"
+                  "                 [--amp-model capture.json [--int8]] [--no-skip]\n"
+                  "       fx_render --replay FR000.BIN out.wav [--no-skip]\n");
+}
+
+// **************************
+// Replay
+// *****************
+// A dump is small (FRAMES blocks), so it's read whole and run in place.
+static int replay(const char* dumpPath, const char* outPath) {
+  using FR = FlightRecorder;
+
+  FILE* f = fopen(dumpPath, "rb");
+  if (!f) {
+    fprintf(stderr, "can't read %s\n", dumpPath);
+    return 1;
+  }
+  std::vector<uint8_t> data;
+  uint8_t buf[4096];
+  for (size_t got; (got = fread(buf, 1, sizeof(buf), f)) > 0;) data.insert(data.end(), buf, buf + got);
+  fclose(f);
+
+  // Serial dumps may have the text line in front
+  size_t at = 0;
+  while (at + 4 <= data.size() && memcmp(&data[at], "FXFR", 4)) at++;
+  FR::Header h;
+  if (at + sizeof(h) > data.size()) {
+    fprintf(stderr, "%s: no FXFR header\n", dumpPath);
+    return 1;
+  }
+  memcpy(&h, &data[at], sizeof(h));
+  if (h.version != 1 || h.blockSamples != Pedal::BLOCK || h.headerBytes < sizeof(h)) {
+    fprintf(stderr, "%s: version %u, %u samples per block: not this build's format\n", dumpPath,
+            (unsigned)h.version, (unsigned)h.blockSamples);
+    return 1;
+  }
+  at += h.headerBytes;
+
+  const size_t frames = std::min((size_t)h.frames, (data.size() - at) / sizeof(FR::Frame));
+  if (frames < h.frames) fprintf(stderr, "%s: cut short, %zu of %u frames\n", dumpPath, frames, (unsigned)h.frames);
+  if (frames == 0) return 1;
+
+  auto knobsOf = [](const FR::Frame& fr) {
+    Pedal::Knobs5 k;
+    for (int i = 0; i < 5; i++) k.v[i] = (float)fr.knobs[i] / 65535.0f;
+    return k;
+  };
+
+  FR::Frame fr;
+  memcpy(&fr, &data[at], sizeof(fr));
+  Pedal::begin(fr.mode, knobsOf(fr));
+  int mode = fr.mode;
+
+  fprintf(stderr, "%s: %zu blocks, trigger at seq %u (%s%s), deadline %u cycles\n", dumpPath, frames,
+          (unsigned)h.triggerSeq, (h.reason & FR::DEADLINE) ? "deadline " : "",
+          (h.reason & FR::CLIPPED) ? "clip" : "", (unsigned)h.deadlineCycles);
+  fprintf(stderr, "   seq  mode flags  pedal cycles  of deadline   host us\n");
+
+  std::vector<int16_t> out(frames * Pedal::BLOCK);
+  for (size_t i = 0; i < frames; i++) {
+    memcpy(&fr, &data[at + i * sizeof(fr)], sizeof(fr));
+
+    // a mode change resets like the button does; knobs as recorded (to
+    // the pot's resolution, they go through readControls() again)
+    if (fr.mode != mode) {
+      mode = fr.mode;
+      Pedal::setMode(mode);
+    }
+    Pedal::setKnobs(knobsOf(fr));
+
+    const auto t0 = std::chrono::steady_clock::now();
+    Pedal::process(fr.input, &out[i * Pedal::BLOCK]);
+    const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+
+    fprintf(stderr, "%6u  %4d  %c%c   %12u  %10.1f%%  %8.2f%s\n", (unsigned)fr.seq, (int)fr.mode,
+            (fr.flags & FR::DEADLINE) ? 'D' : '-', (fr.flags & FR::CLIPPED) ? 'C' : '-', (unsigned)fr.cycles,
+            h.deadlineCycles ? 100.0 * fr.cycles / h.deadlineCycles : 0.0, us,
+            (fr.seq == h.triggerSeq) ? "  <- trigger" : "");
+  }
+
+  if (!Wav::write(outPath, out, (uint32_t)lrintf(h.sampleRate))) {
+    fprintf(stderr, "can't write %s\n", outPath);
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    usage();
+    return 2;
+  }
+
+  if (!strcmp(argv[1], "--replay")) {
+    if (argc < 4) {
+      usage();
+      return 2;
+    }
+    for (int i = 4; i < argc; i++) {
+      if (!strcmp(argv[i], "--no-skip")) {
+        idleSkip = false;
+      } else {
+        usage();
+        return 2;
+      }
+    }
+    return replay(argv[2], argv[3]);
+  }
+
+  const char* inPath  = argv[1];
+  const char* outPath = argv[2];
+  const char* tracePath = nullptr;
+  const char* ampPath = nullptr;
+  bool ampInt8 = false;
+  int m = MODE_BYPASS;
+  Pedal::Knobs5 knobs = { { 0.8f, 0.5f, 0.5f, 0.5f, 0.5f } };
+
+  for (int i = 3; i < argc; i++) {
+    if (!strcmp(argv[i], "--mode") && i + 1 < argc) {
+      m = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--knobs") && i + 1 < argc) {
+      if (!Pedal::parseKnobs(argv[++i], knobs)) { usage(); return 2; }
+    } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+      tracePath = argv[++i];
+    } else if (!strcmp(argv[i], "--amp-model") && i + 1 < argc) {
+      ampPath = argv[++i];
+    } else if (!strcmp(argv[i], "--int8")) {
+      ampInt8 = true;
+    } else if (!strcmp(argv[i], "--no-skip")) {
+      idleSkip = false;
+    } else {
+      usage();
+      return 2;
+    }
+  }
+
+  Wav::Reader reader;
+  if (!reader.open(inPath)) {
+    fprintf(stderr, "can't read %s (16 bit PCM WAV)\n", inPath);
+    return 1;
+  }
+  const uint32_t fs = reader.rate();
+  if (fs != 44100 && fs != 44117) {
+    fprintf(stderr, "note: %s is %u Hz, the pedal runs at %.1f Hz\n", inPath, fs, (double)Pedal::FS);
+  }
+
+  Wav::Writer writer;
+  if (!writer.open(outPath, fs)) {
+    fprintf(stderr, "can't write %s\n", outPath);
+    return 1;
+  }
+
+  Pedal::begin(m, knobs);
+
+  // the model points into the blob, which lives until exit
+  static std::vector<uint8_t> ampBlob;
+  if (ampPath) {
+    std::string err;
+    if (!AmpJson::loadFile(ampPath, ampInt8, ampBlob, err) || !amp.load(ampBlob.data(), ampBlob.size())) {
+      fprintf(stderr, "%s: %s\n", ampPath, err.empty() ? "converted blob doesn't load" : err.c_str());
+      return 1;
+    }
+    amp.reset();
+  }
+
+  // **************************
+  // Stages
+  // *****************
+  static Chunk chunks[CHUNKS];
+  static ChunkQueue freeQ, inQ, outQ; // writer -> reader -> DSP -> writer
+
+  double unused = 0.0;
+  for (Chunk& c : chunks) freeQ.push(&c, unused);
+
+  double readS = 0.0, readWaitS = 0.0;
+  double dspS = 0.0, dspWaitInS = 0.0, dspWaitOutS = 0.0;
+  double writeS = 0.0, writeWaitS = 0.0;
+  double sumUs = 0.0, maxUs = 0.0;
+  size_t blocks = 0;
+  std::atomic<bool> writeFailed{ false };
+
+  const auto wall0 = std::chrono::steady_clock::now();
+
+  // whole blocks, tail padded with zeros
+  std::thread readThread([&] {
+    for (;;) {
+      Chunk* c;
+      freeQ.pop(c, readWaitS);
+      const auto t0 = std::chrono::steady_clock::now();
+      const size_t got = reader.read(c->in, CHUNK_BLOCKS * Pedal::BLOCK);
+      if (got == 0) {
+        readS += secondsSince(t0);
+        inQ.push(nullptr, readWaitS);
+        return;
+      }
+      c->n = (got + Pedal::BLOCK - 1) / Pedal::BLOCK * Pedal::BLOCK;
+      memset(c->in + got, 0, (c->n - got) * sizeof(int16_t));
+      readS += secondsSince(t0);
+      inQ.push(c, readWaitS);
+    }
+  });
+
+  std::thread dspThread([&] {
+    for (;;) {
+      Chunk* c;
+      inQ.pop(c, dspWaitInS);
+      if (!c) {
+        outQ.push(nullptr, dspWaitOutS);
+        return;
+      }
+      for (size_t at = 0; at < c->n; at += Pedal::BLOCK) {
+        auto t0 = std::chrono::steady_clock::now();
+        Pedal::process(&c->in[at], &c->out[at]);
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        sumUs += us;
+        if (us > maxUs) maxUs = us;
+      }
+      blocks += c->n / Pedal::BLOCK;
+      outQ.push(c, dspWaitOutS);
+    }
+  });
+
+  std::thread writeThread([&] {
+    for (;;) {
+      Chunk* c;
+      outQ.pop(c, writeWaitS);
+      if (!c) return;
+      const auto t0 = std::chrono::steady_clock::now();
+      if (!writer.write(c->out, c->n)) writeFailed = true;
+      writeS += secondsSince(t0);
+      freeQ.push(c, writeWaitS);
+    }
+  });
+
+  readThread.join();
+  dspThread.join();
+  writeThread.join();
+  reader.close();
+
+  const auto close0 = std::chrono::steady_clock::now();
+  if (!writer.close() || writeFailed) {
+    fprintf(stderr, "can't write %s\n", outPath);
+    return 1;
+  }
+  writeS += secondsSince(close0);
+  const double wallS = secondsSince(wall0);
+  dspS = sumUs * 1e-6;
+
+  const double budgetUs = 1e6 * Pedal::BLOCK / Pedal::FS;
+  fprintf(stderr, "mode %d: %zu blocks, %.2f us mean, %.2f us max per block (budget %.0f us)\n",
+          m, blocks, blocks ? sumUs / blocks : 0.0, maxUs, budgetUs);
+
+  // shares of the wall time; the stages overlap, so they don't add up
+  const double audioS = (double)blocks * Pedal::BLOCK / Pedal::FS;
+  const double pct = (wallS > 0.0) ? 100.0 / wallS : 0.0;
+  fprintf(stderr, "pipeline: %.2f s wall for %.1f s of audio (%.0fx real time)\n", wallS, audioS,
+          (wallS > 0.0) ? audioS / wallS : 0.0);
+  fprintf(stderr, "  read  %7.3f s  %5.1f%% of wall\n", readS, readS * pct);
+  fprintf(stderr, "  dsp   %7.3f s  %5.1f%% of wall, waited %.3f s for input, %.3f s for the writer\n",
+          dspS, dspS * pct, dspWaitInS, dspWaitOutS);
+  fprintf(stderr, "  write %7.3f s  %5.1f%% of wall\n", writeS, writeS * pct);
+
+  if (tracePath) {
+#if defined(FX_TRACE_ENABLE)
+    if (!Trace::writeChromeJson(tracePath)) {
+      fprintf(stderr, "can't write %s\n", tracePath);
+      return 1;
+    }
+#else
+    fprintf(stderr, "--trace: built without -DFX_TRACE_ENABLE, nothing recorded\n");
+#endif
+  }
+  return 0;
+}
@@ -0,0 +1,296 @@
+// **************************
+// fx_rt
+// *****************
+// Real-time run of the pedal firmware on a PC. An audio thread wakes at
+// absolute block deadlines (clock_nanosleep, SCHED_FIFO when allowed)
+// and runs FxStream::update() on the next WAV block, the way the I2S
+// interrupt would, while the main thread runs loop(). Background load
+// threads compete for the CPU and caches. Every block's wake-up latency,
+// execution time and finish time against its deadline are recorded.
+//
+//   fx_rt in.wav out.wav [--mode N] [--knobs vol,k2,k3,k4,k5]
+//         [--speed R] [--load T] [--cpu C] [--max-miss M]
+//         [--csv blocks.csv] [--serial log.txt]
+//
+//   --speed R     block period divided by R (R = 10 asks for 10x
+//                 headroom over real time, a rough stand-in for the
+//                 slower Teensy core)
+//   --load T      T threads streaming through 16 MB and doing math
+//   --cpu C       pin the audio thread (and the load threads) to CPU C
+//   --max-miss M  exit status 1 if more than M blocks finish late
+//
+// SCHED_FIFO and mlockall need root or CAP_SYS_NICE / CAP_IPC_LOCK
+// (or an rtprio limit); without them the run continues at normal
+// priority and says so.
+//
+// Build like fx_render (tools/host/fx_render.cpp), with
+// tools/host/fx_rt.cpp in place of fx_render.cpp.
+#include "pedal.h"
+#include "wav.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// **************************
+// Time
+// *****************
+static int64_t nowNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+static timespec toTimespec(int64_t ns) {
+  timespec ts;
+  ts.tv_sec  = (time_t)(ns / 1000000000ll);
+  ts.tv_nsec = (long)(ns % 1000000000ll);
+  return ts;
+}
+
+// absolute sleep, restarts after signals
+static void sleepUntil(int64_t ns) {
+  timespec ts = toTimespec(ns);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+}
+
+static bool pinToCpu(pthread_t t, int cpu) {
+  if (cpu < 0) return true;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(t, sizeof(set), &set) == 0;
+}
+
+// **************************
+// Background load
+// *****************
+static std::atomic<bool> loadRun{ true };
+
+static void loadThread(int id) {
+  static constexpr size_t BYTES = 16u << 20;
+  std::vector<uint32_t> buf(BYTES / 4, (uint32_t)id);
+  volatile float sink = 0.0f;
+  float acc = 1.0f + (float)id;
+
+  while (loadRun.load(std::memory_order_relaxed)) {
+    // sweep the buffer: evicts whatever the audio thread had cached
+    for (size_t i = 0; i < buf.size(); i += 16) buf[i] = buf[i] * 1664525u + 1013904223u;
+    // then some FPU work
+    for (int i = 0; i < 200000; i++) acc = acc * 0.9999f + 0.0001f;
+    sink = acc;
+  }
+  (void)sink;
+}
+
+// **************************
+// Audio thread
+// *****************
+struct BlockTimes {
+  float wakeUs; // release -> running
+  float execUs; // update() itself
+  float respUs; // release -> done
+};
+
+struct RtRun {
+  const std::vector<int16_t>* in  = nullptr;
+  std::vector<int16_t>*       out = nullptr;
+  std::vector<BlockTimes>     times;
+  int64_t periodNs = 0;
+  bool    fifo = false;
+};
+
+static void audioThread(RtRun* run) {
+  const size_t blocks = run->in->size() / Pedal::BLOCK;
+
+  int64_t release = nowNs() + 10 * run->periodNs; // settle before the first block
+  for (size_t b = 0; b < blocks; b++) {
+    sleepUntil(release);
+    const int64_t t0 = nowNs();
+
+    Pedal::process(&(*run->in)[b * Pedal::BLOCK], &(*run->out)[b * Pedal::BLOCK]);
+
+    const int64_t t1 = nowNs();
+    BlockTimes& bt = run->times[b];
+    bt.wakeUs = (float)(t0 - release) * 1e-3f;
+    bt.execUs = (float)(t1 - t0) * 1e-3f;
+    bt.respUs = (float)(t1 - release) * 1e-3f;
+
+    // like the I2S DMA: the next block is due one period later no matter
+    // how late this one was
+    release += run->periodNs;
+  }
+}
+
+// **************************
+// Report
+// *****************
+static float percentile(std::vector<float> v, float p) {
+  if (v.empty()) return 0.0f;
+  size_t k = (size_t)(p * (float)(v.size() - 1) + 0.5f);
+  std::nth_element(v.begin(), v.begin() + k, v.end());
+  return v[k];
+}
+
+static void usage() {
+  fprintf(stderr,
+          "usage: fx_rt in.wav out.wav [--mode N] [--knobs vol,k2,k3,k4,k5] [--speed R]\n"
+          "             [--load T] [--cpu C] [--max-miss M] [--csv blocks.csv] [--serial log.txt]\n");
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    usage();
+    return 2;
+  }
+
+  const char* inPath  = argv[1];
+  const char* outPath = argv[2];
+  const char* csvPath = nullptr;
+  const char* serialPath = nullptr;
+  int   m = MODE_BYPASS;
+  float speed = 1.0f;
+  int   loads = 0;
+  int   cpu = -1;
+  long  maxMiss = 0;
+  Pedal::Knobs5 knobs = { { 0.8f, 0.5f, 0.5f, 0.5f, 0.5f } };
+
+  for (int i = 3; i < argc; i++) {
+    if (!strcmp(argv[i], "--mode") && i + 1 < argc)          m = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--knobs") && i + 1 < argc)    { if (!Pedal::parseKnobs(argv[++i], knobs)) { usage(); return 2; } }
+    else if (!strcmp(argv[i], "--speed") && i + 1 < argc)    speed = strtof(argv[++i], nullptr);
+    else if (!strcmp(argv[i], "--load") && i + 1 < argc)     loads = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--cpu") && i + 1 < argc)      cpu = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--max-miss") && i + 1 < argc) maxMiss = atol(argv[++i]);
+    else if (!strcmp(argv[i], "--csv") && i + 1 < argc)      csvPath = argv[++i];
+    else if (!strcmp(argv[i], "--serial") && i + 1 < argc)   serialPath = argv[++i];
+    else {
+      usage();
+      return 2;
+    }
+  }
+  if (!(speed > 0.0f)) speed = 1.0f;
+
+  std::vector<int16_t> in;
+  uint32_t fs = 0;
+  if (!Wav::read(inPath, in, fs)) {
+    fprintf(stderr, "can't read %s (16 bit PCM WAV)\n", inPath);
+    return 1;
+  }
+  const size_t blocks = (in.size() + Pedal::BLOCK - 1) / Pedal::BLOCK;
+  in.resize(blocks * Pedal::BLOCK, 0);
+  std::vector<int16_t> out(in.size(), 0);
+
+  // loop() prints, and dumps the flight recorder over Serial without a card
+  FILE* serial = serialPath ? fopen(serialPath, "wb") : nullptr;
+  HostShim::serialOut = serial;
+
+  Pedal::begin(m, knobs);
+  HostShim::realTime = true;
+
+  // page everything in now, not on the first late block
+  const bool locked = mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+
+  RtRun run;
+  run.in  = &in;
+  run.out = &out;
+  run.times.resize(blocks);
+  run.periodNs = (int64_t)(1e9 * Pedal::BLOCK / Pedal::FS / speed);
+
+  std::vector<std::thread> load;
+  for (int i = 0; i < loads; i++) {
+    load.emplace_back(loadThread, i);
+    pinToCpu(load.back().native_handle(), cpu);
+  }
+
+  // FIFO asked for at creation, plain thread if that's refused
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  sched_param sp;
+  sp.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+  pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+  pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+  pthread_attr_setschedparam(&attr, &sp);
+
+  auto entry = [](void* p) -> void* { audioThread((RtRun*)p); return nullptr; };
+  pthread_t audio;
+  run.fifo = pthread_create(&audio, &attr, entry, &run) == 0;
+  if (!run.fifo && pthread_create(&audio, nullptr, entry, &run) != 0) {
+    fprintf(stderr, "can't start the audio thread\n");
+    return 1;
+  }
+  pthread_attr_destroy(&attr);
+  if (!pinToCpu(audio, cpu)) fprintf(stderr, "note: can't pin to CPU %d\n", cpu);
+
+  // main thread is the firmware's loop(), like on the Teensy
+  std::atomic<bool> done{ false };
+  std::thread watcher([&] { pthread_join(audio, nullptr); done = true; });
+  while (!done) loop();
+  watcher.join();
+
+  loadRun = false;
+  for (std::thread& t : load) t.join();
+  if (serial) fclose(serial);
+
+  if (!Wav::write(outPath, out, fs)) {
+    fprintf(stderr, "can't write %s\n", outPath);
+    return 1;
+  }
+
+  // **************************
+  // Results
+  // *****************
+  const float periodUs = (float)run.periodNs * 1e-3f;
+  std::vector<float> wake, exec, resp;
+  long misses = 0, overruns = 0;
+  size_t firstMiss = blocks;
+  for (size_t b = 0; b < blocks; b++) {
+    const BlockTimes& t = run.times[b];
+    wake.push_back(t.wakeUs);
+    exec.push_back(t.execUs);
+    resp.push_back(t.respUs);
+    if (t.execUs > periodUs) overruns++;
+    if (t.respUs > periodUs) {
+      misses++;
+      if (firstMiss == blocks) firstMiss = b;
+    }
+  }
+
+  if (csvPath) {
+    FILE* f = fopen(csvPath, "w");
+    if (f) {
+      fprintf(f, "block,wake_us,exec_us,resp_us,miss\n");
+      for (size_t b = 0; b < blocks; b++) {
+        const BlockTimes& t = run.times[b];
+        fprintf(f, "%zu,%.2f,%.2f,%.2f,%d\n", b, t.wakeUs, t.execUs, t.respUs, t.respUs > periodUs ? 1 : 0);
+      }
+      fclose(f);
+    } else {
+      fprintf(stderr, "can't write %s\n", csvPath);
+    }
+  }
+
+  printf("mode %d, %zu blocks, period %.1f us (speed x%.2g), load threads %d\n",
+         m, blocks, periodUs, speed, loads);
+  printf("scheduling %s, memory %s\n", run.fifo ? "SCHED_FIFO" : "normal (no SCHED_FIFO permission)",
+         locked ? "locked" : "not locked");
+  printf("          p50      p99      max   (us)\n");
+  printf("wake  %8.2f %8.2f %8.2f\n", percentile(wake, 0.5f), percentile(wake, 0.99f), percentile(wake, 1.0f));
+  printf("exec  %8.2f %8.2f %8.2f\n", percentile(exec, 0.5f), percentile(exec, 0.99f), percentile(exec, 1.0f));
+  printf("resp  %8.2f %8.2f %8.2f\n", percentile(resp, 0.5f), percentile(resp, 0.99f), percentile(resp, 1.0f));
+  if (misses) printf("deadline misses: %ld (first at block %zu)\n", misses, firstMiss);
+  else        printf("deadline misses: 0\n");
+  // the rest of the misses were late wake-ups: scheduler / VM, not DSP
+  printf("update() longer than a period: %ld\n", overruns);
+
+  const bool pass = misses <= maxMiss;
+  printf("%s\n", pass ? "PASS" : "FAIL");
+  return pass ? 0 : 1;
+}
@@ -0,0 +1,434 @@
+// **************************
+// fx_wcet
+// *****************
+// Worst-case block time search. For each mode it runs short sequences
+// of adversarial input (silence, DC, full-scale square / Nyquist,
+// noise, impulses, bursts across the idle gate, chirps) under static
+// knob corners, jumps, pot-speed sweeps and NaN / Inf knob values, then
+// hill-climbs around the most expensive case. The deadline depends on
+// the worst block, not the mean.
+//
+//   fx_wcet [--mode N] [--iters K] [--seed S] [--out DIR]
+//   fx_wcet --replay DIR/wcet_m4.case
+//
+// The worst case of each mode is saved as DIR/wcet_mN.case (one line,
+// replayable) and DIR/wcet_mN.wav (its input). A block that doesn't
+// finish within a second stops the run and prints its case.
+//
+// Build like fx_render (tools/host/fx_render.cpp), with
+// tools/host/fx_wcet.cpp in place of fx_render.cpp. For the checked
+// build add -fsanitize=address,undefined,float-cast-overflow: a NaN
+// reaching a delay index or an int conversion then shows up as an error
+// instead of a quiet out-of-bounds read.
+#include "pedal.h"
+#include "wav.h"
+
+#include <signal.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+static const char* MODE_NAMES[] = {
+  "bypass", "leslie", "muff", "octave", "orch", "crush",
+  "flange", "trem", "chorus", "polyoct", "looper", "echo",
+  "amp", "tuner", "envf", "freeze",
+};
+static_assert(sizeof(MODE_NAMES) / sizeof(MODE_NAMES[0]) == MODE_COUNT, "one name per mode");
+
+static constexpr int BLOCKS  = 64; // per run, ~186 ms
+static constexpr int REPEATS = 3;  // per-block minimum over runs drops timer noise
+static constexpr int FINAL_REPEATS = 9;
+static constexpr int TOP = 4;      // candidates re-measured at the end
+
+// **************************
+// Cases
+// *****************
+enum Signal : int {
+  SIG_SILENCE, SIG_DC, SIG_SQUARE, SIG_SINE, SIG_NOISE, SIG_NYQUIST,
+  SIG_IMPULSE, SIG_BURST, SIG_GATE, SIG_CHIRP, SIG_COUNT
+};
+static const char* SIG_NAMES[SIG_COUNT] = {
+  "silence", "dc", "square", "sine", "noise", "nyquist",
+  "impulse", "burst", "gate", "chirp",
+};
+
+// how the knobs move from k0 to k1 over the run
+enum Sweep : int { SW_STATIC, SW_RAMP, SW_JUMP, SW_POT, SW_COUNT };
+static const char* SWEEP_NAMES[SW_COUNT] = { "static", "ramp", "jump", "pot" };
+
+// knob values forced into the smoothing state from mid-run on
+enum Poison : int { PO_NONE, PO_NAN, PO_INF, PO_NEG_INF, PO_COUNT };
+static const char* POISON_NAMES[PO_COUNT] = { "none", "nan", "inf", "-inf" };
+
+struct Case {
+  int      mode   = 0;
+  int      sig    = SIG_SILENCE;
+  float    hz     = 440.0f;
+  float    amp    = 1.0f;
+  int      sweep  = SW_STATIC;
+  float    k0[5]  = { 0.5f, 0.5f, 0.5f, 0.5f, 0.5f };
+  float    k1[5]  = { 0.5f, 0.5f, 0.5f, 0.5f, 0.5f };
+  int      poison = PO_NONE;
+  uint32_t seed   = 1;
+};
+
+static int lookup(const char* s, const char* const* names, int n) {
+  for (int i = 0; i < n; i++) if (!strcmp(s, names[i])) return i;
+  return -1;
+}
+
+static std::string describe(const Case& c) {
+  char buf[256];
+  snprintf(buf, sizeof(buf),
+           "mode=%d sig=%s hz=%.1f amp=%.3f sweep=%s k0=%.3f,%.3f,%.3f,%.3f,%.3f "
+           "k1=%.3f,%.3f,%.3f,%.3f,%.3f poison=%s seed=%u",
+           c.mode, SIG_NAMES[c.sig], (double)c.hz, (double)c.amp, SWEEP_NAMES[c.sweep],
+           (double)c.k0[0], (double)c.k0[1], (double)c.k0[2], (double)c.k0[3], (double)c.k0[4],
+           (double)c.k1[0], (double)c.k1[1], (double)c.k1[2], (double)c.k1[3], (double)c.k1[4],
+           POISON_NAMES[c.poison], c.seed);
+  return buf;
+}
+
+static bool parseCase(const char* line, Case& c) {
+  char sig[16], sweep[16], poison[16];
+  int n = sscanf(line,
+                 "mode=%d sig=%15s hz=%f amp=%f sweep=%15s k0=%f,%f,%f,%f,%f "
+                 "k1=%f,%f,%f,%f,%f poison=%15s seed=%u",
+                 &c.mode, sig, &c.hz, &c.amp, sweep,
+                 &c.k0[0], &c.k0[1], &c.k0[2], &c.k0[3], &c.k0[4],
+                 &c.k1[0], &c.k1[1], &c.k1[2], &c.k1[3], &c.k1[4],
+                 poison, &c.seed);
+  if (n != 17) return false;
+  c.sig    = lookup(sig, SIG_NAMES, SIG_COUNT);
+  c.sweep  = lookup(sweep, SWEEP_NAMES, SW_COUNT);
+  c.poison = lookup(poison, POISON_NAMES, PO_COUNT);
+  return c.mode >= 0 && c.mode < MODE_COUNT && c.sig >= 0 && c.sweep >= 0 && c.poison >= 0;
+}
+
+// **************************
+// Input
+// *****************
+struct Source {
+  std::mt19937 rng;
+  double phase = 0.0;
+  explicit Source(uint32_t seed) : rng(seed) {}
+};
+
+static int16_t full(float v) {
+  v *= 32767.0f;
+  if (v > 32767.0f) v = 32767.0f;
+  if (v < -32768.0f) v = -32768.0f;
+  return (int16_t)lrintf(v);
+}
+
+static void makeInput(const Case& c, int b, Source& s, int16_t* out) {
+  const double inc = (double)c.hz / (double)Pedal::FS;
+  std::uniform_real_distribution<float> uni(-1.0f, 1.0f);
+
+  for (int i = 0; i < Pedal::BLOCK; i++) {
+    float v = 0.0f;
+    switch (c.sig) {
+      case SIG_SILENCE: v = 0.0f; break;
+      case SIG_DC:      v = (c.seed & 1) ? 1.0f : -1.0f; break;
+      case SIG_SQUARE:  v = (s.phase < 0.5) ? 1.0f : -1.0f; break;
+      case SIG_SINE:    v = (float)sin(2.0 * M_PI * s.phase); break;
+      case SIG_NOISE:   v = uni(s.rng); break;
+      case SIG_NYQUIST: v = (i & 1) ? 1.0f : -1.0f; break;
+      case SIG_IMPULSE: v = (i == 0) ? 1.0f : 0.0f; break;
+      // loud / silent in 8 block stretches, wakes every tail up again
+      case SIG_BURST:   v = ((b / 8) & 1) ? 0.0f : ((s.phase < 0.5) ? 1.0f : -1.0f); break;
+      // a few LSB around the analyzer's idle gate, flips idle-skip per block
+      case SIG_GATE:    v = (b & 1) ? uni(s.rng) * (12.0f / 32767.0f) : 0.0f; break;
+      case SIG_CHIRP: {
+        double f = 20.0 * pow(1000.0, (double)(b * Pedal::BLOCK + i) / (BLOCKS * Pedal::BLOCK));
+        v = (float)sin(2.0 * M_PI * s.phase);
+        s.phase += f / (double)Pedal::FS;
+        s.phase -= floor(s.phase);
+        break;
+      }
+    }
+    if (c.sig != SIG_CHIRP) {
+      s.phase += inc;
+      s.phase -= floor(s.phase);
+    }
+    // gate level stays at a few LSB whatever amp says
+    out[i] = full(c.sig == SIG_GATE ? v : v * c.amp);
+  }
+}
+
+// **************************
+// Knobs
+// *****************
+static void knobsAt(const Case& c, int b, Pedal::Knobs5& k, bool& snap) {
+  float t = 0.0f;
+  snap = true;
+  switch (c.sweep) {
+    case SW_STATIC: t = 0.0f; break;
+    case SW_RAMP:   t = (float)b / (float)(BLOCKS - 1); break;
+    case SW_JUMP:   t = (float)(b & 1); break;                // end to end every block
+    case SW_POT:    t = (float)((b / 4) & 1); snap = false; break; // through the pot smoothing
+  }
+  for (int i = 0; i < 5; i++) k.v[i] = c.k0[i] + (c.k1[i] - c.k0[i]) * t;
+}
+
+static void poisonKnobs(int poison) {
+  float v = 0.0f;
+  switch (poison) {
+    case PO_NAN:     v = NAN; break;
+    case PO_INF:     v = INFINITY; break;
+    case PO_NEG_INF: v = -INFINITY; break;
+    default: return;
+  }
+  s1 = v; s2 = v; s3 = v; s4 = v; s5 = v;
+}
+
+// **************************
+// Timing
+// *****************
+static char hangMsg[512];
+
+static void onHang(int) {
+  ssize_t r = write(2, hangMsg, strlen(hangMsg));
+  (void)r;
+  _exit(3);
+}
+
+static double nowUs() {
+  return std::chrono::duration<double, std::micro>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// one run from a fresh mode switch, per-block times out
+static void runOnce(const Case& c, double* us, std::vector<int16_t>* input) {
+  snprintf(hangMsg, sizeof(hangMsg), "block did not finish: %s\n", describe(c).c_str());
+
+  Pedal::Knobs5 k;
+  bool snap;
+  knobsAt(c, 0, k, snap);
+  Pedal::setKnobs(k);
+  Pedal::setMode(c.mode);
+
+  Source src(c.seed);
+  int16_t in[Pedal::BLOCK], out[Pedal::BLOCK];
+
+  for (int b = 0; b < BLOCKS; b++) {
+    makeInput(c, b, src, in);
+    if (input) input->insert(input->end(), in, in + Pedal::BLOCK);
+
+    knobsAt(c, b, k, snap);
+    Pedal::setKnobs(k, snap);
+    if (b >= BLOCKS / 2) poisonKnobs(c.poison);
+
+    alarm(1);
+    double t0 = nowUs();
+    Pedal::process(in, out);
+    us[b] = nowUs() - t0;
+    alarm(0);
+  }
+}
+
+struct Score {
+  double worst = 0.0;
+  double mean  = 0.0;
+  int    block = 0;
+};
+
+static Score measure(const Case& c, int repeats) {
+  double best[BLOCKS], us[BLOCKS];
+  for (int b = 0; b < BLOCKS; b++) best[b] = 1e30;
+
+  for (int r = 0; r < repeats; r++) {
+    runOnce(c, us, nullptr);
+    for (int b = 0; b < BLOCKS; b++) if (us[b] < best[b]) best[b] = us[b];
+  }
+
+  Score s;
+  for (int b = 0; b < BLOCKS; b++) {
+    s.mean += best[b];
+    if (best[b] > s.worst) { s.worst = best[b]; s.block = b; }
+  }
+  s.mean /= BLOCKS;
+  return s;
+}
+
+// **************************
+// Search
+// *****************
+static float randKnob(std::mt19937& rng) {
+  std::uniform_real_distribution<float> u(0.0f, 1.0f);
+  float r = u(rng);
+  if (r < 0.25f) return 0.0f; // ends of travel are where costs jump
+  if (r < 0.50f) return 1.0f;
+  return u(rng);
+}
+
+static Case randomCase(int mode, std::mt19937& rng) {
+  std::uniform_real_distribution<float> u(0.0f, 1.0f);
+  Case c;
+  c.mode  = mode;
+  c.sig   = (int)(rng() % SIG_COUNT);
+  c.hz    = 20.0f * powf(1000.0f, u(rng));
+  c.amp   = (u(rng) < 0.7f) ? 1.0f : u(rng);
+  c.sweep = (int)(rng() % SW_COUNT);
+  for (int i = 0; i < 5; i++) { c.k0[i] = randKnob(rng); c.k1[i] = randKnob(rng); }
+  c.poison = (u(rng) < 0.1f) ? 1 + (int)(rng() % (PO_COUNT - 1)) : PO_NONE;
+  c.seed   = rng();
+  return c;
+}
+
+static Case mutate(const Case& c, std::mt19937& rng) {
+  std::uniform_real_distribution<float> u(0.0f, 1.0f);
+  Case m = c;
+  switch (rng() % 6) {
+    case 0: m.sig = (int)(rng() % SIG_COUNT); break;
+    case 1: m.hz = fminf(20000.0f, fmaxf(20.0f, m.hz * powf(2.0f, 2.0f * u(rng) - 1.0f))); break;
+    case 2: m.sweep = (int)(rng() % SW_COUNT); break;
+    case 3: m.k0[rng() % 5] = randKnob(rng); break;
+    case 4: m.k1[rng() % 5] = randKnob(rng); break;
+    case 5: m.seed = rng(); break;
+  }
+  return m;
+}
+
+struct Found {
+  Case  c;
+  Score s;
+};
+
+static void keep(std::vector<Found>& top, const Case& c, const Score& s) {
+  top.push_back({ c, s });
+  std::sort(top.begin(), top.end(), [](const Found& a, const Found& b) { return a.s.worst > b.s.worst; });
+  if ((int)top.size() > TOP) top.resize(TOP);
+}
+
+static Found searchMode(int mode, int iters, std::mt19937& rng) {
+  std::vector<Found> top;
+
+  // every signal against the 32 knob corners, held still
+  for (int sig = 0; sig < SIG_COUNT; sig++) {
+    for (int corner = 0; corner < 32; corner++) {
+      Case c;
+      c.mode = mode;
+      c.sig  = sig;
+      c.hz   = 110.0f;
+      for (int i = 0; i < 5; i++) c.k0[i] = c.k1[i] = (float)((corner >> i) & 1);
+      c.seed = rng();
+      keep(top, c, measure(c, REPEATS));
+    }
+  }
+
+  // random cases, then mostly small steps from the current worst
+  for (int it = 0; it < iters; it++) {
+    Case c = (it < iters / 3 || (rng() & 3) == 0)
+               ? randomCase(mode, rng)
+               : mutate(top[rng() % top.size()].c, rng);
+    keep(top, c, measure(c, REPEATS));
+  }
+
+  // first place by a single lucky run isn't worth much
+  Found best = top[0];
+  best.s.worst = 0.0;
+  for (const Found& f : top) {
+    Score s = measure(f.c, FINAL_REPEATS);
+    if (s.worst > best.s.worst) best = { f.c, s };
+  }
+  return best;
+}
+
+static bool saveRepro(const char* dir, const Found& f) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s/wcet_m%d.case", dir, f.c.mode);
+  FILE* fp = fopen(path, "w");
+  if (!fp) return false;
+  fprintf(fp, "%s\n", describe(f.c).c_str());
+  fclose(fp);
+
+  double us[BLOCKS];
+  std::vector<int16_t> input;
+  runOnce(f.c, us, &input);
+  snprintf(path, sizeof(path), "%s/wcet_m%d.wav", dir, f.c.mode);
+  return Wav::write(path, input, (uint32_t)lrintf(Pedal::FS));
+}
+
+// **************************
+// Main
+// *****************
+static void usage() {
+  fprintf(stderr, "usage: fx_wcet [--mode N] [--iters K] [--seed S] [--out DIR]\n"
+                  "       fx_wcet --replay FILE.case\n");
+}
+
+static int replay(const char* path) {
+  char line[512];
+  FILE* fp = fopen(path, "r");
+  if (!fp || !fgets(line, sizeof(line), fp)) {
+    fprintf(stderr, "can't read %s\n", path);
+    if (fp) fclose(fp);
+    return 1;
+  }
+  fclose(fp);
+
+  Case c;
+  if (!parseCase(line, c)) {
+    fprintf(stderr, "bad case line: %s", line);
+    return 1;
+  }
+
+  double best[BLOCKS], us[BLOCKS];
+  for (int b = 0; b < BLOCKS; b++) best[b] = 1e30;
+  for (int r = 0; r < FINAL_REPEATS; r++) {
+    runOnce(c, us, nullptr);
+    for (int b = 0; b < BLOCKS; b++) if (us[b] < best[b]) best[b] = us[b];
+  }
+
+  printf("%s\nblock  us\n", describe(c).c_str());
+  for (int b = 0; b < BLOCKS; b++) printf("%5d  %.2f\n", b, best[b]);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  int onlyMode = -1;
+  int iters = 300;
+  uint32_t seed = 1;
+  const char* outDir = ".";
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--mode") && i + 1 < argc)        onlyMode = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--iters") && i + 1 < argc)  iters = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--seed") && i + 1 < argc)   seed = (uint32_t)strtoul(argv[++i], nullptr, 0);
+    else if (!strcmp(argv[i], "--out") && i + 1 < argc)    outDir = argv[++i];
+    else if (!strcmp(argv[i], "--replay") && i + 1 < argc) {
+      signal(SIGALRM, onHang);
+      Pedal::begin(0, Pedal::Knobs5{ { 0.5f, 0.5f, 0.5f, 0.5f, 0.5f } });
+      return replay(argv[++i]);
+    } else {
+      usage();
+      return 2;
+    }
+  }
+
+  signal(SIGALRM, onHang);
+  Pedal::begin(0, Pedal::Knobs5{ { 0.5f, 0.5f, 0.5f, 0.5f, 0.5f } });
+  std::mt19937 rng(seed);
+
+  const double budgetUs = 1e6 * Pedal::BLOCK / Pedal::FS;
+  printf("host block budget %.0f us (the Teensy is several times slower; compare worst/mean)\n\n", budgetUs);
+  printf("mode  name      mean us  worst us  worst/mean  block  case\n");
+
+  for (int m = 0; m < MODE_COUNT; m++) {
+    if (onlyMode >= 0 && m != onlyMode) continue;
+
+    Found f = searchMode(m, iters, rng);
+    printf("%4d  %-8s %8.2f  %8.2f  %10.2f  %5d  %s\n", m, MODE_NAMES[m], f.s.mean, f.s.worst,
+           f.s.mean > 0.0 ? f.s.worst / f.s.mean : 0.0, f.s.block, describe(f.c).c_str());
+    fflush(stdout);
+
+    if (!saveRepro(outDir, f)) fprintf(stderr, "can't write reproducer to %s\n", outDir);
+  }
+  return 0;
+}
@@ -0,0 +1,50 @@
+// **************************
+// limiter_bench
+// *****************
+// OutputLimiter::benchmark on the host: cost of the output stage per
+// block and per sample, the old hard clamp against the look-ahead
+// limiter idling under the ceiling and working on a signal 2x over
+// full scale. --slowdown X divides the budget by X as a stand-in for
+// the slower core; build the firmware with -DLIMITER_BENCH for cycles
+// from the pedal itself.
+//
+//   limiter_bench [--slowdown X]
+//
+// Build from the repo root:
+//
+//   g++ -O2 -std=gnu++17 -Itools/host/shim
+//       $(for d in lib/*/; do printf -- "-I%s " "$d"; done)
+//       tools/host/limiter_bench.cpp tools/host/shim/HostShim.cpp
+//       lib/OutputLimiter/OutputLimiter.cpp -o limiter_bench
+#include <Arduino.h>
+#include <Audio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "OutputLimiter.h"
+
+static uint32_t ticksNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec);
+}
+
+int main(int argc, char** argv) {
+  double slowdown = 1.0;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--slowdown") && i + 1 < argc) {
+      slowdown = atof(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: limiter_bench [--slowdown X]\n");
+      return 2;
+    }
+  }
+  if (!(slowdown > 0.0)) slowdown = 1.0;
+
+  const double blockNs = 1e9 * AUDIO_BLOCK_SAMPLES / AUDIO_SAMPLE_RATE_EXACT;
+  const uint32_t budget = (uint32_t)(blockNs / slowdown);
+  printf("budget %u ns per block (%.0f ns / %.3g)\n", (unsigned)budget, blockNs, slowdown);
+
+  HostShim::serialOut = stdout;
+  OutputLimiter::benchmark(Serial, ticksNs, budget);
+  return 0;
+}
@@ -0,0 +1,239 @@
+// **************************
+// looper_stress
+// *****************
+// lib/SdLooper against a card that stalls. One thread plays the audio
+// interrupt: it calls processBlock() at absolute block deadlines, --speed
+// R times faster than real time. The main thread is loop(): service(),
+// a flight recorder dump while one is pending, then delay(2), scaled
+// like the audio. The card is the host LoopFile with setLatency(): every
+// Nth access sleeps for a spike, scaled by 1 / R. The dump goes to a
+// second file that stalls the same way, since it shares the card.
+//
+// A dump (FlightRecorder::FRAMES frames, FR_FRAMES_PER_PASS per loop()
+// pass as main.cpp drains it) starts with every overdub pass, where the
+// looper has the most card traffic of its own.
+//
+// Each case records L blocks of take A, plays it once, overdubs takes B
+// and C on the next two passes (feedback 0.5), then plays the result.
+// The interrupt thread taps on exact block boundaries and keeps its own
+// copy of the loop, so every output sample is known.
+//
+// Lengths are 3000 blocks, and 2 and 1 times RING_BLOCKS: multiples of
+// the ring, where the write ring slot an overdub writes is the slot
+// playback falls back to when the card read is late. At one ring the
+// write ring holds the whole last pass, so stalls longer than the
+// read-ahead (ALIAS_CASES) still must not miss a sample.
+// Reported per case: underruns, overruns and output samples that differ.
+//
+//   looper_stress [--speed R]
+//
+// Exit status is non-zero if any case underruns, overruns or differs.
+//
+// Build from the repo root:
+//
+//   g++ -O2 -std=gnu++17 -Itools/host/shim
+//       $(for d in lib/*/; do printf -- "-I%s " "$d"; done)
+//       tools/host/looper_stress.cpp tools/host/shim/HostShim.cpp lib/*/*.cpp
+//       -lpthread -o looper_stress
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <iterator>
+#include <random>
+#include <thread>
+#include <vector>
+#include "FlightRecorder.h"
+#include "SdLooper.h"
+
+static constexpr int   BLOCK = SdLooper::BLOCK;
+static constexpr float FS    = 44100.0f;
+static constexpr float FEEDBACK = 0.5f;
+static const char*     PATH  = "looper_stress.raw";
+
+struct Case {
+  int everyN;  // card access that stalls, 0 = never
+  int spikeMs; // stall length, audio time
+};
+
+static const Case CASES[] = { { 0, 0 }, { 10, 400 }, { 15, 500 }, { 30, 600 } };
+
+// past the read-ahead, L = RING_BLOCKS only: playback falls back to the
+// write ring slot the overdub is about to replace
+static const Case ALIAS_CASES[] = { { 20, 1350 }, { 40, 1380 } };
+static const uint32_t LENGTHS[] = { 3000, 2 * SdLooper::RING_BLOCKS, SdLooper::RING_BLOCKS };
+static constexpr int LOOP_DELAY_US = 2000; // delay(2) in loop()
+static const char*     DUMP_PATH = "looper_stress.fr";
+
+// as main.cpp drains the recorder, in whole looper blocks on the card
+static constexpr int FR_FRAMES_PER_PASS = 4;
+static constexpr int DUMP_BLOCKS =
+    (int)((FR_FRAMES_PER_PASS * sizeof(FlightRecorder::Frame) + sizeof(int16_t) * BLOCK - 1) /
+          (sizeof(int16_t) * BLOCK));
+
+// **************************
+// Time
+// *****************
+static int64_t nowNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+static void sleepUntil(int64_t ns) {
+  timespec ts;
+  ts.tv_sec  = (time_t)(ns / 1000000000ll);
+  ts.tv_nsec = (long)(ns % 1000000000ll);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) != 0) {}
+}
+
+// **************************
+// Takes
+// *****************
+// multiples of 4, so every feedback product below is exact
+static std::vector<int16_t> take(uint32_t blocks, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> v(-1500, 1500);
+  std::vector<int16_t> x((size_t)blocks * BLOCK);
+  for (int16_t& s : x) s = (int16_t)(4 * v(rng));
+  return x;
+}
+
+// one pass over the loop each, a tap ahead of every change
+enum Pass { RECORD, PLAY, OVERDUB };
+static const Pass PASSES[] = { RECORD, PLAY, OVERDUB, OVERDUB, PLAY };
+static constexpr int PASS_COUNT = sizeof(PASSES) / sizeof(PASSES[0]);
+
+// **************************
+// One case
+// *****************
+struct Result {
+  SdLooper::Stats stats;
+  uint32_t bad = 0; // output samples that differ
+};
+
+static Result runCase(SdLooper& looper, LoopFile& dump, const Case& c, uint32_t len, double speed) {
+  std::vector<int16_t> takes[PASS_COUNT];
+  for (int i = 0; i < PASS_COUNT; i++) {
+    if (PASSES[i] != PLAY) takes[i] = take(len, (uint32_t)i + 1);
+  }
+
+  looper.begin(PATH);
+  const int spikeMs = (int)(c.spikeMs / speed + 0.5);
+  looper.file().setLatency(c.everyN, spikeMs);
+  dump.open(DUMP_PATH);
+  dump.setLatency(c.everyN, spikeMs);
+  SdLooper::Params p;
+  p.level = 1.0f;
+  p.feedback = FEEDBACK;
+  looper.tap(); // EMPTY -> RECORD, opens the take
+
+  std::atomic<bool> done{ false };
+  std::atomic<int> dumps{ 0 }; // started by the interrupt thread
+  Result r;
+
+  // what the loop holds, kept alongside to know every output sample
+  std::vector<int> model((size_t)len * BLOCK, 0);
+
+  std::thread isr([&] {
+    const int64_t period = (int64_t)(1e9 * BLOCK / FS / speed);
+    const int64_t t0 = nowNs();
+    int16_t data[BLOCK];
+
+    for (uint32_t blk = 0; blk < PASS_COUNT * len; blk++) {
+      sleepUntil(t0 + (int64_t)blk * period);
+
+      const int pass = (int)(blk / len);
+      const size_t at = (size_t)(blk % len) * BLOCK;
+      if (blk % len == 0 && pass > 0 && PASSES[pass] != PASSES[pass - 1]) looper.tap();
+      if (blk % len == 0 && PASSES[pass] == OVERDUB) dumps.fetch_add(1);
+
+      const std::vector<int16_t>& in = takes[pass];
+      if (in.empty()) memset(data, 0, sizeof(data));
+      else memcpy(data, &in[at], sizeof(data));
+
+      looper.processBlock(data, p);
+
+      for (int i = 0; i < BLOCK; i++) {
+        const int x = in.empty() ? 0 : in[at + i];
+        int& loop = model[at + i];
+        if (PASSES[pass] == RECORD) {
+          if (data[i] != x) r.bad++;
+          loop = x;
+          continue;
+        }
+        if (data[i] != x + loop) r.bad++;
+        if (PASSES[pass] == OVERDUB) loop = (int)(FEEDBACK * loop) + x;
+      }
+    }
+    done.store(true);
+  });
+
+  static int16_t frames[DUMP_BLOCKS * BLOCK];
+  int started = 0, framesLeft = 0;
+  uint32_t dumpAt = 0;
+
+  while (!done.load()) {
+    looper.service();
+
+    if (!framesLeft && started < dumps.load()) {
+      started++;
+      framesLeft = FlightRecorder::FRAMES;
+    }
+    if (framesLeft) {
+      dump.write(dumpAt, frames, DUMP_BLOCKS);
+      dumpAt += DUMP_BLOCKS;
+      framesLeft -= FR_FRAMES_PER_PASS;
+    }
+
+    std::this_thread::sleep_for(std::chrono::microseconds((int)(LOOP_DELAY_US / speed)));
+  }
+  isr.join();
+
+  r.stats = looper.stats();
+  looper.file().setLatency(0, 0);
+  looper.reset();
+  dump.close();
+  return r;
+}
+
+int main(int argc, char** argv) {
+  double speed = 10.0;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--speed") && i + 1 < argc) {
+      speed = atof(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: looper_stress [--speed R]\n");
+      return 2;
+    }
+  }
+  if (!(speed > 0.0)) speed = 1.0;
+
+  static SdLooper looper;
+  static LoopFile dump;
+  bool ok = true;
+  printf("%.3g x real time, ring %d blocks (%.0f ms), chunk %d blocks\n", speed,
+         SdLooper::RING_BLOCKS, 1000.0 * SdLooper::RING_BLOCKS * BLOCK / FS, SdLooper::CHUNK_BLOCKS);
+
+  for (uint32_t len : LENGTHS) {
+    std::vector<Case> cases(std::begin(CASES), std::end(CASES));
+    if (len == SdLooper::RING_BLOCKS) cases.insert(cases.end(), std::begin(ALIAS_CASES), std::end(ALIAS_CASES));
+
+    for (const Case& c : cases) {
+      const Result r = runCase(looper, dump, c, len, speed);
+      const bool pass = !r.stats.underruns && !r.stats.overruns && !r.bad;
+      ok &= pass;
+
+      if (c.everyN) printf("L %4u  %4d ms stall every %2dth access", (unsigned)len, c.spikeMs, c.everyN);
+      else          printf("L %4u  no stalls                       ", (unsigned)len);
+      printf("  %3u underruns  %3u overruns  %7u bad samples  %s\n", (unsigned)r.stats.underruns,
+             (unsigned)r.stats.overruns, (unsigned)r.bad, pass ? "ok" : "FAIL");
+    }
+  }
+
+  remove(PATH);
+  remove(DUMP_PATH);
+  printf("%s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,211 @@
+// **************************
+// mod_bench
+// *****************
+// What evaluating the LFO targets at control rate (lib/ModEngine) costs
+// in sound and saves in time, for Leslie, Flanger and Tremolo at the
+// pedal's fastest, deepest knob settings.
+//
+// Each effect plays a sine (110, 1000, 4500 Hz) with K = 1, every target
+// worked out per sample, and with K = 4, 8, 16 and 32, ramped in between.
+// The difference to K = 1 is what the ramps add:
+//
+//   error      rms of the difference against the K = 1 output, dB
+//   sideband   the largest line in the difference's spectrum against the
+//              largest in the K = 1 output (dBc), and where it sits
+//   ns/sample  host time per sample of the effect
+//
+// The pedal runs K = 16 (MOD_CONTROL_K in main.cpp). Exit status is
+// non-zero if a K = 16 sideband comes out above MAX_SIDEBAND_DBC.
+//
+//   mod_bench
+//
+// Build from the repo root:
+//
+//   g++ -O2 -std=gnu++17 -Itools/host/shim
+//       $(for d in lib/*/; do printf -- "-I%s " "$d"; done)
+//       tools/host/mod_bench.cpp tools/host/shim/HostShim.cpp lib/*/*.cpp
+//       -lpthread -o mod_bench
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include "BlockAnalysis.h"
+#include "LeslieEffect.h"
+#include "ModEngine.h"
+#include "SimpleEffects.h"
+#include "Stft.h"
+
+using namespace SimpleFX;
+
+static constexpr int    BLOCK = 128;
+static constexpr float  FS    = 44100.0f;
+static constexpr int    FFT_N = 8192;
+static constexpr double WARMUP_S = 1.0; // rotors up to speed, lines filled
+static constexpr double TIMED_S  = 4.0;
+static constexpr double MAX_SIDEBAND_DBC = -60.0;
+
+static const int KS[] = { 4, 8, 16, 32 };
+static const double TONES[] = { 110.0, 1000.0, 4500.0 };
+
+// **************************
+// Effects
+// *****************
+// fresh effect at its fastest / deepest, control interval k
+struct LeslieCase {
+  using Fx = LeslieEffect;
+  static const char* name() { return "leslie"; }
+  static void setup(LeslieEffect& fx, int k) {
+    LeslieEffect::Params p;
+    p.volume = 1.0f;
+    p.blend  = 1.0f;
+    p.speed  = 1.0f;
+    p.depth  = 1.0f;
+    p.ramp   = 0.0f;
+    fx.prepare(FS, BLOCK);
+    fx.setParams(p);
+    fx.setControlInterval(k);
+    fx.reset();
+  }
+};
+
+struct FlangerCase {
+  using Fx = Flanger;
+  static const char* name() { return "flanger"; }
+  static void setup(Flanger& fx, int k) {
+    Flanger::Params p;
+    p.baseMs   = 0.7f;
+    p.depthMs  = 6.2f;
+    p.rateHz   = 4.05f;
+    p.feedback = 0.0f;
+    p.mix      = 0.5f;
+    fx.prepare(FS, BLOCK);
+    fx.setParams(p);
+    fx.setControlInterval(k);
+    fx.reset();
+  }
+};
+
+struct TremoloCase {
+  using Fx = Tremolo;
+  static const char* name() { return "tremolo"; }
+  static void setup(Tremolo& fx, int k) {
+    Tremolo::Params p;
+    p.rateHz = 12.2f;
+    p.depth  = 1.0f;
+    p.mix    = 1.0f;
+    fx.prepare(FS, BLOCK);
+    fx.setParams(p);
+    fx.setControlInterval(k);
+    fx.reset();
+  }
+};
+
+// **************************
+// Render
+// *****************
+// the analysed window (float, straight from the int16 output) and the
+// time per sample over the whole render
+template <class C>
+static std::vector<float> render(double hz, int k, double& nsPerSample) {
+  static typename C::Fx fx;
+  C::setup(fx, k);
+
+  const size_t warm = (size_t)(WARMUP_S * FS) / BLOCK * BLOCK;
+  const size_t total = warm + (size_t)(TIMED_S * FS) / BLOCK * BLOCK;
+  std::vector<int16_t> x(total);
+  for (size_t i = 0; i < total; i++) x[i] = (int16_t)lrint(16000.0 * sin(2.0 * M_PI * hz * i / FS));
+
+  BlockAnalysis an;
+  double s = 0.0;
+  for (size_t at = 0; at < total; at += BLOCK) {
+    const auto t0 = std::chrono::steady_clock::now();
+    fx.process(&x[at], BLOCK, an);
+    s += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  }
+  nsPerSample = 1e9 * s / (double)total;
+
+  std::vector<float> y(FFT_N);
+  for (int i = 0; i < FFT_N; i++) y[i] = (float)x[warm + i];
+  return y;
+}
+
+// **************************
+// Spectrum
+// *****************
+// Hann windowed magnitudes, bins 0..N/2
+static std::vector<double> spectrum(const std::vector<float>& y) {
+  static float f[FFT_N];
+  for (int i = 0; i < FFT_N; i++) f[i] = y[i] * (float)(0.5 - 0.5 * cos(2.0 * M_PI * i / FFT_N));
+  Stft::RealFft<FFT_N>::forward(f);
+
+  std::vector<double> mag(FFT_N / 2 + 1);
+  mag[0] = fabs(f[0]);
+  mag[FFT_N / 2] = fabs(f[1]);
+  for (int b = 1; b < FFT_N / 2; b++) mag[b] = hypot(f[2 * b], f[2 * b + 1]);
+  return mag;
+}
+
+static int peakBin(const std::vector<double>& mag) {
+  int at = 0;
+  for (int b = 1; b < (int)mag.size(); b++) {
+    if (mag[b] > mag[at]) at = b;
+  }
+  return at;
+}
+
+static double db(double ratio) { return 20.0 * log10(fmax(ratio, 1e-12)); }
+
+// **************************
+// One effect
+// *****************
+template <class C>
+static bool runCase() {
+  bool ok = true;
+  for (double hz : TONES) {
+    double refNs = 0.0;
+    const std::vector<float> ref = render<C>(hz, 1, refNs);
+    const std::vector<double> refMag = spectrum(ref);
+    const double carrier = refMag[peakBin(refMag)];
+
+    double refRms = 0.0;
+    for (float v : ref) refRms += (double)v * v;
+    refRms = sqrt(refRms / FFT_N);
+
+    printf("%-8s %5.0f Hz  K  1                                       %6.1f ns/sample\n", C::name(),
+           hz, refNs);
+    for (int k : KS) {
+      double ns = 0.0;
+      const std::vector<float> y = render<C>(hz, k, ns);
+
+      std::vector<float> e(FFT_N);
+      double eRms = 0.0;
+      for (int i = 0; i < FFT_N; i++) {
+        e[i] = y[i] - ref[i];
+        eRms += (double)e[i] * e[i];
+      }
+      eRms = sqrt(eRms / FFT_N);
+
+      const std::vector<double> eMag = spectrum(e);
+      const int spur = peakBin(eMag);
+      const double sideband = db(eMag[spur] / carrier);
+      const bool pass = (k != ModEngine::K_DEFAULT) || sideband <= MAX_SIDEBAND_DBC;
+      ok &= pass;
+
+      printf("%-8s %5.0f Hz  K %2d  error %6.1f dB  sideband %6.1f dBc at %5.0f Hz  %6.1f ns/sample%s\n",
+             C::name(), hz, k, db(eRms / refRms), sideband, spur * (double)FS / FFT_N, ns,
+             pass ? "" : "  OVER");
+    }
+  }
+  return ok;
+}
+
+int main() {
+  bool ok = true;
+  ok &= runCase<LeslieCase>();
+  ok &= runCase<FlangerCase>();
+  ok &= runCase<TremoloCase>();
+
+  printf("%s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
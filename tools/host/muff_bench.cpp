@@ -0,0 +1,49 @@
+// **************************
+// muff_bench
+// *****************
+// BigMuffEffect::benchmark on the host: block time of the classic and
+// circuit models against the 128 sample deadline, and the clipper
+// table's error against the exact diode solution. --slowdown X divides
+// the budget by X as a stand-in for the slower core; build the firmware
+// with -DMUFF_BENCH for cycles from the pedal itself.
+//
+//   muff_bench [--slowdown X]
+//
+// Build from the repo root:
+//
+//   g++ -O2 -std=gnu++17 -Itools/host/shim
+//       $(for d in lib/*/; do printf -- "-I%s " "$d"; done)
+//       tools/host/muff_bench.cpp tools/host/shim/HostShim.cpp lib/*/*.cpp
+//       -lpthread -o muff_bench
+#include <Arduino.h>
+#include <Audio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "BigMuffEffect.h"
+
+static uint32_t ticksNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec);
+}
+
+int main(int argc, char** argv) {
+  double slowdown = 1.0;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--slowdown") && i + 1 < argc) {
+      slowdown = atof(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: muff_bench [--slowdown X]\n");
+      return 2;
+    }
+  }
+  if (!(slowdown > 0.0)) slowdown = 1.0;
+
+  const double blockNs = 1e9 * AUDIO_BLOCK_SAMPLES / AUDIO_SAMPLE_RATE_EXACT;
+  const uint32_t budget = (uint32_t)(blockNs / slowdown);
+  printf("budget %u ns per block (%.0f ns / %.3g)\n", (unsigned)budget, blockNs, slowdown);
+
+  HostShim::serialOut = stdout;
+  BigMuffEffect::benchmark(Serial, ticksNs, budget);
+  return 0;
+}
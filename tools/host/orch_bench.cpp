@@ -0,0 +1,156 @@
+// **************************
+// orch_bench
+// *****************
+// Orchestra's half-rate wet path (ORCH_HALF_RATE, OrchestraEffectT<2>)
+// against the full-rate one the pedal ships (OrchestraEffectT<1>). Both
+// render the same plucked chord and its tail through the shared input
+// analysis, whatever ORCH_HALF_RATE is set to.
+//
+//   cost   sizeof and mean host us per 128-sample block
+//   tail   band levels of the tail, TAIL_FROM_S..TAIL_TO_S, averaged
+//          Hann windowed FFT frames, and half rate minus full rate
+//
+// The wet path ends in two one-pole low-passes (wet smoothing, ~740 Hz,
+// and the output filter, ~590 Hz); bands that end at or below
+// PASS_HZ have to match within MAX_DIFF_DB. Bands above are printed
+// for reference: there the comb lengths, which can only be halved to
+// the nearest sample, set where the modes fall.
+//
+//   orch_bench
+//
+// Exit status is non-zero if a band below PASS_HZ differs by more;
+// ORCH_HALF_RATE stays off by default until it passes.
+//
+// Build from the repo root:
+//
+//   g++ -O2 -std=gnu++17 -Itools/host/shim
+//       $(for d in lib/*/; do printf -- "-I%s " "$d"; done)
+//       tools/host/orch_bench.cpp tools/host/shim/HostShim.cpp lib/*/*.cpp
+//       -lpthread -o orch_bench
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include "BlockAnalysis.h"
+#include "OrchestraEffect.h"
+#include "Stft.h"
+
+static constexpr int    BLOCK = 128;
+static constexpr float  FS    = 44100.0f;
+static constexpr int    FFT_N = 4096;
+static constexpr double CLIP_S      = 6.0;
+static constexpr double TAIL_FROM_S = 2.0;
+static constexpr double TAIL_TO_S   = 5.0;
+static constexpr double PASS_HZ     = 700.0;
+static constexpr double MAX_DIFF_DB = 1.0;
+
+static const double EDGES[] = { 50, 100, 200, 400, 700, 1000, 1500, 2000, 3000, 5000, 8000 };
+static constexpr int BAND_COUNT = sizeof(EDGES) / sizeof(EDGES[0]) - 1;
+
+using FullRate = OrchestraEffectT<1>;
+using HalfRate = OrchestraEffectT<2>;
+
+// **************************
+// Clip
+// *****************
+// 1 s of a plucked open A chord, then silence
+static std::vector<int16_t> makeClip() {
+  static const double notes[] = { 110.0, 164.81, 220.0, 277.18, 329.63 };
+  const int n = (int)(CLIP_S * FS) / BLOCK * BLOCK;
+  std::vector<int16_t> x(n, 0);
+  for (int i = 0; i < (int)FS; i++) {
+    const double t = i / (double)FS;
+    double y = 0.0;
+    for (double f : notes) {
+      for (int k = 1; k <= 6; k++) y += exp(-t * (1.5 + k)) * sin(2.0 * M_PI * k * f * t) / k;
+    }
+    x[i] = (int16_t)lrint(4000.0 * y);
+  }
+  return x;
+}
+
+// **************************
+// Render
+// *****************
+// pedal defaults for the mode's knobs at noon
+template <class Fx>
+static typename Fx::Params params() {
+  typename Fx::Params p;
+  p.mix   = 0.5f;
+  p.size  = 0.85f;
+  p.up    = 0.5f;
+  p.down  = 0.375f;
+  p.swell = 0.5f;
+  p.tone  = 0.55f;
+  return p;
+}
+
+template <class Fx>
+static std::vector<int16_t> render(Fx& fx, const std::vector<int16_t>& x, double& usPerBlock) {
+  InputAnalyzer an;
+  an.setSampleRate(FS, BLOCK);
+  an.reset();
+  fx.reset();
+
+  const typename Fx::Params p = params<Fx>();
+  std::vector<int16_t> y(x.size());
+  double s = 0.0;
+  for (size_t at = 0; at + BLOCK <= x.size(); at += BLOCK) {
+    const BlockAnalysis& a = an.process(&x[at], BLOCK);
+    const auto t0 = std::chrono::steady_clock::now();
+    fx.processMono(&x[at], &y[at], BLOCK, FS, p, a);
+    s += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  }
+  usPerBlock = 1e6 * s / (double)(x.size() / BLOCK);
+  return y;
+}
+
+// **************************
+// Tail
+// *****************
+// power per band, half overlapped Hann frames over the tail window
+static std::vector<double> bands(const std::vector<int16_t>& y) {
+  static float f[FFT_N];
+  std::vector<double> pw(BAND_COUNT, 0.0);
+  const double binHz = FS / (double)FFT_N;
+
+  for (size_t at = (size_t)(TAIL_FROM_S * FS); at + FFT_N <= (size_t)(TAIL_TO_S * FS); at += FFT_N / 2) {
+    for (int i = 0; i < FFT_N; i++) f[i] = (float)((0.5 - 0.5 * cos(2.0 * M_PI * i / FFT_N)) * y[at + i]);
+    Stft::RealFft<FFT_N>::forward(f);
+
+    for (int b = 0; b < BAND_COUNT; b++) {
+      for (int k = (int)ceil(EDGES[b] / binHz); k * binHz < EDGES[b + 1]; k++) {
+        pw[b] += (double)f[2 * k] * f[2 * k] + (double)f[2 * k + 1] * f[2 * k + 1];
+      }
+    }
+  }
+  for (double& p : pw) p = 10.0 * log10(fmax(p, 1e-30));
+  return pw;
+}
+
+int main() {
+  static FullRate full;
+  static HalfRate half;
+  const std::vector<int16_t> clip = makeClip();
+
+  double usFull = 0.0, usHalf = 0.0;
+  const std::vector<double> a = bands(render(full, clip, usFull));
+  const std::vector<double> b = bands(render(half, clip, usHalf));
+
+  printf("cost   full rate %7zu bytes %6.1f us/block   half rate %7zu bytes %6.1f us/block\n",
+         sizeof(FullRate), usFull, sizeof(HalfRate), usHalf);
+
+  bool ok = true;
+  for (int k = 0; k < BAND_COUNT; k++) {
+    const double d = b[k] - a[k];
+    const bool checked = EDGES[k + 1] <= PASS_HZ;
+    const bool pass = !checked || fabs(d) <= MAX_DIFF_DB;
+    ok &= pass;
+    printf("tail   %5.0f-%5.0f Hz  full %6.1f dB  half %6.1f dB  diff %+5.2f dB%s\n", EDGES[k], EDGES[k + 1],
+           a[k], b[k], d, checked ? (pass ? "  ok" : "  OVER") : "");
+  }
+
+  printf("%s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+// **************************
+// Pedal on the host
+// *****************
+// The firmware itself (src/main.cpp, statics and all) driven one audio
+// block at a time through the shims. Include from exactly one .cpp per
+// tool, with tools/host/shim first on the include path.
+#include "../../src/main.cpp"
+
+namespace Pedal {
+
+static constexpr int BLOCK = AUDIO_BLOCK_SAMPLES;
+static constexpr float FS  = AUDIO_SAMPLE_RATE_EXACT;
+
+// knob order as the firmware reads it: vol, k2, k3, k4, k5
+struct Knobs5 { float v[5]; };
+
+inline void setKnobs(const Knobs5& k, bool snap = true) {
+  // readPot01Flipped() turns the reading around
+  static const int pins[5] = { POT5_PIN, POT4_PIN, POT3_PIN, POT2_PIN, POT1_PIN };
+  for (int i = 0; i < 5; i++) HostShim::setAnalog01(pins[i], 1.0f - k.v[i]);
+
+  // skip the pot smoothing so the first block already has the setting
+  if (snap) {
+    s1 = k.v[0]; s2 = k.v[1]; s3 = k.v[2]; s4 = k.v[3]; s5 = k.v[4];
+  }
+}
+
+inline void setMode(int m) {
+  mode = (Mode)(m % MODE_COUNT);
+  applyModeLED();
+  resetAllStates();
+}
+
+inline int modeCount() { return MODE_COUNT; }
+
+inline void begin(int m, const Knobs5& k) {
+  setup();
+  setKnobs(k);
+  setMode(m);
+}
+
+// one block through FxStream, false if nothing came out
+inline bool process(const int16_t* in, int16_t* out) {
+  HostAudio::setInput(in);
+  fx.update();
+  HostAudio::setInput(nullptr);
+  return HostAudio::takeOutput(out);
+}
+
+// "0.5,0.5,0.5,0.5,0.5" -> knobs, missing ones keep their value
+inline bool parseKnobs(const char* s, Knobs5& k) {
+  for (int i = 0; i < 5 && *s; i++) {
+    char* end = nullptr;
+    float v = strtof(s, &end);
+    if (end == s) return false;
+    k.v[i] = v;
+    s = (*end == ',') ? end + 1 : end;
+  }
+  return true;
+}
+
+} // namespace Pedal
@@ -0,0 +1,274 @@
+// **************************
+// polyoct_bench
+// *****************
+// lib/PolyOctaveEffect on the host: what the band count costs, how clean
+// the sub comes out on chords, and the half angle on the negative real
+// axis.
+//
+//   cost    us per 128-sample block and ns per band-sample for 16, 32
+//           (the pedal, POLY_OCT_BANDS), 48 and 64 bands
+//   chords  wet only, on synthetic 4-harmonic notes and open chords.
+//           On-grid is the output power within GRID_BINS of a harmonic
+//           of some played note's octave down (k * f0 / 2) over the
+//           total. Weakest sub is the quietest note's f0 / 2 against the
+//           loudest: every note in the chord should get its own. The
+//           mono tracker (OctaveEffect, down only) is printed next to it
+//           for scale.
+//   axis    PolyOctaveEffect::halfAngle on a z walking round the unit
+//           circle both ways, landing exactly on the negative real axis
+//           (where z + |z| is zero) every half turn. Its output has to
+//           stay on one branch of cos(theta / 2) within MAX_AXIS_ERR; a
+//           band that loses its root there flips sign from then on.
+//
+//   polyoct_bench
+//
+// Exit status is non-zero if the axis check fails.
+//
+// Build from the repo root:
+//
+//   g++ -O2 -std=gnu++17 -Itools/host/shim
+//       $(for d in lib/*/; do printf -- "-I%s " "$d"; done)
+//       tools/host/polyoct_bench.cpp tools/host/shim/HostShim.cpp lib/*/*.cpp
+//       -lpthread -o polyoct_bench
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include "BlockAnalysis.h"
+#include "OctaveEffect.h"
+#include "PolyOctaveEffect.h"
+#include "Stft.h"
+
+static constexpr int    BLOCK = 128;
+static constexpr float  FS    = 44100.0f;
+static constexpr int    FFT_N = 8192;
+static constexpr int    REPS  = 5;
+static constexpr int    GRID_BINS = 1; // +-5.4 Hz
+static constexpr double MAX_AXIS_ERR = 1.0e-5;
+
+static const int BANDS[] = { 16, 32, 48, 64 };
+
+// **************************
+// Clips
+// *****************
+struct Chord {
+  const char* name;
+  double hz[6];
+  int notes;
+};
+
+static const Chord CHORDS[] = {
+  { "A3 note", { 220.0 }, 1 },
+  { "E major", { 82.41, 123.47, 164.81, 207.65, 246.94, 329.63 }, 6 },
+  { "A major", { 110.0, 164.81, 220.0, 277.18, 329.63 }, 5 },
+  { "G major", { 98.0, 123.47, 146.83, 196.0, 246.94, 392.0 }, 6 },
+};
+
+// 4 harmonics per note, steady, 1.5 s
+static std::vector<int16_t> chordClip(const Chord& c) {
+  const int n = (int)(1.5 * FS) / BLOCK * BLOCK;
+  std::vector<int16_t> x(n);
+  const double amp = 12000.0 / c.notes;
+  for (int i = 0; i < n; i++) {
+    const double t = i / (double)FS;
+    double y = 0.0;
+    for (int v = 0; v < c.notes; v++) {
+      for (int k = 1; k <= 4; k++) y += sin(2.0 * M_PI * k * c.hz[v] * t) / k;
+    }
+    x[i] = (int16_t)lrint(amp * y);
+  }
+  return x;
+}
+
+// gate open, for timing without the analyzer
+static BlockAnalysis playing() {
+  BlockAnalysis a;
+  a.gate = true;
+  return a;
+}
+
+// each block through the shared input analysis first, as main does
+template <class Fx, class P>
+static std::vector<int16_t> render(Fx& fx, const P& p, std::vector<int16_t> x) {
+  InputAnalyzer an;
+  an.setSampleRate(FS, BLOCK);
+  an.reset();
+  for (size_t at = 0; at + BLOCK <= x.size(); at += BLOCK) {
+    const BlockAnalysis& a = an.process(&x[at], BLOCK);
+    fx.processMono(&x[at], &x[at], BLOCK, FS, p, a);
+  }
+  return x;
+}
+
+// wet only, mode defaults otherwise
+static PolyOctaveEffect::Params wetParams() {
+  PolyOctaveEffect::Params p;
+  p.blend = 1.0f;
+  p.focus = 0.5f;
+  p.tone  = 0.5f;
+  return p;
+}
+
+static std::vector<int16_t> renderPoly(PolyOctaveEffect& fx, int bands, const std::vector<int16_t>& x) {
+  fx.setBands(bands);
+  fx.reset();
+  return render(fx, wetParams(), x);
+}
+
+// **************************
+// Cost
+// *****************
+static void cost(PolyOctaveEffect& fx) {
+  const std::vector<int16_t> clip = chordClip(CHORDS[1]);
+  const BlockAnalysis a = playing();
+  const PolyOctaveEffect::Params p = wetParams();
+  const size_t blocks = clip.size() / BLOCK;
+
+  for (int bands : BANDS) {
+    fx.setBands(bands);
+    fx.reset();
+    std::vector<int16_t> y(clip.size());
+    double best = 1e30;
+    for (int r = 0; r < REPS; r++) {
+      y = clip;
+      const auto t0 = std::chrono::steady_clock::now();
+      for (size_t at = 0; at + BLOCK <= y.size(); at += BLOCK) fx.processMono(&y[at], &y[at], BLOCK, FS, p, a);
+      best = fmin(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+    }
+    const double us = 1e6 * best / (double)blocks;
+    printf("cost   %2d bands  %6.1f us/block  %5.2f ns/band-sample\n", bands, us,
+           1e3 * us / ((double)bands * BLOCK));
+  }
+}
+
+// **************************
+// Chords
+// *****************
+// power spectrum of the output after the first 0.5 s, Hann windowed
+static std::vector<double> power(const std::vector<int16_t>& y) {
+  static float f[FFT_N];
+  const size_t from = (size_t)(0.5 * FS);
+  for (int i = 0; i < FFT_N; i++) {
+    const double w = 0.5 - 0.5 * cos(2.0 * M_PI * i / FFT_N);
+    f[i] = (float)(w * y[from + i]);
+  }
+  Stft::RealFft<FFT_N>::forward(f);
+
+  std::vector<double> pw(FFT_N / 2);
+  for (int b = 1; b < FFT_N / 2; b++) pw[b] = (double)f[2 * b] * f[2 * b] + (double)f[2 * b + 1] * f[2 * b + 1];
+  return pw;
+}
+
+static constexpr double BIN_HZ = FS / (double)FFT_N;
+
+static double around(const std::vector<double>& pw, double hz) {
+  const int b = (int)lrint(hz / BIN_HZ);
+  double s = 0.0;
+  for (int i = b - GRID_BINS; i <= b + GRID_BINS; i++) {
+    if (i > 0 && i < (int)pw.size()) s += pw[i];
+  }
+  return s;
+}
+
+struct Quality {
+  double grid;    // share of the power on some k * f0 / 2
+  double weakest; // quietest note's sub against the loudest, dB
+};
+
+static Quality quality(const std::vector<int16_t>& y, const Chord& c) {
+  const std::vector<double> pw = power(y);
+
+  double total = 0.0, grid = 0.0;
+  for (int b = 3; b < (int)pw.size(); b++) {
+    total += pw[b];
+    bool near = false;
+    for (int v = 0; v < c.notes && !near; v++) {
+      const double sub = 0.5 * c.hz[v];
+      const double k = round(b * BIN_HZ / sub);
+      near = (k >= 1.0) && fabs(b * BIN_HZ - k * sub) <= GRID_BINS * BIN_HZ;
+    }
+    if (near) grid += pw[b];
+  }
+
+  double lo = 1e300, hi = 0.0;
+  for (int v = 0; v < c.notes; v++) {
+    const double p = around(pw, 0.5 * c.hz[v]);
+    lo = fmin(lo, p);
+    hi = fmax(hi, p);
+  }
+
+  Quality q;
+  q.grid = (total > 0.0) ? grid / total : 0.0;
+  q.weakest = 10.0 * log10(fmax(lo, 1e-30) / fmax(hi, 1e-30));
+  return q;
+}
+
+static void chords(PolyOctaveEffect& poly) {
+  printf("chords on-grid / weakest sub ");
+  for (int bands : BANDS) printf("  %2d bands      ", bands);
+  printf("  mono tracker\n");
+
+  static OctaveEffect mono;
+  for (const Chord& c : CHORDS) {
+    const std::vector<int16_t> x = chordClip(c);
+    printf("chords %-22s", c.name);
+    for (int bands : BANDS) {
+      const Quality q = quality(renderPoly(poly, bands, x), c);
+      printf("  %5.1f%% %6.1f dB", 100.0 * q.grid, q.weakest);
+    }
+
+    OctaveEffect::Params p;
+    p.blend = 1.0f;
+    p.mix   = 0.0f; // down only
+    p.tracking = 0.5f;
+    mono.reset();
+    const Quality q = quality(render(mono, p, x), c);
+    printf("  %5.1f%% %6.1f dB\n", 100.0 * q.grid, q.weakest);
+  }
+}
+
+// **************************
+// Axis
+// *****************
+// z walks the unit circle one way or the other and lands exactly on -1
+// every half turn; the sub has to follow cos(theta / 2) on one branch
+// all the way round
+static bool axisCase(int stepsPerTurn, int dir) {
+  const double w = dir * 2.0 * M_PI / stepsPerTurn;
+  float hr = 0.0f, hi = 0.0f;
+  double worst = 0.0;
+  for (int n = 0; n <= 3 * stepsPerTurn; n++) {
+    const double th = n * w;
+    float zr = (float)cos(th), zi = (float)sin(th);
+    if (n % stepsPerTurn == stepsPerTurn / 2) { zr = -1.0f; zi = 0.0f; }
+
+    const float y = PolyOctaveEffect::halfAngle(zr, zi, hr, hi);
+    worst = fmax(worst, fabs((double)y - cos(0.5 * th)));
+  }
+  const bool ok = worst < MAX_AXIS_ERR;
+  printf("axis   %3d steps per turn, %s  worst error %.2e  %s\n", stepsPerTurn,
+         dir > 0 ? "counterclockwise" : "clockwise       ", worst, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+static bool axis() {
+  bool ok = true;
+  for (int steps : { 8, 64, 1024 }) {
+    ok &= axisCase(steps, 1);
+    ok &= axisCase(steps, -1);
+  }
+  return ok;
+}
+
+int main() {
+  static PolyOctaveEffect poly;
+  poly.prepare(FS, BLOCK);
+
+  cost(poly);
+  chords(poly);
+  const bool ok = axis();
+
+  printf("%s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
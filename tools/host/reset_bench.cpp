@@ -0,0 +1,199 @@
+// **************************
+// reset_bench
+// *****************
+// Cost of constructing and resetting the effects with delay lines, and
+// a check that a reset line really sounds like a zeroed one.
+//
+// For each effect the same test clip (plucked chords, a few seconds of
+// silence so the tails park and idle, chords again) is rendered three
+// ways through FxBase::run():
+//   fresh    constructed in zeroed memory
+//   reset    after noise filled every line
+//   garbage  constructed in memory filled with junk
+// each after prepare(), the params and reset(), as main.cpp does.
+// All three must match sample for sample. The output hash is printed
+// too, so builds can be compared with each other.
+//
+//   reset_bench
+//
+// Build from the repo root:
+//
+//   g++ -O2 -std=gnu++17 -Itools/host/shim
+//       $(for d in lib/*/; do printf -- "-I%s " "$d"; done)
+//       tools/host/reset_bench.cpp tools/host/shim/HostShim.cpp lib/*/*.cpp
+//       -lpthread -o reset_bench
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <new>
+#include <random>
+#include <vector>
+#include "BlockAnalysis.h"
+#include "LeslieEffect.h"
+#include "OrchestraEffect.h"
+#include "SimpleEffects.h"
+#include "TapeEchoEffect.h"
+
+using namespace SimpleFX;
+
+static constexpr int   BLOCK = 128;
+static constexpr float FS    = 44100.0f;
+static constexpr int   REPS  = 20;
+
+// **************************
+// Test clip
+// *****************
+static std::vector<int16_t> makeClip() {
+  std::vector<int16_t> x;
+  const double notes[2][3] = { { 110.0, 164.8, 220.0 }, { 146.8, 220.0, 293.7 } };
+  for (int part = 0; part < 3; part++) {
+    if (part == 1) {
+      x.insert(x.end(), (size_t)(3.5 * FS), 0); // long enough for every tail
+      continue;
+    }
+    const int n = (int)(2.0 * FS);
+    for (int i = 0; i < n; i++) {
+      const double t = i / (double)FS;
+      double y = 0.0;
+      for (double f : notes[part / 2]) {
+        for (int k = 1; k <= 6; k++) y += exp(-t * (1.5 + k)) * sin(2.0 * M_PI * k * f * t) / k;
+      }
+      x.push_back((int16_t)lrint(6000.0 * y));
+    }
+  }
+  return x;
+}
+
+static uint64_t fnv(const std::vector<int16_t>& y) {
+  uint64_t h = 1469598103934665603ull;
+  for (int16_t v : y) {
+    h ^= (uint16_t)v;
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+// **************************
+// One effect
+// *****************
+template <class Fx>
+static std::vector<int16_t> render(Fx& fx, const std::vector<int16_t>& x) {
+  InputAnalyzer an;
+  an.setSampleRate(FS, BLOCK);
+  an.reset();
+
+  std::vector<int16_t> y(x);
+  for (size_t at = 0; at + BLOCK <= y.size(); at += BLOCK) {
+    const BlockAnalysis& a = an.process(&y[at], BLOCK);
+    bool silent = a.silent;
+    fx.run(&y[at], BLOCK, a, silent);
+  }
+  return y;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+template <class Fx, class Setup>
+static bool check(const char* name, const std::vector<int16_t>& clip, Setup setup) {
+  void* mem = ::operator new(sizeof(Fx));
+
+  // construction, best of REPS
+  double ctor = 1e30;
+  for (int r = 0; r < REPS; r++) {
+    memset(mem, 0, sizeof(Fx));
+    auto t0 = std::chrono::steady_clock::now();
+    Fx* fx = new (mem) Fx();
+    ctor = std::min(ctor, secondsSince(t0));
+    fx->~Fx();
+  }
+
+  // fresh
+  memset(mem, 0, sizeof(Fx));
+  Fx* fx = new (mem) Fx();
+  fx->prepare(FS, BLOCK);
+  setup(*fx);
+  fx->reset();
+  const std::vector<int16_t> fresh = render(*fx, clip);
+
+  // dirty every line, then reset
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> noise(-20000, 20000);
+  std::vector<int16_t> junk((size_t)(2.0 * FS));
+  for (int16_t& v : junk) v = (int16_t)noise(rng);
+  render(*fx, junk);
+
+  double rst = 1e30;
+  for (int r = 0; r < REPS; r++) {
+    auto t0 = std::chrono::steady_clock::now();
+    fx->reset();
+    rst = std::min(rst, secondsSince(t0));
+  }
+  const std::vector<int16_t> afterReset = render(*fx, clip);
+  fx->~Fx();
+
+  // constructed over junk
+  memset(mem, 0xA5, sizeof(Fx));
+  fx = new (mem) Fx();
+  fx->prepare(FS, BLOCK);
+  setup(*fx);
+  fx->reset();
+  const std::vector<int16_t> overJunk = render(*fx, clip);
+  const size_t bytes = fx->memoryBytes();
+  fx->~Fx();
+  ::operator delete(mem);
+
+  const bool same = (afterReset == fresh) && (overJunk == fresh);
+  printf("%-10s %7zu bytes  ctor %8.2f us  reset %8.2f us  hash %016llx  %s\n", name, bytes,
+         ctor * 1e6, rst * 1e6, (unsigned long long)fnv(fresh), same ? "same" : "DIFFERENT");
+  return same;
+}
+
+int main() {
+  const std::vector<int16_t> clip = makeClip();
+  bool ok = true;
+
+  ok &= check<OrchestraEffect>("orchestra", clip, [](OrchestraEffect& fx) {
+    OrchestraEffect::Params p;
+    p.mix = 0.8f;
+    p.size = 0.9f;
+    fx.setParams(p);
+  });
+  ok &= check<LeslieEffect>("leslie", clip, [](LeslieEffect& fx) {
+    LeslieEffect::Params p;
+    p.blend = 0.8f;
+    p.speed = 0.7f;
+    p.depth = 0.8f;
+    p.ramp  = 0.5f;
+    fx.setParams(p);
+  });
+  ok &= check<TapeEchoEffect>("echo", clip, [](TapeEchoEffect& fx) {
+    TapeEchoEffect::Params p;
+    p.mix = 0.6f;
+    p.time = 0.3f;
+    p.feedback = 0.7f;
+    p.tone = 0.5f;
+    fx.setParams(p);
+  });
+  ok &= check<TapeEchoEffect>("echo pcm12", clip, [](TapeEchoEffect& fx) {
+    fx.setFormat(TapeEchoEffect::PCM12);
+    TapeEchoEffect::Params p;
+    p.mix = 0.6f;
+    p.time = 0.3f;
+    p.feedback = 0.7f;
+    p.tone = 0.5f;
+    fx.setParams(p);
+  });
+  ok &= check<Flanger>("flanger", clip, [](Flanger& fx) {
+    fx.setParams(2.0f, 1.5f, 0.4f, 0.7f, 0.6f);
+  });
+  ok &= check<Chorus>("chorus", clip, [](Chorus& fx) {
+    fx.setVoices(4);
+    fx.setParams(12.0f, 4.0f, 0.5f, 0.5f);
+  });
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <stdio.h>
+
+// **************************
+// Host shim: Teensy core
+// *****************
+// Just enough of the Arduino / Teensy 4 core for src/main.cpp and the
+// libs to build and run on a PC. Pins, time and Serial are plain state
+// the host tools drive (see HostShim below).
+#define DMAMEM
+#define PROGMEM
+#define F_CPU_ACTUAL 600000000u
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A6 20
+
+#define LOW  0
+#define HIGH 1
+#define INPUT        0
+#define OUTPUT       1
+#define INPUT_PULLUP 2
+
+namespace HostShim {
+static constexpr int PINS = 64;
+
+extern int      analogPins[PINS];  // raw ADC reading per pin
+extern int      digitalPins[PINS]; // HIGH by default (buttons pulled up)
+extern int      adcBits;
+extern uint32_t nowMs;             // millis(), moved by delay() or the tool
+extern bool     realTime;          // millis() / delay() follow the wall clock
+extern FILE*    serialOut;         // Serial goes here, nullptr drops it
+
+// knob position as the pot would read it (0..1 of full scale)
+void setAnalog01(int pin, float v01);
+}
+
+void     pinMode(int pin, int mode);
+int      digitalRead(int pin);
+void     analogWrite(int pin, int value);
+int      analogRead(int pin);
+void     analogReadResolution(int bits);
+uint32_t millis();
+void     delay(uint32_t ms);
+
+// **************************
+// Print / Serial
+// *****************
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t b) { return write(&b, 1); }
+  virtual size_t write(const uint8_t* buf, size_t n) = 0;
+
+  size_t print(const char* s)          { return write((const uint8_t*)s, strlen(s)); }
+  size_t print(int v)                  { return printf_("%d", v); }
+  size_t print(unsigned v)             { return printf_("%u", v); }
+  size_t print(long v)                 { return printf_("%ld", v); }
+  size_t print(unsigned long v)        { return printf_("%lu", v); }
+  size_t print(double v, int digits = 2) { return printf_("%.*f", digits, v); }
+
+  size_t println()                     { return print("\n"); }
+  template <class T> size_t println(T v) { size_t n = print(v); return n + println(); }
+  size_t println(double v, int digits) { size_t n = print(v, digits); return n + println(); }
+
+private:
+  template <class T> size_t printf_(const char* fmt, T v) {
+    char buf[48];
+    int n = snprintf(buf, sizeof(buf), fmt, v);
+    return write((const uint8_t*)buf, (size_t)n);
+  }
+  template <class T> size_t printf_(const char* fmt, int a, T v) {
+    char buf[64];
+    int n = snprintf(buf, sizeof(buf), fmt, a, v);
+    return write((const uint8_t*)buf, (size_t)n);
+  }
+};
+
+// USB serial -> stderr (or HostShim::serialOut)
+class HostSerial : public Print {
+public:
+  using Print::write;
+  size_t write(const uint8_t* buf, size_t n) override {
+    return HostShim::serialOut ? fwrite(buf, 1, n, HostShim::serialOut) : n;
+  }
+  void begin(unsigned long) {}
+  explicit operator bool() const { return true; }
+};
+
+extern HostSerial Serial;
@@ -0,0 +1,77 @@
+#pragma once
+#include <Arduino.h>
+
+// **************************
+// Host shim: Teensy Audio Library
+// *****************
+// One in-place stream under test. The tool hands an input block to
+// HostAudio, calls update(), and picks up whatever got transmitted.
+// I2S objects, connections and the codec are inert.
+#define AUDIO_BLOCK_SAMPLES     128
+#define AUDIO_SAMPLE_RATE_EXACT 44117.64706f
+
+#define AUDIO_INPUT_LINEIN 0
+#define AUDIO_INPUT_MIC    1
+
+typedef struct audio_block_struct {
+  uint8_t  ref_count;
+  uint8_t  reserved1;
+  uint16_t memory_pool_index;
+  int16_t  data[AUDIO_BLOCK_SAMPLES];
+} audio_block_t;
+
+class AudioStream {
+public:
+  AudioStream(unsigned char ninput, audio_block_t** iqueue) { (void)ninput; (void)iqueue; }
+  virtual ~AudioStream() {}
+  virtual void update() = 0;
+
+protected:
+  static audio_block_t* allocate();
+  static void release(audio_block_t* block);
+
+  audio_block_t* receiveReadOnly(unsigned int index = 0);
+  audio_block_t* receiveWritable(unsigned int index = 0);
+  void transmit(audio_block_t* block, unsigned char index = 0);
+};
+
+namespace HostAudio {
+// next block every receive*() gets (nullptr = nothing arrives)
+void setInput(const int16_t* in);
+
+// copy of the block transmitted on output 0 since the last call,
+// false (and zeros) if nothing was sent
+bool takeOutput(int16_t* out);
+
+void setPoolBlocks(int n);
+int  blocksInUseMax();
+}
+
+void     AudioMemory(int blocks);
+uint16_t AudioMemoryUsageMax();
+
+class AudioInputI2S : public AudioStream {
+public:
+  AudioInputI2S() : AudioStream(0, nullptr) {}
+  void update() override {}
+};
+
+class AudioOutputI2S : public AudioStream {
+public:
+  AudioOutputI2S() : AudioStream(2, nullptr) {}
+  void update() override {}
+};
+
+class AudioConnection {
+public:
+  AudioConnection(AudioStream&, unsigned char, AudioStream&, unsigned char) {}
+  AudioConnection(AudioStream&, AudioStream&) {}
+};
+
+class AudioControlSGTL5000 {
+public:
+  bool enable() { return true; }
+  bool volume(float) { return true; }
+  bool inputSelect(int) { return true; }
+  bool lineInLevel(uint8_t) { return true; }
+};
@@ -0,0 +1,130 @@
+#include <Arduino.h>
+#include <Audio.h>
+#include <SD.h>
+
+#include <chrono>
+#include <thread>
+
+// **************************
+// Core
+// *****************
+namespace HostShim {
+int      analogPins[PINS];
+int      digitalPins[PINS];
+int      adcBits = 10;
+uint32_t nowMs   = 0;
+bool     realTime = false;
+FILE*    serialOut = stderr;
+
+void setAnalog01(int pin, float v01) {
+  if (pin < 0 || pin >= PINS) return;
+  if (v01 < 0.0f) v01 = 0.0f;
+  if (v01 > 1.0f) v01 = 1.0f;
+  const int full = (1 << adcBits) - 1;
+  analogPins[pin] = (int)(v01 * (float)full + 0.5f);
+}
+
+static struct Init {
+  Init() { for (int& p : digitalPins) p = HIGH; }
+} init;
+}
+
+void pinMode(int, int) {}
+void analogWrite(int, int) {}
+void analogReadResolution(int bits) { HostShim::adcBits = bits; }
+
+int digitalRead(int pin) {
+  return (pin >= 0 && pin < HostShim::PINS) ? HostShim::digitalPins[pin] : HIGH;
+}
+
+int analogRead(int pin) {
+  return (pin >= 0 && pin < HostShim::PINS) ? HostShim::analogPins[pin] : 0;
+}
+
+static const auto bootTime = std::chrono::steady_clock::now();
+
+uint32_t millis() {
+  if (!HostShim::realTime) return HostShim::nowMs;
+  return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - bootTime).count();
+}
+
+void delay(uint32_t ms) {
+  if (HostShim::realTime) std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  else HostShim::nowMs += ms;
+}
+
+HostSerial Serial;
+SDClass    SD;
+
+// **************************
+// Audio
+// *****************
+namespace HostAudio {
+static constexpr int MAX_POOL = 64;
+
+static audio_block_t pool[MAX_POOL];
+static bool     used[MAX_POOL];
+static int      poolBlocks = MAX_POOL;
+static int      inUse = 0, inUseMax = 0;
+
+static const int16_t* input = nullptr;
+static int16_t        output[AUDIO_BLOCK_SAMPLES];
+static bool           sent = false;
+
+void setInput(const int16_t* in) { input = in; }
+
+bool takeOutput(int16_t* out) {
+  if (!sent) {
+    memset(out, 0, sizeof(output));
+    return false;
+  }
+  memcpy(out, output, sizeof(output));
+  sent = false;
+  return true;
+}
+
+void setPoolBlocks(int n) { poolBlocks = (n < MAX_POOL) ? n : MAX_POOL; }
+int  blocksInUseMax()     { return inUseMax; }
+
+static audio_block_t* allocate() {
+  for (int i = 0; i < poolBlocks; i++) {
+    if (used[i]) continue;
+    used[i] = true;
+    pool[i].ref_count = 1;
+    pool[i].memory_pool_index = (uint16_t)i;
+    if (++inUse > inUseMax) inUseMax = inUse;
+    return &pool[i];
+  }
+  return nullptr;
+}
+
+static void release(audio_block_t* b) {
+  if (!b || --b->ref_count) return;
+  used[b->memory_pool_index] = false;
+  inUse--;
+}
+}
+
+audio_block_t* AudioStream::allocate() { return HostAudio::allocate(); }
+void AudioStream::release(audio_block_t* block) { HostAudio::release(block); }
+
+audio_block_t* AudioStream::receiveWritable(unsigned int index) {
+  if (index != 0 || !HostAudio::input) return nullptr;
+  audio_block_t* b = HostAudio::allocate();
+  if (b) memcpy(b->data, HostAudio::input, sizeof(b->data));
+  return b;
+}
+
+audio_block_t* AudioStream::receiveReadOnly(unsigned int index) {
+  return receiveWritable(index);
+}
+
+void AudioStream::transmit(audio_block_t* block, unsigned char index) {
+  if (index != 0 || !block) return;
+  memcpy(HostAudio::output, block->data, sizeof(HostAudio::output));
+  HostAudio::sent = true;
+}
+
+void     AudioMemory(int blocks) { HostAudio::setPoolBlocks(blocks); }
+uint16_t AudioMemoryUsageMax()   { return (uint16_t)HostAudio::inUseMax; }
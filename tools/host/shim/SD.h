@@ -0,0 +1,32 @@
+#pragma once
+#include <Arduino.h>
+
+// **************************
+// Host shim: SD
+// *****************
+// No card: begin() fails, so the pedal runs as it would with the slot
+// empty (looper stays EMPTY, flight recorder dumps go to Serial).
+// The looper's own host path streams through stdio instead.
+#define FILE_READ        0
+#define FILE_WRITE       1
+#define FILE_WRITE_BEGIN 2
+
+class File : public Print {
+public:
+  using Print::write;
+  size_t write(const uint8_t*, size_t) override { return 0; }
+  explicit operator bool() const { return false; }
+  void close() {}
+  bool seek(uint64_t) { return false; }
+  int  read(void*, size_t) { return -1; }
+};
+
+class SDClass {
+public:
+  bool begin(int) { return false; }
+  bool exists(const char*) { return false; }
+  bool remove(const char*) { return false; }
+  File open(const char*, int = FILE_READ) { return File(); }
+};
+
+extern SDClass SD;
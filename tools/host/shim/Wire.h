@@ -0,0 +1,2 @@
+#pragma once
+// host shim: nothing on the I2C bus
@@ -0,0 +1,173 @@
+// **************************
+// skip_check
+// *****************
+// The idle skip must not be audible. Every mode renders the same clips
+// through the firmware twice, once as on the pedal and once with the
+// skip off (idleSkip = false, what fx_render --no-skip does), from the
+// same reset state, for three knob settings:
+//
+//   gaps   plucked chords, 5 s of digital silence with K3 and K4 moving
+//          halfway through, chords again, 5 s of silence. Has to match
+//          sample for sample: a parked effect fed zeros puts out zeros
+//          and only its free-running state moves, which idle() keeps.
+//   hiss   the same with +-5 LSB of noise on top, under the idle gate.
+//          A parked effect skips those blocks and puts out zeros where
+//          running it would have processed the hiss; reported, not
+//          checked (bypass and the other pass-through modes never park,
+//          so they come out the same).
+//
+// The render time both ways is printed too, so a build whose skip stops
+// firing shows up as on ~ off.
+//
+//   skip_check
+//
+// Exit status is non-zero if a gaps render differs.
+//
+// Build from the repo root:
+//
+//   g++ -O2 -std=gnu++17 -Itools/host/shim
+//       $(for d in lib/*/; do printf -- "-I%s " "$d"; done)
+//       tools/host/skip_check.cpp tools/host/shim/HostShim.cpp lib/*/*.cpp
+//       -lpthread -o skip_check
+#include "pedal.h"
+
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+static constexpr int BLOCK = Pedal::BLOCK;
+
+// **************************
+// Clips
+// *****************
+static void chords(std::vector<int16_t>& x, int which) {
+  static const double notes[2][3] = { { 110.0, 164.8, 220.0 }, { 146.8, 220.0, 293.7 } };
+  const int n = (int)(1.5 * Pedal::FS);
+  for (int i = 0; i < n; i++) {
+    const double t = i / (double)Pedal::FS;
+    double y = 0.0;
+    for (double f : notes[which]) {
+      for (int k = 1; k <= 6; k++) y += exp(-t * (1.5 + k)) * sin(2.0 * M_PI * k * f * t) / k;
+    }
+    x.push_back((int16_t)lrint(6000.0 * y));
+  }
+}
+
+// chords / silence / chords / silence, and where the knob moves
+static std::vector<int16_t> makeGaps(size_t& knobAt) {
+  std::vector<int16_t> x;
+  const size_t gap = (size_t)(5.0 * Pedal::FS);
+  chords(x, 0);
+  knobAt = x.size() + gap / 2;
+  x.insert(x.end(), gap, 0);
+  chords(x, 1);
+  x.insert(x.end(), gap, 0);
+  x.resize(x.size() / BLOCK * BLOCK);
+  return x;
+}
+
+static std::vector<int16_t> addHiss(std::vector<int16_t> x) {
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> hiss(-5, 5);
+  for (int16_t& v : x) v = (int16_t)std::min(32767, std::max(-32768, (int)v + hiss(rng)));
+  return x;
+}
+
+// **************************
+// Render
+// *****************
+// everything update() carries from block to block back to a known state.
+// A mode reset picks up the params of the last block, so one block with
+// these knobs goes through first and the mode is reset again after it.
+static void hardReset(int m, const Pedal::Knobs5& k) {
+  static const int16_t zeros[BLOCK] = {};
+  int16_t out[BLOCK];
+  Pedal::setKnobs(k);
+  Pedal::setMode(m);
+  Pedal::process(zeros, out);
+  Pedal::setMode(m);
+  analyzer.reset();
+  limiter.reset();
+}
+
+static std::vector<int16_t> render(int m, const Pedal::Knobs5& k, const std::vector<int16_t>& x,
+                                   size_t knobAt, bool skip, double& seconds) {
+  hardReset(m, k);
+  idleSkip = skip;
+
+  // K3 and K4 swing across while the input is silent, through the pot
+  // smoothing (K4 is freeze's hold: a press nobody plays through)
+  Pedal::Knobs5 moved = k;
+  moved.v[2] = 1.0f - k.v[2];
+  moved.v[3] = 1.0f - k.v[3];
+
+  std::vector<int16_t> y(x.size(), 0);
+  const auto t0 = std::chrono::steady_clock::now();
+  for (size_t at = 0; at + BLOCK <= x.size(); at += BLOCK) {
+    if (at == knobAt / BLOCK * BLOCK) Pedal::setKnobs(moved, false);
+    Pedal::process(&x[at], &y[at]);
+  }
+  seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  idleSkip = true;
+  return y;
+}
+
+struct Diff {
+  int    maxLsb = 0;
+  size_t blocks = 0; // blocks with any difference
+};
+
+static Diff compare(const std::vector<int16_t>& a, const std::vector<int16_t>& b) {
+  Diff d;
+  for (size_t at = 0; at + BLOCK <= a.size(); at += BLOCK) {
+    bool differs = false;
+    for (int i = 0; i < BLOCK; i++) {
+      const int e = abs((int)a[at + i] - (int)b[at + i]);
+      if (e > d.maxLsb) d.maxLsb = e;
+      if (e) differs = true;
+    }
+    if (differs) d.blocks++;
+  }
+  return d;
+}
+
+int main() {
+  Pedal::Knobs5 knobs = { { 0.8f, 0.5f, 0.5f, 0.5f, 0.5f } };
+  Pedal::begin(MODE_BYPASS, knobs);
+
+  size_t knobAt = 0;
+  const std::vector<int16_t> gaps = makeGaps(knobAt);
+  const std::vector<int16_t> hiss = addHiss(gaps);
+  const size_t blocks = gaps.size() / BLOCK;
+
+  static const Pedal::Knobs5 SETS[3] = {
+    { { 0.8f, 0.5f, 0.5f, 0.5f, 0.5f } },
+    { { 0.8f, 1.0f, 0.2f, 0.9f, 0.1f } },
+    { { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f } },
+  };
+
+  printf("%zu blocks per clip, K3 / K4 move at %.2f s\n", blocks, knobAt / (double)Pedal::FS);
+  bool ok = true;
+  for (int m = 0; m < Pedal::modeCount(); m++) {
+    for (int s = 0; s < 3; s++) {
+      double on = 0.0, off = 0.0, unused = 0.0;
+      const Diff g = compare(render(m, SETS[s], gaps, knobAt, true, on),
+                             render(m, SETS[s], gaps, knobAt, false, off));
+      const Diff h = compare(render(m, SETS[s], hiss, knobAt, true, unused),
+                             render(m, SETS[s], hiss, knobAt, false, unused));
+
+      const bool same = (g.blocks == 0);
+      ok &= same;
+      printf("mode %2d knobs %d  gaps: %s", m, s, same ? "same" : "DIFFERS");
+      if (!same) printf(" (%zu blocks, max %d LSB)", g.blocks, g.maxLsb);
+      printf("  on %5.1f ms / off %5.1f ms   hiss: %zu blocks gated, max %d LSB\n", 1000.0 * on,
+             1000.0 * off, h.blocks, h.maxLsb);
+    }
+  }
+
+  printf("%s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// **************************
+// Spsc
+// *****************
+// Bounded single producer / single consumer queue, lock free: each side
+// owns one index and publishes it with release / acquire. The host
+// render pipeline passes buffer pointers through these, so nothing is
+// allocated once it's running.
+//
+// push() / pop() block: a short spin with yields, then sleeps. The time
+// spent blocked is added to the caller's counter, which is how a stage
+// tells its own work from waiting on its neighbour.
+template <class T, int CAP>
+class Spsc {
+public:
+  static_assert(CAP >= 2 && (CAP & (CAP - 1)) == 0, "CAP a power of two");
+
+  bool tryPush(const T& v) {
+    const uint32_t h = _head.load(std::memory_order_relaxed);
+    if (h - _tail.load(std::memory_order_acquire) == (uint32_t)CAP) return false; // full
+    _slots[h & (CAP - 1)] = v;
+    _head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool tryPop(T& v) {
+    const uint32_t t = _tail.load(std::memory_order_relaxed);
+    if (t == _head.load(std::memory_order_acquire)) return false; // empty
+    v = _slots[t & (CAP - 1)];
+    _tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  void push(const T& v, double& waitS) {
+    if (tryPush(v)) return;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int spin = 0; !tryPush(v); spin++) backoff(spin);
+    waitS += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  }
+
+  void pop(T& v, double& waitS) {
+    if (tryPop(v)) return;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int spin = 0; !tryPop(v); spin++) backoff(spin);
+    waitS += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  }
+
+private:
+  static void backoff(int spin) {
+    if (spin < 64) std::this_thread::yield();
+    else std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+
+  T _slots[CAP];
+  alignas(64) std::atomic<uint32_t> _head{ 0 }; // written by the producer
+  alignas(64) std::atomic<uint32_t> _tail{ 0 }; // written by the consumer
+};
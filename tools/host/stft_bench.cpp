@@ -0,0 +1,180 @@
+// **************************
+// stft_bench
+// *****************
+// lib/Stft and the freeze mode on the host.
+//
+//   cost       Stft::benchmark, the same table the pedal prints with
+//              -DSTFT_BENCH: forward + inverse FFT per size, then the
+//              engine's worst block with the frame spread over its blocks
+//              and run whole in one. --slowdown X divides the budget by X
+//              as a stand-in for the slower core.
+//   identity   the engine with a client that leaves the spectrum alone
+//              has to give back the input LATENCY samples later; fails
+//              past MAX_ERR_LSB. Also the packed RealFft against a plain
+//              DFT.
+//   freeze     a plucked note, hold on during it: the layer has to keep
+//              sounding through 3 s of silence, then fade and park
+//              (isSilent) within 15 s of hold being let go.
+//
+//   stft_bench [--slowdown X]
+//
+// Exit status is non-zero if a check fails.
+//
+// Build from the repo root:
+//
+//   g++ -O2 -std=gnu++17 -Itools/host/shim
+//       $(for d in lib/*/; do printf -- "-I%s " "$d"; done)
+//       tools/host/stft_bench.cpp tools/host/shim/HostShim.cpp
+//       lib/Stft/Stft.cpp lib/FreezeEffect/FreezeEffect.cpp
+//       lib/BlockAnalysis/BlockAnalysis.cpp -o stft_bench
+#include <Arduino.h>
+#include <Audio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <time.h>
+#include <random>
+#include <vector>
+#include "BlockAnalysis.h"
+#include "FreezeEffect.h"
+#include "Stft.h"
+
+static constexpr int    BLOCK = 128;
+static constexpr float  FS    = 44100.0f;
+static constexpr double MAX_ERR_LSB = 0.05;
+
+static uint32_t ticksNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec);
+}
+
+// **************************
+// Identity
+// *****************
+struct Passthrough {
+  void beginFrame() {}
+  void spectrum(float*, int, int) {}
+};
+
+template <int N, int HOP>
+static bool identityCase() {
+  using E = Stft::Engine<N, HOP>;
+  static E e;
+  e.reset();
+  Passthrough c;
+
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> noise(-32768, 32767);
+  std::vector<int16_t> x((size_t)FS);
+  for (int16_t& v : x) v = (int16_t)noise(rng);
+  std::vector<float> y(x.size());
+  for (size_t at = 0; at + BLOCK <= x.size(); at += BLOCK) e.process(&x[at], &y[at], c);
+
+  // skip the first frame, it overlaps the zeros before the clip
+  double worst = 0.0;
+  for (size_t i = E::LATENCY + N; i + BLOCK <= x.size(); i++) {
+    worst = fmax(worst, fabs((double)y[i] * 32768.0 - (double)x[i - E::LATENCY]));
+  }
+
+  // the packed forward transform against a DFT
+  static float f[N];
+  for (int i = 0; i < N; i++) f[i] = (float)x[i] / 32768.0f;
+  Stft::RealFft<N>::forward(f);
+  double dft = 0.0;
+  for (int k = 0; k <= N / 2; k++) {
+    double re = 0.0, im = 0.0;
+    for (int i = 0; i < N; i++) {
+      re += x[i] / 32768.0 * cos(2.0 * M_PI * k * i / N);
+      im -= x[i] / 32768.0 * sin(2.0 * M_PI * k * i / N);
+    }
+    const double gr = (k == 0) ? f[0] : (k == N / 2) ? f[1] : f[2 * k];
+    const double gi = (k == 0 || k == N / 2) ? 0.0 : f[2 * k + 1];
+    dft = fmax(dft, hypot(gr - re, gi - im));
+  }
+
+  const bool ok = worst < MAX_ERR_LSB && dft < 1.0e-3 * sqrt((double)N);
+  printf("identity N=%4d hop=%3d  latency %4d  max error %.4f LSB  dft error %.2e  %s\n", N, HOP,
+         E::LATENCY, worst, dft, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+// **************************
+// Freeze
+// *****************
+static double rmsOf(const std::vector<int16_t>& y, size_t from, size_t to) {
+  double s = 0.0;
+  for (size_t i = from; i < to; i++) s += (double)y[i] * y[i];
+  return sqrt(s / (double)(to - from));
+}
+
+static bool freezeCase(float glide) {
+  static FreezeEffect fx;
+  fx.prepare(FS, BLOCK);
+  fx.reset();
+  InputAnalyzer an;
+  an.setSampleRate(FS, BLOCK);
+  an.reset();
+
+  // 1 s of note, 3 s silence held, 15 s silence released
+  const size_t note = (size_t)FS, held = 4 * (size_t)FS, total = 19 * (size_t)FS;
+  std::vector<int16_t> y(total, 0);
+  for (size_t i = 0; i < note; i++) {
+    const double t = i / (double)FS;
+    double v = 0.0;
+    for (int k = 1; k <= 6; k++) v += exp(-t * (2.0 + k)) * sin(2.0 * M_PI * k * 196.0 * t) / k;
+    y[i] = (int16_t)lrint(12000.0 * v);
+  }
+
+  FreezeEffect::Params p;
+  p.level = 1.0f;
+  p.glide = glide;
+  int parkedAt = -1;
+  for (size_t at = 0; at + BLOCK <= total; at += BLOCK) {
+    p.hold = (at >= (size_t)(0.1 * FS) && at < held);
+    fx.setParams(p);
+    const BlockAnalysis& a = an.process(&y[at], BLOCK);
+    bool silent = a.silent;
+    fx.run(&y[at], BLOCK, a, silent);
+    if (at >= held && parkedAt < 0 && fx.isSilent()) parkedAt = (int)(at - held);
+  }
+
+  const double sustain = rmsOf(y, held - (size_t)FS, held);
+  const double after = rmsOf(y, total - (size_t)FS, total);
+  const bool ok = sustain > 300.0 && after == 0.0 && parkedAt >= 0;
+  printf("freeze glide %.1f  held rms %.0f  after release %.0f  parked %s%.0f ms after release  %s\n",
+         glide, sustain, after, parkedAt >= 0 ? "" : "never ", 1000.0 * fmax(parkedAt, 0) / FS,
+         ok ? "ok" : "FAIL");
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  double slowdown = 1.0;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--slowdown") && i + 1 < argc) {
+      slowdown = atof(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: stft_bench [--slowdown X]\n");
+      return 2;
+    }
+  }
+  if (!(slowdown > 0.0)) slowdown = 1.0;
+
+  const double blockNs = 1e9 * AUDIO_BLOCK_SAMPLES / AUDIO_SAMPLE_RATE_EXACT;
+  const uint32_t budget = (uint32_t)(blockNs / slowdown);
+  printf("budget %u ns per block (%.0f ns / %.3g)\n", (unsigned)budget, blockNs, slowdown);
+
+  HostShim::serialOut = stdout;
+  Stft::benchmark(Serial, ticksNs, budget);
+
+  bool ok = true;
+  ok &= identityCase<256, 128>();
+  ok &= identityCase<512, 256>();
+  ok &= identityCase<1024, 256>();
+  ok &= identityCase<2048, 512>();
+
+  ok &= freezeCase(0.0f);
+  ok &= freezeCase(1.0f);
+
+  printf("%s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,228 @@
+// **************************
+// tuner_test
+// *****************
+// Accuracy, latency and interrupt cost of lib/Tuner.
+//
+// Each note is fed through processBlock() in audio blocks while
+// service() is called on simulated milliseconds, the way loop() does on
+// the pedal. Synthetic notes are plucked strings (decaying harmonics, a
+// noisy attack, a touch of inharmonicity) from E2 to E6 with a random
+// detune; a recorded single note can be checked with --wav.
+//
+//   tuner_test [--seed N] [--wav note.wav --expect HZ]
+//
+// Per note: median error of the steady readings in cents, the worst
+// one, and the time from the pluck to the first reading within 2 cents.
+//
+// Build from the repo root:
+//
+//   g++ -O2 -std=gnu++17 -Itools/host/shim
+//       $(for d in lib/*/; do printf -- "-I%s " "$d"; done)
+//       tools/host/tuner_test.cpp tools/host/shim/HostShim.cpp lib/Tuner/Tuner.cpp
+//       -o tuner_test
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "Tuner.h"
+#include "wav.h"
+
+static constexpr int    BLOCK = 128;
+static constexpr double FS    = 44100.0;
+
+static constexpr float  HIT_CENTS = 2.0f;  // "locked" for the latency figure
+static constexpr double STEADY_FROM = 0.3; // s after the pluck
+static constexpr double STEADY_TO   = 1.5;
+
+// **************************
+// Notes
+// *****************
+static double midiHz(double midi) { return 440.0 * pow(2.0, (midi - 69.0) / 12.0); }
+
+static std::vector<int16_t> pluck(double f0, double seconds, std::mt19937& rng) {
+  std::normal_distribution<double> noise(0.0, 1.0);
+  const int n = (int)(seconds * FS);
+  std::vector<double> y(n, 0.0);
+
+  const double B = 1.0e-4; // string stiffness
+  for (int k = 1; k <= 12; k++) {
+    const double fk = k * f0 * sqrt(1.0 + B * k * k);
+    if (fk > 0.45 * FS) break;
+    const double amp = 1.0 / k;
+    const double tau = 1.2 / (1.0 + 0.35 * k); // upper partials die first
+    const double ph  = 6.283185307 * (double)(rng() % 1000) / 1000.0;
+    for (int i = 0; i < n; i++) {
+      const double t = i / FS;
+      y[i] += amp * exp(-t / tau) * sin(6.283185307 * fk * t + ph);
+    }
+  }
+  // pick noise for the first few ms
+  for (int i = 0; i < (int)(0.006 * FS) && i < n; i++) y[i] += 0.6 * noise(rng) * (1.0 - i / (0.006 * FS));
+
+  double peak = 1e-9;
+  for (double v : y) peak = std::max(peak, fabs(v));
+  std::vector<int16_t> out(n);
+  for (int i = 0; i < n; i++) out[i] = (int16_t)lrint(16000.0 * y[i] / peak + 8.0 * noise(rng));
+  return out;
+}
+
+// **************************
+// Run one note
+// *****************
+struct Result {
+  int    readings = 0;
+  int    wrongNote = 0;
+  float  medianErr = 0.0f; // cents, signed
+  float  worstErr  = 0.0f; // cents, absolute
+  double lockMs    = -1.0; // pluck to first reading within HIT_CENTS
+};
+
+static Result runNote(Tuner& t, const std::vector<int16_t>& x, double trueHz) {
+  t.reset();
+  Tuner::Params p;
+  t.setParams(p);
+
+  const double trueMidi = 69.0 + 12.0 * log2(trueHz / p.refHz);
+  const int    note = (int)floor(trueMidi + 0.5);
+  const float  cents = (float)(100.0 * (trueMidi - note));
+
+  Result r;
+  std::vector<float> errs;
+  int16_t blk[BLOCK];
+  for (size_t at = 0; at + BLOCK <= x.size(); at += BLOCK) {
+    memcpy(blk, &x[at], sizeof(blk));
+    t.processBlock(blk, BLOCK);
+
+    const double s = (double)(at + BLOCK) / FS;
+    if (!t.service((uint32_t)(s * 1000.0))) continue;
+
+    const Tuner::Reading& rd = t.reading();
+    if (!rd.valid) continue;
+    r.readings++;
+    if (rd.note != note) {
+      if (s >= STEADY_FROM && s <= STEADY_TO) r.wrongNote++;
+      continue;
+    }
+    const float e = rd.cents - cents;
+    if (r.lockMs < 0.0 && fabsf(e) <= HIT_CENTS) r.lockMs = s * 1000.0;
+    if (s >= STEADY_FROM && s <= STEADY_TO) errs.push_back(e);
+  }
+
+  if (!errs.empty()) {
+    std::vector<float> srt = errs;
+    std::sort(srt.begin(), srt.end());
+    r.medianErr = srt[srt.size() / 2];
+    for (float e : errs) r.worstErr = std::max(r.worstErr, fabsf(e));
+  }
+  return r;
+}
+
+static void printResult(const char* name, double hz, const Result& r) {
+  printf("%-5s %8.2f Hz  readings %3d  median %+6.2f c  worst %5.2f c  wrong %d  lock ",
+         name, hz, r.readings, (double)r.medianErr, (double)r.worstErr, r.wrongNote);
+  if (r.lockMs < 0.0) printf("never\n");
+  else                printf("%4.0f ms\n", r.lockMs);
+}
+
+// **************************
+// Cost
+// *****************
+static void cost(Tuner& t) {
+  std::mt19937 rng(7);
+  std::vector<int16_t> x = pluck(110.0, 2.0, rng);
+  const int blocks = (int)(x.size() / BLOCK);
+  int16_t blk[BLOCK];
+
+  // interrupt side, against a plain copy of the block (what bypass does)
+  auto timeBlocks = [&](bool tuner) {
+    double best = 1e30;
+    for (int rep = 0; rep < 20; rep++) {
+      auto t0 = std::chrono::steady_clock::now();
+      for (int b = 0; b < blocks; b++) {
+        memcpy(blk, &x[(size_t)b * BLOCK], sizeof(blk));
+        if (tuner) t.processBlock(blk, BLOCK);
+        __asm__ __volatile__("" : : "r"(blk) : "memory");
+      }
+      double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+      best = std::min(best, ns / blocks);
+    }
+    return best;
+  };
+  const double copyNs  = timeBlocks(false);
+  const double tunerNs = timeBlocks(true);
+  const double periodNs = 1.0e9 * BLOCK / FS;
+
+  // loop() side, one analysis
+  std::vector<int16_t> win(Tuner::WINDOW);
+  std::vector<float> scratch(Tuner::WINDOW);
+  for (int i = 0; i < Tuner::WINDOW; i++) win[i] = x[(size_t)i * Tuner::DECIM];
+  double anaNs = 1e30;
+  volatile float sink = 0.0f;
+  for (int rep = 0; rep < 50; rep++) {
+    auto t0 = std::chrono::steady_clock::now();
+    Tuner::Reading rd = Tuner::analyze(win.data(), Tuner::WINDOW, (float)(FS / Tuner::DECIM), 440.0f, scratch.data());
+    anaNs = std::min(anaNs, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count());
+    sink = sink + rd.hz;
+  }
+
+  printf("\ninterrupt: %.0f ns/block copy, %.0f ns/block with the tuner (+%.2f%% of the %.0f us period)\n",
+         copyNs, tunerNs, 100.0 * (tunerNs - copyNs) / periodNs, periodNs / 1000.0);
+  printf("loop():    %.1f us per analysis, every %u ms\n", anaNs / 1000.0, (unsigned)Tuner::INTERVAL_MS);
+}
+
+int main(int argc, char** argv) {
+  uint32_t seed = 1;
+  const char* wavPath = nullptr;
+  double expect = 0.0;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--wav") && i + 1 < argc) {
+      wavPath = argv[++i];
+    } else if (!strcmp(argv[i], "--expect") && i + 1 < argc) {
+      expect = atof(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: tuner_test [--seed N] [--wav note.wav --expect HZ]\n");
+      return 2;
+    }
+  }
+
+  static Tuner t;
+  t.prepare((float)FS, BLOCK);
+
+  if (wavPath) {
+    std::vector<int16_t> x;
+    uint32_t fs = 0;
+    if (!Wav::read(wavPath, x, fs)) {
+      fprintf(stderr, "can't read %s\n", wavPath);
+      return 1;
+    }
+    if (fs != (uint32_t)FS) fprintf(stderr, "warning: %u Hz file, tuner runs at %.0f\n", (unsigned)fs, FS);
+    if (expect <= 0.0) {
+      fprintf(stderr, "--expect HZ is needed with --wav\n");
+      return 2;
+    }
+    printResult("wav", expect, runNote(t, x, expect));
+    return 0;
+  }
+
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> detune(-30.0, 30.0);
+  int fails = 0;
+  for (int midi = 40; midi <= 88; midi += 4) { // E2 .. E6
+    const double hz = midiHz(midi + detune(rng) / 100.0);
+    std::vector<int16_t> x = pluck(hz, 2.0, rng);
+    Result r = runNote(t, x, hz);
+    char name[8];
+    snprintf(name, sizeof(name), "%s%d", Tuner::noteName(midi), midi / 12 - 1);
+    printResult(name, hz, r);
+    if (r.lockMs < 0.0 || r.wrongNote > 0 || fabsf(r.medianErr) > 1.0f) fails++;
+  }
+
+  cost(t);
+  return fails ? 1 : 0;
+}
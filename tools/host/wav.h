@@ -0,0 +1,190 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// **************************
+// WAV
+// *****************
+// 16 bit PCM only. Reading keeps the first channel (the pedal is mono),
+// writing is always mono. read() / write() take the whole file at once,
+// Reader / Writer stream it.
+namespace Wav {
+
+inline uint32_t rd32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+inline uint16_t rd16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+inline void wr32(FILE* f, uint32_t v) { uint8_t b[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) }; fwrite(b, 1, 4, f); }
+inline void wr16(FILE* f, uint16_t v) { uint8_t b[2] = { (uint8_t)v, (uint8_t)(v >> 8) }; fwrite(b, 1, 2, f); }
+
+// **************************
+// Reader
+// *****************
+// Streams the first channel in chunks, for files too long to hold. A
+// data size of 0xffffffff (what Writer leaves past 4 GB, and what some
+// recorders leave when they can't patch the header) reads to the end.
+class Reader {
+public:
+  ~Reader() { close(); }
+
+  bool open(const char* path) {
+    close();
+    _f = fopen(path, "rb");
+    if (!_f) return false;
+    setvbuf(_f, nullptr, _IOFBF, 1 << 20);
+
+    uint8_t hdr[12];
+    if (fread(hdr, 1, 12, _f) != 12 || memcmp(hdr, "RIFF", 4) || memcmp(hdr + 8, "WAVE", 4)) {
+      close();
+      return false;
+    }
+
+    int bits = 0;
+    uint8_t ch[8];
+    while (fread(ch, 1, 8, _f) == 8) {
+      uint32_t len = rd32(ch + 4);
+
+      if (!memcmp(ch, "fmt ", 4)) {
+        uint8_t fmt[16];
+        if (len < 16 || fread(fmt, 1, 16, _f) != 16) break;
+        _channels = rd16(fmt + 2);
+        _fs       = rd32(fmt + 4);
+        bits      = rd16(fmt + 14);
+        fseek(_f, (long)(len - 16 + (len & 1)), SEEK_CUR);
+        continue;
+      }
+
+      if (!memcmp(ch, "data", 4)) {
+        if (_channels < 1 || bits != 16) break;
+        _left = (len == 0xffffffffu) ? UINT64_MAX : len;
+        return true;
+      }
+
+      fseek(_f, (long)(len + (len & 1)), SEEK_CUR);
+    }
+
+    close();
+    return false;
+  }
+
+  // up to frames samples of the first channel, 0 at the end
+  size_t read(int16_t* mono, size_t frames) {
+    if (!_f) return 0;
+    const size_t frameBytes = 2 * (size_t)_channels;
+    if (_left / frameBytes < frames) frames = (size_t)(_left / frameBytes);
+    if (frames == 0) return 0;
+
+    _raw.resize(frames * _channels);
+    const size_t got = fread(_raw.data(), frameBytes, frames, _f);
+    _left -= got * frameBytes;
+    if (got < frames) _left = 0;
+    for (size_t i = 0; i < got; i++) mono[i] = _raw[i * _channels];
+    return got;
+  }
+
+  void close() {
+    if (_f) fclose(_f);
+    _f = nullptr;
+  }
+
+  uint32_t rate() const { return _fs; }
+
+private:
+  FILE*    _f = nullptr;
+  int      _channels = 0;
+  uint32_t _fs = 0;
+  uint64_t _left = 0; // data bytes not read yet
+  std::vector<int16_t> _raw;
+};
+
+// **************************
+// Writer
+// *****************
+// Mono, sizes patched on close(); past 4 GB of data they stay 0xffffffff.
+class Writer {
+public:
+  ~Writer() { close(); }
+
+  bool open(const char* path, uint32_t fs) {
+    close();
+    _f = fopen(path, "wb");
+    if (!_f) return false;
+    setvbuf(_f, nullptr, _IOFBF, 1 << 20);
+    _bytes = 0;
+
+    fwrite("RIFF", 1, 4, _f); wr32(_f, 0xffffffffu); fwrite("WAVE", 1, 4, _f);
+    fwrite("fmt ", 1, 4, _f); wr32(_f, 16);
+    wr16(_f, 1);      // PCM
+    wr16(_f, 1);      // mono
+    wr32(_f, fs);
+    wr32(_f, fs * 2);
+    wr16(_f, 2);
+    wr16(_f, 16);
+    fwrite("data", 1, 4, _f); wr32(_f, 0xffffffffu);
+    return !ferror(_f);
+  }
+
+  bool write(const int16_t* mono, size_t n) {
+    if (!_f) return false;
+    _bytes += fwrite(mono, 2, n, _f) * 2;
+    return !ferror(_f);
+  }
+
+  bool close() {
+    if (!_f) return true;
+    if (_bytes <= 0xffffffffu - 36) {
+      fseek(_f, 4, SEEK_SET);
+      wr32(_f, (uint32_t)(36 + _bytes));
+      fseek(_f, 40, SEEK_SET);
+      wr32(_f, (uint32_t)_bytes);
+    }
+    const bool ok = !ferror(_f);
+    const bool closed = fclose(_f) == 0;
+    _f = nullptr;
+    return ok && closed;
+  }
+
+private:
+  FILE*    _f = nullptr;
+  uint64_t _bytes = 0;
+};
+
+inline bool read(const char* path, std::vector<int16_t>& mono, uint32_t& fs) {
+  Reader r;
+  if (!r.open(path)) return false;
+  fs = r.rate();
+
+  mono.clear();
+  static constexpr size_t CHUNK = 1 << 16;
+  size_t got;
+  do {
+    mono.resize(mono.size() + CHUNK);
+    got = r.read(mono.data() + mono.size() - CHUNK, CHUNK);
+    mono.resize(mono.size() - CHUNK + got);
+  } while (got > 0);
+  return true;
+}
+
+inline bool write(const char* path, const std::vector<int16_t>& mono, uint32_t fs) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+
+  const uint32_t bytes = (uint32_t)mono.size() * 2;
+  fwrite("RIFF", 1, 4, f); wr32(f, 36 + bytes); fwrite("WAVE", 1, 4, f);
+  fwrite("fmt ", 1, 4, f); wr32(f, 16);
+  wr16(f, 1);      // PCM
+  wr16(f, 1);      // mono
+  wr32(f, fs);
+  wr32(f, fs * 2);
+  wr16(f, 2);
+  wr16(f, 16);
+  fwrite("data", 1, 4, f); wr32(f, bytes);
+  fwrite(mono.data(), 2, mono.size(), f);
+
+  bool ok = !ferror(f);
+  fclose(f);
+  return ok;
+}
+
+} // namespace Wav